@@ -0,0 +1,75 @@
+/*
+  Measure archive creation and extraction time on a tree of small files,
+  depending on the number of threads reading and writing files.
+
+  How to run:
+  $ ./examples/demo/elle/archive/archive_bench [files] [file size]
+
+  The tree defaults to 100000 files of 4 KiB spread over 1000 directories,
+  created in a temporary directory.
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <elle/archive/archive.hh>
+#include <elle/filesystem/TemporaryDirectory.hh>
+#include <elle/printf.hh>
+
+namespace bfs = boost::filesystem;
+
+namespace
+{
+  double
+  seconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const files = argc > 1 ? std::atoi(argv[1]) : 100000;
+  auto const size = argc > 2 ? std::atoi(argv[2]) : 4096;
+  auto const tmp = elle::filesystem::TemporaryDirectory("archive_bench");
+  auto const root = tmp.path() / "tree";
+  {
+    auto const start = std::chrono::steady_clock::now();
+    auto const content = std::string(size, 'x');
+    for (int i = 0; i < files; ++i)
+    {
+      auto const dir = root / elle::sprintf("%s", i % 1000);
+      if (i < 1000)
+        bfs::create_directories(dir);
+      bfs::ofstream(dir / elle::sprintf("%s", i)) << content;
+    }
+    elle::fprintf(std::cout, "created %s files of %s bytes in %.2fs\n",
+                  files, size, seconds(start));
+  }
+  auto const cores = int(std::thread::hardware_concurrency());
+  for (int jobs = 1; jobs <= cores; jobs *= 2)
+  {
+    auto const archive = tmp.path() / elle::sprintf("%s.tar", jobs);
+    auto start = std::chrono::steady_clock::now();
+    elle::archive::archive(elle::archive::Format::tar, {root}, archive,
+                           {}, {}, false, jobs);
+    auto const create = seconds(start);
+    auto const output = tmp.path() / elle::sprintf("extract-%s", jobs);
+    bfs::create_directories(output);
+    start = std::chrono::steady_clock::now();
+    elle::archive::extract(archive, output, jobs);
+    auto const extract = seconds(start);
+    elle::fprintf(std::cout,
+                  "%2s threads: create %.2fs (%.0f files/s), "
+                  "extract %.2fs (%.0f files/s)\n",
+                  jobs, create, files / create, extract, files / extract);
+    bfs::remove_all(output);
+    bfs::remove(archive);
+  }
+}
@@ -0,0 +1,255 @@
+/*
+  Measure the throughput of Paxos consensus, one update per round versus
+  batched rounds, with and without a leadership lease, and the latency of
+  reads with and without a lease.
+
+  How to run:
+  $ ./examples/demo/elle/athena/paxos_bench [submitters] [delay ms] [seconds]
+
+  Replicas run in process; every message to a replica is delayed to
+  simulate the network. Each submitter proposes one update at a time and
+  waits for it to be decided; as many readers read the value in a loop.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <elle/Exception.hh>
+#include <elle/With.hh>
+#include <elle/print.hh>
+
+#include <elle/athena/paxos/Batcher.hh>
+#include <elle/athena/paxos/Client.hh>
+#include <elle/athena/paxos/Server.hh>
+
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/scheduler.hh>
+
+namespace paxos = elle::athena::paxos;
+
+using Batch = std::vector<int>;
+using Server = paxos::Server<Batch, int, int>;
+using Client = paxos::Client<Batch, int, int>;
+using Batcher = paxos::Batcher<int, int, int>;
+
+namespace
+{
+  double
+  seconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  /// A replica reached through a simulated network.
+  class Peer
+    : public Client::Peer
+  {
+  public:
+    Peer(Server& server, elle::Duration delay)
+      : Client::Peer(server.id())
+      , _server(server)
+      , _delay(delay)
+    {}
+
+    Client::Response
+    propose(Client::Quorum const& q, Client::Proposal const& p) override
+    {
+      elle::reactor::sleep(this->_delay);
+      return this->_server.propose(q, p);
+    }
+
+    Client::Response
+    lead(Client::Quorum const& q,
+         Client::Proposal const& p,
+         elle::Duration lease) override
+    {
+      elle::reactor::sleep(this->_delay);
+      return this->_server.lead(q, p, lease);
+    }
+
+    Client::Proposal
+    accept(Client::Quorum const& q,
+           Client::Proposal const& p,
+           elle::Option<Batch, Client::Quorum> const& value) override
+    {
+      elle::reactor::sleep(this->_delay);
+      return this->_server.accept(q, p, value);
+    }
+
+    void
+    confirm(Client::Quorum const& q, Client::Proposal const& p) override
+    {
+      elle::reactor::sleep(this->_delay);
+      this->_server.confirm(q, p);
+    }
+
+    boost::optional<Client::Accepted>
+    get(Client::Quorum const& q) override
+    {
+      elle::reactor::sleep(this->_delay);
+      return this->_server.get(q);
+    }
+
+  private:
+    Server& _server;
+    elle::Duration _delay;
+  };
+
+  /// Sort latencies and return a function computing their percentiles.
+  std::function<double (double)>
+  percentiles(std::vector<double>& latencies)
+  {
+    std::sort(latencies.begin(), latencies.end());
+    return [&latencies] (double p)
+      {
+        return latencies[std::min(latencies.size() - 1,
+                                  std::size_t(p * latencies.size()))];
+      };
+  }
+
+  void
+  bench(int replicas, int max_batch, bool lease,
+        int submitters, elle::Duration delay,
+        std::chrono::steady_clock::duration duration)
+  {
+    auto quorum = Server::Quorum{};
+    for (int i = 0; i < replicas; ++i)
+      quorum.emplace(i);
+    auto servers = std::vector<std::unique_ptr<Server>>{};
+    auto peers = Client::Peers{};
+    for (int i = 0; i < replicas; ++i)
+    {
+      servers.emplace_back(std::make_unique<Server>(i, quorum));
+      peers.emplace_back(std::make_unique<Peer>(*servers.back(), delay));
+    }
+    Client client(replicas, std::move(peers));
+    client.early_return(true);
+    if (lease)
+      client.lease(elle::Duration(std::chrono::seconds(10)));
+    Batcher batcher(client, 0, max_batch);
+    auto rounds = 0;
+    auto updates = 0;
+    batcher.decided().connect(
+      [&] (int, Batch const& batch)
+      {
+        ++rounds;
+        updates += batch.size();
+      });
+    // Latency of every update, in microseconds.
+    auto latencies = std::vector<double>{};
+    auto const start = std::chrono::steady_clock::now();
+    elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+    {
+      for (int i = 0; i < submitters; ++i)
+        s.run_background(elle::print("submitter {}", i), [&, i]
+          {
+            for (int n = 0;
+                 std::chrono::steady_clock::now() - start < duration; ++n)
+            {
+              auto const submitted = std::chrono::steady_clock::now();
+              batcher.submit(n * submitters + i);
+              latencies.push_back(seconds(submitted) * 1e6);
+            }
+          });
+      elle::reactor::wait(s);
+    };
+    auto const elapsed = seconds(start);
+    auto const percentile = percentiles(latencies);
+    std::cout << replicas << " replicas, "
+              << (max_batch == 1 ? "unbatched" : "batched  ")
+              << (lease ? ", lease   " : ", no lease")
+              << ": " << updates / elapsed << " updates/s, "
+              << rounds / elapsed << " rounds/s, "
+              << double(updates) / std::max(rounds, 1) << " updates/round, "
+              << "latency p50 " << percentile(0.5)
+              << "us p99 " << percentile(0.99) << "us" << std::endl;
+  }
+
+  void
+  bench_reads(int replicas, bool lease,
+              int readers, elle::Duration delay,
+              std::chrono::steady_clock::duration duration)
+  {
+    auto quorum = Server::Quorum{};
+    for (int i = 0; i < replicas; ++i)
+      quorum.emplace(i);
+    auto servers = std::vector<std::unique_ptr<Server>>{};
+    auto peers = Client::Peers{};
+    for (int i = 0; i < replicas; ++i)
+    {
+      servers.emplace_back(std::make_unique<Server>(i, quorum));
+      peers.emplace_back(std::make_unique<Peer>(*servers.back(), delay));
+    }
+    Client client(replicas, std::move(peers));
+    if (lease)
+      // Outlive the measurement, renewing is not measured.
+      client.lease(elle::Duration(duration * 2));
+    client.choose(0, Batch{42});
+    auto reads = 0;
+    // Latency of every read, in microseconds.
+    auto latencies = std::vector<double>{};
+    auto const start = std::chrono::steady_clock::now();
+    elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+    {
+      for (int i = 0; i < readers; ++i)
+        s.run_background(elle::print("reader {}", i), [&]
+          {
+            while (std::chrono::steady_clock::now() - start < duration)
+            {
+              auto const read = std::chrono::steady_clock::now();
+              client.get();
+              ++reads;
+              latencies.push_back(seconds(read) * 1e6);
+              // Local reads do not yield: let others run.
+              elle::reactor::yield();
+            }
+          });
+      elle::reactor::wait(s);
+    };
+    auto const elapsed = seconds(start);
+    auto const percentile = percentiles(latencies);
+    std::cout << replicas << " replicas, reads"
+              << (lease ? ", lease   " : ", no lease")
+              << ": " << reads / elapsed << " reads/s, "
+              << "latency p50 " << percentile(0.5)
+              << "us p99 " << percentile(0.99) << "us" << std::endl;
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  try
+  {
+    auto const submitters = argc >= 2 ? std::atoi(argv[1]) : 256;
+    auto const delay = elle::Duration(
+      std::chrono::milliseconds(argc >= 3 ? std::atoi(argv[2]) : 1));
+    auto const duration =
+      std::chrono::seconds(argc >= 4 ? std::atoi(argv[3]) : 5);
+    elle::reactor::Scheduler sched;
+    elle::reactor::Thread main(sched, "paxos_bench", [&]
+      {
+        for (auto replicas: {3, 5})
+          for (auto lease: {false, true})
+          {
+            for (auto max_batch: {1, 1024})
+              bench(replicas, max_batch, lease, submitters, delay, duration);
+            bench_reads(replicas, lease, submitters, delay, duration);
+          }
+      });
+    sched.run();
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << elle::exception_string() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,157 @@
+/*
+  Simulate Paxos consensus over a lossy network in virtual time, and report
+  its throughput and latency under various latency distributions and drop
+  rates.
+
+  How to run:
+  $ ./examples/demo/elle/athena/paxos_simulation [seeds] [clients] [versions]
+
+  Each configuration runs once per seed. Clients choose values concurrently,
+  one version after the other, until every version is decided. Throughput
+  and latencies are measured in virtual time; the simulation speed is the
+  number of rounds simulated per second of actual time.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <elle/Exception.hh>
+#include <elle/With.hh>
+#include <elle/print.hh>
+
+#include <elle/athena/paxos/Simulation.hh>
+
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/scheduler.hh>
+
+namespace paxos = elle::athena::paxos;
+
+using Simulation = paxos::Simulation<int, int, int>;
+
+namespace
+{
+  double
+  milliseconds(elle::Duration d)
+  {
+    return std::chrono::duration<double, std::milli>(d).count();
+  }
+
+  /// Sort latencies and return a function computing their percentiles.
+  std::function<double (double)>
+  percentiles(std::vector<double>& latencies)
+  {
+    std::sort(latencies.begin(), latencies.end());
+    return [&latencies] (double p)
+      {
+        return latencies[std::min(latencies.size() - 1,
+                                  std::size_t(p * latencies.size()))];
+      };
+  }
+
+  void
+  bench(std::string const& name,
+        int replicas,
+        Simulation::Distribution const& latency,
+        double drop,
+        int seeds, int clients, int versions)
+  {
+    auto const real_start = std::chrono::steady_clock::now();
+    auto virtual_time = elle::Duration(0);
+    auto rounds = 0;
+    auto messages = 0;
+    auto lost = 0;
+    // Latency of every choice, in milliseconds of virtual time.
+    auto latencies = std::vector<double>{};
+    for (int seed = 0; seed < seeds; ++seed)
+    {
+      auto quorum = Simulation::Quorum{};
+      for (int i = 0; i < replicas; ++i)
+        quorum.emplace(i);
+      Simulation simulation(quorum, seed);
+      simulation.latency(latency);
+      simulation.drop(drop);
+      simulation.timeout(std::chrono::milliseconds(100));
+      auto const start = elle::reactor::now();
+      elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+      {
+        for (int i = 0; i < clients; ++i)
+          s.run_background(elle::print("client {}", i), [&, i]
+            {
+              auto client = simulation.client(replicas + i);
+              for (int version = 0; version < versions;)
+              {
+                auto const chosen = elle::reactor::now();
+                ++rounds;
+                try
+                {
+                  client.choose(version, version * clients + i);
+                  ++version;
+                  latencies.push_back(
+                    milliseconds(elle::reactor::now() - chosen));
+                }
+                catch (paxos::TooFewPeers const&)
+                {}
+              }
+            });
+        elle::reactor::wait(s);
+      };
+      virtual_time += elle::reactor::now() - start;
+      messages += simulation.messages();
+      lost += simulation.lost();
+    }
+    auto const real = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - real_start).count();
+    auto const decided = double(seeds) * versions;
+    auto const percentile = percentiles(latencies);
+    std::cout << replicas << " replicas, " << name << ", "
+              << drop * 100 << "% drop: "
+              << decided / (milliseconds(virtual_time) / 1000)
+              << " versions/s, latency p50 " << percentile(0.5)
+              << "ms p99 " << percentile(0.99) << "ms, "
+              << double(messages) / rounds << " messages/round, "
+              << lost << " lost, "
+              << rounds / real << " rounds/s simulated" << std::endl;
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  try
+  {
+    auto const seeds = argc >= 2 ? std::atoi(argv[1]) : 10;
+    auto const clients = argc >= 3 ? std::atoi(argv[2]) : 3;
+    auto const versions = argc >= 4 ? std::atoi(argv[3]) : 100;
+    elle::reactor::Scheduler sched;
+    sched.simulated(true);
+    elle::reactor::Thread main(sched, "paxos_simulation", [&]
+      {
+        using std::chrono::milliseconds;
+        auto const distributions = {
+          std::make_pair(std::string("uniform 1-10ms"),
+                         Simulation::uniform(milliseconds(1),
+                                             milliseconds(10))),
+          std::make_pair(std::string("exponential 1+4ms"),
+                         Simulation::exponential(milliseconds(1),
+                                                 milliseconds(4))),
+        };
+        for (auto replicas: {3, 5})
+          for (auto const& distribution: distributions)
+            for (auto drop: {0., 0.01, 0.05})
+              bench(distribution.first, replicas, distribution.second, drop,
+                    seeds, clients, versions);
+      });
+    sched.run();
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << elle::exception_string() << std::endl;
+    return 1;
+  }
+}
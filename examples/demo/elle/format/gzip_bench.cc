@@ -0,0 +1,100 @@
+/*
+  Measure GZIP compression throughput and ratio, sequential versus parallel.
+
+  How to run:
+  $ ./examples/demo/elle/format/gzip_bench [file]
+
+  Without a file, compress a synthetic payload mixing serialized-looking
+  text records and incompressible bytes. Throughput is reported overall and
+  per core used.
+*/
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include <elle/Buffer.hh>
+#include <elle/format/gzip.hh>
+#include <elle/printf.hh>
+
+namespace gzip = elle::format::gzip;
+
+namespace
+{
+  double
+  seconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  std::string
+  payload()
+  {
+    auto gen = std::mt19937{42};
+    auto res = std::string{};
+    while (res.size() < 64 * 1024 * 1024)
+      if (gen() % 8)
+        res += elle::sprintf(
+          "{\"id\": %s, \"name\": \"user%s\", \"score\": %s}\n",
+          gen() % 100000, gen() % 1000, gen() % 100);
+      else
+        for (int i = 0; i < 256; ++i)
+          res += char(gen());
+    return res;
+  }
+
+  void
+  report(std::string const& name, int cores, std::size_t size,
+         std::size_t compressed, double time)
+  {
+    auto const mbs = size / time / 1e6;
+    elle::fprintf(std::cout,
+                  "%-10s %3s cores %9.1f MB/s %9.1f MB/s/core ratio %.3f\n",
+                  name, cores, mbs, mbs / cores, double(compressed) / size);
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const data = [&]
+  {
+    if (argc < 2)
+      return payload();
+    std::ifstream input(argv[1], std::ios::binary);
+    std::stringstream res;
+    res << input.rdbuf();
+    return res.str();
+  }();
+  elle::fprintf(std::cout, "%s bytes\n", data.size());
+  {
+    auto const start = std::chrono::steady_clock::now();
+    std::stringstream output;
+    {
+      gzip::Stream stream(output, false);
+      stream.write(data.data(), data.size());
+    }
+    report("sequential", 1, data.size(), output.str().size(), seconds(start));
+  }
+  auto const cores = int(std::thread::hardware_concurrency());
+  for (int jobs = 1; jobs <= cores; jobs *= 2)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    std::stringstream output;
+    {
+      gzip::ParallelStream stream(output, jobs);
+      stream.write(data.data(), data.size());
+    }
+    auto const time = seconds(start);
+    auto const compressed = output.str();
+    if (gzip::decompress(elle::ConstWeakBuffer(compressed)).string() != data)
+    {
+      std::cerr << "corrupted output with " << jobs << " jobs" << std::endl;
+      return 1;
+    }
+    report("parallel", jobs, data.size(), compressed.size(), time);
+  }
+}
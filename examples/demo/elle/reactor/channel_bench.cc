@@ -0,0 +1,131 @@
+/*
+  Measure the message rate of reactor::Channel: one element at a time
+  versus batches, with the default and ring buffer storages, and from
+  system threads.
+
+  How to run:
+  $ ./examples/demo/elle/reactor/channel_bench [messages] [batch] [threads]
+
+  A producer and a consumer exchange messages through a channel bounded to
+  the batch size. System thread producers are not bounded.
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <elle/Exception.hh>
+#include <elle/With.hh>
+
+#include <elle/reactor/Channel.hh>
+#include <elle/reactor/RingBuffer.hh>
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/scheduler.hh>
+
+namespace
+{
+  double
+  seconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  void
+  report(std::string const& name, int messages,
+         std::chrono::steady_clock::time_point start)
+  {
+    std::cout << name << ": " << messages / seconds(start) << " msgs/s"
+              << std::endl;
+  }
+
+  template <typename Channel>
+  void
+  bench(std::string const& name, int messages, int batch)
+  {
+    Channel channel;
+    channel.max_size(batch);
+    auto const start = std::chrono::steady_clock::now();
+    elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+    {
+      s.run_background("producer", [&]
+        {
+          if (batch == 1)
+            for (int i = 0; i < messages; ++i)
+              channel.put(i);
+          else
+            for (int i = 0; i < messages; i += batch)
+            {
+              auto data = std::vector<int>{};
+              data.reserve(batch);
+              for (int j = i; j < i + batch && j < messages; ++j)
+                data.push_back(j);
+              channel.put_batch(std::move(data));
+            }
+        });
+      s.run_background("consumer", [&]
+        {
+          if (batch == 1)
+            for (int i = 0; i < messages; ++i)
+              channel.get();
+          else
+            for (int i = 0; i < messages;)
+              i += channel.get_batch(batch).size();
+        });
+      elle::reactor::wait(s);
+    };
+    report(name + (batch == 1 ? ", single" : ", batched"), messages, start);
+  }
+
+  void
+  bench_threads(int messages, int batch, int threads)
+  {
+    elle::reactor::Channel<int, elle::reactor::RingBuffer<int>> channel;
+    auto const start = std::chrono::steady_clock::now();
+    auto producers = std::vector<std::thread>{};
+    for (int t = 0; t < threads; ++t)
+      producers.emplace_back([&, t]
+        {
+          for (int i = t; i < messages; i += threads)
+            channel.mt_put(i);
+        });
+    for (int i = 0; i < messages;)
+      i += channel.get_batch(batch).size();
+    report("system threads", messages, start);
+    for (auto& p: producers)
+      p.join();
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  try
+  {
+    auto const messages = argc >= 2 ? std::atoi(argv[1]) : 10000000;
+    auto const batch = argc >= 3 ? std::atoi(argv[2]) : 256;
+    auto const threads = argc >= 4 ? std::atoi(argv[3]) : 4;
+    using Queue = elle::reactor::Channel<int>;
+    using Ring = elle::reactor::Channel<int, elle::reactor::RingBuffer<int>>;
+    elle::reactor::Scheduler sched;
+    elle::reactor::Thread main(sched, "channel_bench", [&]
+      {
+        for (auto b: {1, batch})
+        {
+          bench<Queue>("queue", messages, b);
+          bench<Ring>("ring buffer", messages, b);
+        }
+        bench_threads(messages, batch, threads);
+      });
+    sched.run();
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << elle::exception_string() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,141 @@
+/*
+  Measure the request rate of HttpServer, wrk style: a number of kept-alive
+  connections each send batches of pipelined requests for a while.
+
+  How to run:
+  $ ./reactor/examples/http_bench [connections] [pipeline depth] [seconds]
+
+  With a pipeline depth of 1, every connection waits for each response
+  before sending the next request.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <elle/Buffer.hh>
+#include <elle/Exception.hh>
+#include <elle/With.hh>
+#include <elle/err.hh>
+#include <elle/print.hh>
+
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/network/TCPSocket.hh>
+#include <elle/reactor/network/http-server.hh>
+#include <elle/reactor/scheduler.hh>
+
+using Server = elle::reactor::network::HttpServer;
+
+namespace
+{
+  double
+  seconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  /// Read a response and return the size of its body.
+  std::size_t
+  response(elle::reactor::network::TCPSocket& socket)
+  {
+    auto const head = socket.read_until("\r\n\r\n").string();
+    auto const field = std::string("Content-Length: ");
+    auto const start = head.find(field);
+    if (start == std::string::npos)
+      elle::err("response without Content-Length: %s", head);
+    auto const size = std::stoul(head.substr(start + field.size()));
+    socket.read(size);
+    return size;
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  try
+  {
+    auto const connections = argc >= 2 ? std::atoi(argv[1]) : 64;
+    auto const depth = argc >= 3 ? std::atoi(argv[2]) : 16;
+    auto const duration =
+      std::chrono::seconds(argc >= 4 ? std::atoi(argv[3]) : 5);
+    elle::reactor::Scheduler sched;
+    elle::reactor::Thread main(sched, "http_bench", [&]
+      {
+        Server server;
+        server.max_connections(connections);
+        server.register_route(
+          "/plaintext", elle::reactor::http::Method::GET,
+          [] (Server::Headers const&,
+              Server::Cookies const&,
+              Server::Parameters const&,
+              elle::Buffer const&) -> std::string
+          {
+            return "Hello, World!";
+          });
+        server.register_route(
+          "/users/:id", elle::reactor::http::Method::GET,
+          [] (Server::Headers const&,
+              Server::Cookies const&,
+              Server::Parameters const& params,
+              elle::Buffer const&) -> std::string
+          {
+            return params.at("id");
+          });
+        auto batch = std::string{};
+        for (int i = 0; i < depth; ++i)
+          batch += elle::print(
+            "GET {} HTTP/1.1\r\nHost: localhost\r\n\r\n",
+            i % 2 ? "/plaintext" : elle::print("/users/{}", i));
+        auto requests = std::size_t(0);
+        auto bytes = std::size_t(0);
+        // Latency of every batch, in microseconds.
+        auto latencies = std::vector<double>{};
+        auto const start = std::chrono::steady_clock::now();
+        elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+        {
+          for (int c = 0; c < connections; ++c)
+            s.run_background(elle::print("client {}", c), [&]
+              {
+                elle::reactor::network::TCPSocket socket(
+                  "127.0.0.1", server.port());
+                while (std::chrono::steady_clock::now() - start < duration)
+                {
+                  auto const sent = std::chrono::steady_clock::now();
+                  socket.write(elle::ConstWeakBuffer(batch));
+                  for (int i = 0; i < depth; ++i)
+                    bytes += response(socket);
+                  requests += depth;
+                  latencies.push_back(seconds(sent) * 1e6);
+                }
+              });
+          elle::reactor::wait(s);
+        };
+        auto const elapsed = seconds(start);
+        std::sort(latencies.begin(), latencies.end());
+        auto const percentile = [&] (double p)
+          {
+            return latencies[std::min(latencies.size() - 1,
+                                      std::size_t(p * latencies.size()))];
+          };
+        std::cout << connections << " connections, pipeline depth " << depth
+                  << std::endl
+                  << "requests: " << requests / elapsed << "/s" << std::endl
+                  << "transfer: " << bytes / elapsed / 1024 << " KiB/s"
+                  << std::endl
+                  << "batch latency: p50 " << percentile(0.5)
+                  << "us, p99 " << percentile(0.99) << "us, max "
+                  << latencies.back() << "us" << std::endl;
+      });
+    sched.run();
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << elle::exception_string() << std::endl;
+    return 1;
+  }
+}
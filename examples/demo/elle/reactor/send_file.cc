@@ -0,0 +1,145 @@
+/*
+  Compare the cost of sending a file with Socket::send_file against reading
+  it and writing it through the socket.
+
+  How to run:
+  $ ./reactor/examples/send_file [size in MiB] [rounds]
+
+  For each method, the CPU time spent by the sending thread is reported per
+  GiB sent. The receiver runs in a separate system thread and is not
+  accounted for.
+*/
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#ifndef ELLE_WINDOWS
+# include <fcntl.h>
+# include <sys/resource.h>
+# include <sys/time.h>
+# include <unistd.h>
+#endif
+
+#include <elle/Buffer.hh>
+#include <elle/Exception.hh>
+#include <elle/filesystem/TemporaryFile.hh>
+#include <elle/finally.hh>
+
+#include <elle/reactor/asio.hh>
+#include <elle/reactor/network/TCPServer.hh>
+#include <elle/reactor/network/TCPSocket.hh>
+#include <elle/reactor/scheduler.hh>
+
+#ifndef ELLE_WINDOWS
+namespace
+{
+  /// CPU time, user and system, consumed by the calling thread.
+  std::chrono::microseconds
+  cpu_time()
+  {
+    struct rusage usage;
+# ifdef RUSAGE_THREAD
+    ::getrusage(RUSAGE_THREAD, &usage);
+# else
+    ::getrusage(RUSAGE_SELF, &usage);
+# endif
+    auto const us = [] (struct timeval const& tv)
+      {
+        return std::chrono::seconds(tv.tv_sec) +
+          std::chrono::microseconds(tv.tv_usec);
+      };
+    return us(usage.ru_utime) + us(usage.ru_stime);
+  }
+
+  /// Drain @a bytes from port @a port, blocking.
+  void
+  drain(int port, std::size_t bytes)
+  {
+    boost::asio::io_service service;
+    boost::asio::ip::tcp::socket socket(service);
+    socket.connect(
+      {boost::asio::ip::address::from_string("127.0.0.1"),
+       static_cast<unsigned short>(port)});
+    char buffer[1 << 16];
+    while (bytes)
+      bytes -= socket.read_some(boost::asio::buffer(buffer));
+  }
+}
+#endif
+
+int
+main(int argc, char* argv[])
+{
+#ifdef ELLE_WINDOWS
+  std::cerr << "send_file is not available on this platform" << std::endl;
+  return 1;
+#else
+  try
+  {
+    auto const size =
+      std::size_t(argc >= 2 ? std::atoi(argv[1]) : 64) * 1024 * 1024;
+    auto const rounds = argc >= 3 ? std::atoi(argv[2]) : 16;
+    auto file = elle::filesystem::TemporaryFile("send_file");
+    {
+      std::ofstream output(file.path().string(), std::ios::binary);
+      auto chunk = std::string(1024 * 1024, 'x');
+      for (std::size_t written = 0; written < size; written += chunk.size())
+        output.write(chunk.data(), chunk.size());
+    }
+    int fd = ::open(file.path().string().c_str(), O_RDONLY);
+    if (fd < 0)
+      elle::err("unable to open %s", file.path());
+    elle::SafeFinally close([fd] { ::close(fd); });
+    elle::reactor::Scheduler sched;
+    elle::reactor::Thread main(sched, "send_file", [&]
+      {
+        auto const run = [&] (std::string const& name, auto send)
+          {
+            elle::reactor::network::TCPServer server;
+            server.listen();
+            std::thread receiver(drain, server.port(), size * rounds);
+            auto socket = server.accept();
+            auto const start = cpu_time();
+            for (int i = 0; i < rounds; ++i)
+              send(*socket);
+            auto const cpu = cpu_time() - start;
+            socket->flush();
+            receiver.join();
+            auto const gib = double(size) * rounds / (1024 * 1024 * 1024);
+            std::cout << name << ": "
+                      << std::chrono::duration<double, std::milli>(cpu).count()
+                         / gib
+                      << " ms CPU/GiB" << std::endl;
+          };
+        run("read+write",
+            [&] (elle::reactor::network::TCPSocket& socket)
+            {
+              auto buffer = elle::Buffer(1024 * 1024);
+              for (std::size_t offset = 0; offset < size;)
+              {
+                auto n = ::pread(fd, buffer.mutable_contents(),
+                                 buffer.size(), offset);
+                if (n <= 0)
+                  elle::err("unable to read file");
+                socket.write(elle::ConstWeakBuffer(buffer.contents(), n));
+                offset += n;
+              }
+            });
+        run("send_file",
+            [&] (elle::reactor::network::TCPSocket& socket)
+            {
+              socket.send_file(fd, 0, size);
+            });
+      });
+    sched.run();
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << elle::exception_string() << std::endl;
+    return 1;
+  }
+#endif
+}
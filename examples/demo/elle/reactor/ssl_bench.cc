@@ -0,0 +1,122 @@
+/*
+  Measure the SSL handshake rate, with and without session resumption, and
+  the bulk encrypted throughput, with and without kernel TLS.
+
+  How to run:
+  $ ./reactor/examples/ssl_bench <certificate> <key> <dh> [size in MiB]
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include <elle/Buffer.hh>
+#include <elle/Exception.hh>
+
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/network/ssl-server.hh>
+#include <elle/reactor/network/ssl-socket.hh>
+#include <elle/reactor/scheduler.hh>
+
+using namespace elle::reactor::network;
+
+namespace
+{
+  double
+  seconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 4 || argc > 5)
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " <certificate> <key> <dh> [size in MiB]" << std::endl;
+    return 1;
+  }
+  try
+  {
+    auto const size =
+      std::size_t(argc >= 5 ? std::atoi(argv[4]) : 256) * 1024 * 1024;
+    auto const certificate = [&]
+      {
+        // Version-flexible, to negotiate TLS 1.3 where available.
+        return std::make_unique<SSLCertificate>(
+          argv[1], argv[2], argv[3], boost::asio::ssl::context::sslv23_server);
+      };
+    elle::reactor::Scheduler sched;
+    elle::reactor::Thread main(sched, "ssl_bench", [&]
+      {
+        {
+          auto const handshakes = 500;
+          SSLServer server(certificate());
+          server.listen();
+          auto const port = std::to_string(server.port());
+          auto const key = "127.0.0.1:" + port;
+          elle::reactor::Thread accept("accept", [&]
+            {
+              while (true)
+              {
+                auto socket = server.accept();
+                socket->write(elle::ConstWeakBuffer("x"));
+              }
+            });
+          for (auto resume: {false, true})
+          {
+            auto const start = std::chrono::steady_clock::now();
+            auto resumed = 0;
+            for (int i = 0; i < handshakes; ++i)
+            {
+              if (!resume)
+                SSLSessionCache::global()->erase(key);
+              SSLSocket socket("127.0.0.1", port);
+              // Receive session tickets.
+              socket.read(1);
+              resumed += socket.resumed();
+            }
+            std::cout << "handshakes"
+                      << (resume ? " with resumption" : "") << ": "
+                      << handshakes / seconds(start) << "/s ("
+                      << resumed << " resumed)" << std::endl;
+          }
+          accept.terminate_now();
+        }
+        for (auto ktls: {false, true})
+        {
+          auto c = certificate();
+          c->kernel_tls(ktls);
+          SSLServer server(std::move(c));
+          server.listen();
+          elle::reactor::Thread send("send", [&]
+            {
+              auto socket = server.accept();
+              auto chunk = elle::Buffer(1024 * 1024);
+              for (std::size_t sent = 0; sent < size; sent += chunk.size())
+                socket->write(chunk);
+              if (ktls && !socket->write_offloaded())
+                std::cout << "kernel TLS is unavailable" << std::endl;
+            });
+          SSLSocket socket("127.0.0.1", std::to_string(server.port()));
+          auto const start = std::chrono::steady_clock::now();
+          auto buffer = elle::Buffer(1024 * 1024);
+          for (std::size_t received = 0; received < size;)
+            received += socket.read_some(buffer);
+          std::cout << "throughput" << (ktls ? " with kernel TLS" : "")
+                    << ": " << size / seconds(start) / (1024 * 1024)
+                    << " MiB/s" << std::endl;
+          elle::reactor::wait(send);
+        }
+      });
+    sched.run();
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << elle::exception_string() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,105 @@
+/*
+  Compare the cost of reactor::Task and reactor::Thread: spawn many of
+  them, have each wait for a barrier once, open it and wait for them all.
+
+  How to run:
+  $ ./examples/demo/elle/reactor/task_bench [count]
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <elle/Exception.hh>
+
+#include <elle/reactor/Barrier.hh>
+#include <elle/reactor/Task.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/scheduler.hh>
+
+namespace
+{
+  double
+  seconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  void
+  report(std::string const& name, int count,
+         std::chrono::steady_clock::time_point start)
+  {
+    std::cout << name << ": " << count / seconds(start) << " spawns/s"
+              << std::endl;
+  }
+
+  void
+  bench_tasks(int count)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    auto barrier = elle::reactor::Barrier();
+    auto tasks = std::vector<std::unique_ptr<elle::reactor::Task>>{};
+    tasks.reserve(count);
+    for (int i = 0; i < count; ++i)
+      tasks.emplace_back(std::make_unique<elle::reactor::Task>(
+        "task",
+        [&, waited = false] (elle::reactor::Task& self) mutable
+        {
+          if (!waited)
+          {
+            waited = true;
+            self.wait(barrier);
+          }
+        }));
+    elle::reactor::yield();
+    barrier.open();
+    for (auto& task: tasks)
+      elle::reactor::wait(*task);
+    report("tasks", count, start);
+  }
+
+  void
+  bench_threads(int count)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    auto barrier = elle::reactor::Barrier();
+    auto threads = std::vector<std::unique_ptr<elle::reactor::Thread>>{};
+    threads.reserve(count);
+    for (int i = 0; i < count; ++i)
+      threads.emplace_back(std::make_unique<elle::reactor::Thread>(
+        "thread", [&] { elle::reactor::wait(barrier); }));
+    elle::reactor::yield();
+    barrier.open();
+    for (auto& thread: threads)
+      elle::reactor::wait(*thread);
+    report("threads", count, start);
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  try
+  {
+    auto const count = argc >= 2 ? std::atoi(argv[1]) : 100000;
+    std::cout << "sizeof(Task): " << sizeof(elle::reactor::Task) << std::endl
+              << "sizeof(Thread): " << sizeof(elle::reactor::Thread)
+              << " plus its stack" << std::endl;
+    elle::reactor::Scheduler sched;
+    elle::reactor::Thread main(sched, "task_bench", [&]
+      {
+        bench_tasks(count);
+        bench_threads(count);
+      });
+    sched.run();
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << elle::exception_string() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,117 @@
+/*
+  Measure the rate of waits and wake-ups: two threads handing a mutex over
+  to each other, and one barrier waking many threads at once.
+
+  How to run:
+  $ ./examples/demo/elle/reactor/wait_bench [handoffs] [waiters] [rounds]
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <elle/Exception.hh>
+#include <elle/With.hh>
+
+#include <elle/reactor/Barrier.hh>
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/mutex.hh>
+#include <elle/reactor/scheduler.hh>
+
+namespace
+{
+  double
+  seconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  void
+  report(std::string const& name, int wakes,
+         std::chrono::steady_clock::time_point start)
+  {
+    std::cout << name << ": " << wakes / seconds(start) << " wakes/s"
+              << std::endl;
+  }
+
+  void
+  ping_pong(int handoffs)
+  {
+    elle::reactor::Mutex mutex;
+    auto const start = std::chrono::steady_clock::now();
+    elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+    {
+      for (auto name: {"ping", "pong"})
+        s.run_background(name, [&]
+          {
+            // Yield holding the mutex, so that the other side waits for it.
+            for (int i = 0; i < handoffs / 2; ++i)
+            {
+              elle::reactor::Lock lock(mutex);
+              elle::reactor::yield();
+            }
+          });
+      elle::reactor::wait(s);
+    };
+    report("mutex ping-pong", handoffs, start);
+  }
+
+  void
+  fan_out(int waiters, int rounds)
+  {
+    elle::reactor::Barrier barrier;
+    int woken = 0;
+    auto const start = std::chrono::steady_clock::now();
+    elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+    {
+      for (int i = 0; i < waiters; ++i)
+        s.run_background(elle::sprintf("waiter %s", i), [&]
+          {
+            for (int r = 0; r < rounds; ++r)
+            {
+              elle::reactor::wait(barrier);
+              ++woken;
+            }
+          });
+      while (int(barrier.waiters().size()) < waiters)
+        elle::reactor::yield();
+      for (int r = 0; r < rounds; ++r)
+      {
+        // Waiters woken wait again once run, the barrier being closed.
+        barrier.open();
+        barrier.close();
+        while (woken < (r + 1) * waiters)
+          elle::reactor::yield();
+      }
+      elle::reactor::wait(s);
+    };
+    report("barrier fan-out", woken, start);
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  try
+  {
+    auto const handoffs = argc >= 2 ? std::atoi(argv[1]) : 1000000;
+    auto const waiters = argc >= 3 ? std::atoi(argv[2]) : 1000;
+    auto const rounds = argc >= 4 ? std::atoi(argv[3]) : 1000;
+    elle::reactor::Scheduler sched;
+    elle::reactor::Thread main(sched, "wait_bench", [&]
+      {
+        ping_pong(handoffs);
+        fan_out(waiters, rounds);
+      });
+    sched.run();
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << elle::exception_string() << std::endl;
+    return 1;
+  }
+}
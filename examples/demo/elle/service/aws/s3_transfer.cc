@@ -0,0 +1,88 @@
+/*
+  Measure the throughput of aws::Transfer uploads and downloads against a
+  local S3 stand-in, depending on the number of concurrent parts.
+
+  How to run:
+  $ ./examples/demo/elle/service/aws/s3_transfer [size in MiB] [latency in ms]
+
+  The stand-in, shared with the tests, keeps objects in memory and implements
+  just enough of the S3 API for multipart uploads and ranged GETs. It delays
+  every response by the given latency to mimic a remote endpoint.
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include <elle/Buffer.hh>
+#include <elle/Exception.hh>
+#include <elle/err.hh>
+#include <elle/print.hh>
+
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/scheduler.hh>
+#include <elle/service/aws/Transfer.hh>
+#include <elle/service/aws/stand-in.hh>
+
+namespace aws = elle::service::aws;
+
+namespace
+{
+  double
+  seconds(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  try
+  {
+    auto const size =
+      aws::S3::FileSize(argc >= 2 ? std::atoi(argv[1]) : 256) * 1024 * 1024;
+    auto const latency =
+      std::chrono::milliseconds(argc >= 3 ? std::atoi(argv[2]) : 20);
+    auto content = elle::Buffer(size);
+    for (std::size_t i = 0; i < size; ++i)
+      content[i] = i % 251;
+    elle::reactor::Scheduler sched;
+    elle::reactor::Thread main(sched, "s3_transfer", [&]
+      {
+        S3StandIn stand_in(latency);
+        auto s3 = aws::S3(aws::Credentials(
+          "access", "secret", "us-east-1", "bucket", "folder",
+          elle::print("http://127.0.0.1:{}", stand_in.port())));
+        for (auto concurrency: {1, 4, 16})
+        {
+          auto transfer = aws::Transfer(s3, concurrency);
+          auto const mib = double(size) / (1024 * 1024);
+          auto start = std::chrono::steady_clock::now();
+          transfer.upload(
+            "object", size,
+            [&] (aws::S3::FileSize offset, std::size_t length)
+            {
+              return elle::Buffer(content.contents() + offset, length);
+            });
+          std::cout << concurrency << " parts, upload: "
+                    << mib / seconds(start) << " MiB/s" << std::endl;
+          start = std::chrono::steady_clock::now();
+          std::stringstream output;
+          transfer.download("object", size, output);
+          std::cout << concurrency << " parts, download: "
+                    << mib / seconds(start) << " MiB/s" << std::endl;
+          if (output.str() != content.string())
+            elle::err("downloaded object differs");
+        }
+      });
+    sched.run();
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << elle::exception_string() << std::endl;
+    return 1;
+  }
+}
@@ -1,13 +1,29 @@
 #include <elle/archive/archive.hh>
 
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
 #include <unordered_set>
 
+#ifndef ELLE_WINDOWS
+# include <cerrno>
+# include <cstring>
+
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
 #include <archive.h>
 #include <archive_entry.h>
 
 #include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 
 #include <elle/Error.hh>
+#include <elle/format/codec.hh>
 #include <elle/system/system.hh>
 #include <elle/log.hh>
 #include <elle/printf.hh>
@@ -74,6 +90,16 @@ namespace elle
     };
     using ArchivePtr = std::unique_ptr< ::archive, archive_deleter >;
 
+    /// Write libarchive output to the std::ostream client data.
+    static
+    la_ssize_t
+    write_stream(::archive*, void* output, void const* data, size_t size)
+    {
+      auto& stream = *static_cast<std::ostream*>(output);
+      stream.write(static_cast<char const*>(data), size);
+      return stream ? la_ssize_t(size) : -1;
+    }
+
     struct archive_read_deleter
     {
       void
@@ -97,13 +123,148 @@ namespace elle
     };
     using EntryPtr = std::unique_ptr< ::archive_entry, archive_entry_deleter >;
 
+    namespace
+    {
+      /// Threads running jobs in the background.
+      ///
+      /// Jobs are weighted, typically by the memory they hold: submitting
+      /// blocks while the pending weight exceeds the capacity.
+      class Pool
+      {
+      public:
+        Pool(int size, std::size_t capacity = 0)
+          : _capacity(capacity)
+          , _weight(0)
+          , _running(0)
+          , _stop(false)
+        {
+          for (int i = 0; i < size; ++i)
+            this->_threads.emplace_back([this] { this->_work(); });
+        }
+
+        ~Pool()
+        {
+          {
+            std::unique_lock<std::mutex> lock(this->_mutex);
+            this->_stop = true;
+          }
+          this->_available.notify_all();
+          for (auto& thread: this->_threads)
+            thread.join();
+        }
+
+        void
+        run(std::function<void ()> job, std::size_t weight = 0)
+        {
+          std::unique_lock<std::mutex> lock(this->_mutex);
+          this->_done.wait(lock, [&]
+            {
+              return this->_error ||
+                this->_capacity == 0 || this->_weight == 0 ||
+                this->_weight + weight <= this->_capacity;
+            });
+          this->_check();
+          this->_weight += weight;
+          this->_jobs.emplace(std::move(job), weight);
+          this->_available.notify_one();
+        }
+
+        /// Wait until all jobs are done, rethrowing the first failure.
+        void
+        wait()
+        {
+          std::unique_lock<std::mutex> lock(this->_mutex);
+          this->_done.wait(lock, [&]
+            {
+              return this->_error || (this->_jobs.empty() && !this->_running);
+            });
+          this->_check();
+        }
+
+      private:
+        void
+        _check()
+        {
+          if (this->_error)
+            std::rethrow_exception(this->_error);
+        }
+
+        void
+        _work()
+        {
+          std::unique_lock<std::mutex> lock(this->_mutex);
+          while (true)
+          {
+            this->_available.wait(
+              lock, [&] { return this->_stop || !this->_jobs.empty(); });
+            if (this->_stop)
+              return;
+            auto job = std::move(this->_jobs.front());
+            this->_jobs.pop();
+            ++this->_running;
+            lock.unlock();
+            auto error = std::exception_ptr{};
+            try
+            {
+              job.first();
+            }
+            catch (...)
+            {
+              error = std::current_exception();
+            }
+            lock.lock();
+            --this->_running;
+            this->_weight -= job.second;
+            if (error && !this->_error)
+              this->_error = error;
+            this->_done.notify_all();
+          }
+        }
+
+        std::size_t _capacity;
+        std::size_t _weight;
+        int _running;
+        bool _stop;
+        std::exception_ptr _error;
+        std::queue<std::pair<std::function<void ()>, std::size_t>> _jobs;
+        std::mutex _mutex;
+        std::condition_variable _available;
+        std::condition_variable _done;
+        std::vector<std::thread> _threads;
+      };
+    }
+
+    /// The size up to which file contents are read, or written, in the
+    /// background, larger files being streamed by the archiving thread.
+    static auto const background_file_size = std::size_t(4 * 1024 * 1024);
+    /// The size of file contents held by background jobs.
+    static auto const background_capacity = std::size_t(64 * 1024 * 1024);
+
     static
-    void
-    _archive_file(::archive* archive,
-                  bfs::path const& file,
-                  bfs::path const& relative_path)
+    int
+    concurrency(int jobs)
+    {
+      if (jobs > 0)
+        return jobs;
+      return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /// A file ready to be archived: its entry, and its content if small.
+    struct Prepared
+    {
+      EntryPtr entry;
+      bool link;
+      boost::optional<elle::Buffer> data;
+    };
+
+    /// Stat a file, and read it if small and @a read.
+    static
+    Prepared
+    _archive_prepare(bfs::path const& file,
+                     bfs::path const& relative_path,
+                     bool read)
     {
-      ELLE_TRACE_SCOPE("add %s as %s", file, relative_path);
+      ELLE_DEBUG_SCOPE("prepare %s as %s", file, relative_path);
       EntryPtr entry(archive_entry_new());
       // XXX: Convert path to native windows encoding.
       archive_entry_copy_pathname(entry.get(), relative_path.string().c_str());
@@ -121,10 +282,36 @@ namespace elle
       archive_read_disk_entry_from_file(read_disk.get(), entry.get(), -1, 0/*&st*/);
       ELLE_DEBUG("will write %s bytes for %s, islink:%s mode:%s",
         archive_entry_size(entry.get()), file, S_ISLNK(st.st_mode), st.st_mode);
-      check_call(archive, archive_write_header(archive, entry.get()));
+      auto res = Prepared{std::move(entry), bool(S_ISLNK(st.st_mode)), {}};
+      auto const size = archive_entry_size(res.entry.get());
+      if (read && size > 0 && !res.link &&
+          std::size_t(size) <= background_file_size)
+        res.data = elle::system::read_file_chunk(file, 0, size);
+      return res;
+    }
 
+    static
+    void
+    _archive_write(::archive* archive,
+                   bfs::path const& file,
+                   Prepared const& prepared)
+    {
+      ELLE_TRACE_SCOPE("add %s", file);
+      auto const entry = prepared.entry.get();
+      if (prepared.data)
+        // The file may have changed since it was read.
+        archive_entry_set_size(entry, prepared.data->size());
+      check_call(archive, archive_write_header(archive, entry));
+      if (prepared.data)
+      {
+        if (!prepared.data->empty())
+          check_call(archive,
+                     archive_write_data(archive, prepared.data->contents(),
+                                        prepared.data->size()),
+                     prepared.data->size());
+      }
       // An archive_entry_size of 0 means data is not required (hardlink).
-      if (archive_entry_size(entry.get()) > 0 && !S_ISLNK(st.st_mode))
+      else if (archive_entry_size(entry) > 0 && !prepared.link)
       {
         uint64_t offset = 0;
         size_t chunck_size = 5 * 1024 * 1024;
@@ -152,11 +339,17 @@ namespace elle
             bfs::path const& path,
             Renamer const& renamer,
             Excluder const& excluder,
-            bool ignore_failure)
+            bool ignore_failure,
+            int jobs)
     {
       ELLE_TRACE_SCOPE("archive %s", path);
       ELLE_DEBUG("files: %s", files);
       auto root_entries = std::unordered_set<std::string>{};
+      // Output compressed by elle rather than libarchive, declared first to
+      // outlive the archive which flushes when closed.
+      auto codec = elle::format::Codec::none;
+      auto file = std::unique_ptr<bfs::ofstream>{};
+      auto compressed = std::unique_ptr<std::ostream>{};
       ArchivePtr archive(archive_write_new());
       ELLE_TRACE("archive: %s", (void*)(archive.get()));
       int (*format_setter)(::archive*) = nullptr;
@@ -172,7 +365,8 @@ namespace elle
           break;
         case Format::tar_gzip:
           format_setter = archive_write_set_format_gnutar;
-          compression_setter = archive_write_add_filter_gzip;
+          // Compress on all cores instead of libarchive's sequential filter.
+          codec = elle::format::Codec::gzip;
           break;
         case Format::zip:
           format_setter = archive_write_set_format_zip;
@@ -187,25 +381,42 @@ namespace elle
       check_call(archive.get(), format_setter(archive.get()));
       if (compression_setter)
         check_call(archive.get(), compression_setter(archive.get()));
-      check_call(archive.get(),
+      if (codec != elle::format::Codec::none)
+      {
+        file = std::make_unique<bfs::ofstream>(path, std::ios::binary);
+        if (!*file)
+          throw elle::Error(elle::sprintf("unable to open %s", path));
+        compressed = elle::format::compressor(
+          codec, *file, std::max(1u, std::thread::hardware_concurrency()));
+        check_call(archive.get(),
+                   archive_write_open(archive.get(), compressed.get(),
+                                      nullptr, &write_stream, nullptr));
+      }
+      else
+        check_call(archive.get(),
 #ifdef ELLE_WINDOWS
-        archive_write_open_filename_w(archive.get(), path.native().c_str()));
+          archive_write_open_filename_w(archive.get(), path.native().c_str()));
 #else
-        archive_write_open_filename(archive.get(), path.string().c_str()));
+          archive_write_open_filename(archive.get(), path.string().c_str()));
 #endif
-      auto do_archiving = [ignore_failure] (
-        ::archive* archive,
-        bfs::path const& absolute,
-        bfs::path const& relative)
+      // Files to archive and their path in the archive.
+      auto entries = std::vector<std::pair<bfs::path, bfs::path>>{};
+      auto do_archiving = [&] (bfs::path const& absolute,
+                               bfs::path const& relative)
+        {
+          entries.emplace_back(absolute, relative);
+        };
+      auto archive_entry = [&] (std::size_t i,
+                                std::function<Prepared ()> const& prepare)
         {
           try
           {
-            _archive_file(archive, absolute, relative);
+            _archive_write(archive.get(), entries[i].first, prepare());
           }
           catch (elle::Error const& e)
           {
             if (ignore_failure)
-              ELLE_ERR("ignore %s: %s", absolute, e);
+              ELLE_ERR("ignore %s: %s", entries[i].first, e);
             else
               throw;
           }
@@ -245,7 +456,7 @@ namespace elle
                   return res;
                 }();
                 ELLE_DEBUG("archiving from directory %s as %s", absolute, relative);
-                do_archiving(archive.get(), absolute, relative);
+                do_archiving(absolute, relative);
               }
             }
         }
@@ -257,13 +468,109 @@ namespace elle
             continue;
           }
           ELLE_DEBUG("archiving %s as %s", path, root);
-          do_archiving(archive.get(), path, root);
+          do_archiving(path, root);
+        }
+      }
+      auto const threads = concurrency(jobs);
+      if (threads == 1)
+        for (auto i = 0u; i < entries.size(); ++i)
+          archive_entry(i, [&]
+            {
+              return _archive_prepare(entries[i].first, entries[i].second,
+                                      false);
+            });
+      else
+      {
+        // Stat and read files in the background, a few ahead of the
+        // archive which is written in order on this thread.
+        auto const window = std::size_t(4 * threads);
+        auto ready = std::deque<std::future<Prepared>>{};
+        Pool pool(threads);
+        auto prepared = 0u;
+        for (auto i = 0u; i < entries.size(); ++i)
+        {
+          for (; prepared < entries.size() && prepared < i + window;
+               ++prepared)
+          {
+            auto task = std::make_shared<std::packaged_task<Prepared ()>>(
+              [&entries, prepared]
+              {
+                return _archive_prepare(entries[prepared].first,
+                                        entries[prepared].second,
+                                        true);
+              });
+            ready.emplace_back(task->get_future());
+            pool.run([task] { (*task)(); });
+          }
+          auto next = std::move(ready.front());
+          ready.pop_front();
+          archive_entry(i, [&] { return next.get(); });
+        }
+      }
+      if (compressed)
+      {
+        // Close the archive, then finish compression, before the file.
+        archive.reset();
+        compressed.reset();
+        file->close();
+        if (!*file)
+          throw elle::Error(elle::sprintf("unable to write %s", path));
+      }
+    }
+
+    /// Write a file extracted in the background, with the permissions
+    /// libarchive would give it.
+    static
+    void
+    _extract_file(bfs::path const& path,
+                  elle::Buffer const& data,
+                  int mode)
+    {
+      ELLE_DEBUG_SCOPE("write %s bytes to %s", data.size(), path);
+#ifdef ELLE_WINDOWS
+      bfs::ofstream output(path, std::ios::binary | std::ios::trunc);
+      output.write(reinterpret_cast<char const*>(data.contents()),
+                   data.size());
+      if (!output)
+        throw elle::Error(elle::sprintf("unable to write %s", path));
+#else
+      auto const open = [&]
+        {
+          return ::open(path.string().c_str(),
+                        O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+        };
+      auto fd = open();
+      // Replace existing files, like libarchive does.
+      if (fd < 0 && errno == EEXIST && ::unlink(path.string().c_str()) == 0)
+        fd = open();
+      if (fd < 0)
+        throw elle::Error(elle::sprintf("unable to open %s: %s",
+                                        path, ::strerror(errno)));
+      auto written = std::size_t(0);
+      while (written < data.size())
+      {
+        auto const n = ::write(fd, data.contents() + written,
+                               data.size() - written);
+        if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          auto const error = errno;
+          ::close(fd);
+          throw elle::Error(elle::sprintf("unable to write %s: %s",
+                                          path, ::strerror(error)));
         }
+        written += n;
       }
+      if (::close(fd) != 0)
+        throw elle::Error(elle::sprintf("unable to close %s: %s",
+                                        path, ::strerror(errno)));
+#endif
     }
 
     void extract(bfs::path const& archive,
-                 boost::optional<bfs::path> const& output)
+                 boost::optional<bfs::path> const& output,
+                 int jobs)
     {
       ELLE_TRACE("[Archive] extracting %s", archive.string());
       ArchiveReadPtr a(archive_read_new());
@@ -274,6 +581,17 @@ namespace elle
       archive_read_support_format_all(a.get());
       check_call(a.get(), archive_read_open_filename(a.get(),
                  archive.string().c_str(), 10240));
+      auto const threads = concurrency(jobs);
+      // Small regular files are decoded here and written by the pool, the
+      // rest is written by libarchive. Declared after the writer so files
+      // are written before it applies deferred directory permissions.
+      auto pool = std::unique_ptr<Pool>{};
+      if (threads > 1)
+        pool = std::make_unique<Pool>(threads, background_capacity);
+      // Directories known to exist.
+      auto directories = std::unordered_set<std::string>{};
+      // Files written by the pool since it was last waited for.
+      auto pending = std::unordered_set<std::string>{};
       for (;;)
       {
         ::archive_entry* entry;
@@ -285,11 +603,55 @@ namespace elle
         auto dest = output ? output.get() : archive.parent_path();
         const std::string fullpath = (dest / cur_file).string();
         ELLE_TRACE("[Archive] extracting %s", fullpath);
+        auto const size = archive_entry_size(entry);
+        if (pool &&
+            archive_entry_filetype(entry) == AE_IFREG &&
+            !archive_entry_hardlink(entry) &&
+            archive_entry_size_is_set(entry) &&
+            std::size_t(size) <= background_file_size &&
+            !pending.count(fullpath))
+        {
+          auto data = elle::Buffer(std::size_t(size));
+          auto read = std::size_t(0);
+          while (read < data.size())
+          {
+            auto const n = archive_read_data(
+              a.get(), data.mutable_contents() + read, data.size() - read);
+            if (n < 0)
+              check_call(a.get(), n);
+            if (n == 0)
+              break;
+            read += n;
+          }
+          data.size(read);
+          auto const parent = bfs::path(fullpath).parent_path();
+          if (directories.insert(parent.string()).second)
+            bfs::create_directories(parent);
+          pending.insert(fullpath);
+          auto const weight = data.size();
+          pool->run(
+            [fullpath, data = std::move(data),
+             mode = archive_entry_perm(entry)]
+            {
+              _extract_file(fullpath, data, mode);
+            },
+            weight);
+          continue;
+        }
+        // Hard links may target files being written, and files may be
+        // extracted several times: let pending writes complete first.
+        if (pool && (archive_entry_hardlink(entry) || pending.count(fullpath)))
+        {
+          pool->wait();
+          pending.clear();
+        }
         archive_entry_set_pathname(entry, fullpath.c_str());
         check_call(a.get(), archive_write_header(out.get(), entry));
         check_call(a.get(), copy_data(a.get(), out.get()));
         check_call(a.get(), archive_write_finish_entry(out.get()));
       }
+      if (pool)
+        pool->wait();
     }
   }
 }
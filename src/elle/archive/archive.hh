@@ -38,13 +38,18 @@ namespace elle
     /// @param renamer        A function to rename entries.
     /// @param excluder       A function to exclude files.
     /// @param ignore_failure Ignore failure (like non-existent files, etc.)
+    /// @param jobs           The number of threads reading files, one per
+    ///                       core if 0. Files are stat'ed and read ahead in
+    ///                       the background while the archive is written in
+    ///                       order.
     void
     archive(Format format,
             Paths const& files,
             bfs::path const& path,
             Renamer const& renamer = {},
             Excluder const& excluder = {},
-            bool ignore_failure = false);
+            bool ignore_failure = false,
+            int jobs = 0);
 
     /// Extract an archive to a given path.
     ///
@@ -54,8 +59,12 @@ namespace elle
     /// @param output An optional location where to output the archive. If
     //                unspecified, archive will be extracted in its parent
     ///               folder.
+    /// @param jobs   The number of threads writing files, one per core if 0.
+    ///               Small regular files are decoded in order and written
+    ///               concurrently, other entries are written in order.
     void
     extract(bfs::path const& archive,
-            boost::optional<bfs::path> const& output = {});
+            boost::optional<bfs::path> const& output = {},
+            int jobs = 0);
   }
 }
@@ -0,0 +1,153 @@
+#include <elle/archive/chunker.hh>
+
+#include <algorithm>
+#include <array>
+#include <istream>
+
+#include <elle/err.hh>
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("elle.archive.chunker");
+
+namespace elle
+{
+  namespace archive
+  {
+    namespace
+    {
+      /// The random value each byte adds to the rolling hash.
+      ///
+      /// The values are part of the chunk boundaries definition: they must
+      /// never change, lest previously stored chunks stop deduplicating.
+      std::array<uint64_t, 256> const&
+      gear()
+      {
+        static auto const res = []
+          {
+            auto res = std::array<uint64_t, 256>{};
+            // splitmix64, with a fixed seed.
+            auto state = uint64_t(0x6a09e667f3bcc908);
+            for (auto& value: res)
+            {
+              auto z = (state += 0x9e3779b97f4a7c15);
+              z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+              z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+              value = z ^ (z >> 31);
+            }
+            return res;
+          }();
+        return res;
+      }
+
+      int
+      log2(std::size_t size)
+      {
+        auto res = 0;
+        while (size >>= 1)
+          ++res;
+        return res;
+      }
+
+      /// A mask of the @a bits most significant bits: shifting the hash left
+      /// as bytes are added, they depend on the last 64 bytes.
+      uint64_t
+      mask(int bits)
+      {
+        return ~uint64_t(0) << (64 - bits);
+      }
+    }
+
+    /*-------------.
+    | Construction |
+    `-------------*/
+
+    Chunker::Chunker(std::istream& input, std::size_t average)
+      : _offset(0)
+      , _minimum(0)
+      , _average(0)
+      , _maximum(0)
+      , _input(input)
+      , _mask_small(0)
+      , _mask_large(0)
+      , _buffer()
+      , _start(0)
+    {
+      auto const bits = log2(average);
+      if (bits < 8 || bits > 30)
+        elle::err("invalid average chunk size: %s", average);
+      this->_average = std::size_t(1) << bits;
+      this->_minimum = this->_average / 4;
+      this->_maximum = this->_average * 4;
+      // Normalized chunking: boundaries are harder to match before the
+      // average size and easier after, which concentrates chunk sizes around
+      // the average.
+      this->_mask_small = mask(bits + 2);
+      this->_mask_large = mask(bits - 2);
+    }
+
+    /*---------.
+    | Chunking |
+    `---------*/
+
+    boost::optional<elle::Buffer>
+    Chunker::next()
+    {
+      this->_fill(this->_maximum);
+      auto const available = this->_buffer.size() - this->_start;
+      if (available == 0)
+        return boost::none;
+      auto const data = this->_buffer.contents() + this->_start;
+      auto const size = this->cut(data, available);
+      ELLE_DUMP("chunk of %s bytes at %s", size, this->_offset);
+      this->_start += size;
+      this->_offset += size;
+      return elle::Buffer(data, size);
+    }
+
+    std::size_t
+    Chunker::cut(uint8_t const* data, std::size_t size) const
+    {
+      if (size <= this->_minimum)
+        return size;
+      auto const& table = gear();
+      auto const end = std::min(size, this->_maximum);
+      auto const normal = std::min(end, this->_average);
+      auto hash = uint64_t(0);
+      // No boundary can occur before the minimum size: skip hashing it.
+      auto i = this->_minimum;
+      for (; i < normal; ++i)
+      {
+        hash = (hash << 1) + table[data[i]];
+        if (!(hash & this->_mask_small))
+          return i + 1;
+      }
+      for (; i < end; ++i)
+      {
+        hash = (hash << 1) + table[data[i]];
+        if (!(hash & this->_mask_large))
+          return i + 1;
+      }
+      return end;
+    }
+
+    void
+    Chunker::_fill(std::size_t size)
+    {
+      if (this->_buffer.size() - this->_start >= size || !this->_input)
+        return;
+      // Drop chunked data and read a few chunks ahead, so data is moved back
+      // once every few chunks only.
+      this->_buffer.pop_front(this->_start);
+      this->_start = 0;
+      auto const used = this->_buffer.size();
+      auto const target = std::max(size, 2 * this->_maximum);
+      this->_buffer.size(target);
+      this->_input.read(
+        reinterpret_cast<char*>(this->_buffer.mutable_contents() + used),
+        target - used);
+      this->_buffer.size(used + this->_input.gcount());
+      if (this->_input.bad())
+        elle::err("unable to read chunked stream");
+    }
+  }
+}
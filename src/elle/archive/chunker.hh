@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+
+#include <boost/optional.hpp>
+
+#include <elle/Buffer.hh>
+#include <elle/attribute.hh>
+#include <elle/compiler.hh>
+
+namespace elle
+{
+  namespace archive ELLE_API
+  {
+    /// Split a stream in content-defined chunks.
+    ///
+    /// Boundaries are chosen where a rolling gear hash of the last 64 bytes
+    /// matches a mask (FastCDC), so they depend on the content around them
+    /// instead of their offset: an insertion or a deletion only changes the
+    /// chunks it touches, and the rest of the stream yields the same chunks
+    /// as before. This makes chunks of successive snapshots of an archive
+    /// good deduplication units.
+    ///
+    /// Chunks are between `minimum` and `maximum` bytes, `average` on
+    /// average. Boundaries only depend on the content and these sizes:
+    /// changing them changes every chunk.
+    ///
+    /// @code{.cc}
+    ///
+    /// elle::archive::Chunker chunker(input);
+    /// while (auto chunk = chunker.next())
+    ///   store(*chunk);
+    ///
+    /// @endcode
+    class Chunker
+    {
+    /*-------------.
+    | Construction |
+    `-------------*/
+    public:
+      /// Create a Chunker.
+      ///
+      /// @param input   The stream to split.
+      /// @param average The average chunk size, rounded down to a power of
+      ///                two. Chunks are a quarter to four times as large.
+      Chunker(std::istream& input, std::size_t average = 1024 * 1024);
+
+    /*---------.
+    | Chunking |
+    `---------*/
+    public:
+      /// The next chunk, or none once the stream is exhausted.
+      boost::optional<elle::Buffer>
+      next();
+      /// The size of the chunk starting at @a data.
+      ///
+      /// @param size The size of data available, which ends the chunk if
+      ///             no boundary is found before.
+      std::size_t
+      cut(uint8_t const* data, std::size_t size) const;
+      /// The offset of the next chunk in the stream.
+      ELLE_ATTRIBUTE_R(uint64_t, offset);
+      ELLE_ATTRIBUTE_R(std::size_t, minimum);
+      ELLE_ATTRIBUTE_R(std::size_t, average);
+      ELLE_ATTRIBUTE_R(std::size_t, maximum);
+    private:
+      /// Read until @a size bytes are buffered or the stream is exhausted.
+      void
+      _fill(std::size_t size);
+      ELLE_ATTRIBUTE(std::istream&, input);
+      /// The mask boundaries must match before the average size, harder to
+      /// match than the average.
+      ELLE_ATTRIBUTE(uint64_t, mask_small);
+      /// The mask boundaries must match after the average size, easier to
+      /// match than the average.
+      ELLE_ATTRIBUTE(uint64_t, mask_large);
+      /// Data read and not yet chunked, starting at `_start`.
+      ELLE_ATTRIBUTE(elle::Buffer, buffer);
+      ELLE_ATTRIBUTE(std::size_t, start);
+    };
+  }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <deque>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include <boost/signals2.hpp>
+
+#include <elle/Printable.hh>
+#include <elle/athena/paxos/Client.hh>
+#include <elle/attribute.hh>
+#include <elle/reactor/Barrier.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/signal.hh>
+
+namespace elle
+{
+  namespace athena
+  {
+    namespace paxos
+    {
+      /// Batch independent updates into consensus rounds.
+      ///
+      /// Updates submitted concurrently are gathered and chosen together as
+      /// one value, a vector of updates, for the next version. While a round
+      /// is in flight, new submissions accumulate for the next one: the
+      /// busier the group, the larger the batches, and a round decides as
+      /// many updates as were submitted during the previous one.
+      ///
+      /// Versions are decided one at a time, since servers only accept a
+      /// proposal for a version once the previous one is confirmed. If
+      /// another proposer's batch is chosen for a version, ours is retried
+      /// at the next one. Updates are decided, and submitters woken, in
+      /// submission order.
+      ///
+      /// A round that fails may still have had its batch accepted and later
+      /// completed by another proposer: the batch is retried at the same
+      /// version, with a backoff, until that version is decided, and is ours
+      /// if the value decided equals it. Updates must thus be equality
+      /// comparable, and distinct enough, e.g. carrying an identifier, that
+      /// another proposer's batch cannot be mistaken for ours. After
+      /// `max_attempts` failed rounds in a row, or on unexpected errors, the
+      /// submitters of the batch in flight fail with the last error. Pending
+      /// submitters fail too when the Batcher is destroyed.
+      ///
+      /// @code{.cc}
+      ///
+      /// paxos::Client<std::vector<Update>, int, int> client(id, peers);
+      /// client.lease(1s);
+      /// paxos::Batcher<Update, int, int> batcher(client);
+      /// // From any number of threads:
+      /// auto version = batcher.submit(update);
+      ///
+      /// @endcode
+      template <typename T, typename Version, typename ClientId>
+      class Batcher
+        : public elle::Printable
+      {
+      /*------.
+      | Types |
+      `------*/
+      public:
+        using Self = Batcher;
+        using Batch = std::vector<T>;
+        using Client = paxos::Client<Batch, Version, ClientId>;
+
+      /*-------------.
+      | Construction |
+      `-------------*/
+      public:
+        /// Create a Batcher.
+        ///
+        /// @param client    The client to choose batches with.
+        /// @param version   The first version to choose.
+        /// @param max_batch The maximum number of updates per batch.
+        Batcher(Client& client,
+                Version version = Version(),
+                int max_batch = 1024);
+        ~Batcher();
+
+      /*-----------.
+      | Submission |
+      `-----------*/
+      public:
+        /// Submit @a update and wait until it is decided.
+        ///
+        /// @returns The version @a update was decided at.
+        /// @throws The last error choosing its batch if it keeps failing, or
+        ///         any unexpected one, in which case @a update may or may not
+        ///         have been decided.
+        Version
+        submit(T update);
+        /// The next version to choose.
+        ELLE_ATTRIBUTE_R(Version, version);
+        /// The maximum number of updates per batch.
+        ELLE_ATTRIBUTE_RW(int, max_batch);
+        /// The number of failed rounds in a row before failing a batch.
+        ELLE_ATTRIBUTE_RW(int, max_attempts);
+        /// Batches decided, in version order, including other proposers'.
+        ELLE_ATTRIBUTE_RX(
+          (boost::signals2::signal<void (Version, Batch const&)>), decided);
+      private:
+        struct Submission
+        {
+          Submission(T update);
+          T update;
+          Version version;
+          std::exception_ptr error;
+          elle::reactor::Barrier done;
+        };
+        void
+        _run();
+        ELLE_ATTRIBUTE(Client&, client);
+        ELLE_ATTRIBUTE(std::deque<std::shared_ptr<Submission>>, pending);
+        ELLE_ATTRIBUTE(std::vector<std::shared_ptr<Submission>>, in_flight);
+        ELLE_ATTRIBUTE(elle::reactor::Signal, submitted);
+        ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr, thread);
+
+      /*----------.
+      | Printable |
+      `----------*/
+      public:
+        void
+        print(std::ostream& output) const override;
+      };
+    }
+  }
+}
+
+#include <elle/athena/paxos/Batcher.hxx>
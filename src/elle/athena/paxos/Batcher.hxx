@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+#include <elle/log.hh>
+#include <elle/reactor/exception.hh>
+#include <elle/reactor/scheduler.hh>
+
+namespace elle
+{
+  namespace athena
+  {
+    namespace paxos
+    {
+      /*-------------.
+      | Construction |
+      `-------------*/
+
+      template <typename T, typename Version, typename ClientId>
+      Batcher<T, Version, ClientId>::Batcher(Client& client,
+                                             Version version,
+                                             int max_batch)
+        : _version(std::move(version))
+        , _max_batch(max_batch)
+        , _max_attempts(8)
+        , _decided()
+        , _client(client)
+        , _pending()
+        , _in_flight()
+        , _submitted()
+        , _thread(new elle::reactor::Thread(
+                    elle::sprintf("%s", this), [this] { this->_run(); }))
+      {}
+
+      template <typename T, typename Version, typename ClientId>
+      Batcher<T, Version, ClientId>::~Batcher()
+      {
+        this->_thread.reset();
+        // Submitters outlive us: they must not wait forever.
+        auto const error = std::make_exception_ptr(
+          elle::Error(elle::sprintf("%s was destroyed", this)));
+        auto const fail = [&] (std::shared_ptr<Submission> const& s)
+          {
+            if (!s->done.opened())
+            {
+              s->error = error;
+              s->done.open();
+            }
+          };
+        for (auto const& s: this->_in_flight)
+          fail(s);
+        for (auto const& s: this->_pending)
+          fail(s);
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      Batcher<T, Version, ClientId>::Submission::Submission(T update_)
+        : update(std::move(update_))
+        , version()
+        , error()
+        , done("batch submission")
+      {}
+
+      /*-----------.
+      | Submission |
+      `-----------*/
+
+      template <typename T, typename Version, typename ClientId>
+      Version
+      Batcher<T, Version, ClientId>::submit(T update)
+      {
+        // Shared with the batching thread, in case we are terminated while
+        // our update is in flight.
+        auto submission = std::make_shared<Submission>(std::move(update));
+        this->_pending.emplace_back(submission);
+        this->_submitted.signal();
+        elle::reactor::wait(submission->done);
+        if (submission->error)
+          std::rethrow_exception(submission->error);
+        return submission->version;
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      void
+      Batcher<T, Version, ClientId>::_run()
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Batcher");
+        while (true)
+        {
+          while (this->_pending.empty())
+            elle::reactor::wait(this->_submitted);
+          auto const size =
+            std::min<std::size_t>(this->_pending.size(), this->_max_batch);
+          auto& submissions = this->_in_flight;
+          submissions.assign(
+            this->_pending.begin(), this->_pending.begin() + size);
+          this->_pending.erase(this->_pending.begin(),
+                               this->_pending.begin() + size);
+          auto batch = Batch{};
+          batch.reserve(size);
+          for (auto const& s: submissions)
+            batch.emplace_back(s->update);
+          ELLE_TRACE_SCOPE("%s: choose %s updates", this, size);
+          try
+          {
+            // Whether the batch may have been accepted by a failed round.
+            auto in_doubt = false;
+            auto attempts = 0;
+            auto backoff = 1;
+            while (true)
+            {
+              auto choice = boost::optional<typename Client::Choice>{};
+              try
+              {
+                choice.emplace(this->_client.choose(this->_version, batch));
+              }
+              catch (elle::Error const& e)
+              {
+                // The batch may have been chosen nonetheless: retry it at the
+                // same version until that version's outcome is known, or
+                // give up on persistent failures such as a lost quorum.
+                if (++attempts >= this->_max_attempts)
+                  throw;
+                auto const delay = std::chrono::milliseconds(100) * backoff;
+                ELLE_TRACE("%s: unable to choose batch at version %s, "
+                           "retry in %s: %s", this, this->_version, delay, e);
+                in_doubt = true;
+                elle::reactor::sleep(delay);
+                backoff = std::min(backoff * 2, 64);
+                continue;
+              }
+              attempts = 0;
+              backoff = 1;
+              auto const version = choice->proposal().version;
+              this->_version = version + 1;
+              // A batch accepted by a failed round comes back as the value
+              // to complete.
+              if (!*choice ||
+                  (in_doubt && (*choice)->template is<Batch>() &&
+                   (*choice)->template get<Batch>() == batch))
+              {
+                ELLE_DEBUG("%s: chose batch at version %s", this, version);
+                for (auto const& s: submissions)
+                {
+                  s->version = version;
+                  s->done.open();
+                }
+                this->_decided(version, batch);
+                break;
+              }
+              ELLE_DEBUG("%s: version %s was taken, retry", this, version);
+              in_doubt = false;
+              if ((*choice)->template is<Batch>())
+                this->_decided(version, (*choice)->template get<Batch>());
+            }
+          }
+          catch (elle::reactor::Terminate const&)
+          {
+            throw;
+          }
+          catch (...)
+          {
+            ELLE_WARN("%s: unable to choose batch: %s",
+                      this, elle::exception_string());
+            for (auto const& s: submissions)
+              if (!s->done.opened())
+              {
+                s->error = std::current_exception();
+                s->done.open();
+              }
+          }
+          submissions.clear();
+        }
+      }
+
+      /*----------.
+      | Printable |
+      `----------*/
+
+      template <typename T, typename Version, typename ClientId>
+      void
+      Batcher<T, Version, ClientId>::print(std::ostream& output) const
+      {
+        elle::fprintf(output, "paxos::Batcher(%s)", this->_client);
+      }
+    }
+  }
+}
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <set>
+
 #include <elle/Printable.hh>
+#include <elle/athena/paxos/Latency.hh>
 #include <elle/athena/paxos/Server.hh>
 #include <elle/attribute.hh>
 #include <elle/reactor/Barrier.hh>
@@ -80,7 +86,20 @@ namespace elle
           virtual
           boost::optional<Accepted>
           get(Quorum const& q) = 0;
+          /// Send \a Proposal to \a Quorum for all later versions too.
+          ///
+          /// Peers supporting Multi-Paxos forward it to Server::lead. The
+          /// default implementation throws.
+          ///
+          /// @param q The quorum the proposal is sent to.
+          /// @param p The proposal.
+          /// @param lease How long the leadership is requested for.
+          virtual
+          Response
+          lead(Quorum const& q, Proposal const& p, Duration lease);
           ELLE_ATTRIBUTE_R(ClientId, id);
+          /// The response times of this peer.
+          ELLE_ATTRIBUTE_RX(Latency, latency);
           /*----------.
           | Printable |
           `----------*/
@@ -104,6 +123,43 @@ namespace elle
         // FIXME: the W is there only for unit tests
         ELLE_ATTRIBUTE_RX(Peers, peers);
         ELLE_ATTRIBUTE_RW(bool, conflict_backoff);
+        /// Seed the randomization of conflict backoffs, for reproducible
+        /// runs.
+        void
+        seed(std::uint32_t seed);
+        /// Whether to end consensus phases once a majority answered.
+        ///
+        /// Peers that did not answer yet are abandoned, and every request is
+        /// bounded by the peer's adaptive timeout, so one slow peer does not
+        /// slow down every choice. Abandoned peers miss the acceptation and
+        /// confirmation of the value: they lag behind until they catch up on
+        /// a later version.
+        ELLE_ATTRIBUTE_RW(bool, early_return);
+        /// The lease to request leadership for, enabling Multi-Paxos.
+        ///
+        /// Once a choice is made, the client leads the later versions: it
+        /// skips the proposal phase, until the lease expires or another
+        /// proposer takes over, and then falls back to a classic round that
+        /// requests leadership again. Peers must implement Peer::lead.
+        ELLE_ATTRIBUTE_RW(boost::optional<Duration>, lease);
+        /// The proposal leadership was granted for, its version being the
+        /// next version the client may choose without a proposal phase.
+        ELLE_ATTRIBUTE_R(boost::optional<Proposal>, leadership);
+        /// The maximum rate at which the servers' clocks may run faster than
+        /// ours, e.g. 0.01 for 1%.
+        ///
+        /// Servers hold other proposers off until the lease expires by their
+        /// own clock: the leader only trusts its lease for local reads until
+        /// it expires by the slowest clock this bound allows.
+        ELLE_ATTRIBUTE_RW(double, clock_drift);
+      private:
+        ELLE_ATTRIBUTE(elle::Time, lease_end);
+        /// When reads may no longer be served locally.
+        ELLE_ATTRIBUTE(elle::Time, read_lease_end);
+        /// The latest value chosen as leader, unset while a choice is in
+        /// flight.
+        ELLE_ATTRIBUTE(boost::optional<T>, leased_value);
+        ELLE_ATTRIBUTE(std::mt19937, random);
 
         /*----------.
         | Consensus |
@@ -138,6 +194,10 @@ namespace elle
         choose(elle::_detail::attribute_r_t<Version> version,
                Value const& value);
         /// Get the latest chosen value.
+        ///
+        /// While the client holds a lease, no other proposer may choose a
+        /// value: the value it chose last is returned without consulting
+        /// the peers. Otherwise, read from a majority of peers.
         boost::optional<T>
         get();
         using State = das::tuple<
@@ -146,9 +206,40 @@ namespace elle
           decltype(proposal)::Formal<boost::optional<Proposal>>>;
         State
         state();
+        /// Whether the client holds a leadership lease.
+        bool
+        leading() const;
+        /// Whether get is served locally.
+        bool
+        reading() const;
         ELLE_ATTRIBUTE(int, round);
 
       private:
+        /// Choose \a value as leader, skipping the proposal phase.
+        ///
+        /// @returns The choice, or none if leadership was lost.
+        boost::optional<Choice>
+        _choose_leading(Quorum const& q,
+                        elle::_detail::attribute_r_t<Version> version,
+                        Value const& value);
+        /// Record \a value as chosen at \a proposal, as leader.
+        void
+        _lead(Proposal const& proposal,
+              Value const& value,
+              elle::Time lease_start);
+        /// Send the acceptation of \a value for \a proposal.
+        ///
+        /// @returns The conflicting proposal, if any.
+        boost::optional<Proposal>
+        _accept(Quorum const& q,
+                Proposal const& proposal,
+                Value const& value,
+                std::set<Peer*>& unavailables);
+        /// Send the confirmation of \a proposal.
+        void
+        _confirm(Quorum const& q,
+                 Proposal const& proposal,
+                 std::set<Peer*>& unavailables);
         /// Check a majority of members where reached.
         ///
         /// @param q The quorum we consult.
@@ -161,6 +252,20 @@ namespace elle
                          int reached,
                          std::exception_ptr weak_error,
                          bool reading) const;
+        /// Whether a phase may end with \a reached peers answering.
+        bool
+        _enough(Quorum const& q, int reached) const;
+        /// Skip peers that did not answer in the next phases.
+        void
+        _abandon(std::set<Peer*> const& answered,
+                 std::set<Peer*>& unavailables,
+                 elle::Time start);
+        /// Run \a action on \a peer, accounting for its response time.
+        ///
+        /// @throws Unavailable if \a peer times out.
+        template <typename Action>
+        void
+        _call(Peer& peer, Action const& action);
 
         /*----------.
         | Printable |
@@ -1,13 +1,20 @@
 #pragma once
 
+#include <chrono>
+
+#include <boost/optional.hpp>
 #include <boost/range/adaptor/filtered.hpp>
 
 #include <elle/With.hh>
 #include <elle/cryptography/random.hh>
+#include <elle/err.hh>
+#include <elle/finally.hh>
 #include <elle/find.hh>
 #include <elle/find_if.hh>
 #include <elle/max_element.hh>
 #include <elle/reactor/Scope.hh>
+#include <elle/reactor/TimeoutGuard.hh>
+#include <elle/reactor/exception.hh>
 #include <elle/reactor/for-each.hh>
 #include <elle/reactor/scheduler.hh>
 
@@ -24,8 +31,19 @@ namespace elle
       template <typename T, typename Version, typename ClientId>
       Client<T, Version, ClientId>::Peer::Peer(ClientId id)
         : _id(id)
+        , _latency()
       {}
 
+      template <typename T, typename Version, typename ClientId>
+      auto
+      Client<T, Version, ClientId>::Peer::lead(Quorum const& q,
+                                               Proposal const& p,
+                                               Duration lease)
+        -> Response
+      {
+        elle::err("%s does not support leadership", *this);
+      }
+
       template <typename T, typename Version, typename ClientId>
       void
       Client<T, Version, ClientId>::Peer::print(std::ostream& output) const
@@ -43,6 +61,14 @@ namespace elle
         : _id(id)
         , _peers(elle::make_vector<Peers>(std::forward<P>(peers)))
         , _conflict_backoff(true)
+        , _early_return(false)
+        , _lease()
+        , _leadership()
+        , _clock_drift(0.01)
+        , _lease_end()
+        , _read_lease_end()
+        , _leased_value()
+        , _random(elle::cryptography::random::generate<std::uint32_t>())
         , _round(0)
       {
         ELLE_ASSERT(!this->_peers.empty());
@@ -56,6 +82,13 @@ namespace elle
         this->_peers = elle::make_vector<Peers>(std::forward<P>(peers));
       }
 
+      template <typename T, typename Version, typename ClientId>
+      void
+      Client<T, Version, ClientId>::seed(std::uint32_t seed)
+      {
+        this->_random.seed(seed);
+      }
+
       class Unavailable
         : public elle::Error
       {
@@ -144,6 +177,63 @@ namespace elle
         }
       }
 
+      template <typename T, typename Version, typename ClientId>
+      bool
+      Client<T, Version, ClientId>::_enough(Quorum const& q, int reached) const
+      {
+        return this->_early_return && reached > signed(q.size()) / 2;
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      void
+      Client<T, Version, ClientId>::_abandon(
+        std::set<Peer*> const& answered,
+        std::set<Peer*>& unavailables,
+        elle::Time start)
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Client");
+        auto const elapsed = std::chrono::duration_cast<Duration>(
+          elle::reactor::now() - start);
+        // Peers abandoned before they answered must not be sent the next
+        // phase: they may not have seen this one.
+        for (auto const& peer: this->_peers)
+          if (!elle::find(answered, peer.get()) &&
+              unavailables.emplace(peer.get()).second)
+          {
+            ELLE_DEBUG("%s: abandon straggling peer %s", *this, peer);
+            peer->latency().straggled(elapsed);
+          }
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      template <typename Action>
+      void
+      Client<T, Version, ClientId>::_call(Peer& peer, Action const& action)
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Client");
+        auto const start = elle::reactor::now();
+        auto const elapsed = [&]
+          {
+            return std::chrono::duration_cast<Duration>(
+              elle::reactor::now() - start);
+          };
+        try
+        {
+          boost::optional<elle::reactor::TimeoutGuard> guard;
+          if (this->_early_return)
+            guard.emplace(peer.latency().timeout());
+          action();
+        }
+        catch (elle::reactor::Timeout const&)
+        {
+          ELLE_TRACE("%s: peer %s timed out after %s",
+                     *this, peer, peer.latency().timeout());
+          peer.latency().straggled(elapsed());
+          throw Unavailable();
+        }
+        peer.latency().sample(elapsed());
+      }
+
       template <typename T, typename Version, typename ClientId>
       auto
       Client<T, Version, ClientId>::choose(
@@ -158,6 +248,12 @@ namespace elle
         for (auto const& peer: this->_peers)
           q.insert(peer->id());
         ELLE_DUMP("quorum: %f", q);
+        // Peers may learn about the new value before we do: stop serving
+        // the previous one.
+        this->_leased_value.reset();
+        if (this->leading() && !(version < this->_leadership->version))
+          if (auto res = this->_choose_leading(q, version, value))
+            return std::move(*res);
         boost::optional<Value> replace;
         while (true)
         {
@@ -165,21 +261,35 @@ namespace elle
           std::set<Peer*> unavailables;
           auto const proposal =
             Proposal(std::move(version), this->_round, this->_id);
+          auto const lease_start = elle::reactor::now();
           ELLE_DEBUG("%s: send proposal: %s", *this, proposal)
           {
             int reached = 0;
             std::exception_ptr weak_error;
-            auto responses = elle::reactor::for_each_parallel(
+            auto responses = std::vector<Response>{};
+            auto answered = std::set<Peer*>{};
+            auto const start = elle::reactor::now();
+            elle::reactor::for_each_parallel(
               this->_peers,
-              [&] (std::unique_ptr<Peer>& peer)
+              [&] (std::unique_ptr<Peer>& peer) -> void
               {
                 try
                 {
                   ELLE_DEBUG_SCOPE("%s: send proposal %s to %s",
                                    *this, proposal, peer);
-                  auto response = peer->propose(q, proposal);
+                  this->_call(
+                    *peer,
+                    [&]
+                    {
+                      responses.emplace_back(
+                        this->_lease ?
+                        peer->lead(q, proposal, *this->_lease) :
+                        peer->propose(q, proposal));
+                    });
+                  answered.emplace(peer.get());
                   ++reached;
-                  return response;
+                  if (this->_enough(q, reached))
+                    elle::reactor::break_parallel();
                 }
                 catch (Unavailable const& e)
                 {
@@ -195,9 +305,9 @@ namespace elle
                   if (!weak_error)
                     weak_error = e.exception();
                 }
-                elle::reactor::continue_parallel();
               },
               std::string("send proposal"));
+            this->_abandon(answered, unavailables, start);
             ELLE_DUMP("proposal responses: {}", responses);
             auto const confirmed = [] (Response const& r)
               {
@@ -249,104 +359,33 @@ namespace elle
                 }
               }
           }
-          ELLE_DEBUG("%s: send acceptation", *this)
+          if (auto conflict =
+              this->_accept(q, proposal, replace ? *replace : value,
+                            unavailables))
           {
-            int reached = 0;
-            bool conflicted = false;
-            std::exception_ptr weak_error;
-            elle::reactor::for_each_parallel(
-              this->_peers,
-              [&] (std::unique_ptr<Peer> const& peer) -> void
-              {
-                if (elle::find(unavailables, peer.get()))
-                  return;
-                try
-                {
-                  ELLE_DEBUG_SCOPE("%s: send acceptation %s to %s",
-                                   *this, proposal, *peer);
-                  auto minimum = peer->accept(
-                    q, proposal, replace ? *replace : value);
-                  // FIXME: If the majority doesn't conflict, the value was
-                  // still chosen - right ? Take that in account.
-                  if (proposal < minimum)
-                  {
-                    ELLE_DEBUG("%s: conflicted proposal on peer %s: %s",
-                               *this, peer, minimum);
-                    version = minimum.version;
-                    this->_round = minimum.round;
-                    conflicted = true;
-                    elle::reactor::break_parallel();
-                  }
-                  ++reached;
-                }
-                catch (Unavailable const& e)
-                {
-                  ELLE_TRACE("%s: peer %s unavailable: %s",
-                             *this, peer, e.what());
-                  unavailables.emplace(peer.get());
-                }
-                catch (WeakError const& e)
-                {
-                  ELLE_TRACE("%s: peer %s weak error: %s",
-                             *this, peer, e.what());
-                  unavailables.emplace(peer.get());
-                  if (!weak_error)
-                    weak_error = e.exception();
-                }
-              },
-              std::string("send acceptation"));
-            if (conflicted)
+            version = conflict->version;
+            this->_round = conflict->round;
+            auto rn = std::uniform_int_distribution<int>(1, 8)(this->_random);
+            auto delay = 100ms * rn * backoff;
+            if (this->_conflict_backoff)
             {
-              auto rn = elle::cryptography::random::generate<uint8_t>(1, 8);
-              auto delay = 100ms * rn * backoff;
-              if (this->_conflict_backoff)
-              {
-                ELLE_TRACE("%s: conflicted proposal, retry in %s", this, delay);
-                elle::reactor::sleep(delay);
-              }
-              else
-                ELLE_TRACE("%s: conflicted proposal, retry", this);
-              backoff = std::min(backoff * 2, 64);
-              continue;
+              ELLE_TRACE("%s: conflicted proposal, retry in %s", this, delay);
+              elle::reactor::sleep(delay);
             }
             else
-              this->_check_headcount(q, reached, weak_error, false);
+              ELLE_TRACE("%s: conflicted proposal, retry", this);
+            backoff = std::min(backoff * 2, 64);
+            continue;
           }
           ELLE_TRACE("%s: chose %f", this, replace ? *replace : value);
-          ELLE_DEBUG("%s: send confirmation", *this)
+          this->_confirm(q, proposal, unavailables);
+          if (this->_lease)
           {
-            auto reached = 0;
-            std::exception_ptr weak_error;
-            elle::reactor::for_each_parallel(
-              this->_peers,
-              [&] (std::unique_ptr<Peer> const& peer) -> void
-              {
-                if (elle::find(unavailables, peer.get()))
-                  return;
-                try
-                {
-                  ELLE_DEBUG_SCOPE("%s: send confirmation %s to %s",
-                                   *this, proposal, *peer);
-                  peer->confirm(q, proposal);
-                  ++reached;
-                }
-                catch (Unavailable const& e)
-                {
-                  ELLE_TRACE("%s: peer %s unavailable: %s",
-                             *this, peer, e.what());
-                  unavailables.emplace(peer.get());
-                }
-                catch (WeakError const& e)
-                {
-                  ELLE_TRACE("%s: peer %s weak error: %s",
-                             *this, peer, e.what());
-                  unavailables.emplace(peer.get());
-                  if (!weak_error)
-                    weak_error = e.exception();
-                }
-              },
-              std::string("send confirmation"));
-            this->_check_headcount(q, reached, weak_error, false);
+            ELLE_TRACE("%s: lead from version %s for %s",
+                       this, proposal.version, *this->_lease);
+            this->_leadership.emplace(
+              proposal.version + 1, proposal.round, proposal.sender);
+            this->_lead(proposal, replace ? *replace : value, lease_start);
           }
           if (replace)
             return Choice(proposal, *replace);
@@ -355,10 +394,187 @@ namespace elle
         }
       }
 
+      template <typename T, typename Version, typename ClientId>
+      bool
+      Client<T, Version, ClientId>::leading() const
+      {
+        return this->_leadership &&
+          elle::reactor::now() < this->_lease_end;
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      bool
+      Client<T, Version, ClientId>::reading() const
+      {
+        return this->_leadership && this->_leased_value &&
+          elle::reactor::now() < this->_read_lease_end;
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      void
+      Client<T, Version, ClientId>::_lead(
+        Proposal const& proposal,
+        Value const& value,
+        elle::Time lease_start)
+      {
+        this->_lease_end = lease_start + *this->_lease;
+        this->_read_lease_end = lease_start +
+          std::chrono::duration_cast<Duration>(
+            *this->_lease * (1 - this->_clock_drift));
+        // A quorum change does not tell the current value.
+        if (value.template is<T>())
+          this->_leased_value = value.template get<T>();
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      auto
+      Client<T, Version, ClientId>::_choose_leading(
+        Quorum const& q,
+        elle::_detail::attribute_r_t<Version> version,
+        Value const& value)
+        -> boost::optional<Choice>
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Client");
+        auto const proposal = Proposal(
+          version, this->_leadership->round, this->_leadership->sender);
+        ELLE_TRACE_SCOPE("%s: skip proposal as leader: %s", *this, proposal);
+        std::set<Peer*> unavailables;
+        // Any failure may leave the value accepted by some peers: the same
+        // proposal must not be sent again with another value.
+        elle::SafeFinally lost([&] { this->_leadership.reset(); });
+        if (auto conflict = this->_accept(q, proposal, value, unavailables))
+        {
+          ELLE_TRACE("%s: leadership lost to %s", *this, *conflict);
+          this->_round = std::max(this->_round, conflict->round);
+          return boost::none;
+        }
+        this->_confirm(q, proposal, unavailables);
+        lost.abort();
+        this->_leadership->version = version + 1;
+        if (value.template is<T>())
+          this->_leased_value = value.template get<T>();
+        return Choice(proposal);
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      auto
+      Client<T, Version, ClientId>::_accept(Quorum const& q,
+                                            Proposal const& proposal,
+                                            Value const& value,
+                                            std::set<Peer*>& unavailables)
+        -> boost::optional<Proposal>
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Client");
+        ELLE_DEBUG_SCOPE("%s: send acceptation", *this);
+        int reached = 0;
+        boost::optional<Proposal> conflict;
+        std::exception_ptr weak_error;
+        auto answered = std::set<Peer*>{};
+        auto const start = elle::reactor::now();
+        elle::reactor::for_each_parallel(
+          this->_peers,
+          [&] (std::unique_ptr<Peer> const& peer) -> void
+          {
+            if (elle::find(unavailables, peer.get()))
+              return;
+            try
+            {
+              ELLE_DEBUG_SCOPE("%s: send acceptation %s to %s",
+                               *this, proposal, *peer);
+              auto minimum = Proposal();
+              this->_call(
+                *peer,
+                [&] { minimum = peer->accept(q, proposal, value); });
+              // FIXME: If the majority doesn't conflict, the value was
+              // still chosen - right ? Take that in account.
+              if (proposal < minimum)
+              {
+                ELLE_DEBUG("%s: conflicted proposal on peer %s: %s",
+                           *this, peer, minimum);
+                conflict = minimum;
+                elle::reactor::break_parallel();
+              }
+              answered.emplace(peer.get());
+              ++reached;
+              if (this->_enough(q, reached))
+                elle::reactor::break_parallel();
+            }
+            catch (Unavailable const& e)
+            {
+              ELLE_TRACE("%s: peer %s unavailable: %s",
+                         *this, peer, e.what());
+              unavailables.emplace(peer.get());
+            }
+            catch (WeakError const& e)
+            {
+              ELLE_TRACE("%s: peer %s weak error: %s",
+                         *this, peer, e.what());
+              unavailables.emplace(peer.get());
+              if (!weak_error)
+                weak_error = e.exception();
+            }
+          },
+          std::string("send acceptation"));
+        this->_abandon(answered, unavailables, start);
+        if (!conflict)
+          this->_check_headcount(q, reached, weak_error, false);
+        return conflict;
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      void
+      Client<T, Version, ClientId>::_confirm(Quorum const& q,
+                                             Proposal const& proposal,
+                                             std::set<Peer*>& unavailables)
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Client");
+        ELLE_DEBUG_SCOPE("%s: send confirmation", *this);
+        auto reached = 0;
+        std::exception_ptr weak_error;
+        elle::reactor::for_each_parallel(
+          this->_peers,
+          [&] (std::unique_ptr<Peer> const& peer) -> void
+          {
+            if (elle::find(unavailables, peer.get()))
+              return;
+            try
+            {
+              ELLE_DEBUG_SCOPE("%s: send confirmation %s to %s",
+                               *this, proposal, *peer);
+              this->_call(*peer, [&] { peer->confirm(q, proposal); });
+              ++reached;
+              if (this->_enough(q, reached))
+                elle::reactor::break_parallel();
+            }
+            catch (Unavailable const& e)
+            {
+              ELLE_TRACE("%s: peer %s unavailable: %s",
+                         *this, peer, e.what());
+              unavailables.emplace(peer.get());
+            }
+            catch (WeakError const& e)
+            {
+              ELLE_TRACE("%s: peer %s weak error: %s",
+                         *this, peer, e.what());
+              unavailables.emplace(peer.get());
+              if (!weak_error)
+                weak_error = e.exception();
+            }
+          },
+          std::string("send confirmation"));
+        this->_check_headcount(q, reached, weak_error, false);
+      }
+
       template <typename T, typename Version, typename ClientId>
       boost::optional<T>
       Client<T, Version, ClientId>::get()
       {
+        ELLE_LOG_COMPONENT("athena.paxos.Client");
+        if (this->reading())
+        {
+          ELLE_DEBUG("%s: read value under lease", *this);
+          return this->_leased_value;
+        }
         return this->state().value;
       }
 
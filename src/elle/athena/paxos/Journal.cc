@@ -0,0 +1,211 @@
+#include <elle/athena/paxos/Journal.hh>
+
+#include <cerrno>
+#include <cstring>
+#include <istream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef ELLE_WINDOWS
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+#include <boost/crc.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <elle/err.hh>
+#include <elle/printf.hh>
+
+namespace elle
+{
+  namespace athena
+  {
+    namespace paxos
+    {
+      namespace _details
+      {
+        namespace journal
+        {
+          namespace
+          {
+            // Frame header: payload size, checksum, sequence number. Integers
+            // are stored in host byte order, journals being local.
+            auto const header_size = 2 * sizeof(std::uint32_t) +
+              sizeof(std::uint64_t);
+            auto const max_size = std::uint32_t(1) << 30;
+
+            std::uint32_t
+            checksum(std::uint64_t sequence, elle::ConstWeakBuffer payload)
+            {
+              boost::crc_32_type crc;
+              crc.process_bytes(&sequence, sizeof(sequence));
+              crc.process_bytes(payload.contents(), payload.size());
+              return crc.checksum();
+            }
+
+            [[noreturn]]
+            void
+            fail(std::string const& action)
+            {
+              elle::err("unable to %s: %s", action, std::strerror(errno));
+            }
+
+            void
+            sync(int fd)
+            {
+#ifdef ELLE_WINDOWS
+              if (::_commit(fd) != 0)
+#else
+              if (::fsync(fd) != 0)
+#endif
+                fail("sync journal");
+            }
+
+            void
+            write_all(int fd, elle::ConstWeakBuffer data)
+            {
+              auto p = data.contents();
+              auto size = data.size();
+              while (size)
+              {
+                auto const written = ::write(fd, p, size);
+                if (written < 0)
+                {
+                  if (errno == EINTR)
+                    continue;
+                  fail("write journal");
+                }
+                p += written;
+                size -= written;
+              }
+            }
+          }
+
+          void
+          frame(elle::Buffer& output,
+                std::uint64_t sequence,
+                elle::ConstWeakBuffer payload)
+          {
+            auto const size = std::uint32_t(payload.size());
+            auto const crc = checksum(sequence, payload);
+            output.append(&size, sizeof(size));
+            output.append(&crc, sizeof(crc));
+            output.append(&sequence, sizeof(sequence));
+            output.append(payload.contents(), payload.size());
+          }
+
+          bool
+          unframe(std::istream& input,
+                  std::uint64_t& sequence,
+                  elle::Buffer& payload)
+          {
+            char header[header_size];
+            if (!input.read(header, header_size))
+              return false;
+            auto size = std::uint32_t(0);
+            auto crc = std::uint32_t(0);
+            std::memcpy(&size, header, sizeof(size));
+            std::memcpy(&crc, header + sizeof(size), sizeof(crc));
+            std::memcpy(&sequence, header + sizeof(size) + sizeof(crc),
+                        sizeof(sequence));
+            // A corrupted size must not exhaust memory.
+            if (size > max_size)
+              return false;
+            payload.size(size);
+            if (!input.read(reinterpret_cast<char*>(payload.mutable_contents()),
+                            size))
+              return false;
+            return checksum(sequence, payload) == crc;
+          }
+
+          int
+          open(boost::filesystem::path const& path)
+          {
+#ifdef ELLE_WINDOWS
+            auto const fd = ::_open(path.string().c_str(),
+                                    _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY,
+                                    _S_IREAD | _S_IWRITE);
+#else
+            auto const fd = ::open(path.string().c_str(),
+                                   O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                                   0600);
+#endif
+            if (fd < 0)
+              fail(elle::sprintf("open %s", path));
+            return fd;
+          }
+
+          void
+          close(int fd)
+          {
+            ::close(fd);
+          }
+
+          void
+          write(int fd, elle::ConstWeakBuffer data)
+          {
+            write_all(fd, data);
+            sync(fd);
+          }
+
+          void
+          truncate(int fd)
+          {
+#ifdef ELLE_WINDOWS
+            if (::_chsize(fd, 0) != 0)
+#else
+            if (::ftruncate(fd, 0) != 0)
+#endif
+              fail("truncate journal");
+            sync(fd);
+          }
+
+          void
+          replace(boost::filesystem::path const& path,
+                  elle::ConstWeakBuffer data)
+          {
+            auto tmp = path;
+            tmp += ".tmp";
+#ifdef ELLE_WINDOWS
+            auto const fd = ::_open(tmp.string().c_str(),
+                                    _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                                    _S_IREAD | _S_IWRITE);
+#else
+            auto const fd = ::open(tmp.string().c_str(),
+                                   O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                                   0600);
+#endif
+            if (fd < 0)
+              fail(elle::sprintf("open %s", tmp));
+            try
+            {
+              write(fd, data);
+            }
+            catch (...)
+            {
+              ::close(fd);
+              throw;
+            }
+            ::close(fd);
+            auto error = boost::system::error_code{};
+            boost::filesystem::rename(tmp, path, error);
+            if (error)
+              elle::err("unable to rename %s to %s: %s",
+                        tmp, path, error.message());
+#ifndef ELLE_WINDOWS
+            // Make the rename itself durable.
+            auto const dir = ::open(path.parent_path().string().c_str(),
+                                    O_RDONLY | O_CLOEXEC);
+            if (dir < 0)
+              fail(elle::sprintf("open %s", path.parent_path()));
+            ::fsync(dir);
+            ::close(dir);
+#endif
+          }
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <iosfwd>
+
+#include <boost/filesystem/path.hpp>
+
+#include <elle/Buffer.hh>
+#include <elle/Printable.hh>
+#include <elle/athena/paxos/Server.hh>
+#include <elle/attribute.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/signal.hh>
+
+namespace elle
+{
+  namespace athena
+  {
+    namespace paxos
+    {
+      /// Persist a Server incrementally.
+      ///
+      /// Every change of the server state is appended to a log as a Record,
+      /// and the server only answers once its record is durable. Records
+      /// made while the log is being synced are written and synced together
+      /// by the next sync: concurrent changes share the cost of an fsync.
+      ///
+      /// Once the log holds compaction_threshold records, the whole server
+      /// is written to a snapshot and the log is truncated. On opening, the
+      /// server is recovered from the latest snapshot, and the records
+      /// logged after it are replayed.
+      ///
+      /// The journal directory holds:
+      /// - snapshot: the latest snapshot, replaced atomically.
+      /// - log:      the records since that snapshot.
+      ///
+      /// @code{.cc}
+      ///
+      /// paxos::Journal<T, int, int> journal(
+      ///   path, paxos::Server<T, int, int>(id, quorum));
+      /// auto& server = journal.server();
+      ///
+      /// @endcode
+      template <typename T,
+                typename Version,
+                typename ClientId,
+                typename ServerId = ClientId>
+      class Journal
+        : public elle::Printable
+      {
+      /*------.
+      | Types |
+      `------*/
+      public:
+        using Self = Journal;
+        using Server = paxos::Server<T, Version, ClientId, ServerId>;
+        using Record = typename Server::Record;
+
+      /*-------------.
+      | Construction |
+      `-------------*/
+      public:
+        /// Open the journal in @a path, creating it if needed.
+        ///
+        /// @param path   The journal directory.
+        /// @param server The server to journal if @a path holds no
+        ///               snapshot yet. Its version is the serialization
+        ///               version of the journal.
+        Journal(boost::filesystem::path path, Server server);
+        ~Journal();
+
+      /*--------.
+      | Journal |
+      `--------*/
+      public:
+        /// Snapshot the server and truncate the log.
+        void
+        snapshot();
+        ELLE_ATTRIBUTE_R(boost::filesystem::path, path);
+        /// The journaled server.
+        ELLE_ATTRIBUTE_RX(Server, server);
+        /// The number of records past which the log is compacted.
+        ELLE_ATTRIBUTE_RW(int, compaction_threshold);
+        /// The number of records in the log.
+        ELLE_ATTRIBUTE_R(int, records);
+        /// The number of log syncs.
+        ELLE_ATTRIBUTE_R(int, syncs);
+      private:
+        void
+        _recover();
+        void
+        _append(Record const& record);
+        void
+        _write();
+        void
+        _snapshot();
+        /// The sequence number of the latest record.
+        ELLE_ATTRIBUTE(std::uint64_t, sequence);
+        /// The sequence number of the latest durable record.
+        ELLE_ATTRIBUTE(std::uint64_t, durable);
+        /// Records not written yet.
+        ELLE_ATTRIBUTE(elle::Buffer, pending);
+        ELLE_ATTRIBUTE(int, pending_records);
+        ELLE_ATTRIBUTE(bool, compact);
+        ELLE_ATTRIBUTE(std::exception_ptr, error);
+        ELLE_ATTRIBUTE(int, log);
+        ELLE_ATTRIBUTE(elle::reactor::Signal, appended);
+        ELLE_ATTRIBUTE(elle::reactor::Signal, synced);
+        ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr, writer);
+
+      /*----------.
+      | Printable |
+      `----------*/
+      public:
+        void
+        print(std::ostream& output) const override;
+      };
+
+      namespace _details
+      {
+        namespace journal
+        {
+          /// Append a frame holding @a sequence and @a payload to @a output.
+          ///
+          /// Frames are checksummed, so a torn write is detected on reading.
+          void
+          frame(elle::Buffer& output,
+                std::uint64_t sequence,
+                elle::ConstWeakBuffer payload);
+          /// Read the next frame from @a input.
+          ///
+          /// @returns false at the end of @a input, or at a truncated or
+          ///          corrupted frame.
+          bool
+          unframe(std::istream& input,
+                  std::uint64_t& sequence,
+                  elle::Buffer& payload);
+          /// Open @a path for appending, creating it if needed.
+          int
+          open(boost::filesystem::path const& path);
+          void
+          close(int fd);
+          /// Write @a data to @a fd and sync it to disk.
+          void
+          write(int fd, elle::ConstWeakBuffer data);
+          /// Truncate @a fd and sync it to disk.
+          void
+          truncate(int fd);
+          /// Write @a data to @a path atomically and durably.
+          void
+          replace(boost::filesystem::path const& path,
+                  elle::ConstWeakBuffer data);
+        }
+      }
+    }
+  }
+}
+
+#include <elle/athena/paxos/Journal.hxx>
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <memory>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <elle/err.hh>
+#include <elle/log.hh>
+#include <elle/serialization/binary.hh>
+
+#include <elle/reactor/scheduler.hh>
+
+namespace elle
+{
+  namespace athena
+  {
+    namespace paxos
+    {
+      /*-------------.
+      | Construction |
+      `-------------*/
+
+      template <typename T, typename Version, typename CId, typename SId>
+      Journal<T, Version, CId, SId>::Journal(boost::filesystem::path path,
+                                             Server server)
+        : _path(std::move(path))
+        , _server(std::move(server))
+        , _compaction_threshold(1024)
+        , _records(0)
+        , _syncs(0)
+        , _sequence(0)
+        , _durable(0)
+        , _pending()
+        , _pending_records(0)
+        , _compact(false)
+        , _error()
+        , _log(-1)
+        , _appended()
+        , _synced()
+        , _writer()
+      {
+        boost::filesystem::create_directories(this->_path);
+        this->_recover();
+        this->_log = _details::journal::open(this->_path / "log");
+        this->_server.journal(
+          [this] (Record const& record) { this->_append(record); });
+        this->_writer.reset(
+          new elle::reactor::Thread(
+            elle::sprintf("%s writer", this), [this] { this->_write(); }));
+      }
+
+      template <typename T, typename Version, typename CId, typename SId>
+      Journal<T, Version, CId, SId>::~Journal()
+      {
+        this->_writer.reset();
+        this->_server.journal(nullptr);
+        if (this->_log != -1)
+          _details::journal::close(this->_log);
+      }
+
+      /*--------.
+      | Journal |
+      `--------*/
+
+      template <typename T, typename Version, typename CId, typename SId>
+      void
+      Journal<T, Version, CId, SId>::_recover()
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Journal");
+        ELLE_TRACE_SCOPE("%s: recover", this);
+        auto const version = this->_server.version();
+        auto ctx = elle::serialization::Context{};
+        ctx.set<elle::Version>(version);
+        auto payload = elle::Buffer{};
+        {
+          boost::filesystem::ifstream input(
+            this->_path / "snapshot", std::ios::binary);
+          if (input)
+          {
+            if (!_details::journal::unframe(input, this->_sequence, payload))
+              elle::err("%s: corrupted snapshot", this);
+            this->_server = elle::serialization::binary::deserialize<Server>(
+              payload, true, ctx);
+            ELLE_DEBUG("%s: recovered snapshot at record %s",
+                       this, this->_sequence);
+          }
+        }
+        auto const log = this->_path / "log";
+        auto valid = std::streamoff(0);
+        {
+          boost::filesystem::ifstream input(log, std::ios::binary);
+          auto sequence = std::uint64_t(0);
+          while (_details::journal::unframe(input, sequence, payload))
+          {
+            valid = input.tellg();
+            // Records made while a snapshot was written, or logged before a
+            // snapshot whose log truncation was interrupted.
+            if (sequence <= this->_sequence)
+              continue;
+            auto record = elle::serialization::binary::deserialize<Record>(
+              payload, true, ctx);
+            this->_server.replay(record);
+            this->_sequence = sequence;
+            ++this->_records;
+          }
+        }
+        if (boost::filesystem::exists(log) &&
+            boost::filesystem::file_size(log) != std::uintmax_t(valid))
+        {
+          ELLE_WARN("%s: drop torn log tail after %s bytes", this, valid);
+          boost::filesystem::resize_file(log, valid);
+        }
+        this->_durable = this->_sequence;
+        ELLE_TRACE("%s: replayed %s records", this, this->_records);
+      }
+
+      template <typename T, typename Version, typename CId, typename SId>
+      void
+      Journal<T, Version, CId, SId>::_append(Record const& record)
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Journal");
+        if (this->_error)
+          std::rethrow_exception(this->_error);
+        auto const payload = elle::serialization::binary::serialize(
+          record, this->_server.version(), true);
+        auto const sequence = ++this->_sequence;
+        _details::journal::frame(this->_pending, sequence, payload);
+        ++this->_pending_records;
+        this->_appended.signal();
+        ELLE_DEBUG("%s: wait for record %s to be durable", this, sequence);
+        while (this->_durable < sequence)
+        {
+          elle::reactor::wait(this->_synced);
+          if (this->_error)
+            std::rethrow_exception(this->_error);
+        }
+      }
+
+      template <typename T, typename Version, typename CId, typename SId>
+      void
+      Journal<T, Version, CId, SId>::snapshot()
+      {
+        auto const sequence = this->_sequence;
+        this->_compact = true;
+        this->_appended.signal();
+        while (this->_compact || this->_durable < sequence)
+        {
+          elle::reactor::wait(this->_synced);
+          if (this->_error)
+            std::rethrow_exception(this->_error);
+        }
+      }
+
+      template <typename T, typename Version, typename CId, typename SId>
+      void
+      Journal<T, Version, CId, SId>::_write()
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Journal");
+        try
+        {
+          while (true)
+          {
+            while (!this->_pending_records && !this->_compact)
+              elle::reactor::wait(this->_appended);
+            if (this->_compact ||
+                this->_records + this->_pending_records >=
+                this->_compaction_threshold)
+            {
+              this->_snapshot();
+              continue;
+            }
+            auto data = std::move(this->_pending);
+            this->_pending = elle::Buffer();
+            auto const sequence = this->_sequence;
+            auto const records = this->_pending_records;
+            this->_pending_records = 0;
+            ELLE_DEBUG_SCOPE("%s: sync %s records (%s bytes)",
+                             this, records, data.size());
+            // Shared with the system thread, in case we are terminated.
+            auto const shared =
+              std::make_shared<elle::Buffer>(std::move(data));
+            auto const fd = this->_log;
+            elle::reactor::background(
+              [fd, shared] { _details::journal::write(fd, *shared); });
+            ++this->_syncs;
+            this->_records += records;
+            this->_durable = sequence;
+            this->_synced.signal();
+          }
+        }
+        catch (elle::Error const& e)
+        {
+          ELLE_ERR("%s: unable to write journal: %s", this, e);
+          this->_error = std::current_exception();
+          this->_synced.signal();
+        }
+      }
+
+      template <typename T, typename Version, typename CId, typename SId>
+      void
+      Journal<T, Version, CId, SId>::_snapshot()
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Journal");
+        // Records are appended right after the change they describe: the
+        // server state matches the latest record, and pending records are
+        // covered by the snapshot.
+        auto const sequence = this->_sequence;
+        auto const payload = elle::serialization::binary::serialize(
+          this->_server, this->_server.version(), true);
+        auto data = elle::Buffer{};
+        _details::journal::frame(data, sequence, payload);
+        this->_pending = elle::Buffer();
+        this->_pending_records = 0;
+        this->_compact = false;
+        ELLE_TRACE_SCOPE("%s: snapshot at record %s (%s bytes)",
+                         this, sequence, data.size());
+        auto const shared = std::make_shared<elle::Buffer>(std::move(data));
+        auto const path = this->_path / "snapshot";
+        auto const fd = this->_log;
+        elle::reactor::background(
+          [path, fd, shared]
+          {
+            _details::journal::replace(path, *shared);
+            // Records logged since are written after the truncation.
+            _details::journal::truncate(fd);
+          });
+        ++this->_syncs;
+        this->_records = 0;
+        this->_durable = sequence;
+        this->_synced.signal();
+      }
+
+      /*----------.
+      | Printable |
+      `----------*/
+
+      template <typename T, typename Version, typename CId, typename SId>
+      void
+      Journal<T, Version, CId, SId>::print(std::ostream& output) const
+      {
+        elle::fprintf(output, "paxos::Journal(%s)", this->_path);
+      }
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#include <elle/athena/paxos/Latency.hh>
+
+#include <algorithm>
+
+#include <elle/printf.hh>
+
+namespace elle
+{
+  namespace athena
+  {
+    namespace paxos
+    {
+      /*-------------.
+      | Construction |
+      `-------------*/
+
+      Latency::Latency(Duration minimum, Duration maximum)
+        : _mean(0)
+        , _deviation(0)
+        , _samples(0)
+        , _stragglers(0)
+        , _minimum(minimum)
+        , _maximum(maximum)
+      {}
+
+      /*-----------.
+      | Statistics |
+      `-----------*/
+
+      void
+      Latency::sample(Duration duration)
+      {
+        if (this->_samples++ == 0)
+        {
+          this->_mean = duration;
+          this->_deviation = duration / 2;
+        }
+        else
+        {
+          // RFC 6298 gains: 1/8 for the mean, 1/4 for the deviation.
+          auto const error = duration - this->_mean;
+          auto const distance = error < Duration(0) ? -error : error;
+          this->_deviation += (distance - this->_deviation) / 4;
+          this->_mean += error / 8;
+        }
+      }
+
+      void
+      Latency::straggled(Duration duration)
+      {
+        ++this->_stragglers;
+        if (this->_samples && duration > this->_mean)
+          this->sample(duration);
+      }
+
+      Duration
+      Latency::timeout() const
+      {
+        if (!this->_samples)
+          return this->_maximum;
+        return std::min(
+          std::max(this->_mean + 4 * this->_deviation, this->_minimum),
+          this->_maximum);
+      }
+
+      /*----------.
+      | Printable |
+      `----------*/
+
+      void
+      Latency::print(std::ostream& output) const
+      {
+        elle::fprintf(output, "Latency(%s +/- %s, %s samples)",
+                      this->_mean, this->_deviation, this->_samples);
+      }
+    }
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <elle/Duration.hh>
+#include <elle/Printable.hh>
+#include <elle/attribute.hh>
+
+namespace elle
+{
+  namespace athena
+  {
+    namespace paxos
+    {
+      /// The response time statistics of a peer.
+      ///
+      /// Keep a smoothed mean and mean deviation of response times, the way
+      /// TCP estimates round trip times, to derive a timeout adapted to the
+      /// peer: slow but steady peers get more time, fast ones are given up
+      /// on sooner.
+      class Latency
+        : public elle::Printable
+      {
+      /*------.
+      | Types |
+      `------*/
+      public:
+        using Self = Latency;
+
+      /*-------------.
+      | Construction |
+      `-------------*/
+      public:
+        /// Create statistics without any sample.
+        ///
+        /// @param minimum The lowest timeout.
+        /// @param maximum The highest timeout, and the timeout of a peer
+        ///                without any sample.
+        Latency(Duration minimum = 500ms, Duration maximum = 30s);
+
+      /*-----------.
+      | Statistics |
+      `-----------*/
+      public:
+        /// Account for a response received after @a duration.
+        void
+        sample(Duration duration);
+        /// Account for a request abandoned after @a duration.
+        ///
+        /// The response time is at least @a duration: it only counts if it
+        /// raises the estimation.
+        void
+        straggled(Duration duration);
+        /// The time to wait for a response before deeming the peer
+        /// unavailable.
+        Duration
+        timeout() const;
+        /// The smoothed mean response time.
+        ELLE_ATTRIBUTE_R(Duration, mean);
+        /// The smoothed mean deviation of response times.
+        ELLE_ATTRIBUTE_R(Duration, deviation);
+        /// The number of responses accounted for.
+        ELLE_ATTRIBUTE_R(int, samples);
+        /// The number of requests abandoned.
+        ELLE_ATTRIBUTE_R(int, stragglers);
+        ELLE_ATTRIBUTE_RW(Duration, minimum);
+        ELLE_ATTRIBUTE_RW(Duration, maximum);
+
+      /*----------.
+      | Printable |
+      `----------*/
+      public:
+        void
+        print(std::ostream& output) const override;
+      };
+    }
+  }
+}
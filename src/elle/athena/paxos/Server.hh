@@ -1,11 +1,14 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <unordered_set>
 
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
 
+#include <elle/Duration.hh>
 #include <elle/Error.hh>
 #include <elle/Option.hh>
 #include <elle/Printable.hh>
@@ -192,6 +195,48 @@ namespace elle
         static const elle::serialization::Hierarchy<elle::Exception>::
         Register<PartialState> _register_partial_state_serialization;
 
+        /*-------.
+        | Record |
+        `-------*/
+      public:
+        /// A change of state, to be journaled.
+        ///
+        /// Replaying the records of a server on the state it had before
+        /// them yields the state it had after them.
+        struct Record
+        {
+          enum class Type
+          {
+            propose,
+            lead,
+            accept,
+            confirm,
+          };
+          Record(Type type,
+                 Quorum quorum,
+                 Proposal proposal,
+                 boost::optional<Value> value = {});
+          /// Deserialize a Record.
+          Record(elle::serialization::SerializerIn& s, elle::Version const& v);
+          Type type;
+          Quorum quorum;
+          Proposal proposal;
+          /// The accepted value, for Type::accept.
+          boost::optional<Value> value;
+          void
+          serialize(elle::serialization::Serializer& s, elle::Version const& v);
+          using serialization_tag = elle::serialization_tag;
+          friend
+          std::ostream&
+          operator <<(std::ostream& o, Record const& r)
+          {
+            static char const* const types[] =
+              {"propose", "lead", "accept", "confirm"};
+            elle::fprintf(o, "Record(%s %f)", types[int(r.type)], r.proposal);
+            return o;
+          }
+        };
+
         /*-------------.
         | Construction |
         `-------------*/
@@ -245,8 +290,25 @@ namespace elle
         /// Submit a Proposal to a Quorum.
         ///
         /// If the Proposal is already outdated, return the newest Proposal.
+        /// Wait for the lease of another leader to expire first.
         Response
         propose(Quorum q, Proposal p);
+        /// Submit a Proposal to a Quorum, for all later versions too.
+        ///
+        /// Once the proposal is granted, proposals for later versions with
+        /// a lower round are refused, and accepts for later versions with
+        /// the same round and sender are taken as an implicit proposal: the
+        /// leader only needs one round trip per version. Other proposers
+        /// wait for @a lease to expire before they are answered, and the
+        /// leader cannot renew its leadership while they wait.
+        ///
+        /// Servers below version 0.5.0 refuse leadership with an elle::Error.
+        ///
+        /// @param q     The quorum.
+        /// @param p     The proposal.
+        /// @param lease How long to hold other proposers off.
+        Response
+        lead(Quorum q, Proposal p, Duration lease);
         Proposal
         accept(Quorum q, Proposal p, Value value);
         void
@@ -275,6 +337,31 @@ namespace elle
         using serialization_tag = elle::serialization_tag;
         };
         ELLE_ATTRIBUTE_R(boost::optional<VersionState>, state);
+        /// The proposal of the latest leader, granted for all versions from
+        /// its version on.
+        ELLE_ATTRIBUTE_R(boost::optional<Proposal>, leader);
+      private:
+        /// When the leader's lease expires. Leases are not persisted: a
+        /// restarted server does not hold other proposers off.
+        ELLE_ATTRIBUTE(elle::Time, lease_end);
+        /// Number of proposers waiting for the lease to expire.
+        ELLE_ATTRIBUTE(int, lease_contenders);
+
+        /*--------.
+        | Journal |
+        `--------*/
+      public:
+        /// Called with every change of state, before the server answers.
+        ///
+        /// It is called right after the change, without yielding in
+        /// between: records come in the order changes were made. It may
+        /// yield until the record is durable, and throw if it cannot be.
+        ELLE_ATTRIBUTE_RW((std::function<void (Record const&)>), journal);
+        /// Apply a journaled change again, without journaling it.
+        void
+        replay(Record const& record);
+      private:
+        ELLE_ATTRIBUTE(bool, replaying);
 
       private:
         struct _Details;
@@ -4,9 +4,11 @@
 #include <boost/multi_index_container.hpp>
 
 #include <elle/With.hh>
+#include <elle/finally.hh>
 #include <elle/serialization/Serializer.hh>
 
 #include <elle/reactor/Scope.hh>
+#include <elle/reactor/scheduler.hh>
 
 namespace elle
 {
@@ -238,6 +240,49 @@ namespace elle
                                 "elle::athena", "athena")
           };
 
+      /*-------.
+      | Record |
+      `-------*/
+
+      template <
+        typename T, typename Version, typename ClientId, typename ServerId>
+      Server<T, Version, ClientId, ServerId>::Record::Record(
+        Type type_,
+        Quorum quorum_,
+        Proposal proposal_,
+        boost::optional<Value> value_)
+        : type(type_)
+        , quorum(std::move(quorum_))
+        , proposal(std::move(proposal_))
+        , value(std::move(value_))
+      {}
+
+      template <
+        typename T, typename Version, typename ClientId, typename ServerId>
+      Server<T, Version, ClientId, ServerId>::Record::Record(
+        elle::serialization::SerializerIn& s, elle::Version const& v)
+        : type()
+        , quorum()
+        , proposal()
+        , value()
+      {
+        this->serialize(s, v);
+      }
+
+      template <
+        typename T, typename Version, typename ClientId, typename ServerId>
+      void
+      Server<T, Version, ClientId, ServerId>::Record::serialize(
+        elle::serialization::Serializer& s, elle::Version const& v)
+      {
+        auto type = static_cast<int>(this->type);
+        s.serialize("type", type);
+        this->type = static_cast<Type>(type);
+        s.serialize("quorum", this->quorum);
+        s.serialize("proposal", this->proposal);
+        s.serialize("value", this->value);
+      }
+
       /*-------------.
       | Construction |
       `-------------*/
@@ -255,6 +300,11 @@ namespace elle
         , _version(version)
         , _partial(false)
         , _state()
+        , _leader()
+        , _lease_end()
+        , _lease_contenders(0)
+        , _journal()
+        , _replaying(false)
       {
         ELLE_ASSERT_CONTAINS(this->_quorum, this->_id);
         this->_register_wrong_quorum_serialization.poke();
@@ -330,6 +380,67 @@ namespace elle
           ELLE_DUMP("unconfirmed");
           return false;
         }
+
+        /// Whether proposal \a p is from the leader, for a version it leads.
+        static
+        bool
+        led(Server<T, Version, CId, SId> const& self, Proposal const& p)
+        {
+          return self._leader &&
+            p.version >= self._leader->version &&
+            p.round == self._leader->round &&
+            p.sender == self._leader->sender;
+        }
+
+        /// Journal the change of state described by \a make, if any
+        /// journal is set: values are only copied into records if needed.
+        template <typename Make>
+        static
+        void
+        persist(Server<T, Version, CId, SId>& self, Make const& make)
+        {
+          ELLE_LOG_COMPONENT("athena.paxos.Server");
+          if (self._journal && !self._replaying)
+          {
+            auto const record = make();
+            ELLE_DEBUG("%s: journal %s", self, record);
+            self._journal(record);
+          }
+        }
+
+        /// Wait until the lease of a leader other than \a sender expires.
+        ///
+        /// @param renew Whether to also wait, if \a sender is the leader,
+        ///              for other proposers to be served first.
+        static
+        void
+        wait_lease(Server<T, Version, CId, SId>& self,
+                   CId const& sender,
+                   bool renew)
+        {
+          ELLE_LOG_COMPONENT("athena.paxos.Server");
+          while (self._leader)
+          {
+            auto const now = elle::reactor::now();
+            if (now >= self._lease_end)
+              return;
+            auto const other = !(self._leader->sender == sender);
+            if (!other && !(renew && self._lease_contenders))
+              return;
+            auto const delay =
+              std::chrono::duration_cast<Duration>(self._lease_end - now);
+            ELLE_TRACE("%s: wait %s for the lease of %s",
+                       self, delay, self._leader->sender);
+            if (other)
+              ++self._lease_contenders;
+            elle::SafeFinally done([&]
+              {
+                if (other)
+                  --self._lease_contenders;
+              });
+            elle::reactor::sleep(delay);
+          }
+        }
       };
 
       /*----------.
@@ -344,6 +455,7 @@ namespace elle
       {
         ELLE_LOG_COMPONENT("athena.paxos.Server");
         ELLE_TRACE_SCOPE("%s: get proposal: %s ", *this, p);
+        _Details::wait_lease(*this, p.sender, false);
         if (this->_state &&
             this->_state->accepted &&
             this->_state->accepted->proposal.version > p.version)
@@ -355,6 +467,15 @@ namespace elle
                           this->_state->accepted->value,
                           this->_state->accepted->confirmed);
         }
+        if (this->_leader &&
+            p.version >= this->_leader->version &&
+            std::tie(p.round, p.sender) <
+            std::tie(this->_leader->round, this->_leader->sender))
+        {
+          ELLE_DEBUG("refuse proposal in favor of leader %s", this->_leader);
+          return Response(
+            Proposal(p.version, this->_leader->round, this->_leader->sender));
+        }
         if (_Details::check_confirmed(*this, p))
         {
           _Details::check_quorum(*this, q, p);
@@ -387,6 +508,10 @@ namespace elle
           ELLE_DEBUG("accept first proposal for version %s", p.version);
           this->_state.reset();
           this->_state.emplace(std::move(p));
+          _Details::persist(*this, [&]
+            {
+              return Record(Record::Type::propose, q, this->_state->proposal);
+            });
           return {};
         }
         else
@@ -396,6 +521,10 @@ namespace elle
             ELLE_DEBUG("update minimum proposal for version %s", p.version);
             auto previous_proposal = this->_state->proposal;
             this->_state->proposal = std::move(p);
+            _Details::persist(*this, [&]
+              {
+                return Record(Record::Type::propose, q, this->_state->proposal);
+              });
             if (this->_state->accepted)
               return Response(previous_proposal,
                               this->_state->accepted->value,
@@ -413,6 +542,37 @@ namespace elle
         }
       }
 
+      template <
+        typename T, typename Version, typename ClientId, typename ServerId>
+      auto
+      Server<T, Version, ClientId, ServerId>::lead(
+        Quorum q, Proposal p, Duration lease)
+        -> Response
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Server");
+        ELLE_TRACE_SCOPE("%s: get leadership proposal: %s ", *this, p);
+        // Older versions neither serialize nor honor the leadership.
+        if (this->version() < elle::Version(0, 5, 0))
+          elle::err("%s: leadership requires version 0.5.0, not %s",
+                    *this, this->version());
+        _Details::wait_lease(*this, p.sender, true);
+        auto res = this->propose(q, p);
+        if (this->_state && this->_state->proposal == p)
+        {
+          ELLE_DEBUG("grant leadership for %s", lease);
+          this->_lease_end = elle::reactor::now() + lease;
+          if (!this->_leader || !(*this->_leader == p))
+          {
+            this->_leader = std::move(p);
+            _Details::persist(*this, [&]
+              {
+                return Record(Record::Type::lead, q, *this->_leader);
+              });
+          }
+        }
+        return res;
+      }
+
       template <typename T, typename Version, typename CId, typename SId>
       typename Server<T, Version, CId, SId>::Proposal
       Server<T, Version, CId, SId>::accept(
@@ -422,6 +582,23 @@ namespace elle
         ELLE_TRACE_SCOPE("%s: accept for %f: %f", *this, p, value);
         if (!this->_partial)
           _Details::check_quorum(*this, q, p);
+        if (_Details::led(*this, p) &&
+            (!this->_state || this->_state->version() < p.version))
+        {
+          ELLE_DEBUG("take accept from leader as a proposal");
+          this->propose(q, p);
+        }
+        if (this->_leader &&
+            (!this->_state || this->_state->proposal < p) &&
+            p.version >= this->_leader->version &&
+            std::tie(p.round, p.sender) <
+            std::tie(this->_leader->round, this->_leader->sender))
+        {
+          ELLE_TRACE("discard accept from former leader, current leader is %s",
+                     this->_leader);
+          return Proposal(p.version, this->_leader->round,
+                          this->_leader->sender);
+        }
         if (!this->_state || this->_state->proposal < p)
         {
           ELLE_WARN("%s: someone malicious sent an accept before propose",
@@ -445,6 +622,12 @@ namespace elle
             version.accepted->proposal = std::move(p);
             version.accepted->value = std::move(value);
           }
+          auto const& accepted = *version.accepted;
+          _Details::persist(*this, [&]
+            {
+              return Record(Record::Type::accept,
+                            q, accepted.proposal, accepted.value);
+            });
         }
         return version.proposal;
       }
@@ -481,6 +664,36 @@ namespace elle
             this->_quorum = q;
             this->_partial = false;
           }
+          _Details::persist(
+            *this, [&] { return Record(Record::Type::confirm, q, p); });
+        }
+      }
+
+      template <
+        typename T, typename Version, typename ClientId, typename ServerId>
+      void
+      Server<T, Version, ClientId, ServerId>::replay(Record const& record)
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Server");
+        ELLE_DEBUG_SCOPE("%s: replay %s", *this, record);
+        this->_replaying = true;
+        elle::SafeFinally done([&] { this->_replaying = false; });
+        switch (record.type)
+        {
+          case Record::Type::propose:
+            this->propose(record.quorum, record.proposal);
+            break;
+          case Record::Type::lead:
+            // Leases are not persisted: only the leadership is restored.
+            this->_leader = record.proposal;
+            break;
+          case Record::Type::accept:
+            this->accept(
+              record.quorum, record.proposal, ELLE_ENFORCE(record.value).get());
+            break;
+          case Record::Type::confirm:
+            this->confirm(record.quorum, record.proposal);
+            break;
         }
       }
 
@@ -606,6 +819,11 @@ namespace elle
         , _version()
         , _partial(false)
         , _state()
+        , _leader()
+        , _lease_end()
+        , _lease_contenders(0)
+        , _journal()
+        , _replaying(false)
       {
         this->serialize(s, v);
       }
@@ -647,6 +865,9 @@ namespace elle
         }
         if (v >= elle::Version(0, 2, 0))
           s.serialize("partial", this->_partial);
+        // Servers deserialized from older states start without a leader.
+        if (v >= elle::Version(0, 5, 0))
+          s.serialize("leader", this->_leader);
       }
 
       /*----------.
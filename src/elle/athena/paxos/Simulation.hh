@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+
+#include <elle/Duration.hh>
+#include <elle/Printable.hh>
+#include <elle/athena/paxos/Client.hh>
+#include <elle/athena/paxos/Server.hh>
+#include <elle/attribute.hh>
+
+namespace elle
+{
+  namespace athena
+  {
+    namespace paxos
+    {
+      /// A simulated network of Paxos servers, to test and benchmark
+      /// consensus under adverse conditions.
+      ///
+      /// Clients reach the servers through peers that deliver every request
+      /// and response after a random latency. Messages may be dropped, and
+      /// links cut to partition the network: the request then fails with
+      /// Unavailable after timeout, as a real one would time out.
+      ///
+      /// All randomness is drawn from one seeded generator. On a simulated
+      /// Scheduler, latencies and timeouts elapse in virtual time: a run is
+      /// reproducible from its seed, whatever the speed of the machine, and
+      /// runs thousands of rounds per second.
+      ///
+      /// @code{.cc}
+      ///
+      /// elle::reactor::scheduler().simulated(true);
+      /// paxos::Simulation<int, int, int> simulation({1, 2, 3}, seed);
+      /// simulation.latency(simulation.uniform(1ms, 20ms));
+      /// simulation.drop(0.01);
+      /// auto client = simulation.client(1);
+      /// client.choose(0, 42);
+      ///
+      /// @endcode
+      template <typename T, typename Version, typename ClientId>
+      class Simulation
+        : public elle::Printable
+      {
+      /*------.
+      | Types |
+      `------*/
+      public:
+        using Self = Simulation;
+        using Client = paxos::Client<T, Version, ClientId>;
+        using Server = paxos::Server<T, Version, ClientId>;
+        using Quorum = typename Server::Quorum;
+        /// A latency distribution.
+        using Distribution = std::function<Duration (std::mt19937&)>;
+
+      /*-------------.
+      | Construction |
+      `-------------*/
+      public:
+        /// Create one server per member of @a quorum.
+        ///
+        /// @param quorum The servers.
+        /// @param seed   The seed of all random draws.
+        Simulation(Quorum const& quorum, std::uint32_t seed = 0);
+
+      /*--------------.
+      | Distributions |
+      `--------------*/
+      public:
+        static
+        Distribution
+        constant(Duration latency);
+        static
+        Distribution
+        uniform(Duration minimum, Duration maximum);
+        /// @a minimum plus an exponentially distributed delay averaging
+        /// @a mean: mostly fast messages, with a long tail.
+        static
+        Distribution
+        exponential(Duration minimum, Duration mean);
+
+      /*--------.
+      | Network |
+      `--------*/
+      public:
+        /// A client reaching every server through the network.
+        ///
+        /// Its conflict backoff is seeded from the simulation.
+        Client
+        client(ClientId id);
+        /// Cut the link between @a client and @a server.
+        void
+        disconnect(ClientId const& client, ClientId const& server);
+        /// Cut @a server from every client.
+        void
+        isolate(ClientId const& server);
+        /// Restore every link.
+        void
+        heal();
+        ELLE_ATTRIBUTE_RX(std::mt19937, random);
+        /// The servers, by id.
+        ELLE_ATTRIBUTE_RX((std::map<ClientId, Server>), servers);
+        /// The one-way latency of messages.
+        ELLE_ATTRIBUTE_RW(Distribution, latency);
+        /// The probability for a message to be lost.
+        ELLE_ATTRIBUTE_RW(double, drop);
+        /// How long a request whose message was lost takes to fail.
+        ELLE_ATTRIBUTE_RW(Duration, timeout);
+        /// The number of messages sent.
+        ELLE_ATTRIBUTE_R(int, messages);
+        /// The number of messages lost, dropped or across a cut link.
+        ELLE_ATTRIBUTE_R(int, lost);
+      private:
+        class Peer;
+        /// Carry one message from @a from to @a to.
+        ///
+        /// @throws Unavailable if the message is lost.
+        void
+        _transmit(ClientId const& from, ClientId const& to);
+        ELLE_ATTRIBUTE((std::set<std::pair<ClientId, ClientId>>), cuts);
+        ELLE_ATTRIBUTE(std::set<ClientId>, isolated);
+
+      /*----------.
+      | Printable |
+      `----------*/
+      public:
+        void
+        print(std::ostream& output) const override;
+      };
+    }
+  }
+}
+
+#include <elle/athena/paxos/Simulation.hxx>
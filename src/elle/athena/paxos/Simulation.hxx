@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+
+#include <boost/optional.hpp>
+
+#include <elle/find.hh>
+#include <elle/log.hh>
+#include <elle/reactor/scheduler.hh>
+
+namespace elle
+{
+  namespace athena
+  {
+    namespace paxos
+    {
+      /*-----.
+      | Peer |
+      `-----*/
+
+      template <typename T, typename Version, typename ClientId>
+      class Simulation<T, Version, ClientId>::Peer
+        : public Client::Peer
+      {
+      public:
+        using Accepted = typename Client::Accepted;
+        using Proposal = typename Client::Proposal;
+        using Response = typename Client::Response;
+        using Value = typename Client::Value;
+
+        Peer(Simulation& simulation, ClientId client, Server& server)
+          : Client::Peer(server.id())
+          , _simulation(simulation)
+          , _client(std::move(client))
+          , _server(server)
+        {}
+
+        Response
+        propose(Quorum const& q, Proposal const& p) override
+        {
+          return this->_call([&] { return this->_server.propose(q, p); });
+        }
+
+        Proposal
+        accept(Quorum const& q, Proposal const& p, Value const& value) override
+        {
+          return this->_call(
+            [&] { return this->_server.accept(q, p, value); });
+        }
+
+        void
+        confirm(Quorum const& q, Proposal const& p) override
+        {
+          this->_call(
+            [&]
+            {
+              this->_server.confirm(q, p);
+              return true;
+            });
+        }
+
+        boost::optional<Accepted>
+        get(Quorum const& q) override
+        {
+          return this->_call([&] { return this->_server.get(q); });
+        }
+
+        Response
+        lead(Quorum const& q, Proposal const& p, Duration lease) override
+        {
+          return this->_call(
+            [&] { return this->_server.lead(q, p, lease); });
+        }
+
+      private:
+        /// Carry the request, run @a action on the server and carry its
+        /// result or error back.
+        template <typename Action>
+        auto
+        _call(Action const& action)
+          -> std::decay_t<decltype(action())>
+        {
+          this->_simulation._transmit(this->_client, this->id());
+          auto res = boost::optional<std::decay_t<decltype(action())>>{};
+          // Do not yield in the handler: carry the error back after it.
+          auto error = std::exception_ptr{};
+          try
+          {
+            res.emplace(action());
+          }
+          catch (elle::Error const&)
+          {
+            error = std::current_exception();
+          }
+          this->_simulation._transmit(this->id(), this->_client);
+          if (error)
+            std::rethrow_exception(error);
+          return std::move(*res);
+        }
+
+        ELLE_ATTRIBUTE(Simulation&, simulation);
+        ELLE_ATTRIBUTE(ClientId, client);
+        ELLE_ATTRIBUTE(Server&, server);
+      };
+
+      /*-------------.
+      | Construction |
+      `-------------*/
+
+      template <typename T, typename Version, typename ClientId>
+      Simulation<T, Version, ClientId>::Simulation(Quorum const& quorum,
+                                                   std::uint32_t seed)
+        : _random(seed)
+        , _servers()
+        , _latency(constant(1ms))
+        , _drop(0)
+        , _timeout(1s)
+        , _messages(0)
+        , _lost(0)
+        , _cuts()
+        , _isolated()
+      {
+        for (auto const& id: quorum)
+          this->_servers.emplace(id, Server(id, quorum));
+      }
+
+      /*--------------.
+      | Distributions |
+      `--------------*/
+
+      template <typename T, typename Version, typename ClientId>
+      auto
+      Simulation<T, Version, ClientId>::constant(Duration latency)
+        -> Distribution
+      {
+        return [latency] (std::mt19937&) { return latency; };
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      auto
+      Simulation<T, Version, ClientId>::uniform(Duration minimum,
+                                                Duration maximum)
+        -> Distribution
+      {
+        return [minimum, maximum] (std::mt19937& random)
+        {
+          auto d = std::uniform_int_distribution<Duration::rep>(
+            minimum.count(), maximum.count());
+          return Duration(d(random));
+        };
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      auto
+      Simulation<T, Version, ClientId>::exponential(Duration minimum,
+                                                    Duration mean)
+        -> Distribution
+      {
+        return [minimum, mean] (std::mt19937& random)
+        {
+          auto d = std::exponential_distribution<double>(1. / mean.count());
+          return minimum + Duration(Duration::rep(d(random)));
+        };
+      }
+
+      /*--------.
+      | Network |
+      `--------*/
+
+      template <typename T, typename Version, typename ClientId>
+      auto
+      Simulation<T, Version, ClientId>::client(ClientId id)
+        -> Client
+      {
+        auto peers = typename Client::Peers{};
+        for (auto& server: this->_servers)
+          peers.emplace_back(new Peer(*this, id, server.second));
+        auto res = Client(std::move(id), std::move(peers));
+        res.seed(this->_random());
+        return res;
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      void
+      Simulation<T, Version, ClientId>::disconnect(ClientId const& client,
+                                                   ClientId const& server)
+      {
+        this->_cuts.emplace(client, server);
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      void
+      Simulation<T, Version, ClientId>::isolate(ClientId const& server)
+      {
+        this->_isolated.emplace(server);
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      void
+      Simulation<T, Version, ClientId>::heal()
+      {
+        this->_cuts.clear();
+        this->_isolated.clear();
+      }
+
+      template <typename T, typename Version, typename ClientId>
+      void
+      Simulation<T, Version, ClientId>::_transmit(ClientId const& from,
+                                                  ClientId const& to)
+      {
+        ELLE_LOG_COMPONENT("athena.paxos.Simulation");
+        ++this->_messages;
+        // Draw even for lost messages, so a partition does not shift the
+        // draws of unrelated messages.
+        auto const latency = this->_latency(this->_random);
+        auto const dropped =
+          std::bernoulli_distribution(this->_drop)(this->_random);
+        if (dropped ||
+            elle::find(this->_isolated, from) ||
+            elle::find(this->_isolated, to) ||
+            elle::find(this->_cuts, std::make_pair(from, to)) ||
+            elle::find(this->_cuts, std::make_pair(to, from)))
+        {
+          ELLE_DEBUG("%s: lose message from %s to %s", this, from, to);
+          ++this->_lost;
+          elle::reactor::sleep(this->_timeout);
+          throw Unavailable();
+        }
+        elle::reactor::sleep(latency);
+      }
+
+      /*----------.
+      | Printable |
+      `----------*/
+
+      template <typename T, typename Version, typename ClientId>
+      void
+      Simulation<T, Version, ClientId>::print(std::ostream& output) const
+      {
+        elle::fprintf(output, "paxos::Simulation(%s servers)",
+                      this->_servers.size());
+      }
+    }
+  }
+}
@@ -32,6 +32,16 @@ namespace elle
       return (raw::hash(function, next_block));
     }
 
+    std::vector<elle::Buffer>
+    hash(std::function<elle::ConstWeakBuffer (void)> next_block,
+         std::vector<Oneway> const& oneways)
+    {
+      auto functions = std::vector< ::EVP_MD const*>{};
+      for (auto oneway: oneways)
+        functions.push_back(oneway::resolve(oneway));
+      return (raw::hash(functions, next_block));
+    }
+
     elle::Buffer
     hash(std::istream& plain,
          Oneway const oneway)
@@ -5,6 +5,7 @@
 # include <elle/cryptography/Oneway.hh>
 
 # include <iosfwd>
+# include <vector>
 
 namespace elle
 {
@@ -21,6 +22,11 @@ namespace elle
     elle::Buffer
     hash(std::function<elle::ConstWeakBuffer (void)> next_block,
          Oneway const oneway);
+    /// Hash blocks of data (last block empty) with several functions in a
+    /// single pass and return their digest messages, in order.
+    std::vector<elle::Buffer>
+    hash(std::function<elle::ConstWeakBuffer (void)> next_block,
+         std::vector<Oneway> const& oneways);
     /// Hash an input stream and return a digest message.
     elle::Buffer
     hash(std::istream& plain,
@@ -924,6 +924,61 @@ namespace elle
         ELLE_CRYPTOGRAPHY_FINALLY_ABORT(context);
         return (digest);
       }
+
+      std::vector<elle::Buffer>
+      hash(std::vector< ::EVP_MD const*> const& oneways,
+           std::function<elle::ConstWeakBuffer (void)> next_block)
+      {
+        // Make sure the cryptographic system is set up.
+        cryptography::require();
+        // Initialise one context per function.
+        std::vector< ::EVP_MD_CTX*> contexts;
+        elle::SafeFinally cleanup(
+          [&]
+          {
+            for (auto context: contexts)
+              ::EVP_MD_CTX_destroy(context);
+          });
+        for (auto oneway: oneways)
+        {
+          contexts.push_back(::EVP_MD_CTX_create());
+          if (!contexts.back() ||
+              ::EVP_DigestInit_ex(contexts.back(), oneway, nullptr) <= 0)
+            throw Error(
+              elle::sprintf("unable to initialize the digest process: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+        }
+        // Apply every function to each block while it is hot in the cache.
+        while (true)
+        {
+          auto const& buffer = next_block();
+          if (buffer.size() == 0)
+            break;
+          for (auto context: contexts)
+            if (::EVP_DigestUpdate(context,
+                                   buffer.contents(),
+                                   buffer.size()) <= 0)
+              throw Error(
+                elle::sprintf("unable to apply the digest function: %s",
+                              ::ERR_error_string(ERR_get_error(), nullptr)));
+        }
+        // Finalize the digests.
+        std::vector<elle::Buffer> digests;
+        for (std::size_t i = 0; i < oneways.size(); ++i)
+        {
+          elle::Buffer digest(EVP_MD_size(oneways[i]));
+          unsigned int size(0);
+          if (::EVP_DigestFinal_ex(contexts[i],
+                                   digest.mutable_contents(),
+                                   &size) <= 0)
+            throw Error(
+              elle::sprintf("unable to finalize the digest process: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          digest.size(size);
+          digests.push_back(std::move(digest));
+        }
+        return (digests);
+      }
     }
   }
 }
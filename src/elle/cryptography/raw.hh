@@ -8,6 +8,7 @@
 # include <elle/fwd.hh>
 
 # include <memory>
+# include <vector>
 
 //
 // ---------- Asymmetric ------------------------------------------------------
@@ -146,6 +147,11 @@ namespace elle
            std::function<elle::ConstWeakBuffer (void)> next_block,
            std::function<void (::EVP_MD_CTX*)> prolog = nullptr,
            std::function<void (::EVP_MD_CTX*)> epilog = nullptr);
+      /// Hash blocks of data (last block empty) with several functions in a
+      /// single pass over the data and return one digest per function.
+      std::vector<elle::Buffer>
+      hash(std::vector< ::EVP_MD const*> const& oneways,
+           std::function<elle::ConstWeakBuffer (void)> next_block);
     }
   }
 }
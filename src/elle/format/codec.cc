@@ -0,0 +1,67 @@
+#include <elle/format/codec.hh>
+
+#include <ostream>
+
+#include <elle/assert.hh>
+#include <elle/format/gzip.hh>
+
+namespace elle
+{
+  namespace format
+  {
+    std::ostream&
+    operator <<(std::ostream& output, Codec codec)
+    {
+      switch (codec)
+      {
+        case Codec::none:
+          return output << "none";
+        case Codec::gzip:
+          return output << "gzip";
+      }
+      elle::unreachable();
+    }
+
+    std::unique_ptr<std::ostream>
+    compressor(Codec codec, std::ostream& underlying, int jobs)
+    {
+      switch (codec)
+      {
+        case Codec::none:
+          return std::make_unique<std::ostream>(underlying.rdbuf());
+        case Codec::gzip:
+          if (jobs > 1)
+            return std::make_unique<gzip::ParallelStream>(underlying, jobs);
+          else
+            return std::make_unique<gzip::Stream>(underlying, false);
+      }
+      elle::unreachable();
+    }
+
+    elle::Buffer
+    compress(Codec codec, elle::ConstWeakBuffer data)
+    {
+      switch (codec)
+      {
+        case Codec::none:
+          return elle::Buffer(data);
+        case Codec::gzip:
+          return gzip::compress(data);
+      }
+      elle::unreachable();
+    }
+
+    elle::Buffer
+    decompress(Codec codec, elle::ConstWeakBuffer data)
+    {
+      switch (codec)
+      {
+        case Codec::none:
+          return elle::Buffer(data);
+        case Codec::gzip:
+          return gzip::decompress(data);
+      }
+      elle::unreachable();
+    }
+  }
+}
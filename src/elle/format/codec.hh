@@ -0,0 +1,47 @@
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+
+#include <elle/Buffer.hh>
+#include <elle/compiler.hh>
+
+namespace elle
+{
+  namespace format
+  {
+    /// A compression format, to pick one per use.
+    enum class Codec
+    {
+      /// No compression.
+      none,
+      /// GZIP, compressed on several cores when streamed.
+      gzip,
+    };
+
+    ELLE_API
+    std::ostream&
+    operator <<(std::ostream& output, Codec codec);
+
+    /// A stream compressing data written to it with @a codec to
+    /// @a underlying.
+    ///
+    /// Compression completes when the stream is destroyed.
+    ///
+    /// @param jobs The number of cores to compress with, if the codec
+    ///             supports it.
+    ELLE_API
+    std::unique_ptr<std::ostream>
+    compressor(Codec codec, std::ostream& underlying, int jobs = 1);
+
+    /// Compress @a data with @a codec.
+    ELLE_API
+    elle::Buffer
+    compress(Codec codec, elle::ConstWeakBuffer data);
+
+    /// Decompress @a data compressed with @a codec.
+    ELLE_API
+    elle::Buffer
+    decompress(Codec codec, elle::ConstWeakBuffer data);
+  }
+}
@@ -1,5 +1,12 @@
 # include <zlib.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
 #include <elle/finally.hh>
 #include <elle/format/gzip.hh>
 #include <elle/log.hh>
@@ -143,6 +150,428 @@ namespace elle
                      Buffer::Size buffer_size):
         IOStream(new StreamBuffer(underlying, honor_flush, buffer_size))
       {}
+
+      /*---------------.
+      | ParallelStream |
+      `---------------*/
+
+      namespace
+      {
+        /// The largest window DEFLATE references: the part of the previous
+        /// block to prime the next one with.
+        auto const window_size = Buffer::Size(32 * 1024);
+
+        void
+        check(int code, char const* operation)
+        {
+          if (code == Z_MEM_ERROR)
+            throw std::bad_alloc();
+          else if (code != Z_OK)
+            throw elle::Exception(
+              elle::sprintf("ZLIB %s error: %s", operation, code));
+        }
+
+        /// Compress a block to raw DEFLATE, ending it on a byte boundary so
+        /// compressed blocks can be concatenated.
+        ///
+        /// \param last Whether this is the last block of the stream.
+        elle::Buffer
+        deflate_block(elle::ConstWeakBuffer data,
+                      elle::ConstWeakBuffer dictionary,
+                      int level,
+                      bool last)
+        {
+          auto stream = z_stream{};
+          check(deflateInit2(&stream, level, Z_DEFLATED,
+                             // Negative: raw DEFLATE, no header or trailer.
+                             -15, 8, Z_DEFAULT_STRATEGY),
+                "deflateInit");
+          elle::SafeFinally end([&] { deflateEnd(&stream); });
+          if (dictionary.size())
+            check(deflateSetDictionary(&stream, dictionary.contents(),
+                                       dictionary.size()),
+                  "deflateSetDictionary");
+          auto res = elle::Buffer(deflateBound(&stream, data.size()) + 16);
+          stream.next_in = const_cast<Bytef*>(data.contents());
+          stream.avail_in = data.size();
+          stream.next_out = res.mutable_contents();
+          stream.avail_out = res.size();
+          auto ret = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+          ELLE_ASSERT(ret == (last ? Z_STREAM_END : Z_OK));
+          ELLE_ASSERT_EQ(stream.avail_in, 0u);
+          res.size(res.size() - stream.avail_out);
+          return res;
+        }
+
+        /// Threads compressing the blocks of every ParallelStream using the
+        /// default runner, started on first use and kept until exit.
+        class Pool
+        {
+        public:
+          static
+          Pool&
+          instance()
+          {
+            static Pool pool;
+            return pool;
+          }
+
+          Pool()
+            : _stop(false)
+          {
+            auto const size = std::max(std::thread::hardware_concurrency(), 1u);
+            for (auto i = 0u; i < size; ++i)
+              this->_threads.emplace_back([this] { this->_run(); });
+          }
+
+          ~Pool()
+          {
+            {
+              std::lock_guard<std::mutex> lock(this->_mutex);
+              this->_stop = true;
+            }
+            this->_changed.notify_all();
+            for (auto& t: this->_threads)
+              t.join();
+          }
+
+          std::future<void>
+          run(std::function<void ()> job)
+          {
+            auto task =
+              std::make_shared<std::packaged_task<void ()>>(std::move(job));
+            auto res = task->get_future();
+            {
+              std::lock_guard<std::mutex> lock(this->_mutex);
+              this->_jobs.emplace([task] { (*task)(); });
+            }
+            this->_changed.notify_one();
+            return res;
+          }
+
+        private:
+          void
+          _run()
+          {
+            while (true)
+            {
+              auto job = std::function<void ()>{};
+              {
+                std::unique_lock<std::mutex> lock(this->_mutex);
+                this->_changed.wait(
+                  lock, [&] { return this->_stop || !this->_jobs.empty(); });
+                if (this->_jobs.empty())
+                  return;
+                job = std::move(this->_jobs.front());
+                this->_jobs.pop();
+              }
+              job();
+            }
+          }
+
+          bool _stop;
+          std::mutex _mutex;
+          std::condition_variable _changed;
+          std::queue<std::function<void ()>> _jobs;
+          std::vector<std::thread> _threads;
+        };
+
+        void
+        write_le32(std::ostream& output, uint32_t value)
+        {
+          char bytes[4];
+          for (auto& b: bytes)
+          {
+            b = char(value & 0xff);
+            value >>= 8;
+          }
+          output.write(bytes, sizeof bytes);
+        }
+      }
+
+      class ParallelStreamBuffer
+        : public elle::StreamBuffer
+      {
+      public:
+        ParallelStreamBuffer(std::ostream& underlying,
+                             int jobs,
+                             Buffer::Size block_size,
+                             int level,
+                             Runner runner);
+        ~ParallelStreamBuffer();
+
+        WeakBuffer write_buffer() override;
+        WeakBuffer read_buffer() override;
+        void flush(Size size) override;
+
+      private:
+        /// Blocks being compressed together.
+        struct Batch
+        {
+          ~Batch();
+          std::vector<elle::Buffer> blocks;
+          /// The end of the block preceding the first one.
+          elle::Buffer dictionary;
+          std::vector<elle::Buffer> compressed;
+          std::vector<uLong> crcs;
+          /// The jobs in flight on the pool, if any.
+          std::vector<std::future<void>> running;
+        };
+        /// Start compressing full blocks, and the last one if @a last, then
+        /// write the previous batch out.
+        void
+        _compress(bool last);
+        /// Wait for the batch in flight and write it out.
+        void
+        _write();
+        ELLE_ATTRIBUTE(std::ostream&, underlying);
+        ELLE_ATTRIBUTE(int, jobs);
+        ELLE_ATTRIBUTE(Buffer::Size, block_size);
+        ELLE_ATTRIBUTE(int, level);
+        ELLE_ATTRIBUTE(Runner, runner);
+        /// Blocks to compress, the last one being filled.
+        ELLE_ATTRIBUTE(std::vector<elle::Buffer>, blocks);
+        /// The end of the last block handed to compression.
+        ELLE_ATTRIBUTE(elle::Buffer, dictionary);
+        /// The batch being compressed while the next one fills.
+        ELLE_ATTRIBUTE(std::unique_ptr<Batch>, compressing);
+        ELLE_ATTRIBUTE(uLong, crc);
+        ELLE_ATTRIBUTE(uint64_t, size);
+      };
+
+      ParallelStreamBuffer::Batch::~Batch()
+      {
+        // Jobs reference the batch.
+        for (auto& job: this->running)
+          if (job.valid())
+            job.wait();
+      }
+
+      ParallelStreamBuffer::ParallelStreamBuffer(std::ostream& underlying,
+                                                 int jobs,
+                                                 Buffer::Size block_size,
+                                                 int level,
+                                                 Runner runner)
+        : _underlying(underlying)
+        , _jobs(std::max(jobs, 1))
+        , _block_size(std::max(block_size, window_size))
+        , _level(level)
+        , _runner(std::move(runner))
+        , _blocks()
+        , _dictionary()
+        , _compressing()
+        , _crc(crc32(0, Z_NULL, 0))
+        , _size(0)
+      {
+        // Magic, DEFLATE, no flags, no modification time, no extra flags,
+        // unknown operating system.
+        static unsigned char const header[] =
+          {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff};
+        this->_underlying.write(reinterpret_cast<char const*>(header),
+                                sizeof header);
+      }
+
+      ParallelStreamBuffer::~ParallelStreamBuffer()
+      {
+        ELLE_TRACE_SCOPE("%s: flush remaining content", *this);
+        try
+        {
+          this->_compress(true);
+          write_le32(this->_underlying, this->_crc);
+          write_le32(this->_underlying, uint32_t(this->_size));
+          this->_underlying.flush();
+        }
+        catch (...)
+        {
+          ELLE_ERR("%s: unable to finish compression: %s",
+                   *this, elle::exception_string());
+        }
+      }
+
+      WeakBuffer
+      ParallelStreamBuffer::write_buffer()
+      {
+        if (this->_blocks.empty() ||
+            this->_blocks.back().size() == this->_block_size)
+        {
+          if (int(this->_blocks.size()) > this->_jobs)
+            this->_compress(false);
+          this->_blocks.emplace_back();
+          this->_blocks.back().capacity(this->_block_size);
+        }
+        auto& block = this->_blocks.back();
+        return WeakBuffer(block.mutable_contents() + block.size(),
+                          this->_block_size - block.size());
+      }
+
+      WeakBuffer
+      ParallelStreamBuffer::read_buffer()
+      {
+        throw elle::Exception("Gzip decompression not handled yet");
+      }
+
+      void
+      ParallelStreamBuffer::flush(Size size)
+      {
+        auto& block = this->_blocks.back();
+        block.size(block.size() + size);
+      }
+
+      void
+      ParallelStreamBuffer::_compress(bool last)
+      {
+        // Keep the block being filled unless this is the end: whether it is
+        // the last one is not known yet.
+        auto count = this->_blocks.size();
+        if (!last)
+          count -= 1;
+        else if (this->_blocks.empty())
+        {
+          // The final DEFLATE block must be written even with no data.
+          this->_blocks.emplace_back();
+          count = 1;
+        }
+        ELLE_TRACE_SCOPE("%s: compress %s blocks", *this, count);
+        auto batch = std::make_unique<Batch>();
+        batch->blocks.assign(
+          std::make_move_iterator(this->_blocks.begin()),
+          std::make_move_iterator(this->_blocks.begin() + count));
+        this->_blocks.erase(this->_blocks.begin(),
+                            this->_blocks.begin() + count);
+        batch->dictionary = std::move(this->_dictionary);
+        batch->compressed.resize(count);
+        batch->crcs.resize(count);
+        // Prime the next batch with the end of this one.
+        {
+          auto const& tail = batch->blocks.back();
+          auto const window = std::min(tail.size(), window_size);
+          this->_dictionary = elle::Buffer(
+            tail.contents() + tail.size() - window, window);
+        }
+        auto jobs = std::vector<std::function<void ()>>{};
+        for (auto i = 0u; i < count; ++i)
+          jobs.emplace_back(
+            [this, b = batch.get(), i, last]
+            {
+              auto const& block = b->blocks[i];
+              auto const& previous = i == 0 ? b->dictionary : b->blocks[i - 1];
+              auto const window = std::min(previous.size(), window_size);
+              b->compressed[i] = deflate_block(
+                block,
+                elle::ConstWeakBuffer(
+                  previous.contents() + previous.size() - window, window),
+                this->_level,
+                last && i + 1 == b->blocks.size());
+              b->crcs[i] = crc32(crc32(0, Z_NULL, 0),
+                                 block.contents(), block.size());
+            });
+        if (this->_runner)
+          // The last batch may hold one block more than the jobs: no more
+          // than `jobs` compressions run at once.
+          for (auto start = 0u; start < jobs.size(); start += this->_jobs)
+            this->_runner(std::vector<std::function<void ()>>(
+              jobs.begin() + start,
+              jobs.begin() + std::min<std::size_t>(start + this->_jobs,
+                                                   jobs.size())));
+        else
+          for (auto& job: jobs)
+            batch->running.emplace_back(Pool::instance().run(std::move(job)));
+        // Write the previous batch out while this one compresses.
+        this->_write();
+        this->_compressing = std::move(batch);
+        if (last)
+          this->_write();
+      }
+
+      void
+      ParallelStreamBuffer::_write()
+      {
+        if (!this->_compressing)
+          return;
+        auto batch = std::move(this->_compressing);
+        for (auto& job: batch->running)
+          job.get();
+        for (auto i = 0u; i < batch->blocks.size(); ++i)
+        {
+          auto const& block = batch->blocks[i];
+          this->_crc = crc32_combine(this->_crc, batch->crcs[i], block.size());
+          this->_size += block.size();
+          this->_underlying.write(
+            reinterpret_cast<char const*>(batch->compressed[i].contents()),
+            batch->compressed[i].size());
+        }
+        if (!this->_underlying)
+          throw elle::Exception("unable to write compressed data");
+      }
+
+      ParallelStream::ParallelStream(std::ostream& underlying,
+                                     int jobs,
+                                     Buffer::Size block_size,
+                                     int level,
+                                     Runner runner)
+        : IOStream(new ParallelStreamBuffer(
+                     underlying, jobs, block_size, level, std::move(runner)))
+      {}
+
+      /*---------.
+      | One shot |
+      `---------*/
+
+      elle::Buffer
+      compress(elle::ConstWeakBuffer data, int level)
+      {
+        auto stream = z_stream{};
+        check(deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8,
+                           Z_DEFAULT_STRATEGY),
+              "deflateInit");
+        elle::SafeFinally end([&] { deflateEnd(&stream); });
+        auto res = elle::Buffer(deflateBound(&stream, data.size()));
+        stream.next_in = const_cast<Bytef*>(data.contents());
+        stream.avail_in = data.size();
+        stream.next_out = res.mutable_contents();
+        stream.avail_out = res.size();
+        auto ret = deflate(&stream, Z_FINISH);
+        ELLE_ASSERT_EQ(ret, Z_STREAM_END);
+        res.size(res.size() - stream.avail_out);
+        return res;
+      }
+
+      elle::Buffer
+      decompress(elle::ConstWeakBuffer data)
+      {
+        auto stream = z_stream{};
+        // 32: detect ZLIB or GZIP headers.
+        check(inflateInit2(&stream, 15 + 32), "inflateInit");
+        elle::SafeFinally end([&] { inflateEnd(&stream); });
+        auto res = elle::Buffer(std::max<Buffer::Size>(data.size() * 4,
+                                                        1024));
+        stream.next_in = const_cast<Bytef*>(data.contents());
+        stream.avail_in = data.size();
+        auto produced = Buffer::Size(0);
+        while (true)
+        {
+          if (produced == res.size())
+            res.size(res.size() * 2);
+          stream.next_out = res.mutable_contents() + produced;
+          stream.avail_out = res.size() - produced;
+          auto ret = inflate(&stream, Z_NO_FLUSH);
+          produced = res.size() - stream.avail_out;
+          if (ret == Z_STREAM_END)
+          {
+            if (stream.avail_in == 0)
+              break;
+            // Another member follows.
+            check(inflateReset(&stream), "inflateReset");
+          }
+          else if (ret == Z_BUF_ERROR && stream.avail_in == 0)
+            throw elle::Exception("truncated GZIP data");
+          else if (ret != Z_OK && ret != Z_BUF_ERROR)
+            throw elle::Exception(
+              elle::sprintf("ZLIB inflate error: %s", ret));
+        }
+        res.size(produced);
+        return res;
+      }
     }
   }
 }
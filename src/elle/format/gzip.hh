@@ -1,6 +1,9 @@
 #ifndef ELLE_FORMAT_GZIP_HH
 # define ELLE_FORMAT_GZIP_HH
 
+# include <functional>
+# include <vector>
+
 # include <elle/Buffer.hh>
 # include <elle/IOStream.hh>
 # include <elle/compiler.hh>
@@ -27,7 +30,7 @@ namespace elle
       /// to ensure compressed packets are sent immediately on flush() and not
       /// waiting to be compressed with the next ones.
       ///
-      /// Decompression is not supported for now.
+      /// Decompression is not supported for now, see decompress.
       class ELLE_API Stream
         : public elle::IOStream
       {
@@ -41,6 +44,73 @@ namespace elle
                bool honor_flush,
                Buffer::Size buffer_size = 1 << 16);
       };
+
+      /// Run jobs concurrently, returning once they are all done.
+      using Runner = std::function<void (std::vector<std::function<void ()>>
+                                         const& jobs)>;
+
+      /// Stream wrapper that compresses to GZIP on several cores.
+      ///
+      /// Data is cut in blocks compressed concurrently, each one primed with
+      /// the end of the previous one so the ratio is close to a sequential
+      /// compression. Blocks are concatenated in a single standard GZIP member
+      /// that any GZIP decompressor reads.
+      ///
+      /// Blocks are compressed by batches of `jobs`, so about `2 * jobs`
+      /// blocks are held in memory. Compression starts when a batch is full
+      /// and on destruction: flushing the stream does not force output.
+      ///
+      /// By default, blocks are compressed on a pool of threads shared by all
+      /// streams, and a batch compresses while the next one fills. A Runner
+      /// can run them elsewhere instead, for instance on the reactor
+      /// background pool so the scheduler keeps running meanwhile. Runners
+      /// return once their jobs are done, so batches are then compressed
+      /// one after the other:
+      ///
+      /// @code{.cc}
+      ///
+      /// elle::format::gzip::ParallelStream gzip(
+      ///   output, 4, 1 << 17, Z_DEFAULT_COMPRESSION,
+      ///   [] (std::vector<std::function<void ()>> const& jobs)
+      ///   {
+      ///     elle::reactor::for_each_parallel(
+      ///       jobs,
+      ///       [] (std::function<void ()> const& job)
+      ///       {
+      ///         elle::reactor::background(job);
+      ///       });
+      ///   });
+      ///
+      /// @endcode
+      class ELLE_API ParallelStream
+        : public elle::IOStream
+      {
+      public:
+        /// Construct a ParallelStream.
+        ///
+        /// \param underlying The wrapped stream to write compressed data to.
+        /// \param jobs       The number of blocks compressed concurrently.
+        /// \param block_size The size of compressed blocks.
+        /// \param level      The ZLIB compression level, -1 for the default.
+        /// \param runner     How to run compression jobs concurrently.
+        ParallelStream(std::ostream& underlying,
+                       int jobs,
+                       Buffer::Size block_size = 1 << 17,
+                       int level = -1,
+                       Runner runner = {});
+      };
+
+      /// Compress @a data to a GZIP member.
+      ///
+      /// \param level The ZLIB compression level, -1 for the default.
+      ELLE_API
+      elle::Buffer
+      compress(elle::ConstWeakBuffer data, int level = -1);
+
+      /// Decompress GZIP @a data, possibly several concatenated members.
+      ELLE_API
+      elle::Buffer
+      decompress(elle::ConstWeakBuffer data);
     }
   }
 }
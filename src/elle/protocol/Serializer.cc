@@ -428,7 +428,6 @@ namespace elle
                   this->_stream,
                   this->version(), packet, false, offset, to_send);
                 offset += to_send;
-                this->_stream.flush();
               };
             {
               elle::With<elle::reactor::Thread::NonInterruptible>() << [&]
@@ -450,8 +449,10 @@ namespace elle
                 this->write_control(Control::keep_going);
                 send();
               };
-              this->write_pings_pongs(true);
+              // Buffered: sent along with the next chunk.
+              this->write_pings_pongs(false);
             }
+            this->_stream.flush();
           }
           catch (elle::reactor::Terminate const&)
           {
@@ -460,7 +461,8 @@ namespace elle
               ELLE_DEBUG("interrupted after sending %s bytes over %s",
                          offset, packet.size());
               this->write_control(Control::interrupt);
-              this->write_pings_pongs(true);
+              this->write_pings_pongs(false);
+              this->_stream.flush();
             }
             throw;
           }
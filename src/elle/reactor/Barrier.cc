@@ -58,12 +58,12 @@ namespace elle
     }
 
     bool
-    Barrier::_wait(Thread* thread, Waker const& waker)
+    Barrier::_wait(Handler& handler)
     {
       if (this->_opened)
         return false;
       else
-        return Super::_wait(thread, waker);
+        return Super::_wait(handler);
     }
 
     void
@@ -96,12 +96,12 @@ namespace elle
     {}
 
     bool
-    Barrier::InvertedBarrier::_wait(Thread* thread, Waker const& waker)
+    Barrier::InvertedBarrier::_wait(Handler& handler)
     {
       if (!this->_barrier._opened)
         return false;
       else
-        return Super::_wait(thread, waker);
+        return Super::_wait(handler);
     }
 
     Barrier::InvertedBarrier::operator bool() const
@@ -64,7 +64,7 @@ namespace elle
     protected:
       /// Stop the thread if and only if this is closed.
       bool
-      _wait(Thread* thread, Waker const&) override;
+      _wait(Handler& handler) override;
 
       /*----------.
       | Exception |
@@ -90,7 +90,7 @@ namespace elle
         InvertedBarrier(Barrier& barrier);
         /// Stop the thread if and only if this is opened.
         bool
-        _wait(Thread* thread, Waker const& waker) override;
+        _wait(Handler& handler) override;
         operator bool() const;
       private:
         friend class Barrier;
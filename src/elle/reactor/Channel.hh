@@ -1,11 +1,15 @@
 #pragma once
 
-#include <queue>
+#include <atomic>
 #include <limits>
+#include <memory>
+#include <queue>
+#include <vector>
 
 #include <elle/Printable.hh>
 #include <elle/attribute.hh>
 #include <elle/reactor/Barrier.hh>
+#include <elle/reactor/fwd.hh>
 
 namespace elle
 {
@@ -46,6 +50,13 @@ namespace elle
     /// };
     /// // Result:
     /// // put 0.put 1.get 0.get 1.put 2.put 3.get 3.get 4.put 4.get 4.
+    /// @endcode
+    ///
+    /// Batches of elements can be put and got at once: waiters are woken and
+    /// signals emitted once per batch instead of once per element. Use a
+    /// RingBuffer as Container for a bounded channel that does not allocate
+    /// once full. System threads can put elements with mt_put without
+    /// locking.
     template <class T, class Container = std::queue<T>>
     class Channel
       : public elle::Printable
@@ -65,6 +76,7 @@ namespace elle
       /// Create a Channel from another Channel. Data are acquired by this
       /// Channel.
       Channel(Self&& source);
+      ~Channel();
 
       /*--------.
       | Content |
@@ -86,6 +98,26 @@ namespace elle
       template <typename... Args>
       void
       emplace(Args&&... args);
+      /// Put all of @a data, in order.
+      ///
+      /// Elements are put as many at a time as capacity allows, yielding
+      /// until there is room for more.
+      ///
+      /// @param data The data to store.
+      void
+      put_batch(std::vector<T> data);
+      /// Put data from any system thread.
+      ///
+      /// Elements are handed over without locking, and moved to the Channel
+      /// in the scheduler thread, in the order each thread put them. Only
+      /// the first element put since the previous hand over wakes the
+      /// scheduler. System threads are not held back by max_size, since
+      /// they cannot yield.
+      ///
+      /// @pre The Channel was created in a Scheduler.
+      /// @param data The data to store.
+      void
+      mt_put(T data);
 
       /// Get data and pop it from the Channel.
       ///
@@ -98,6 +130,14 @@ namespace elle
       /// @post _read_barrier is closed if _size == 0.
       T
       get();
+      /// Get up to @a max elements and pop them from the Channel.
+      ///
+      /// If _read_barrier is not opened, wait until it is.
+      ///
+      /// @param max The maximum number of elements to get.
+      /// @returns Queued data, at least one element.
+      std::vector<T>
+      get_batch(int max);
       /// Get data from the Channel without altering it.
       ///
       /// If _read_barrier is not opened, wait until it is.
@@ -120,6 +160,13 @@ namespace elle
       void
       raise(Args&& ... args);
     private:
+      void
+      _wait_readable();
+      void
+      _wait_writable();
+      /// Wake readers after elements were put.
+      void
+      _available();
       void
       _exhausted();
 
@@ -156,6 +203,33 @@ namespace elle
       {
         SizeUnlimited = std::numeric_limits<int>::max()
       };
+
+    /*----------------.
+    | Multithread API |
+    `----------------*/
+    private:
+      /// Elements put by system threads, not moved to the Channel yet.
+      ///
+      /// Shared with the hand over callbacks, which may outlive the Channel.
+      struct Inbox
+      {
+        struct Node
+        {
+          T data;
+          Node* next;
+        };
+        Inbox(Self* channel);
+        ~Inbox();
+        /// The Channel, or null once destroyed.
+        Self* channel;
+        Scheduler* scheduler;
+        /// The latest element put.
+        std::atomic<Node*> head;
+      };
+      /// Move the elements put by system threads to the Channel.
+      void
+      _drain();
+      ELLE_ATTRIBUTE(std::shared_ptr<Inbox>, inbox);
     };
   }
 }
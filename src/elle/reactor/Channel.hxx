@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <utility>
+
 #include <elle/reactor/scheduler.hh>
 
 namespace elle
@@ -16,6 +19,7 @@ namespace elle
       , _write_barrier("channel write")
       , _opened(true)
       , _max_size(SizeUnlimited)
+      , _inbox(std::make_shared<Inbox>(this))
     {}
 
     template <typename T, typename Container>
@@ -25,7 +29,17 @@ namespace elle
       , _queue(std::move(source._queue))
       , _opened(source._opened)
       , _max_size(source._max_size)
-    {}
+      , _inbox(std::move(source._inbox))
+    {
+      this->_inbox->channel = this;
+    }
+
+    template <typename T, typename Container>
+    Channel<T, Container>::~Channel()
+    {
+      if (this->_inbox)
+        this->_inbox->channel = nullptr;
+    }
 
     /*--------.
     | Content |
@@ -44,6 +58,34 @@ namespace elle
     {
       ELLE_LOG_COMPONENT("elle.reactor.Channel");
       ELLE_TRACE_SCOPE("%s: put", this);
+      this->_wait_writable();
+      this->_queue.push(std::move(data));
+      this->_available();
+    }
+
+    template <typename T, typename Container>
+    void
+    Channel<T, Container>::put_batch(std::vector<T> data)
+    {
+      ELLE_LOG_COMPONENT("elle.reactor.Channel");
+      ELLE_TRACE_SCOPE("%s: put %s elements", this, data.size());
+      auto it = data.begin();
+      while (it != data.end())
+      {
+        this->_wait_writable();
+        auto const room = std::min<std::size_t>(
+          this->_max_size - this->_queue.size(), data.end() - it);
+        for (auto end = it + room; it != end; ++it)
+          this->_queue.push(std::move(*it));
+        this->_available();
+      }
+    }
+
+    template <typename T, typename Container>
+    void
+    Channel<T, Container>::_wait_writable()
+    {
+      ELLE_LOG_COMPONENT("elle.reactor.Channel");
       if (signed(this->_queue.size()) >= this->_max_size)
       {
         ELLE_DEBUG("at capacity, wait");
@@ -55,7 +97,13 @@ namespace elle
         while (signed(this->_queue.size()) >= this->_max_size);
         ELLE_DEBUG("gained capacity, resume put");
       }
-      this->_queue.push(std::move(data));
+    }
+
+    template <typename T, typename Container>
+    void
+    Channel<T, Container>::_available()
+    {
+      ELLE_LOG_COMPONENT("elle.reactor.Channel");
       if (this->_opened && !this->_read_barrier.opened())
       {
         ELLE_DEBUG("open");
@@ -99,16 +147,7 @@ namespace elle
     {
       ELLE_LOG_COMPONENT("elle.reactor.Channel");
       ELLE_TRACE_SCOPE("%s: get", this);
-      if (!this->_read_barrier.opened())
-      {
-        ELLE_TRACE_SCOPE("wait for data");
-        // Loop in case the channel was exhausted by another reader.
-        while(!this->_read_barrier.opened())
-          reactor::wait(this->_read_barrier);
-      }
-      else if (this->_queue.empty() && this->_exception)
-        std::rethrow_exception(this->_exception);
-      ELLE_ASSERT(!this->_queue.empty());
+      this->_wait_readable();
       T res(std::move(details::queue_front(this->_queue)));
       this->_queue.pop();
       ELLE_DEBUG("got data")
@@ -121,6 +160,48 @@ namespace elle
       return res;
     }
 
+    template <typename T, typename Container>
+    std::vector<T>
+    Channel<T, Container>::get_batch(int max)
+    {
+      ELLE_LOG_COMPONENT("elle.reactor.Channel");
+      ELLE_TRACE_SCOPE("%s: get up to %s elements", this, max);
+      ELLE_ASSERT_GT(max, 0);
+      this->_wait_readable();
+      auto const count = std::min<std::size_t>(max, this->_queue.size());
+      auto res = std::vector<T>{};
+      res.reserve(count);
+      for (auto i = 0u; i < count; ++i)
+      {
+        res.emplace_back(std::move(details::queue_front(this->_queue)));
+        this->_queue.pop();
+      }
+      ELLE_DEBUG("got %s elements", count);
+      if (this->_queue.empty())
+        this->_exhausted();
+      if (signed(this->_queue.size()) < this->_max_size)
+        this->_write_barrier.open();
+      this->_on_get();
+      return res;
+    }
+
+    template <typename T, typename Container>
+    void
+    Channel<T, Container>::_wait_readable()
+    {
+      ELLE_LOG_COMPONENT("elle.reactor.Channel");
+      if (!this->_read_barrier.opened())
+      {
+        ELLE_TRACE_SCOPE("wait for data");
+        // Loop in case the channel was exhausted by another reader.
+        while(!this->_read_barrier.opened())
+          reactor::wait(this->_read_barrier);
+      }
+      else if (this->_queue.empty() && this->_exception)
+        std::rethrow_exception(this->_exception);
+      ELLE_ASSERT(!this->_queue.empty());
+    }
+
     template <typename T, typename Container>
     void
     Channel<T, Container>::_exhausted()
@@ -236,6 +317,73 @@ namespace elle
       this->_opened = false;
     }
 
+    /*----------------.
+    | Multithread API |
+    `----------------*/
+
+    template <typename T, typename Container>
+    Channel<T, Container>::Inbox::Inbox(Self* channel)
+      : channel(channel)
+      , scheduler(Scheduler::scheduler())
+      , head(nullptr)
+    {}
+
+    template <typename T, typename Container>
+    Channel<T, Container>::Inbox::~Inbox()
+    {
+      auto node = this->head.load();
+      while (node)
+        delete std::exchange(node, node->next);
+    }
+
+    template <typename T, typename Container>
+    void
+    Channel<T, Container>::mt_put(T data)
+    {
+      ELLE_ASSERT(this->_inbox->scheduler);
+      auto node = new typename Inbox::Node{std::move(data), nullptr};
+      node->next = this->_inbox->head.load(std::memory_order_relaxed);
+      while (!this->_inbox->head.compare_exchange_weak(
+               node->next, node,
+               std::memory_order_release, std::memory_order_relaxed))
+        continue;
+      // Elements put before this one are already being handed over.
+      if (!node->next)
+        this->_inbox->scheduler->io_service().post(
+          [inbox = this->_inbox]
+          {
+            if (inbox->channel)
+              inbox->channel->_drain();
+          });
+    }
+
+    template <typename T, typename Container>
+    void
+    Channel<T, Container>::_drain()
+    {
+      ELLE_LOG_COMPONENT("elle.reactor.Channel");
+      auto node =
+        this->_inbox->head.exchange(nullptr, std::memory_order_acquire);
+      // Elements are linked from the latest: restore the order they were
+      // put in.
+      auto ordered = static_cast<typename Inbox::Node*>(nullptr);
+      while (node)
+      {
+        auto next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+      }
+      ELLE_TRACE_SCOPE("%s: get elements put by system threads", this);
+      while (ordered)
+      {
+        auto n = std::unique_ptr<typename Inbox::Node>(ordered);
+        ordered = n->next;
+        this->_queue.push(std::move(n->data));
+      }
+      this->_available();
+    }
+
     /*----------.
     | Printable |
     `----------*/
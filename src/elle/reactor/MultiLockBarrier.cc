@@ -94,12 +94,12 @@ namespace elle
     `---------*/
 
     bool
-    MultiLockBarrier::_wait(Thread* thread, Waker const& waker)
+    MultiLockBarrier::_wait(Handler& handler)
     {
       if (this->opened())
         return false;
       else
-        return Super::_wait(thread, waker);
+        return Super::_wait(handler);
     }
   }
 }
@@ -91,7 +91,7 @@ namespace elle
     protected:
       /// Stop the thread if and only if this is closed.
       bool
-      _wait(Thread* thread, Waker const& waker) override;
+      _wait(Handler& handler) override;
 
     /*------.
     | Hooks |
@@ -1,4 +1,5 @@
 #include <elle/reactor/OrWaitable.hh>
+#include <elle/assert.hh>
 #include <elle/printf.hh>
 
 namespace elle
@@ -8,8 +9,18 @@ namespace elle
     OrWaitable::OrWaitable(Waitable& lhs, Waitable& rhs)
       : _lhs(lhs)
       , _rhs(rhs)
+      , _lhs_handler(
+        nullptr, [this] (Resumable*) { this->_done(this->_rhs_handler); })
+      , _rhs_handler(
+        nullptr, [this] (Resumable*) { this->_done(this->_lhs_handler); })
     {}
 
+    OrWaitable::OrWaitable(OrWaitable&& source)
+      : OrWaitable(source._lhs, source._rhs)
+    {
+      ELLE_ASSERT(source.waiters().empty());
+    }
+
     void
     OrWaitable::print(std::ostream& output) const
     {
@@ -17,24 +28,37 @@ namespace elle
     }
 
     bool
-    OrWaitable::_wait(Thread* t, Waker const& waker)
+    OrWaitable::_wait(Handler& handler)
     {
-      if (!this->_lhs._wait(t, [this] (Thread* t)
-                            {
-                              this->_rhs._unwait(t);
-                              this->_signal_one(t);
-                            }))
+      ELLE_ASSERT(this->waiters().empty());
+      this->_lhs_handler.resumable = handler.resumable;
+      this->_rhs_handler.resumable = handler.resumable;
+      if (!this->_lhs._wait(this->_lhs_handler))
         return false;
-      if (!this->_rhs._wait(t, [this] (Thread* t)
-                            {
-                              this->_lhs._unwait(t);
-                              this->_signal_one(t);
-                            }))
+      if (!this->_rhs._wait(this->_rhs_handler))
       {
-        this->_lhs._unwait(t);
+        this->_lhs._unwait(this->_lhs_handler);
         return false;
       }
-      return Waitable::_wait(t, waker);
+      return Waitable::_wait(handler);
+    }
+
+    void
+    OrWaitable::_unwait(Handler& handler)
+    {
+      if (this->_lhs_handler.is_linked())
+        this->_lhs._unwait(this->_lhs_handler);
+      if (this->_rhs_handler.is_linked())
+        this->_rhs._unwait(this->_rhs_handler);
+      Waitable::_unwait(handler);
+    }
+
+    void
+    OrWaitable::_done(Handler& other)
+    {
+      if (other.is_linked())
+        other.waitable->_unwait(other);
+      this->_signal();
     }
 
     reactor::OrWaitable
@@ -19,6 +19,8 @@ namespace elle
     /// (s || b).wait();
     ///
     /// \endcode.
+    ///
+    /// An OrWaitable is waited for by one thread at a time.
     class OrWaitable
       : public Waitable
     {
@@ -28,6 +30,7 @@ namespace elle
       /// \param lhs First Waitable.
       /// \param lhs Second Waitable.
       OrWaitable(Waitable& lhs, Waitable& rhs);
+      OrWaitable(OrWaitable&& source);
       virtual
       void
       print(std::ostream& output) const override;
@@ -35,11 +38,19 @@ namespace elle
     protected:
       virtual
       bool
-      _wait(Thread* t, Waker const& waker) override;
+      _wait(Handler& handler) override;
+      virtual
+      void
+      _unwait(Handler& handler) override;
 
     private:
+      /// Wake our waiter, forgetting about the @a other Waitable.
+      void
+      _done(Handler& other);
       ELLE_ATTRIBUTE(Waitable&, lhs);
       ELLE_ATTRIBUTE(Waitable&, rhs);
+      ELLE_ATTRIBUTE(Handler, lhs_handler);
+      ELLE_ATTRIBUTE(Handler, rhs_handler);
     };
 
     /// Allow for using || (or) operator to create OrWaitables.
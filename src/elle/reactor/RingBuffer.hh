@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include <elle/attribute.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    /// A FIFO queue stored in a circular array.
+    ///
+    /// It provides the std::queue operations Channel relies on, so it can be
+    /// used as a Channel storage. Unlike std::deque, which allocates a block
+    /// every few elements as the queue moves forward, it only allocates when
+    /// it grows: once a bounded Channel reached its max_size, pushing and
+    /// popping allocates nothing.
+    ///
+    /// @code{.cc}
+    ///
+    /// Channel<Packet, RingBuffer<Packet>> channel;
+    /// channel.max_size(1024);
+    ///
+    /// @endcode
+    template <typename T>
+    class RingBuffer
+    {
+    /*------.
+    | Types |
+    `------*/
+    public:
+      using Self = RingBuffer<T>;
+      using value_type = T;
+      using size_type = std::size_t;
+      using reference = T&;
+      using const_reference = T const&;
+
+    /*-------------.
+    | Construction |
+    `-------------*/
+    public:
+      /// Create an empty RingBuffer.
+      ///
+      /// @param capacity The number of elements it holds before growing,
+      ///                 rounded up to a power of two.
+      RingBuffer(size_type capacity = 16);
+      RingBuffer(Self&& source);
+      Self&
+      operator =(Self&& source);
+      ~RingBuffer();
+
+    /*--------.
+    | Content |
+    `--------*/
+    public:
+      bool
+      empty() const;
+      size_type
+      size() const;
+      /// The oldest element.
+      T&
+      front();
+      T const&
+      front() const;
+      /// Append @a value, doubling the capacity if full.
+      void
+      push(T value);
+      template <typename ... Args>
+      void
+      emplace(Args&& ... args);
+      /// Remove the oldest element.
+      void
+      pop();
+      /// Remove all elements, keeping the capacity.
+      void
+      clear();
+      ELLE_ATTRIBUTE_R(size_type, capacity);
+    private:
+      using Storage =
+        std::aligned_storage_t<sizeof(T), alignof(T)>;
+      T*
+      _at(size_type index);
+      void
+      _grow();
+      ELLE_ATTRIBUTE(std::unique_ptr<Storage[]>, storage);
+      /// The index of the oldest element.
+      ELLE_ATTRIBUTE(size_type, head);
+      ELLE_ATTRIBUTE(size_type, size);
+    };
+  }
+}
+
+#include <elle/reactor/RingBuffer.hxx>
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <utility>
+
+#include <elle/assert.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    /*-------------.
+    | Construction |
+    `-------------*/
+
+    template <typename T>
+    RingBuffer<T>::RingBuffer(size_type capacity)
+      : _capacity(1)
+      , _storage()
+      , _head(0)
+      , _size(0)
+    {
+      while (this->_capacity < capacity)
+        this->_capacity *= 2;
+      this->_storage.reset(new Storage[this->_capacity]);
+    }
+
+    template <typename T>
+    RingBuffer<T>::RingBuffer(Self&& source)
+      : _capacity(source._capacity)
+      , _storage(std::move(source._storage))
+      , _head(source._head)
+      , _size(source._size)
+    {
+      source._storage.reset(new Storage[1]);
+      source._capacity = 1;
+      source._head = 0;
+      source._size = 0;
+    }
+
+    template <typename T>
+    auto
+    RingBuffer<T>::operator =(Self&& source)
+      -> Self&
+    {
+      if (&source != this)
+      {
+        this->clear();
+        std::swap(this->_capacity, source._capacity);
+        std::swap(this->_storage, source._storage);
+        std::swap(this->_head, source._head);
+        std::swap(this->_size, source._size);
+      }
+      return *this;
+    }
+
+    template <typename T>
+    RingBuffer<T>::~RingBuffer()
+    {
+      this->clear();
+    }
+
+    /*--------.
+    | Content |
+    `--------*/
+
+    template <typename T>
+    bool
+    RingBuffer<T>::empty() const
+    {
+      return this->_size == 0;
+    }
+
+    template <typename T>
+    auto
+    RingBuffer<T>::size() const
+      -> size_type
+    {
+      return this->_size;
+    }
+
+    template <typename T>
+    T&
+    RingBuffer<T>::front()
+    {
+      ELLE_ASSERT(!this->empty());
+      return *this->_at(this->_head);
+    }
+
+    template <typename T>
+    T const&
+    RingBuffer<T>::front() const
+    {
+      return const_cast<Self*>(this)->front();
+    }
+
+    template <typename T>
+    void
+    RingBuffer<T>::push(T value)
+    {
+      this->emplace(std::move(value));
+    }
+
+    template <typename T>
+    template <typename ... Args>
+    void
+    RingBuffer<T>::emplace(Args&& ... args)
+    {
+      if (this->_size == this->_capacity)
+        this->_grow();
+      new (this->_at(this->_head + this->_size))
+        T(std::forward<Args>(args)...);
+      ++this->_size;
+    }
+
+    template <typename T>
+    void
+    RingBuffer<T>::pop()
+    {
+      ELLE_ASSERT(!this->empty());
+      this->_at(this->_head)->~T();
+      this->_head = (this->_head + 1) & (this->_capacity - 1);
+      --this->_size;
+    }
+
+    template <typename T>
+    void
+    RingBuffer<T>::clear()
+    {
+      while (!this->empty())
+        this->pop();
+      this->_head = 0;
+    }
+
+    template <typename T>
+    T*
+    RingBuffer<T>::_at(size_type index)
+    {
+      return reinterpret_cast<T*>(
+        &this->_storage[index & (this->_capacity - 1)]);
+    }
+
+    template <typename T>
+    void
+    RingBuffer<T>::_grow()
+    {
+      auto grown = Self(this->_capacity * 2);
+      while (!this->empty())
+      {
+        grown.emplace(std::move(this->front()));
+        this->pop();
+      }
+      *this = std::move(grown);
+    }
+  }
+}
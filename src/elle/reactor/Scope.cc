@@ -174,7 +174,7 @@ namespace elle
     `---------*/
 
     bool
-    Scope::_wait(Thread* thread, Waker const& waker)
+    Scope::_wait(Handler& handler)
     {
       if (this->_running == 0)
       {
@@ -183,7 +183,7 @@ namespace elle
         return false;
       }
       else
-        return Waitable::_wait(thread, waker);
+        return Waitable::_wait(handler);
     }
 
     /*----------.
@@ -91,7 +91,7 @@ namespace elle
     `---------*/
     protected:
       bool
-      _wait(Thread* thread, Waker const& waker) override;
+      _wait(Handler& handler) override;
 
     private:
       ELLE_ATTRIBUTE_R(std::string, name);
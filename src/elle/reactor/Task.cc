@@ -0,0 +1,242 @@
+#include <utility>
+
+#include <elle/Exception.hh>
+#include <elle/assert.hh>
+#include <elle/log.hh>
+#include <elle/reactor/Task.hh>
+#include <elle/reactor/scheduler.hh>
+
+ELLE_LOG_COMPONENT("elle.reactor.Task");
+
+namespace elle
+{
+  namespace reactor
+  {
+    /*-------------.
+    | Construction |
+    `-------------*/
+
+    Task::Task(Scheduler& scheduler, std::string name, Action action)
+      : Resumable(std::move(name))
+      , _state(State::ready)
+      , _scheduler(scheduler)
+      , _managed(false)
+      , _timed_out(false)
+      , _exception_thrown()
+      , _action(std::move(action))
+      , _wait_handlers()
+      , _timer()
+      , _raised()
+      , _tasks_hook()
+      , _ready_hook()
+    {
+      ELLE_TRACE("%s: create", *this);
+      this->_scheduler._tasks.push_back(*this);
+      this->_scheduler._tasks_ready.push_back(*this);
+    }
+
+    Task::Task(std::string name, Action action)
+      : Task(reactor::scheduler(), std::move(name), std::move(action))
+    {}
+
+    Task::~Task()
+    {
+      if (this->_state == State::running)
+        ELLE_ABORT("%s: destroyed from its own action", *this);
+      this->terminate();
+    }
+
+    /*-------.
+    | Status |
+    `-------*/
+
+    bool
+    Task::done() const
+    {
+      return this->_state == State::done;
+    }
+
+    /*--------.
+    | Waiting |
+    `--------*/
+
+    void
+    Task::wait(Waitables const& waitables, DurationOpt timeout)
+    {
+      ELLE_TRACE_SCOPE("%s: wait %s%s", *this, waitables,
+                       timeout ? elle::sprintf(" for %s", timeout) : "");
+      this->_wait_for(waitables.data(), waitables.size(), timeout);
+    }
+
+    void
+    Task::wait(Waitable& waitable, DurationOpt timeout)
+    {
+      ELLE_TRACE_SCOPE("%s: wait %s%s", *this, waitable,
+                       timeout ? elle::sprintf(" for %s", timeout) : "");
+      auto w = &waitable;
+      this->_wait_for(&w, 1, timeout);
+    }
+
+    void
+    Task::_wait_for(Waitable* const* waitables,
+                    int count,
+                    DurationOpt timeout)
+    {
+      ELLE_ASSERT_EQ(this->_state, State::running);
+      this->_timed_out = false;
+      if (!this->_wait_start(waitables, count, this->_wait_handlers))
+      {
+        this->_ready();
+        return;
+      }
+      this->_state = State::waiting;
+      if (timeout)
+        this->_scheduler._timer_arm(
+          this->_timer, *timeout,
+          [this]
+          {
+            ELLE_TRACE("%s: timed out", *this);
+            this->_timed_out = true;
+            this->_wait_abort();
+          });
+    }
+
+    void
+    Task::sleep(Duration delay)
+    {
+      ELLE_TRACE("%s: sleep for %s", *this, delay);
+      ELLE_ASSERT_EQ(this->_state, State::running);
+      this->_state = State::waiting;
+      this->_scheduler._timer_arm(this->_timer, delay,
+                                  [this] { this->_ready(); });
+    }
+
+    void
+    Task::yield()
+    {
+      ELLE_ASSERT_EQ(this->_state, State::running);
+      this->_ready();
+    }
+
+    void
+    Task::terminate()
+    {
+      if (this->_state == State::done)
+        return;
+      ELLE_TRACE_SCOPE("%s: terminate", *this);
+      auto const running = this->_state == State::running;
+      this->_wait_stop();
+      this->_done();
+      // From the action, it is released once it returns.
+      if (!running)
+        this->_action = nullptr;
+    }
+
+    bool
+    Task::_wait(Handler& handler)
+    {
+      if (this->_state == State::done)
+        if (this->_managed && this->_exception_thrown)
+          std::rethrow_exception(this->_exception_thrown);
+        else
+          return false;
+      else
+        return Waitable::_wait(handler);
+    }
+
+    void
+    Task::_run()
+    {
+      ELLE_TRACE_SCOPE("%s: run", *this);
+      ELLE_ASSERT_EQ(this->_state, State::ready);
+      this->_state = State::running;
+      try
+      {
+        if (auto e = std::exchange(this->_raised, std::exception_ptr{}))
+          std::rethrow_exception(e);
+        this->_action(*this);
+      }
+      catch (...)
+      {
+        ELLE_TRACE("%s: exception escaped: %s",
+                   *this, elle::exception_string());
+        this->_exception_thrown = std::current_exception();
+      }
+      if (this->_exception_thrown)
+        this->terminate();
+      else if (this->_state == State::running)
+        this->_done();
+      if (this->_state == State::done)
+        this->_action = nullptr;
+      if (this->_exception_thrown && !this->_managed)
+        std::rethrow_exception(this->_exception_thrown);
+    }
+
+    void
+    Task::_wake(Waitable* waitable)
+    {
+      ELLE_TRACE_SCOPE("%s: wait ended for %s", *this, *waitable);
+      if (waitable->_exception && !this->_raised)
+        this->_raised = waitable->_exception;
+      if (this->_wait_done())
+      {
+        this->_timer.cancel();
+        this->_ready();
+      }
+    }
+
+    void
+    Task::_wait_abort()
+    {
+      this->_wait_stop();
+      this->_timer.cancel();
+      this->_ready();
+    }
+
+    void
+    Task::_ready()
+    {
+      ELLE_ASSERT(!this->_ready_hook.is_linked());
+      this->_state = State::ready;
+      this->_scheduler._tasks_ready.push_back(*this);
+    }
+
+    void
+    Task::_done()
+    {
+      ELLE_TRACE_SCOPE("%s: done", *this);
+      this->_state = State::done;
+      this->_tasks_hook.unlink();
+      this->_ready_hook.unlink();
+      this->_timer.cancel();
+      if (this->_managed && this->_exception_thrown)
+        this->Waitable::_raise(this->_exception_thrown);
+      this->Waitable::_signal();
+    }
+
+    /*----------------.
+    | Print operators |
+    `----------------*/
+
+    std::ostream&
+    operator <<(std::ostream& s, Task::State state)
+    {
+      switch (state)
+      {
+      case Task::State::ready:
+        s << "ready";
+        break;
+      case Task::State::running:
+        s << "running";
+        break;
+      case Task::State::waiting:
+        s << "waiting";
+        break;
+      case Task::State::done:
+        s << "done";
+        break;
+      }
+      return s;
+    }
+  }
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include <boost/intrusive/list.hpp>
+
+#include <elle/attribute.hh>
+#include <elle/reactor/TimerWheel.hh>
+#include <elle/reactor/Waitable.hh>
+#include <elle/reactor/duration.hh>
+#include <elle/reactor/fwd.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    /// A stackless task.
+    ///
+    /// Unlike a Thread, a Task has no stack of its own: its action runs on
+    /// the scheduler stack and returns to wait, and is run again once the
+    /// wait is over. Its state lives in the action itself, for instance as
+    /// captures along with a boost::asio::coroutine. It costs a few hundred
+    /// bytes instead of a coroutine stack, and starting it allocates nothing
+    /// but the action.
+    ///
+    /// Like a Thread, a Task waits for any Waitable and can be waited for
+    /// until done. An exception escaping its action, or raised by what it
+    /// waits for, ends it. If the task is managed, the exception is raised to
+    /// its waiters, otherwise the scheduler rethrows it.
+    ///
+    /// @code{.cc}
+    ///
+    /// reactor::Task pinger(
+    ///   "pinger",
+    ///   [&, coro = boost::asio::coroutine()] (reactor::Task& self) mutable
+    ///   {
+    ///     BOOST_ASIO_CORO_REENTER(coro)
+    ///       while (!stopped)
+    ///       {
+    ///         ping();
+    ///         BOOST_ASIO_CORO_YIELD self.sleep(1s);
+    ///       }
+    ///   });
+    /// reactor::wait(pinger);
+    ///
+    /// @endcode
+    class Task
+      : public Resumable
+    {
+    /*------.
+    | Types |
+    `------*/
+    public:
+      using Self = Task;
+      /// The body of the task, run until it no longer waits.
+      using Action = std::function<void (Task&)>;
+      using Hook = boost::intrusive::list_member_hook<
+        boost::intrusive::link_mode<boost::intrusive::auto_unlink>>;
+      /// Tasks, by one of their hooks.
+      template <Hook Self::* hook>
+      using List = boost::intrusive::list<
+        Task,
+        boost::intrusive::member_hook<Task, Hook, hook>,
+        boost::intrusive::constant_time_size<false>>;
+
+    /*-------------.
+    | Construction |
+    `-------------*/
+    public:
+      /// Create a Task, run from the next scheduler step.
+      ///
+      /// @param scheduler The Scheduler to run the Task.
+      /// @param name A descriptive name of the Task, for debugging.
+      /// @param action The Action to run.
+      Task(Scheduler& scheduler, std::string name, Action action);
+      /// Create a Task run by the current Scheduler.
+      Task(std::string name, Action action);
+      Task(Self const&) = delete;
+      /// Terminate the Task if not done.
+      ~Task();
+
+    /*-------.
+    | Status |
+    `-------*/
+    public:
+      enum class State
+      {
+        /// Waiting to be run.
+        ready,
+        /// Running its action.
+        running,
+        /// Waiting for Waitables, a timeout or a delay.
+        waiting,
+        done,
+      };
+      ELLE_ATTRIBUTE_R(State, state);
+      /// Whether our state is State::done.
+      bool
+      done() const;
+      ELLE_ATTRIBUTE_R(Scheduler&, scheduler);
+      /// Whether exceptions escaping the Task are raised to its waiters
+      /// instead of the scheduler.
+      ELLE_ATTRIBUTE_RW(bool, managed);
+      /// Whether the latest wait timed out.
+      ELLE_ATTRIBUTE_R(bool, timed_out);
+      /// Exception that ended the Task.
+      ELLE_ATTRIBUTE_R(std::exception_ptr, exception_thrown);
+
+    /*--------.
+    | Waiting |
+    `--------*/
+    public:
+      /// Run the action again once @a waitables are done.
+      ///
+      /// Like the other waits, it is called at most once per run of the
+      /// action, which returns right after.
+      ///
+      /// @param waitables The Waitables to wait for.
+      /// @param timeout The delay after which to run the action anyway, with
+      ///                timed_out set.
+      void
+      wait(Waitables const& waitables, DurationOpt timeout = {});
+      /// Shortcut to wait for a single waitable.
+      void
+      wait(Waitable& waitable, DurationOpt timeout = {});
+      /// Run the action again after @a delay.
+      void
+      sleep(Duration delay);
+      /// Run the action again on the next scheduler step.
+      void
+      yield();
+      /// End the Task, without running its action anymore.
+      void
+      terminate();
+
+    protected:
+      bool
+      _wait(Handler& handler) override;
+    private:
+      friend class Scheduler;
+      /// Run the action, called by the scheduler.
+      void
+      _run();
+      void
+      _wait_for(Waitable* const* waitables, int count, DurationOpt timeout);
+      void
+      _wake(Waitable* waitable) override;
+      /// Stop waiting and run again.
+      void
+      _wait_abort();
+      void
+      _ready();
+      void
+      _done();
+      ELLE_ATTRIBUTE(Action, action);
+      ELLE_ATTRIBUTE(Handlers, wait_handlers);
+      /// Delays and wait timeouts.
+      ELLE_ATTRIBUTE(TimerWheel::Timer, timer);
+      /// Exception raised by a waitable, that ends the Task when it runs.
+      ELLE_ATTRIBUTE(std::exception_ptr, raised);
+      /// Link in the scheduler tasks.
+      ELLE_ATTRIBUTE(Hook, tasks_hook);
+      /// Link in the scheduler tasks ready to run.
+      ELLE_ATTRIBUTE(Hook, ready_hook);
+    public:
+      using Tasks = List<&Self::_tasks_hook>;
+      using Ready = List<&Self::_ready_hook>;
+    };
+
+    std::ostream&
+    operator <<(std::ostream& output, Task::State state);
+  }
+}
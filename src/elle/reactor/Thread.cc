@@ -31,9 +31,8 @@ namespace elle
       , _state(State::running)
       , _injection()
       , _exception()
-      , _waited()
       , _timeout(false)
-      , _timeout_timer(scheduler.io_service())
+      , _timeout_timer()
       , _thread(scheduler._manager->make_thread(
                   name,
                   [this, a=std::move(action)] ()
@@ -301,8 +300,12 @@ namespace elle
     bool
     Thread::wait(Waitable& s, DurationOpt timeout)
     {
-      auto waitables = Waitables{&s};
-      return wait(waitables, timeout);
+#ifndef ELLE_IOS
+      ELLE_TRACE_SCOPE("%s: wait %s%s", *this, s,
+                       timeout ? elle::sprintf(" for %s", timeout) : "");
+#endif
+      auto waitable = &s;
+      return this->_wait_for(&waitable, 1, timeout);
     }
 
     bool
@@ -312,47 +315,39 @@ namespace elle
       ELLE_TRACE_SCOPE("%s: wait %s%s", *this, waitables,
                        timeout ? elle::sprintf(" for %s", timeout) : "");
 #endif
+      return this->_wait_for(waitables.data(), waitables.size(), timeout);
+    }
+
+    bool
+    Thread::_wait_for(Waitable* const* waitables,
+                      int count,
+                      DurationOpt timeout)
+    {
       ELLE_ASSERT_EQ(_state, State::running);
-      ELLE_ASSERT(_waited.empty());
+      // The handlers live on our stack until the wait is over.
+      Handlers handlers;
       bool freeze = false;
-      for (auto s: waitables)
-        if (s->_wait(this, Waker()))
-        {
-          freeze = true;
-          _waited.insert(s);
-        }
-        else if (s->_exception)
-        {
-          for (auto waitable: this->_waited)
-            waitable->_unwait(this);
-          ELLE_ASSERT(this->_waited.empty());
-          try
-          {
-            std::rethrow_exception(s->_exception);
-          }
-          catch (elle::Exception& e)
-          {
-            // FIXME: Only the latest backtrace will be stored, but this is still
-            // better than the creation time backtrace, I suppose.
-            static bool keep = elle::os::getenv("ELLE_KEEP_ORIGINAL_BACKTRACE", false);
-            if (!keep)
-              e.backtrace(elle::Backtrace::current());
-            throw;
-          }
-        }
+      try
+      {
+        freeze = this->_wait_start(waitables, count, handlers);
+      }
+      catch (elle::Exception& e)
+      {
+        // FIXME: Only the latest backtrace will be stored, but this is still
+        // better than the creation time backtrace, I suppose.
+        static bool keep = elle::os::getenv("ELLE_KEEP_ORIGINAL_BACKTRACE", false);
+        if (!keep)
+          e.backtrace(elle::Backtrace::current());
+        throw;
+      }
       if (freeze)
       {
         if (timeout)
         {
-          this->_timeout_timer.expires_from_now(*timeout);
           this->_timeout = false;
-          auto repr = elle::sprintf("%s", waitables);
-          this->_timeout_timer.async_wait(
-            [this, repr]
-            (boost::system::error_code const& e)
-            {
-              this->_wait_timeout(e, repr);
-            });
+          this->_scheduler._timer_arm(
+            this->_timeout_timer, *timeout,
+            [this] { this->_wait_timeout(); });
           auto cancel_timeout = [this]
             {
               ELLE_DUMP("%s: cancel timeout", *this);
@@ -386,7 +381,7 @@ namespace elle
     }
 
     bool
-    Thread::_wait(Thread* thread, Waker const& waker)
+    Thread::_wait(Handler& handler)
     {
       if (_state == State::done)
         if (this->_managed && this->_exception_thrown)
@@ -394,49 +389,24 @@ namespace elle
         else
           return false;
       else
-        return Waitable::_wait(thread, waker);
-    }
-
-    static
-    std::ostream&
-    operator <<(std::ostream& output, std::set<Waitable*> waitables)
-    {
-      if (waitables.size() == 1)
-        output << **waitables.begin();
-      else
-      {
-        bool first = true;
-        for (auto const& waitable: waitables)
-        {
-          if (first)
-            first = false;
-          else
-            output << ", ";
-          output << *waitable;
-        }
-        output << "}";
-      }
-      return output;
+        return Waitable::_wait(handler);
     }
 
     void
-    Thread::_wait_timeout(boost::system::error_code const& e,
-                          std::string const& waited)
+    Thread::_wait_timeout()
     {
-      if (e == boost::system::errc::operation_canceled)
-        return;
-      // If we're not frozen anymore, the task must have ended in the same asio
-      // poll than the timeout: Thread::_wake was just called. Ignore the timeout.
+      // If we're not frozen anymore, the task must have ended in the same
+      // step than the timeout: Thread::_wake was just called. Ignore it.
       if (state() != State::frozen)
         return;
       ELLE_TRACE("%s: timed out", *this);
       this->_timeout = true;
+      auto const waited = this->waited();
       // FIXME: bug hunting, remove
-      if (this->_waited.size() == 1 &&
-          dynamic_cast<elle::reactor::http::Request*>(*this->_waited.begin()))
-        ELLE_WARN("DEBUG: timeout on HTTP request: %s", this->_waited);
-      this->_wait_abort(elle::sprintf("wait timeout for %s (waiting %s)",
-                                      waited, this->_waited));
+      if (waited.size() == 1 &&
+          dynamic_cast<elle::reactor::http::Request*>(waited.front()))
+        ELLE_WARN("DEBUG: timeout on HTTP request: %s", waited);
+      this->_wait_abort(elle::sprintf("wait timeout for %s", waited));
     }
 
     void
@@ -444,9 +414,7 @@ namespace elle
     {
       ELLE_TRACE("%s: abort wait because: %s", *this, reason);
       ELLE_ASSERT_EQ(state(), State::frozen);
-      for (Waitable* waitable: _waited)
-        waitable->_unwait(this);
-      this->_waited.clear();
+      this->_wait_stop();
       this->_timeout_timer.cancel();
       this->_scheduler._unfreeze(*this, reason);
       this->_state = State::running;
@@ -471,8 +439,7 @@ namespace elle
           ELLE_TRACE("%s: forward exception", *this);
           this->_exception = waitable->_exception;
         }
-        this->_waited.erase(waitable);
-        if (this->_waited.empty())
+        if (this->_wait_done())
         {
           ELLE_TRACE("%s: nothing to wait on, waking up", *this);
           this->_scheduler._unfreeze(
@@ -480,8 +447,7 @@ namespace elle
           this->_state = State::running;
         }
         else
-          ELLE_TRACE("%s: still waiting for %s other elements",
-                     *this, this->_waited.size());
+          ELLE_TRACE("%s: still waiting for other elements", *this);
       }
     }
 
@@ -12,6 +12,7 @@
 #include <elle/reactor/duration.hh>
 #include <elle/reactor/fwd.hh>
 #include <elle/reactor/signals.hh>
+#include <elle/reactor/TimerWheel.hh>
 #include <elle/reactor/Waitable.hh>
 
 namespace elle
@@ -66,7 +67,7 @@ namespace elle
     ///
     /// @endcode
     class Thread:
-      public Waitable
+      public Resumable
     {
     /*------.
     | Types |
@@ -295,23 +296,24 @@ namespace elle
       terminate_now(bool suicide = true);
     protected:
       bool
-      _wait(Thread* thread, Waker const& waker) override;
+      _wait(Handler& handler) override;
     private:
       friend class Scope;
       friend class TimeoutGuard;
       friend class Waitable;
+      /// Wait for @a count @a waitables.
+      bool
+      _wait_for(Waitable* const* waitables, int count, DurationOpt timeout);
       void
-      _wait_timeout(boost::system::error_code const& e,
-                    std::string const& waited);
+      _wait_timeout();
       void
       _wait_abort(std::string const& reason);
       void
       _freeze();
       void
-      _wake(Waitable* waitable);
-      ELLE_ATTRIBUTE_R(std::set<Waitable*>, waited);
+      _wake(Waitable* waitable) override;
       ELLE_ATTRIBUTE(bool, timeout);
-      ELLE_ATTRIBUTE(AsioTimer, timeout_timer);
+      ELLE_ATTRIBUTE(TimerWheel::Timer, timeout_timer);
 
     /*------.
     | Hooks |
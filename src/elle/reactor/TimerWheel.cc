@@ -0,0 +1,355 @@
+#include <elle/reactor/TimerWheel.hh>
+
+#include <algorithm>
+#include <limits>
+
+#include <elle/assert.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    namespace
+    {
+      /// The ticks in @a d, rounded down.
+      std::int64_t
+      floor(Duration d, Duration resolution)
+      {
+        auto const res = d / resolution;
+        return d < Duration::zero() && d % resolution != Duration::zero()
+          ? res - 1 : res;
+      }
+
+      /// The ticks in @a d, rounded up.
+      std::int64_t
+      ceil(Duration d, Duration resolution)
+      {
+        auto const res = d / resolution;
+        return d > Duration::zero() && d % resolution != Duration::zero()
+          ? res + 1 : res;
+      }
+
+      /// The index of the first set bit of @a mask, rotated right by
+      /// @a shift, or -1.
+      int
+      first(std::uint64_t mask, int shift)
+      {
+        if (!mask)
+          return -1;
+        if (shift)
+          mask = (mask >> shift) | (mask << (64 - shift));
+        return __builtin_ctzll(mask);
+      }
+    }
+
+    /*-----.
+    | List |
+    `-----*/
+
+    TimerWheel::List::List()
+      : head(nullptr)
+      , tail(nullptr)
+    {}
+
+    void
+    TimerWheel::List::push(Timer& timer)
+    {
+      timer._list = this;
+      timer._previous = this->tail;
+      timer._next = nullptr;
+      if (this->tail)
+        this->tail->_next = &timer;
+      else
+        this->head = &timer;
+      this->tail = &timer;
+    }
+
+    void
+    TimerWheel::List::erase(Timer& timer)
+    {
+      ELLE_ASSERT_EQ(timer._list, this);
+      if (timer._previous)
+        timer._previous->_next = timer._next;
+      else
+        this->head = timer._next;
+      if (timer._next)
+        timer._next->_previous = timer._previous;
+      else
+        this->tail = timer._previous;
+      timer._list = nullptr;
+      timer._previous = timer._next = nullptr;
+    }
+
+    void
+    TimerWheel::List::splice(List& list)
+    {
+      while (auto timer = list.head)
+      {
+        list.erase(*timer);
+        this->push(*timer);
+      }
+    }
+
+    /*-------------.
+    | Construction |
+    `-------------*/
+
+    TimerWheel::TimerWheel(Duration now, Duration resolution)
+      : _size(0)
+      , _resolution(resolution)
+      , _tick(floor(now, resolution))
+      , _wheel()
+      , _occupied()
+      , _due()
+    {}
+
+    TimerWheel::~TimerWheel()
+    {
+      auto release = [] (List& list)
+        {
+          while (auto timer = list.head)
+          {
+            list.erase(*timer);
+            timer->_wheel = nullptr;
+          }
+        };
+      release(this->_due);
+      for (auto& level: this->_wheel)
+        for (auto& slot: level)
+          release(slot);
+    }
+
+    /*-------.
+    | Timers |
+    `-------*/
+
+    void
+    TimerWheel::arm(Timer& timer,
+                    Duration deadline,
+                    std::function<void ()> action)
+    {
+      timer.cancel();
+      timer._wheel = this;
+      timer._tick = ceil(deadline, this->_resolution);
+      timer._action = std::move(action);
+      ++this->_size;
+      if (timer._tick <= this->_tick)
+      {
+        timer._level = -1;
+        this->_due.push(timer);
+      }
+      else
+        this->_insert(timer);
+    }
+
+    int
+    TimerWheel::advance(Duration now)
+    {
+      auto const target = floor(now, this->_resolution);
+      auto res = 0;
+      if (this->_due.head)
+      {
+        auto due = List();
+        due.splice(this->_due);
+        res += this->_run(due);
+      }
+      while (this->_tick < target)
+      {
+        auto const next = this->_next_tick();
+        if (next > target)
+        {
+          this->_tick = target;
+          break;
+        }
+        this->_tick = next - 1;
+        res += this->_tick_once();
+      }
+      return res;
+    }
+
+    void
+    TimerWheel::reset(Duration now)
+    {
+      auto armed = List();
+      for (int level = 0; level < levels; ++level)
+      {
+        for (auto& slot: this->_wheel[level])
+          armed.splice(slot);
+        this->_occupied[level] = 0;
+      }
+      auto const tick = floor(now, this->_resolution);
+      auto const shift = tick - this->_tick;
+      this->_tick = tick;
+      for (auto timer = this->_due.head; timer; timer = timer->_next)
+        timer->_tick = tick;
+      while (auto timer = armed.head)
+      {
+        armed.erase(*timer);
+        timer->_tick += shift;
+        this->_insert(*timer);
+      }
+    }
+
+    Duration
+    TimerWheel::next() const
+    {
+      ELLE_ASSERT(!this->empty());
+      if (this->_due.head)
+        return this->_tick * this->_resolution;
+      return this->_next_tick() * this->_resolution;
+    }
+
+    bool
+    TimerWheel::empty() const
+    {
+      return this->_size == 0;
+    }
+
+    void
+    TimerWheel::_insert(Timer& timer)
+    {
+      ELLE_ASSERT_GTE(timer._tick, this->_tick);
+      // Deadlines past the span of the wheel are placed in the last slot
+      // and cascaded again.
+      auto const span = std::int64_t(1) << (bits * levels);
+      auto const tick = std::min(timer._tick, this->_tick + span - 1);
+      auto const delta = tick - this->_tick;
+      auto level = 0;
+      while (delta >> (bits * (level + 1)))
+        ++level;
+      auto const slot = (tick >> (bits * level)) & (slots - 1);
+      timer._level = level;
+      timer._slot = slot;
+      this->_wheel[level][slot].push(timer);
+      this->_occupied[level] |= std::uint64_t(1) << slot;
+    }
+
+    int
+    TimerWheel::_tick_once()
+    {
+      auto const tick = ++this->_tick;
+      // Cascade from the top, as a slot may land in a lower one cascaded
+      // at the same tick.
+      for (int level = levels - 1; level > 0; --level)
+      {
+        auto const shift = bits * level;
+        if (tick & ((std::int64_t(1) << shift) - 1))
+          continue;
+        auto const slot = (tick >> shift) & (slots - 1);
+        if (!(this->_occupied[level] & (std::uint64_t(1) << slot)))
+          continue;
+        this->_occupied[level] &= ~(std::uint64_t(1) << slot);
+        auto cascaded = List();
+        cascaded.splice(this->_wheel[level][slot]);
+        while (auto timer = cascaded.head)
+        {
+          cascaded.erase(*timer);
+          this->_insert(*timer);
+        }
+      }
+      auto const slot = tick & (slots - 1);
+      auto batch = List();
+      if (this->_occupied[0] & (std::uint64_t(1) << slot))
+      {
+        this->_occupied[0] &= ~(std::uint64_t(1) << slot);
+        batch.splice(this->_wheel[0][slot]);
+      }
+      return this->_run(batch);
+    }
+
+    int
+    TimerWheel::_run(List& list)
+    {
+      auto res = 0;
+      for (auto timer = list.head; timer; timer = timer->_next)
+        timer->_level = -1;
+      while (auto timer = list.head)
+      {
+        list.erase(*timer);
+        timer->_wheel = nullptr;
+        --this->_size;
+        ++res;
+        // The action may destroy or rearm the timer.
+        auto action = std::move(timer->_action);
+        try
+        {
+          action();
+        }
+        catch (...)
+        {
+          // Do not lose the timers left, nor leave them in a dead list.
+          this->_due.splice(list);
+          throw;
+        }
+      }
+      return res;
+    }
+
+    std::int64_t
+    TimerWheel::_next_tick() const
+    {
+      auto res = std::numeric_limits<std::int64_t>::max();
+      for (int level = 0; level < levels; ++level)
+      {
+        auto const shift = bits * level;
+        // The next block of this level to start is the one after the
+        // current tick, its slot is the first to cascade.
+        auto const block = (this->_tick >> shift) + 1;
+        auto const offset =
+          first(this->_occupied[level], block & (slots - 1));
+        if (offset >= 0)
+          res = std::min(res, (block + offset) << shift);
+      }
+      return res;
+    }
+
+    void
+    TimerWheel::_erase(Timer& timer)
+    {
+      timer._list->erase(timer);
+      if (timer._level >= 0)
+      {
+        auto const& slot = this->_wheel[timer._level][timer._slot];
+        if (!slot.head)
+          this->_occupied[timer._level] &=
+            ~(std::uint64_t(1) << timer._slot);
+      }
+      timer._wheel = nullptr;
+      timer._action = nullptr;
+      --this->_size;
+    }
+
+    /*------.
+    | Timer |
+    `------*/
+
+    TimerWheel::Timer::Timer()
+      : _wheel(nullptr)
+      , _tick(0)
+      , _action()
+      , _list(nullptr)
+      , _level(-1)
+      , _slot(0)
+      , _previous(nullptr)
+      , _next(nullptr)
+    {}
+
+    TimerWheel::Timer::~Timer()
+    {
+      this->cancel();
+    }
+
+    bool
+    TimerWheel::Timer::armed() const
+    {
+      return this->_list;
+    }
+
+    void
+    TimerWheel::Timer::cancel()
+    {
+      if (this->_list)
+        this->_wheel->_erase(*this);
+    }
+  }
+}
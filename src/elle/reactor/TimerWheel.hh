@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+#include <elle/attribute.hh>
+#include <elle/reactor/duration.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    /// A hierarchical timer wheel.
+    ///
+    /// Timers are hashed by deadline into levels of 64 slots, each level
+    /// covering 64 times the span of the previous one, and cascaded to the
+    /// lower level as their deadline nears. Arming and canceling are O(1)
+    /// and allocation free: timers are intrusive list nodes, embedded in
+    /// whoever waits on them. Deadlines are rounded up to the resolution;
+    /// the wheel covers 2^36 of it, later deadlines are cascaded again.
+    ///
+    /// The wheel has no clock: times are durations since an origin of the
+    /// owner's choosing, and timers only run when the wheel is advanced.
+    /// Timers with the same deadline run in a deterministic order, though
+    /// not always the one they were armed in.
+    class TimerWheel
+    {
+    /*------.
+    | Types |
+    `------*/
+    public:
+      using Self = TimerWheel;
+      class Timer;
+
+    private:
+      struct List
+      {
+        List();
+        /// Append @a timer.
+        void
+        push(Timer& timer);
+        /// Unlink @a timer.
+        void
+        erase(Timer& timer);
+        /// Append every timer of @a list, leaving it empty.
+        void
+        splice(List& list);
+        Timer* head;
+        Timer* tail;
+      };
+
+    /*-------------.
+    | Construction |
+    `-------------*/
+    public:
+      /// Create a wheel.
+      ///
+      /// @param now        The current time.
+      /// @param resolution The duration of a tick.
+      TimerWheel(Duration now, Duration resolution = 1ms);
+      TimerWheel(Self const&) = delete;
+      /// Cancel every timer.
+      ~TimerWheel();
+
+    /*-------.
+    | Timers |
+    `-------*/
+    public:
+      /// Run @a action once the wheel is advanced to @a deadline.
+      ///
+      /// If @a timer is armed already, it is rearmed.
+      void
+      arm(Timer& timer, Duration deadline, std::function<void ()> action);
+      /// Run the timers due at @a now.
+      ///
+      /// @returns The number of timers run.
+      int
+      advance(Duration now);
+      /// Restart the wheel at @a now, keeping the delay of armed timers.
+      void
+      reset(Duration now);
+      /// A lower bound of the earliest deadline.
+      ///
+      /// It is exact for deadlines within 64 ticks. Later ones are only
+      /// known to the span of their slot: advancing to the bound cascades
+      /// them, refining it.
+      ///
+      /// @pre A timer is armed.
+      Duration
+      next() const;
+      bool
+      empty() const;
+      /// The number of armed timers.
+      ELLE_ATTRIBUTE_R(int, size);
+      /// The duration of a tick.
+      ELLE_ATTRIBUTE_R(Duration, resolution);
+    private:
+      static constexpr int bits = 6;
+      static constexpr int slots = 1 << bits;
+      static constexpr int levels = 6;
+      /// Place @a timer according to its deadline.
+      void
+      _insert(Timer& timer);
+      /// Advance by one tick.
+      int
+      _tick_once();
+      /// Run every timer in @a list.
+      int
+      _run(List& list);
+      /// The next tick at which a slot is run or cascaded.
+      std::int64_t
+      _next_tick() const;
+      void
+      _erase(Timer& timer);
+      /// The latest tick run.
+      ELLE_ATTRIBUTE(std::int64_t, tick);
+      ELLE_ATTRIBUTE((std::array<std::array<List, slots>, levels>), wheel);
+      /// Which slots hold timers, per level.
+      ELLE_ATTRIBUTE((std::array<std::uint64_t, levels>), occupied);
+      /// Timers armed for a past tick, run on the next advance.
+      ELLE_ATTRIBUTE(List, due);
+    };
+
+    /// A timer, armed on a TimerWheel.
+    ///
+    /// Destroying an armed timer cancels it.
+    class TimerWheel::Timer
+    {
+    public:
+      Timer();
+      Timer(Timer const&) = delete;
+      ~Timer();
+      /// Whether the timer is armed and did not run yet.
+      bool
+      armed() const;
+      /// Disarm the timer if armed.
+      void
+      cancel();
+
+    private:
+      friend class TimerWheel;
+      TimerWheel* _wheel;
+      std::int64_t _tick;
+      std::function<void ()> _action;
+      List* _list;
+      /// The slot the timer is in, or -1 if it is in no slot.
+      int _level;
+      int _slot;
+      Timer* _previous;
+      Timer* _next;
+    };
+  }
+}
@@ -20,6 +20,12 @@ namespace elle
     | Construction |
     `-------------*/
 
+    Waitable::Handler::Handler(Resumable* resumable, Waker waker)
+      : resumable(resumable)
+      , waker(std::move(waker))
+      , waitable(nullptr)
+    {}
+
     Waitable::Waitable(std::string name)
       : _name(std::move(name))
       , _waiters()
@@ -30,7 +36,10 @@ namespace elle
       : _name(source._name)
       , _waiters(std::move(source._waiters))
       , _exception(source._exception)
-    {}
+    {
+      for (auto& handler: this->_waiters)
+        handler.waitable = this;
+    }
 
     Waitable::~Waitable()
     {
@@ -44,7 +53,7 @@ namespace elle
       {
         auto threads =
           make_vector(this->_waiters,
-                      [](auto& t){ return elle::sprintf("%s", *t.first); });
+                      [](auto& h){ return elle::sprintf("%s", *h.resumable); });
         ELLE_ABORT("%s destroyed while waited by %s at %s",
                    *this,
                    boost::algorithm::join(threads, ", "),
@@ -69,25 +78,23 @@ namespace elle
     int
     Waitable::_signal()
     {
-      if (_waiters.empty())
+      int res = 0;
+      // Only wake current waiters, not the ones registered while waking.
+      auto waiters = Waiters();
+      waiters.swap(this->_waiters);
+      while (!waiters.empty())
       {
-        _exception = std::exception_ptr{}; // An empty one.
-        this->on_signaled()();
-        return false;
+        auto& handler = waiters.front();
+        waiters.pop_front();
+        this->_resume(handler);
+        ++res;
       }
-      for (auto& thread: this->_waiters)
-        if (thread.second)
-          thread.second(thread.first);
-        else
-          thread.first->_wake(this);
-      int res = _waiters.size();
-      _waiters.clear();
       _exception = std::exception_ptr{}; // An empty one.
       this->on_signaled()();
       return res;
     }
 
-    Thread*
+    Resumable*
     Waitable::_signal_one()
     {
       if (this->_waiters.empty())
@@ -96,49 +103,49 @@ namespace elle
         this->on_signaled()();
         return nullptr;
       }
-      auto thread = *this->_waiters.begin();
-      this->_signal_one(thread);
-      return thread.first;
+      auto& handler = this->_waiters.front();
+      auto resumable = handler.resumable;
+      this->_signal_one(handler);
+      return resumable;
     }
 
     void
-    Waitable::_signal_one(Thread* t)
+    Waitable::_signal_one(Handler& handler)
     {
-      auto thread = this->_waiters.get<1>().find(t);
-      if (thread != this->_waiters.get<1>().end())
-        return _signal_one(*thread);
+      ELLE_ASSERT_EQ(handler.waitable, this);
+      handler.unlink();
+      this->_resume(handler);
+      this->_exception = std::exception_ptr{}; // An empty one.
+      if (this->_waiters.empty())
+        this->on_signaled()();
     }
 
     void
-    Waitable::_signal_one(Handler const& thread)
+    Waitable::_resume(Handler& handler)
     {
-      if (thread.second)
-        thread.second(thread.first);
+      if (handler.waker)
+        handler.waker(handler.resumable);
       else
-        thread.first->_wake(this);
-      this->_waiters.get<1>().erase(thread.first);
-      this->_exception = std::exception_ptr{}; // An empty one.
-      if (this->_waiters.empty())
-        this->on_signaled()();
+        handler.resumable->_wake(this);
     }
 
     bool
-    Waitable::_wait(Thread* t, Waker const& waker)
+    Waitable::_wait(Handler& handler)
     {
-      ELLE_TRACE("%s: wait %s", t, this);
-      ELLE_ASSERT_EQ(this->_waiters.get<1>().find(t),
-                     this->_waiters.get<1>().end());
-      this->_waiters.emplace_back(t, waker);
+      ELLE_TRACE("%s: wait %s", handler.resumable, this);
+      ELLE_ASSERT(!handler.is_linked());
+      handler.waitable = this;
+      this->_waiters.push_back(handler);
       return true;
     }
 
     void
-    Waitable::_unwait(Thread* t)
+    Waitable::_unwait(Handler& handler)
     {
-      ELLE_TRACE("%s: unwait %s", t, this);
-      ELLE_ASSERT_NEQ(this->_waiters.get<1>().find(t),
-                      this->_waiters.get<1>().end());
-      this->_waiters.get<1>().erase(t);
+      ELLE_TRACE("%s: unwait %s", handler.resumable, this);
+      ELLE_ASSERT_EQ(handler.waitable, this);
+      ELLE_ASSERT(handler.is_linked());
+      handler.unlink();
     }
 
     void
@@ -162,6 +169,116 @@ namespace elle
       stream << ")";
     }
 
+    /*----------.
+    | Resumable |
+    `----------*/
+
+    Resumable::Resumable(std::string name)
+      : Waitable(std::move(name))
+      , _handlers(nullptr)
+      , _waiting(0)
+    {}
+
+    Resumable::Handlers::Handlers()
+      : _inline()
+      , _heap()
+      , _capacity(0)
+      , _size(0)
+    {}
+
+    void
+    Resumable::Handlers::reset(Resumable* resumable, int size)
+    {
+      if (size > int(this->_inline.size()) && size > this->_capacity)
+      {
+        this->_heap.reset(new Handler[size]);
+        this->_capacity = size;
+      }
+      this->_size = size;
+      for (auto& handler: *this)
+      {
+        ELLE_ASSERT(!handler.is_linked());
+        handler.resumable = resumable;
+        handler.waker = nullptr;
+        handler.waitable = nullptr;
+      }
+    }
+
+    Waitable::Handler*
+    Resumable::Handlers::begin()
+    {
+      if (this->_size > int(this->_inline.size()))
+        return this->_heap.get();
+      else
+        return this->_inline.data();
+    }
+
+    Waitable::Handler*
+    Resumable::Handlers::end()
+    {
+      return this->begin() + this->_size;
+    }
+
+    Waitables
+    Resumable::waited() const
+    {
+      auto res = Waitables{};
+      if (this->_handlers)
+        for (auto& handler: *this->_handlers)
+          if (handler.is_linked())
+            res.push_back(handler.waitable);
+      return res;
+    }
+
+    bool
+    Resumable::_wait_start(Waitable* const* waitables,
+                           int count,
+                           Handlers& handlers)
+    {
+      ELLE_ASSERT(!this->_handlers);
+      handlers.reset(this, count);
+      this->_handlers = &handlers;
+      this->_waiting = 0;
+      try
+      {
+        auto handler = handlers.begin();
+        for (int i = 0; i < count; ++i, ++handler)
+          if (waitables[i]->_wait(*handler))
+            ++this->_waiting;
+          else if (waitables[i]->_exception)
+            std::rethrow_exception(waitables[i]->_exception);
+      }
+      catch (...)
+      {
+        this->_wait_stop();
+        throw;
+      }
+      if (!this->_waiting)
+        this->_handlers = nullptr;
+      return this->_handlers != nullptr;
+    }
+
+    void
+    Resumable::_wait_stop()
+    {
+      if (!this->_handlers)
+        return;
+      for (auto& handler: *this->_handlers)
+        if (handler.is_linked())
+          handler.waitable->_unwait(handler);
+      this->_handlers = nullptr;
+      this->_waiting = 0;
+    }
+
+    bool
+    Resumable::_wait_done()
+    {
+      ELLE_ASSERT_GT(this->_waiting, 0);
+      if (--this->_waiting == 0)
+        this->_handlers = nullptr;
+      return this->_handlers == nullptr;
+    }
+
     /*----------.
     | Waitables |
     `----------*/
@@ -1,12 +1,11 @@
 #pragma once
 
+#include <array>
+#include <memory>
 #include <set>
 
 #include <boost/function.hpp>
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/sequenced_index.hpp>
-#include <boost/multi_index/hashed_index.hpp>
+#include <boost/intrusive/list.hpp>
 #include <boost/noncopyable.hpp>
 
 #include <elle/Exception.hh>
@@ -65,17 +64,28 @@ namespace elle
       /// Self
       using Self = Waitable;
       /// Wake callback.
-      using Waker = std::function<void (Thread*)>;
-      /// Waited thread and its wake callback.
-      using Handler = std::pair<Thread*, Waker>;
-      /// Collection of threads waiting this
-      using Waiters = boost::multi_index_container<
-        Handler,
-        boost::multi_index::indexed_by<
-          boost::multi_index::sequenced<>,
-          boost::multi_index::hashed_unique<
-            boost::multi_index::member<Handler, Thread*, &Handler::first>>>
-        >;
+      using Waker = std::function<void (Resumable*)>;
+      /// A thread or task waiting for a Waitable, and its wake callback.
+      ///
+      /// Handlers are intrusive nodes of the Waitable waiters, owned by the
+      /// waiting side, so that waiting and waking allocate nothing. A Handler
+      /// destroyed while waiting unlinks itself.
+      struct Handler
+        : public boost::intrusive::list_base_hook<
+            boost::intrusive::link_mode<boost::intrusive::auto_unlink>>
+      {
+        Handler(Resumable* resumable = nullptr, Waker waker = {});
+        Handler(Handler const&) = delete;
+        /// The waiting thread or task.
+        Resumable* resumable;
+        /// The wake callback, or empty to wake the Resumable itself.
+        Waker waker;
+        /// The Waitable waited for, set by Waitable::_wait.
+        Waitable* waitable;
+      };
+      /// Collection of threads and tasks waiting this, in order.
+      using Waiters = boost::intrusive::list<
+        Handler, boost::intrusive::constant_time_size<false>>;
 
     /*-------------.
     | Construction |
@@ -130,12 +140,12 @@ namespace elle
       /// returning false, either calling the parent method and
       /// returning true.
       ///
-      /// @param thread The Thread to wake up when we're done.
-      /// @param waker The Waker to invoke.
+      /// @param handler The Handler of the thread to wake up when we're done,
+      ///                which must outlive the wait.
       /// @returns Whether the thread needs to wait for us.
       virtual
       bool
-      _wait(Thread* thread, Waker const& waker);
+      _wait(Handler& handler);
       /// Abort waking a Thread when we are done.
       ///
       /// Forget about a thread previously successfully registered with
@@ -145,11 +155,10 @@ namespace elle
       /// parent method must still be called, to avoid trying to wake
       /// up the thread erroneously when we're done.
       ///
-      /// @param thread A pointer to Thread that should be awaken by this
-      ///               Waitable.
+      /// @param handler The Handler registered with _wait.
       virtual
       void
-      _unwait(Thread* thread);
+      _unwait(Handler& handler);
       /// Wake waiting threads.
       ///
       /// @returns The number of Threads awaken.
@@ -159,23 +168,15 @@ namespace elle
       ///
       /// @returns A pointer to the Thread awoken.
       virtual
-      Thread*
+      Resumable*
       _signal_one();
-      /// Signal @a specific Thread to wake up.
-      ///
-      /// If the Thread is not waiting for us, this is an noop.
-      ///
-      /// @param thread The Thread to wake up.
-      void
-      _signal_one(Thread* thread);
       /// Signal a specific Handler.
       ///
-      /// Same as _signal_one(Thread). If the Handler has a Waker function, use
-      /// it.
+      /// If the Handler has a Waker function, use it.
       ///
-      /// @param thread The Handler to signal.
+      /// @param handler The Handler to signal, waiting for us.
       void
-      _signal_one(Handler const& thread);
+      _signal_one(Handler& handler);
       ///  Register an exception waiting thread should throw when woken.
       ///
       /// @tparam Exception The type of the exception to raise.
@@ -191,8 +192,13 @@ namespace elle
       _raise(std::exception_ptr e);
 
     private:
+      /// Wake the Resumable of @a handler, unlinked.
+      void
+      _resume(Handler& handler);
       /// Let friends register/unregister themselves.
       friend class Thread;
+      friend class Resumable;
+      friend class Task;
       friend class OrWaitable;
       /// Exception woken thread must throw.
       ELLE_ATTRIBUTE_R(std::exception_ptr, exception);
@@ -212,6 +218,68 @@ namespace elle
       print(std::ostream& stream) const override;
     };
 
+    /// Resumable is what waits for Waitables: a Thread or a Task. It is
+    /// itself waitable, until done.
+    class Resumable
+      : public Waitable
+    {
+    public:
+      /// The Waitables we are still waiting for.
+      Waitables
+      waited() const;
+
+    protected:
+      Resumable(std::string name = {});
+      /// Handlers of a wait, the first ones inline.
+      class Handlers
+      {
+      public:
+        Handlers();
+        Handlers(Handlers const&) = delete;
+        /// Make room for @a size unlinked Handlers of @a resumable.
+        void
+        reset(Resumable* resumable, int size);
+        Handler*
+        begin();
+        Handler*
+        end();
+      private:
+        ELLE_ATTRIBUTE((std::array<Handler, 2>), inline);
+        ELLE_ATTRIBUTE(std::unique_ptr<Handler[]>, heap);
+        ELLE_ATTRIBUTE(int, capacity);
+        ELLE_ATTRIBUTE(int, size);
+      };
+      /// Start waiting for @a waitables with @a handlers.
+      ///
+      /// If a Waitable throws, or is done with an exception, the Waitables
+      /// already waited for are forgotten and the exception is rethrown.
+      ///
+      /// @param waitables The Waitables to wait for.
+      /// @param count The number of @a waitables.
+      /// @param handlers The Handlers to wait with, until the wait is over.
+      /// @returns Whether any Waitable must be waited for.
+      bool
+      _wait_start(Waitable* const* waitables, int count, Handlers& handlers);
+      /// Forget the Waitables not done yet.
+      void
+      _wait_stop();
+      /// Note that a Waitable we waited for is done.
+      ///
+      /// @returns Whether the wait is over.
+      bool
+      _wait_done();
+    private:
+      friend class Waitable;
+      /// Resume once @a waitable, which we wait for, is done.
+      virtual
+      void
+      _wake(Waitable* waitable) = 0;
+      /// The Handlers of the current wait, if any.
+      ELLE_ATTRIBUTE(Handlers*, handlers);
+      /// The number of Waitables still waited for.
+      ELLE_ATTRIBUTE(int, waiting);
+    };
+
     /// Add a Waitable into Waitables.
     Waitables& operator << (Waitables& waitables, Waitable& s);
     /// Add a Waitable into Waitables.
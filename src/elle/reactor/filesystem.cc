@@ -36,10 +36,10 @@ namespace elle
       {}
 
       bool
-      FileSystem::_wait(Thread* thread, Waker const& waker)
+      FileSystem::_wait(Handler& handler)
       {
         if (this->_impl)
-          return Waitable::_wait(thread, waker);
+          return Waitable::_wait(handler);
         else
           return false;
       }
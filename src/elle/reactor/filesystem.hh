@@ -267,7 +267,7 @@ namespace elle
       protected:
         virtual
         bool
-        _wait(Thread* thread, Waker const& waker) override;
+        _wait(Handler& handler) override;
 
       /*--------.
       | Details |
@@ -19,11 +19,13 @@ namespace elle
     class Semaphore;
     class Signal;
     class Sleep;
+    class Task;
     class Thread;
     class TimeoutGuard;
     template <typename R = void>
     class VThread;
     class Waitable;
+    class Resumable;
 
     using Signals = std::vector<Signal*>;
     using Waitables = std::vector<Waitable*>;
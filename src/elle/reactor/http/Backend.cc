@@ -0,0 +1,27 @@
+#include <ostream>
+
+#include <elle/assert.hh>
+#include <elle/reactor/http/Backend.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    namespace http
+    {
+      std::ostream&
+      operator <<(std::ostream& output,
+                  Backend backend)
+      {
+        switch (backend)
+        {
+          case Backend::curl:
+            return output << "curl";
+          case Backend::native:
+            return output << "native";
+        }
+        elle::unreachable();
+      }
+    }
+  }
+}
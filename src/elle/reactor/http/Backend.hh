@@ -0,0 +1,27 @@
+#pragma once
+
+#include <iosfwd>
+
+namespace elle
+{
+  namespace reactor
+  {
+    namespace http
+    {
+      /// How a Request reaches the server.
+      enum class Backend
+      {
+        /// Through libcurl: every HTTP version, proxies, compression, shared
+        /// cookie jars.
+        curl,
+        /// Over plain reactor sockets, HTTP/1.1 only, for cheap calls to
+        /// hosts we control.
+        native,
+      };
+
+      std::ostream&
+      operator <<(std::ostream& output,
+                  Backend backend);
+    }
+  }
+}
@@ -35,6 +35,11 @@ namespace elle
             throw std::bad_alloc();
           curl_share_setopt(this->_share.get(),
                             CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
+          // Requests only accept one share, which replaces the Service one.
+          curl_share_setopt(this->_share.get(),
+                            CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+          curl_share_setopt(this->_share.get(),
+                            CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
         }
 
         ~Impl()
@@ -72,6 +77,12 @@ namespace elle
       Client::_register(Request const& request)
       {
         ELLE_TRACE_SCOPE("%s: register %s", *this, request);
+        // Native requests have no CURL handle to share the cookie jar with.
+        if (!request._impl->_handle)
+        {
+          request._impl->header_add("User-Agent", this->_user_agent);
+          return;
+        }
         {
           auto res = curl_easy_setopt(request._impl->_handle,
                                       CURLOPT_SHARE, this->_impl->_share.get());
@@ -9,6 +9,7 @@
 #include <elle/reactor/http/RequestImpl.hh>
 #include <elle/reactor/http/Service.hh>
 #include <elle/reactor/http/exceptions.hh>
+#include <elle/reactor/http/url.hh>
 #include <elle/reactor/scheduler.hh>
 #include <utility>
 
@@ -34,6 +35,15 @@ namespace elle
             throw RequestError("unable to set request option: %s",
                                curl_easy_strerror(res));
         }
+
+        /// Whether curl was built with HTTP/2 support.
+        bool
+        http2_supported()
+        {
+          static auto const res = bool(
+            curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2);
+          return res;
+        }
       }
 
       /*--------------.
@@ -55,6 +65,8 @@ namespace elle
           // XXX: not supported by wsgiref and <=nginx-1.2 ...
         , _chunked_transfers(false)
         , _expected_status()
+        , _buffer_size(0)
+        , _backend(Backend::curl)
         , _ssl_verify_host(true)
       {}
 
@@ -90,6 +102,10 @@ namespace elle
         , _input()
         , _input_current()
         , _input_available("input available")
+        , _input_size(0)
+        , _input_paused(false)
+        , _input_free()
+        , _headers_available("headers available")
         , _output_done(false)
         , _output(0)
         , _output_available(false)
@@ -99,7 +115,8 @@ namespace elle
         , _url(url)
         , _method(method)
         , _query_string()
-        , _handle(curl_easy_init())
+        , _handle(this->_conf.backend() == Backend::curl
+                  ? this->_curl.acquire() : nullptr)
         , _pause_count(0)
         , _debug(0)
         , _debug2(0)
@@ -109,17 +126,56 @@ namespace elle
         , _bt_waited()
         , _slot_frozen()
         , _slot_unfrozen()
+        , _native_thread()
+        , _output_flushed()
+        , _input_drained()
+        , _native_cookies()
       {
+        if (this->_conf.backend() == Backend::native)
+        {
+          auto const& proxy = this->_conf.proxy();
+          if (proxy
+              && proxy.get().type() != reactor::network::ProxyType::None
+              && !proxy.get().host().empty()
+              && proxy.get().port() != 0)
+            throw RequestError(url, "proxies require the curl backend");
+          if (this->_conf.version() == Version::v20)
+            throw RequestError(url, "HTTP/2 requires the curl backend");
+          if (this->_conf.keep_alive())
+            this->header_add("Connection", "keep-alive");
+          return;
+        }
         if (!this->_handle)
           throw RequestError(url, "unable to initialize request");
         // Weird clang macos bug, using 'this->_error' causes a SEGV for
         // some offset of the _error in the class.
         memset(&this->_error[0], 0, CURL_ERROR_SIZE);
         setopt(this->_handle, CURLOPT_ERRORBUFFER, this->_error);
-        // Set version.
-        auto version = this->_conf.version() == Version::v11
-          ? CURL_HTTP_VERSION_1_1 : CURL_HTTP_VERSION_1_0;
+        // Set version. HTTP/1.1 requests over TLS offer HTTP/2, if curl
+        // supports it, and fall back if the server does not accept it.
+        if (this->_conf.version() == Version::v20 && !http2_supported())
+          throw RequestError(url, "HTTP/2 is not supported by curl");
+        auto const version = [&]
+          {
+            switch (this->_conf.version())
+            {
+              case Version::v10:
+                return CURL_HTTP_VERSION_1_0;
+              case Version::v11:
+                return this->_curl.http2() && http2_supported()
+                  ? CURL_HTTP_VERSION_2TLS : CURL_HTTP_VERSION_1_1;
+              case Version::v20:
+                return CURL_HTTP_VERSION_2_0;
+            }
+            elle::unreachable();
+          }();
         setopt(this->_handle, CURLOPT_HTTP_VERSION, version);
+        // Wait for a connection able to multiplex rather than opening a new
+        // one.
+        setopt(this->_handle, CURLOPT_PIPEWAIT, 1L);
+        // Share DNS resolutions and TLS sessions, unless a Client sets its
+        // own share.
+        setopt(this->_handle, CURLOPT_SHARE, this->_curl.share());
         // Set IPv4 only.
         setopt(this->_handle, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
         // Set proxy.
@@ -229,6 +285,7 @@ namespace elle
 
       Request::Impl::~Impl()
       {
+        this->_native_thread.reset();
         this->_slot_frozen.disconnect();
         this->_slot_unfrozen.disconnect();
         this->_request->_status = static_cast<StatusCode>(0);
@@ -236,7 +293,8 @@ namespace elle
         if (this->_curl._requests.find(this->_handle) !=
             this->_curl._requests.end())
           this->_curl.remove(*this->_request);
-        curl_easy_cleanup(this->_handle);
+        if (this->_handle)
+          this->_curl.release(this->_handle);
       }
 
       std::unordered_map<std::string, std::string>
@@ -266,6 +324,8 @@ namespace elle
       std::unordered_map<std::string, std::string>
       Request::Impl::cookies() const
       {
+        if (!this->_handle)
+          return this->_native_cookies;
         return this->cookies(this->_handle);
       }
 
@@ -288,11 +348,17 @@ namespace elle
         // Set URL.
         if (!this->_query_string.empty())
           this->_url = elle::print("%s?%s", this->_url, this->_query_string);
+        // Both backends send the configuration headers.
+        for (auto const& header: this->_conf.headers())
+          this->header_add(header.first, header.second);
+        if (!this->_handle)
+        {
+          this->_native_start();
+          return;
+        }
         setopt(this->_handle, CURLOPT_URL, this->_url.c_str());
         for (auto const& cookie: this->_conf.cookies())
           this->cookie_add(cookie.first, cookie.second);
-        for (auto const& header: this->_conf.headers())
-          this->header_add(header.first, header.second);
         setopt(this->_handle, CURLOPT_HTTPHEADER, this->_headers.get());
         this->_curl.add(*this->_request);
       }
@@ -335,6 +401,19 @@ namespace elle
       void
       Request::Impl::read_header(elle::ConstWeakBuffer const& data)
       {
+        // The empty line ends the headers, unless it only ends an interim
+        // response such as 100 Continue.
+        if (boost::algorithm::all(data, boost::algorithm::is_space()))
+        {
+          long code = 0;
+          curl_easy_getinfo(this->_handle, CURLINFO_RESPONSE_CODE, &code);
+          if (code >= 200)
+          {
+            this->_request->_status = static_cast<StatusCode>(code);
+            this->_headers_available.open();
+          }
+          return;
+        }
         auto separator =
           boost::algorithm::find_first(data, elle::ConstWeakBuffer(":"));
         if (separator.begin() != data.end())
@@ -398,6 +477,9 @@ namespace elle
         ELLE_ASSERT(!this->_output_done);
         if (this->_conf.chunked_transfers())
         {
+          // Do not overwrite data curl did not send yet.
+          if (this->_output_available)
+            this->_output_consumed.wait();
           this->_output.size(CURL_MAX_WRITE_SIZE);
           return this->_output;
         }
@@ -422,7 +504,7 @@ namespace elle
           ELLE_DEBUG_SCOPE("%s: output: post data: %s",
                            *this->_request, this->_output);
           this->_output_available = true;
-          curl_easy_pause(this->_handle, CURLPAUSE_CONT);
+          this->_resume_output();
         }
         else
         {
@@ -434,6 +516,15 @@ namespace elle
         }
       }
 
+      void
+      Request::Impl::_resume_output()
+      {
+        if (this->_handle)
+          curl_easy_pause(this->_handle, CURLPAUSE_CONT);
+        else
+          this->_output_flushed.signal();
+      }
+
       elle::WeakBuffer
       Request::Impl::read_buffer()
       {
@@ -444,13 +535,18 @@ namespace elle
         }
         if (!this->_input.empty())
         {
+          auto const limit = this->_conf.buffer_size();
+          if (limit && this->_input_free.size() <= limit / CURL_MAX_WRITE_SIZE)
+            this->_input_free.push_back(std::move(this->_input_current));
           this->_input_current = std::move(this->_input.front());
           ELLE_DEBUG_SCOPE("%s: input: fetch data: %f",
                            *this->_request, this->_input_current);
           ELLE_DUMP("%s", this->_input_current);
           this->_input.pop();
+          this->_input_size -= this->_input_current.size();
           if (this->_input.empty() && !this->_input_done)
             this->_input_available.close();
+          this->_input_resume();
           return this->_input_current;
         }
         else
@@ -468,7 +564,28 @@ namespace elle
       {
         auto& self = *reinterpret_cast<Request::Impl*>(userdata);
         auto size = chunk * count;
-        self.enqueue_data(elle::Buffer(ptr, size));
+        auto const limit = self._conf.buffer_size();
+        if (!limit)
+        {
+          self.enqueue_data(elle::Buffer(ptr, size));
+          return size;
+        }
+        if (self._input_size >= limit)
+        {
+          ELLE_DEBUG("%s: input: buffer full, pause", *self._request);
+          self._input_paused = true;
+          ++self._pause_count;
+          return CURL_WRITEFUNC_PAUSE;
+        }
+        auto buffer = elle::Buffer();
+        if (!self._input_free.empty())
+        {
+          buffer = std::move(self._input_free.back());
+          self._input_free.pop_back();
+          buffer.size(0);
+        }
+        buffer.append(ptr, size);
+        self.enqueue_data(std::move(buffer));
         return size;
       }
 
@@ -476,15 +593,36 @@ namespace elle
       Request::Impl::enqueue_data(elle::Buffer buffer)
       {
         ELLE_DEBUG_SCOPE("%s: input: got data: %f", *this->_request, buffer);
+        this->_input_size += buffer.size();
         this->_input.push(std::move(buffer));
         this->_input_available.open();
+        this->_headers_available.open();
+      }
+
+      void
+      Request::Impl::_input_resume()
+      {
+        if (this->_input_paused &&
+            this->_input_size <= this->_conf.buffer_size() / 2)
+        {
+          ELLE_DEBUG("%s: input: buffer drained, resume", *this->_request);
+          this->_input_paused = false;
+          if (this->_handle)
+            curl_easy_pause(this->_handle, CURLPAUSE_CONT);
+          else
+            this->_input_drained.signal();
+        }
       }
 
       void
       Request::Impl::_complete()
       {
         this->_input_available.open();
+        this->_headers_available.open();
         this->_input_done = true;
+        // Do not leave writers waiting for curl to consume their data.
+        this->_output_available = false;
+        this->_output_consumed.signal();
       }
 
       /*------.
@@ -668,6 +806,8 @@ namespace elle
         std::string res = "";
         auto curl = [this](auto const& s)
           {
+            if (!this->_impl->_handle)
+              return url_encode(s);
             char* cp = curl_easy_escape(this->_impl->_handle,
                                         s.c_str(), s.size());
             auto res = std::string{cp};
@@ -699,7 +839,7 @@ namespace elle
         ELLE_TRACE_SCOPE("%s: output: finalize", *this);
         this->flush();
         this->_impl->_output_done = true;
-        curl_easy_pause(this->_impl->_handle, CURLPAUSE_CONT);
+        this->_impl->_resume_output();
         if (!this->_impl->_conf.chunked_transfers())
         {
           this->_impl->header_add("Content-Length",
@@ -713,8 +853,10 @@ namespace elle
       {
         this->_impl->_debug2 = 1;
         ELLE_TRACE_SCOPE("%s: complete with code %s", *this, code);
-        curl_easy_getinfo(this->_impl->_handle,
-                          CURLINFO_RESPONSE_CODE, &this->_status);
+        // Native requests set the status as they parse the response.
+        if (this->_impl->_handle)
+          curl_easy_getinfo(this->_impl->_handle,
+                            CURLINFO_RESPONSE_CODE, &this->_status);
         // Distinguishing stall timeout and 'total time limit'
         // timeouts is tricky and requires parsing the error string.
         // Be robust to detection failure.
@@ -776,7 +918,7 @@ namespace elle
       }
 
       bool
-      Request::_wait(Thread* thread, Waker const& waker)
+      Request::_wait(Handler& handler)
       {
         this->_impl->_debug = 1;
         this->finalize();
@@ -816,10 +958,22 @@ namespace elle
                 impl->_bt_unfrozen = elle::Backtrace::current();
                 impl->_slot_unfrozen.disconnect();
               });
-          return Waitable::_wait(thread, waker);
+          return Waitable::_wait(handler);
         }
       }
 
+      void
+      Request::_wait_headers()
+      {
+        ELLE_TRACE_SCOPE("%s: wait headers", *this);
+        this->finalize();
+        reactor::wait(this->_impl->_headers_available);
+        // Only failures before the headers are received are reported here.
+        if (this->_impl->_input_done)
+          if (auto exn = this->exception())
+            std::rethrow_exception(exn);
+      }
+
       /*-------.
       | Status |
       `-------*/
@@ -827,6 +981,11 @@ namespace elle
       StatusCode
       Request::status() const
       {
+        if (this->_impl->_conf.buffer_size())
+        {
+          const_cast<Request*>(this)->_wait_headers();
+          return this->_status;
+        }
         ELLE_TRACE_SCOPE("%s: wait status", *this);
         // XXX: We need not wait for the whole request.
         reactor::wait(*const_cast<Request*>(this));
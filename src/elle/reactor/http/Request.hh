@@ -11,6 +11,7 @@
 #include <elle/reactor/asio.hh>
 #include <elle/attribute.hh>
 #include <elle/reactor/Operation.hh>
+#include <elle/reactor/http/Backend.hh>
 #include <elle/reactor/http/Method.hh>
 #include <elle/reactor/http/StatusCode.hh>
 #include <elle/reactor/http/Version.hh>
@@ -141,6 +142,22 @@ namespace elle
           /// The HTTP status to expect. Any different status will throw an
           /// exception upon waiting.
           ELLE_ATTRIBUTE_RW(boost::optional<StatusCode>, expected_status);
+          /// The maximum number of response bytes buffered ahead of the
+          /// reader, 0 for no limit.
+          ///
+          /// When the limit is reached, the transfer is paused until the
+          /// response stream is read, bounding the memory used by large
+          /// downloads. The body must then be read while the request runs:
+          /// status() only waits for the response headers, and waiting for
+          /// the request before reading its body never returns.
+          ELLE_ATTRIBUTE_RW(std::size_t, buffer_size);
+          /// How to reach the server, curl by default.
+          ///
+          /// The native backend speaks HTTP/1.1 (or 1.0) over reactor
+          /// sockets kept alive in a pool, skipping libcurl entirely. It does
+          /// not support proxies, compression, HTTP/2, nor the cookie jar of a
+          /// Client.
+          ELLE_ATTRIBUTE_RW(Backend, backend);
 
         /*----.
         | SSL |
@@ -243,7 +260,10 @@ namespace elle
         _complete(int code);
         /// Wait for the request to be done.
         bool
-        _wait(Thread* thread, Waker const& waker) override;
+        _wait(Handler& handler) override;
+        /// Wait for the response status and headers.
+        void
+        _wait_headers();
 
       /*-------.
       | Status |
@@ -259,8 +279,12 @@ namespace elle
         elle::Buffer
         response();
         /// The HTTP status. Null until the request is completed.
+        ///
+        /// Waits for the request to complete, or only for the response
+        /// headers if the Configuration bounds the buffer_size.
         ELLE_ATTRIBUTE_r(StatusCode, status);
-        /// How many time the request was paused in wait for output data.
+        /// How many time the request was paused in wait for output data or for
+        /// the response to be read.
         ELLE_attribute_r(int, pause_count);
 
       /*--------.
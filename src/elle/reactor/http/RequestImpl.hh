@@ -2,12 +2,15 @@
 
 #include <queue>
 #include <string>
+#include <vector>
 
 #include <elle/Buffer.hh>
 #include <elle/memory.hh>
 #include <elle/reactor/Barrier.hh>
+#include <elle/reactor/Thread.hh>
 #include <elle/reactor/http/Request.hh>
 #include <elle/reactor/http/fwd.hh>
+#include <elle/reactor/network/fwd.hh>
 #include <elle/reactor/signal.hh>
 
 namespace elle
@@ -81,10 +84,20 @@ namespace elle
       private:
         void
         _complete();
+        /// Resume a paused transfer once the reader caught up.
+        void
+        _input_resume();
         bool _input_done;
         std::queue<elle::Buffer> _input;
         elle::Buffer _input_current;
         reactor::Barrier _input_available;
+        /// The number of bytes in _input.
+        std::size_t _input_size;
+        /// Whether the transfer is paused because _input is full.
+        bool _input_paused;
+        /// Consumed buffers, recycled when the buffer size is bounded.
+        std::vector<elle::Buffer> _input_free;
+        reactor::Barrier _headers_available;
         bool _output_done;
         elle::Buffer _output;
         bool _output_available;
@@ -167,6 +180,44 @@ namespace elle
         elle::Backtrace _bt_waited;
         boost::signals2::connection _slot_frozen;
         boost::signals2::connection _slot_unfrozen;
+
+      /*-------.
+      | Native |
+      `-------*/
+      private:
+        /// Run the request on a reactor thread instead of the CURL multi
+        /// handle.
+        void
+        _native_start();
+        void
+        _native();
+        /// The request line and headers.
+        std::string
+        _native_head(std::string const& host, std::string const& path) const;
+        void
+        _native_send(network::Socket& socket, std::string const& head);
+        /// Read the response.
+        ///
+        /// @param received Set once the response head is received.
+        /// @returns Whether the connection can carry another request.
+        bool
+        _native_receive(network::Socket& socket, bool& received);
+        /// Read size bytes of body, straight into the input buffers.
+        void
+        _native_read(network::Socket& socket,
+                     uint64_t size,
+                     int64_t& downloaded,
+                     int64_t total);
+        /// Let the transfer pick up newly flushed output.
+        void
+        _resume_output();
+        reactor::Thread::unique_ptr _native_thread;
+        /// Signaled when output is flushed or finalized.
+        reactor::Signal _output_flushed;
+        /// Signaled when the reader drained the input.
+        reactor::Signal _input_drained;
+        /// Cookies sent and received by native requests.
+        std::unordered_map<std::string, std::string> _native_cookies;
       };
     }
   }
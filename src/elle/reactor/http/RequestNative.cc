@@ -0,0 +1,498 @@
+#include <algorithm>
+#include <cstdio>
+#include <unordered_set>
+
+#include <curl/curl.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/optional.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <elle/err.hh>
+#include <elle/log.hh>
+#include <elle/print.hh>
+#include <elle/reactor/TimeoutGuard.hh>
+#include <elle/reactor/exception.hh>
+#include <elle/reactor/http/RequestImpl.hh>
+#include <elle/reactor/http/Service.hh>
+#include <elle/reactor/http/exceptions.hh>
+#include <elle/reactor/network/Error.hh>
+#include <elle/reactor/network/socket.hh>
+#include <elle/reactor/scheduler.hh>
+
+ELLE_LOG_COMPONENT("elle.reactor.http.Request");
+
+namespace elle
+{
+  namespace reactor
+  {
+    namespace http
+    {
+      /*--------.
+      | Helpers |
+      `--------*/
+
+      namespace
+      {
+        /// Where a request goes.
+        struct Target
+        {
+          std::string scheme;
+          std::string host;
+          int port;
+          /// The path and query string.
+          std::string path;
+        };
+
+        Target
+        parse_url(std::string const& url)
+        {
+          auto res = Target{"http", "", 0, "/"};
+          auto rest = boost::string_ref(url);
+          auto const separator = rest.find("://");
+          if (separator != boost::string_ref::npos)
+          {
+            res.scheme = boost::algorithm::to_lower_copy(
+              rest.substr(0, separator).to_string());
+            rest.remove_prefix(separator + 3);
+          }
+          if (res.scheme != "http" && res.scheme != "https")
+            throw RequestError(
+              url, elle::print("unsupported scheme {}", res.scheme));
+          auto const end = std::min(rest.find_first_of("/?#"), rest.size());
+          auto authority = rest.substr(0, end);
+          // Fragments are not sent.
+          auto const path = rest.substr(end).substr(0, rest.find('#') - end);
+          if (path.empty() || path.front() == '?')
+            res.path = "/" + path.to_string();
+          else
+            res.path = path.to_string();
+          auto const at = authority.rfind('@');
+          if (at != boost::string_ref::npos)
+            authority.remove_prefix(at + 1);
+          auto const colon = authority.rfind(':');
+          auto const bracket = authority.rfind(']');
+          if (colon != boost::string_ref::npos &&
+              (bracket == boost::string_ref::npos || colon > bracket))
+          {
+            try
+            {
+              res.port = std::stoi(authority.substr(colon + 1).to_string());
+            }
+            catch (std::logic_error const&)
+            {
+              throw RequestError(url, "invalid port");
+            }
+            authority = authority.substr(0, colon);
+          }
+          else
+            res.port = res.scheme == "https" ? 443 : 80;
+          if (!authority.empty() &&
+              authority.front() == '[' && authority.back() == ']')
+            authority = authority.substr(1, authority.size() - 2);
+          if (authority.empty())
+            throw RequestError(url, "missing host");
+          res.host = authority.to_string();
+          return res;
+        }
+
+        /// Consume and return the next line of a response head.
+        boost::string_ref
+        next_line(boost::string_ref& head)
+        {
+          auto const end = head.find("\r\n");
+          auto const line = head.substr(0, end);
+          head.remove_prefix(
+            end == boost::string_ref::npos ? head.size() : end + 2);
+          return line;
+        }
+
+        boost::string_ref
+        trim(boost::string_ref s)
+        {
+          while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+            s.remove_prefix(1);
+          while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+            s.remove_suffix(1);
+          return s;
+        }
+
+        bool
+        is(boost::string_ref a, boost::string_ref b)
+        {
+          return boost::algorithm::iequals(a, b);
+        }
+      }
+
+      /*-------.
+      | Native |
+      `-------*/
+
+      void
+      Request::Impl::_native_start()
+      {
+        for (auto const& cookie: this->_conf.cookies())
+          this->_native_cookies[cookie.first] = cookie.second;
+        this->_native_thread.reset(
+          new reactor::Thread(elle::print("{}", *this),
+                              [this] { this->_native(); }));
+      }
+
+      void
+      Request::Impl::_native()
+      {
+        ELLE_TRACE_SCOPE("%s: run natively", *this->_request);
+        auto code = CURLE_OK;
+        auto received = false;
+        auto fail = [&] (CURLcode c, std::string const& message)
+          {
+            code = c;
+            std::snprintf(this->_error, CURL_ERROR_SIZE, "%s", message.c_str());
+          };
+        try
+        {
+          auto const target = parse_url(this->_url);
+          auto guard = std::unique_ptr<TimeoutGuard>{};
+          if (auto const& timeout = this->_conf.timeout())
+            guard = std::make_unique<TimeoutGuard>(*timeout);
+          auto const default_port =
+            target.port == (target.scheme == "https" ? 443 : 80);
+          auto const host =
+            target.host.find(':') == std::string::npos
+            ? target.host : "[" + target.host + "]";
+          auto const head = this->_native_head(
+            default_port ? host : elle::print("{}:{}", host, target.port),
+            target.path);
+          // Chunked bodies are consumed as they are sent and cannot be
+          // replayed on another connection.
+          auto const replayable = !this->_conf.chunked_transfers();
+          while (true)
+          {
+            auto reused = false;
+            auto socket = this->_curl.connection(
+              target.scheme, target.host, target.port, reused);
+            try
+            {
+              this->_native_send(*socket, head);
+              auto const keep = this->_native_receive(*socket, received);
+              ++this->_curl._statistics.requests;
+              if (reused)
+                ++this->_curl._statistics.reused;
+              if (keep)
+                this->_curl.recycle(
+                  target.scheme, target.host, target.port, std::move(socket));
+              break;
+            }
+            catch (network::TimeOut const&)
+            {
+              throw;
+            }
+            catch (network::Error const& e)
+            {
+              // The server may have closed an idle pooled connection.
+              if (!reused || received || !replayable)
+                throw;
+              ELLE_TRACE("%s: reused connection failed, retry: %s",
+                         *this->_request, e.what());
+            }
+          }
+        }
+        catch (reactor::Terminate const&)
+        {
+          throw;
+        }
+        catch (reactor::Timeout const&)
+        {
+          fail(CURLE_OPERATION_TIMEDOUT, "Operation timed out");
+        }
+        catch (network::TimeOut const&)
+        {
+          // Only the stall timeout bounds individual reads.
+          fail(CURLE_OPERATION_TIMEDOUT, "Operation too slow");
+        }
+        catch (network::ResolutionError const& e)
+        {
+          fail(CURLE_COULDNT_RESOLVE_HOST, e.what());
+        }
+        catch (network::ConnectionClosed const& e)
+        {
+          fail(received ? CURLE_RECV_ERROR : CURLE_GOT_NOTHING, e.what());
+        }
+        catch (RequestError const& e)
+        {
+          fail(CURLE_URL_MALFORMAT, e.error());
+        }
+        catch (elle::Error const& e)
+        {
+          fail(received ? CURLE_RECV_ERROR : CURLE_SEND_ERROR, e.what());
+        }
+        this->_request->_complete(code);
+      }
+
+      std::string
+      Request::Impl::_native_head(std::string const& host,
+                                  std::string const& path) const
+      {
+        // Later headers override earlier ones, and an empty one removes the
+        // header altogether, as with CURL.
+        auto fields = std::vector<std::pair<std::string, std::string>>{};
+        auto removed = std::unordered_set<std::string>{};
+        for (auto it = this->_headers.get(); it; it = it->next)
+        {
+          auto const line = boost::string_ref(it->data);
+          auto const colon = line.find(':');
+          if (colon == boost::string_ref::npos)
+            continue;
+          auto const name = trim(line.substr(0, colon)).to_string();
+          auto const value = trim(line.substr(colon + 1)).to_string();
+          fields.erase(
+            std::remove_if(fields.begin(), fields.end(),
+                           [&] (std::pair<std::string, std::string> const& f)
+                           {
+                             return is(f.first, name);
+                           }),
+            fields.end());
+          if (value.empty())
+            removed.insert(boost::algorithm::to_lower_copy(name));
+          else
+          {
+            removed.erase(boost::algorithm::to_lower_copy(name));
+            fields.emplace_back(name, value);
+          }
+        }
+        auto const has = [&] (std::string const& name)
+          {
+            return removed.count(boost::algorithm::to_lower_copy(name)) ||
+              std::any_of(fields.begin(), fields.end(),
+                          [&] (std::pair<std::string, std::string> const& f)
+                          {
+                            return is(f.first, name);
+                          });
+          };
+        auto res = elle::print(
+          "{} {} {}\r\n", this->_method, path,
+          this->_conf.version() == Version::v10 ? "HTTP/1.0" : "HTTP/1.1");
+        if (!has("Host"))
+          res += elle::print("Host: {}\r\n", host);
+        if (!has("Accept"))
+          res += "Accept: */*\r\n";
+        if (!has("Connection") && !this->_conf.keep_alive())
+          res += "Connection: close\r\n";
+        for (auto const& field: fields)
+          res += elle::print("{}: {}\r\n", field.first, field.second);
+        if (!this->_native_cookies.empty() && !has("Cookie"))
+        {
+          res += "Cookie: ";
+          auto first = true;
+          for (auto const& cookie: this->_native_cookies)
+          {
+            res += elle::print("{}{}={}",
+                               first ? "" : "; ", cookie.first, cookie.second);
+            first = false;
+          }
+          res += "\r\n";
+        }
+        return res + "\r\n";
+      }
+
+      void
+      Request::Impl::_native_send(network::Socket& socket,
+                                  std::string const& head)
+      {
+        ELLE_DEBUG("%s: send head: %s", *this->_request, head);
+        if (!this->_conf.chunked_transfers())
+        {
+          auto const size = int64_t(this->_output.size());
+          // Small bodies go in the same segment as the head.
+          if (size <= 64 * 1024)
+          {
+            auto request = elle::Buffer(head.data(), head.size());
+            request.append(this->_output.contents(), size);
+            socket.write(request);
+          }
+          else
+          {
+            socket.write(elle::ConstWeakBuffer(head));
+            socket.write(this->_output);
+          }
+          this->progress_set(0, 0, size, size);
+          return;
+        }
+        socket.write(elle::ConstWeakBuffer(head));
+        auto buffer = elle::Buffer();
+        buffer.size(CURL_MAX_WRITE_SIZE);
+        auto sent = int64_t(0);
+        while (true)
+        {
+          auto const size = this->read_data(
+            elle::WeakBuffer(buffer.mutable_contents(), buffer.size()));
+          if (size == CURL_READFUNC_PAUSE)
+          {
+            reactor::wait(this->_output_flushed);
+            continue;
+          }
+          if (size == 0)
+          {
+            if (!this->_output_done)
+              continue;
+            socket.write(elle::ConstWeakBuffer("0\r\n\r\n"));
+            break;
+          }
+          auto frame = elle::Buffer(elle::sprintf("%x\r\n", size));
+          frame.append(buffer.contents(), size);
+          frame.append("\r\n", 2);
+          socket.write(frame);
+          sent += size;
+          this->progress_set(0, 0, -1, sent);
+        }
+      }
+
+      bool
+      Request::Impl::_native_receive(network::Socket& socket, bool& received)
+      {
+        auto const& stall = this->_conf.stall_timeout();
+        auto head = elle::Buffer();
+        auto lines = boost::string_ref();
+        auto code = 0;
+        auto version10 = false;
+        // Skip interim responses such as 100 Continue.
+        while (code < 200)
+        {
+          head = socket.read_until("\r\n\r\n", stall);
+          received = true;
+          lines = boost::string_ref(
+            reinterpret_cast<char const*>(head.contents()), head.size());
+          auto const status = next_line(lines);
+          auto const space = status.find(' ');
+          if (!boost::algorithm::starts_with(status, "HTTP/") ||
+              space == boost::string_ref::npos)
+            elle::err("invalid status line: %s", status);
+          try
+          {
+            code = std::stoi(status.substr(space + 1, 3).to_string());
+          }
+          catch (std::logic_error const&)
+          {
+            elle::err("invalid status line: %s", status);
+          }
+          version10 = status.substr(0, space) == "HTTP/1.0";
+        }
+        ELLE_TRACE("%s: got status %s", *this->_request, code);
+        auto length = boost::optional<uint64_t>();
+        auto chunked = false;
+        auto keep_alive = this->_conf.keep_alive() && !version10;
+        for (auto line = next_line(lines); !line.empty();
+             line = next_line(lines))
+        {
+          auto const colon = line.find(':');
+          if (colon == boost::string_ref::npos)
+            continue;
+          auto const name = trim(line.substr(0, colon));
+          auto const value = trim(line.substr(colon + 1));
+          if (is(name, "Content-Length"))
+            length = std::stoull(value.to_string());
+          else if (is(name, "Transfer-Encoding"))
+            chunked = boost::algorithm::icontains(value, "chunked");
+          else if (is(name, "Connection"))
+          {
+            if (is(value, "close"))
+              keep_alive = false;
+            else if (is(value, "keep-alive"))
+              keep_alive = this->_conf.keep_alive();
+          }
+          else if (is(name, "Set-Cookie"))
+          {
+            auto const cookie = value.substr(0, value.find(';'));
+            auto const equal = cookie.find('=');
+            if (equal != boost::string_ref::npos)
+              this->_native_cookies[trim(cookie.substr(0, equal)).to_string()]
+                = trim(cookie.substr(equal + 1)).to_string();
+          }
+          this->_request->_headers.emplace(name.to_string(),
+                                           value.to_string());
+        }
+        this->_request->_status = static_cast<StatusCode>(code);
+        this->_headers_available.open();
+        auto downloaded = int64_t(0);
+        if (this->_method == Method::HEAD || code == 204 || code == 304)
+          ELLE_DEBUG("%s: no body", *this->_request);
+        else if (chunked)
+          while (true)
+          {
+            auto size = uint64_t(0);
+            try
+            {
+              // Chunk extensions, if any, are ignored.
+              size = std::stoull(
+                socket.read_until("\r\n", stall).string(), nullptr, 16);
+            }
+            catch (std::logic_error const&)
+            {
+              elle::err("invalid chunk size");
+            }
+            if (size == 0)
+            {
+              // Skip the trailers.
+              while (!(socket.read_until("\r\n", stall) == "\r\n"))
+                ;
+              break;
+            }
+            this->_native_read(socket, size, downloaded, -1);
+            socket.read(2, stall);
+          }
+        else if (length)
+          this->_native_read(socket, *length, downloaded, *length);
+        else
+        {
+          // The body ends with the connection.
+          keep_alive = false;
+          try
+          {
+            this->_native_read(socket, uint64_t(-1), downloaded, -1);
+          }
+          catch (network::ConnectionClosed const&)
+          {}
+        }
+        ELLE_TRACE("%s: received %s bytes", *this->_request, downloaded);
+        return keep_alive;
+      }
+
+      void
+      Request::Impl::_native_read(network::Socket& socket,
+                                  uint64_t size,
+                                  int64_t& downloaded,
+                                  int64_t total)
+      {
+        auto const limit = this->_conf.buffer_size();
+        while (size)
+        {
+          while (limit && this->_input_size >= limit)
+          {
+            ELLE_DEBUG("%s: input: buffer full, pause", *this->_request);
+            this->_input_paused = true;
+            ++this->_pause_count;
+            reactor::wait(this->_input_drained);
+          }
+          auto buffer = elle::Buffer();
+          if (!this->_input_free.empty())
+          {
+            buffer = std::move(this->_input_free.back());
+            this->_input_free.pop_back();
+          }
+          buffer.size(std::min<uint64_t>(size, CURL_MAX_WRITE_SIZE));
+          // Read straight into the buffer handed to the reader.
+          auto const read = socket.read_some(
+            elle::WeakBuffer(buffer.mutable_contents(), buffer.size()),
+            this->_conf.stall_timeout());
+          buffer.size(read);
+          size -= read;
+          downloaded += read;
+          this->enqueue_data(std::move(buffer));
+          this->progress_set(total, downloaded,
+                             this->_progress.upload_total,
+                             this->_progress.upload_current);
+        }
+      }
+    }
+  }
+}
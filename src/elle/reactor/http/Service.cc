@@ -7,6 +7,8 @@
 #include <elle/reactor/http/RequestImpl.hh>
 #include <elle/reactor/http/Service.hh>
 #include <elle/reactor/http/exceptions.hh>
+#include <elle/reactor/network/TCPSocket.hh>
+#include <elle/reactor/network/ssl-socket.hh>
 #include <elle/reactor/scheduler.hh>
 
 ELLE_LOG_COMPONENT("elle.reactor.http.Service");
@@ -63,6 +65,14 @@ namespace elle
         : boost::asio::io_service::service(service)
         , _curl(nullptr)
         , _requests()
+        , _max_pooled(64)
+        , _handles()
+        , _share(nullptr)
+        , _http2(true)
+        , _max_idle_connections(16)
+        , _idle_timeout(std::chrono::seconds(30))
+        , _idle()
+        , _statistics()
         , _timer(service)
       {
         if (curl_global_ref_count()++ == 0)
@@ -77,8 +87,17 @@ namespace elle
                           &socket_callback);
         curl_multi_setopt(this->_curl,
                           CURLMOPT_TIMERFUNCTION, &Service::timeout_callback);
-        // Pipelining causes issues with S3, requests end up being stuck.
-        // curl_multi_setopt(this->_curl, CURLMOPT_PIPELINING, 1L);
+        // HTTP/1.1 pipelining causes issues with S3, requests end up being
+        // stuck. Only multiplex HTTP/2 streams.
+        curl_multi_setopt(this->_curl, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        // Connections are cached by the multi handle itself, only share DNS
+        // resolutions and TLS sessions.
+        this->_share = curl_share_init();
+        if (!this->_share)
+          throw std::bad_alloc();
+        curl_share_setopt(this->_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(this->_share,
+                          CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
       }
 
       Service::~Service()
@@ -90,8 +109,14 @@ namespace elle
       void
       Service::shutdown_service()
       {
+        for (auto handle: this->_handles)
+          curl_easy_cleanup(handle);
+        this->_handles.clear();
         auto res = curl_multi_cleanup(this->_curl);
         assert(res == CURLM_OK);
+        curl_share_cleanup(this->_share);
+        this->_share = nullptr;
+        this->_idle.clear();
       }
 
       /*--------.
@@ -140,6 +165,172 @@ namespace elle
           ELLE_ASSERT(false);
       }
 
+      /*--------.
+      | Handles |
+      `--------*/
+
+      CURL*
+      Service::acquire()
+      {
+        if (this->_handles.empty())
+          return curl_easy_init();
+        auto res = this->_handles.back();
+        this->_handles.pop_back();
+        return res;
+      }
+
+      void
+      Service::release(CURL* handle)
+      {
+        ELLE_ASSERT_NCONTAINS(this->_requests, handle);
+        if (this->_handles.size() >= this->_max_pooled)
+        {
+          curl_easy_cleanup(handle);
+          return;
+        }
+        // Detach from the Client cookie jar before dropping the cookies that
+        // were set on the handle itself, then reset every other option. The
+        // connection, DNS and TLS session caches survive the reset.
+        curl_easy_setopt(handle, CURLOPT_SHARE, nullptr);
+        curl_easy_setopt(handle, CURLOPT_COOKIELIST, "ALL");
+        curl_easy_reset(handle);
+        this->_handles.push_back(handle);
+      }
+
+      std::size_t
+      Service::pooled() const
+      {
+        return this->_handles.size();
+      }
+
+      /*--------------.
+      | Configuration |
+      `--------------*/
+
+      void
+      Service::max_host_connections(long count)
+      {
+        curl_multi_setopt(this->_curl, CURLMOPT_MAX_HOST_CONNECTIONS, count);
+      }
+
+      void
+      Service::max_total_connections(long count)
+      {
+        curl_multi_setopt(this->_curl, CURLMOPT_MAX_TOTAL_CONNECTIONS, count);
+      }
+
+      void
+      Service::max_concurrent_streams(long count)
+      {
+#if LIBCURL_VERSION_NUM >= 0x074300
+        curl_multi_setopt(this->_curl, CURLMOPT_MAX_CONCURRENT_STREAMS, count);
+#else
+        ELLE_WARN("%s: CURL %s cannot limit concurrent streams",
+                  *this, LIBCURL_VERSION);
+#endif
+      }
+
+      void
+      Service::max_connects(long count)
+      {
+        curl_multi_setopt(this->_curl, CURLMOPT_MAXCONNECTS, count);
+      }
+
+      /*-------------------.
+      | Native connections |
+      `-------------------*/
+
+      namespace
+      {
+        std::string
+        host_key(std::string const& scheme, std::string const& host, int port)
+        {
+          return elle::sprintf("%s://%s:%s", scheme, host, port);
+        }
+      }
+
+      std::unique_ptr<network::Socket>
+      Service::connection(std::string const& scheme,
+                          std::string const& host,
+                          int port,
+                          bool& reused)
+      {
+        auto const key = host_key(scheme, host, port);
+        auto it = this->_idle.find(key);
+        if (it != this->_idle.end())
+        {
+          auto& idle = it->second;
+          auto const now = Clock::now();
+          // Most recently used first, older ones are likely to be closed
+          // by the server.
+          while (!idle.empty())
+          {
+            auto connection = std::move(idle.back());
+            idle.pop_back();
+            if (now - connection.since < this->_idle_timeout)
+            {
+              ELLE_DEBUG("%s: reuse connection to %s", *this, key);
+              reused = true;
+              return std::move(connection.socket);
+            }
+            ELLE_DEBUG("%s: drop expired connection to %s", *this, key);
+          }
+          this->_idle.erase(it);
+        }
+        ELLE_TRACE("%s: connect to %s", *this, key);
+        reused = false;
+        if (scheme == "https")
+          return std::make_unique<network::SSLSocket>(
+            host, std::to_string(port));
+        else
+          return std::make_unique<network::TCPSocket>(host, port);
+      }
+
+      void
+      Service::recycle(std::string const& scheme,
+                       std::string const& host,
+                       int port,
+                       std::unique_ptr<network::Socket> socket)
+      {
+        auto& idle = this->_idle[host_key(scheme, host, port)];
+        if (idle.size() >= this->_max_idle_connections)
+          idle.erase(idle.begin());
+        idle.push_back(Idle{std::move(socket), Clock::now()});
+      }
+
+      std::size_t
+      Service::idle_connections() const
+      {
+        auto res = std::size_t(0);
+        for (auto const& host: this->_idle)
+          res += host.second.size();
+        return res;
+      }
+
+      /*-----------.
+      | Statistics |
+      `-----------*/
+
+      double
+      Service::Statistics::reuse_rate() const
+      {
+        return this->requests ? double(this->reused) / this->requests : 0;
+      }
+
+      void
+      Service::_account(CURL* handle)
+      {
+        ++this->_statistics.requests;
+        long connects = 0;
+        if (curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connects)
+            == CURLE_OK && connects == 0)
+          ++this->_statistics.reused;
+        long version = 0;
+        if (curl_easy_getinfo(handle, CURLINFO_HTTP_VERSION, &version)
+            == CURLE_OK && version == CURL_HTTP_VERSION_2_0)
+          ++this->_statistics.http2;
+      }
+
       /*-------.
       | Socket |
       `-------*/
@@ -167,8 +358,7 @@ namespace elle
 
       /// Callback called when a socket is ready to read or write.
       void
-      Service::handle_socket_ready(Request::Impl& request,
-                                   SocketPtr socket,
+      Service::handle_socket_ready(SocketPtr socket,
                                    int action,
                                    boost::system::error_code const& error,
                                    size_t)
@@ -183,8 +373,8 @@ namespace elle
         else if (error)
         {
           // Notify CURL of the error.
-          ELLE_WARN("%s: %s has error: %s",
-                    *this, *request._request, error.message());
+          ELLE_WARN("%s: socket %s has error: %s",
+                    *this, socket->_fd, error.message());
           auto res = curl_multi_socket_action(this->_curl,
                                               socket->native_handle(),
                                               CURL_CSELECT_ERR,
@@ -195,9 +385,8 @@ namespace elle
         else
         {
           // Notify CURL that the socket is ready for reading or writing.
-          ELLE_DEBUG_SCOPE("%s: %s (fd: %s) can %s",
-                           *this, *request._request,
-                           socket, action_string(action));
+          ELLE_DEBUG_SCOPE("%s: socket %s can %s",
+                           *this, socket->_fd, action_string(action));
           auto res = curl_multi_socket_action(this->_curl,
                                               socket->native_handle(),
                                               action, &running);
@@ -210,10 +399,10 @@ namespace elle
         switch (action)
         {
           case CURL_CSELECT_OUT:
-            this->register_socket_write(request, socket);
+            this->register_socket_write(socket);
             break;
           case CURL_CSELECT_IN:
-            this->register_socket_read(request, socket);
+            this->register_socket_read(socket);
             break;
         }
       };
@@ -225,66 +414,53 @@ namespace elle
                                     curl_socket_t socket,
                                     int action)
       {
-        // Find the Request.
+        // With HTTP/2, several requests share the socket: it is watched on
+        // behalf of the connection, not of the request that reported it.
+        ELLE_DEBUG_SCOPE("%s: socket %s wants to %s",
+                         *this, socket, action_string(action));
         if (this->_requests.find(handle) == this->_requests.end())
-        {
-          ELLE_ERR("missing request: %s, %s", handle, socket);
-          return;
-        }
-        Request::Impl& request = *this->_requests.find(handle)->second;
-        ELLE_DEBUG_SCOPE("%s: %s (fd: %s) wants to %s",
-                         *this, request, socket, action_string(action));
-        auto sock = request._curl.socket(socket);
+          ELLE_DEBUG("no request for handle %s", handle);
+        auto sock = this->socket(socket);
         // Set status and register needed callbacks.
         sock->writing = action & CURL_POLL_OUT;
         sock->reading = action & CURL_POLL_IN;
         // Cancel previous callbacks.
         sock->cancel();
         // Re-register needed callbacks.
-        this->register_socket_write(request, sock);
-        this->register_socket_read(request, sock);
+        this->register_socket_write(sock);
+        this->register_socket_read(sock);
       }
 
-      /// Register write event if the request is writing.
+      /// Register write event if the socket is writing.
       void
-      Service::register_socket_write(Request::Impl& request,
-                                     SocketPtr socket)
+      Service::register_socket_write(SocketPtr socket)
       {
         if (!socket->writing)
           return;
-        ELLE_DEBUG_SCOPE("%s: register %s (fd: %s) for writing",
-                         *this, *request._request, socket->native_handle());
-        socket->async_write_some(boost::asio::null_buffers(),
-                                 [this, &request, socket]
-                                 (boost::system::error_code const& error, size_t s)
-                                 {
-                                   this->handle_socket_ready(request,
-                                                             socket,
-                                                             CURL_CSELECT_OUT,
-                                                             error,
-                                                             s);
-                                 });
+        ELLE_DEBUG_SCOPE("%s: register socket %s for writing",
+                         *this, socket->_fd);
+        socket->async_write_some(
+          boost::asio::null_buffers(),
+          [this, socket] (boost::system::error_code const& error, size_t s)
+          {
+            this->handle_socket_ready(socket, CURL_CSELECT_OUT, error, s);
+          });
       }
 
-      /// Register read event if the request is writing.
+      /// Register read event if the socket is reading.
       void
-      Service::register_socket_read(Request::Impl& request,
-                                    SocketPtr socket)
+      Service::register_socket_read(SocketPtr socket)
       {
         if (!socket->reading)
           return;
-        ELLE_DEBUG_SCOPE("%s: register %s (fd: %s) for reading",
-                         *this, *request._request, socket->native_handle());
-        socket->async_read_some(boost::asio::null_buffers(),
-                                [this, &request, socket]
-                                (boost::system::error_code const& error, size_t s)
-                                {
-                                  this->handle_socket_ready(request,
-                                                            socket,
-                                                            CURL_CSELECT_IN,
-                                                            error,
-                                                            s);
-                                });
+        ELLE_DEBUG_SCOPE("%s: register socket %s for reading",
+                         *this, socket->_fd);
+        socket->async_read_some(
+          boost::asio::null_buffers(),
+          [this, socket] (boost::system::error_code const& error, size_t s)
+          {
+            this->handle_socket_ready(socket, CURL_CSELECT_IN, error, s);
+          });
       }
 
       /*--------.
@@ -355,6 +531,7 @@ namespace elle
           if (msg->msg == CURLMSG_DONE)
           {
             ELLE_TRACE("%s: %s is complete with code %s", *this, request, res);
+            this->_account(handle);
             request._request->_complete(res);
             this->remove(*request._request);
           }
@@ -1,11 +1,18 @@
 #pragma once
 
+#include <memory>
 #include <unordered_map>
+#include <vector>
+
+#include <curl/curl.h>
 
 #include <elle/reactor/asio.hh>
 
 #include <elle/Printable.hh>
+#include <elle/attribute.hh>
+#include <elle/reactor/duration.hh>
 #include <elle/reactor/http/Request.hh>
+#include <elle/reactor/network/fwd.hh>
 
 namespace elle
 {
@@ -13,6 +20,18 @@ namespace elle
   {
     namespace http
     {
+      /// The io_service service driving all HTTP requests of a scheduler
+      /// through a single CURL multi handle.
+      ///
+      /// Connections are cached by the multi handle and reused by subsequent
+      /// requests to the same host. Requests over TLS negotiate HTTP/2 through
+      /// ALPN and, when both ends support it, are multiplexed on a single
+      /// connection. DNS resolutions and TLS sessions are shared between
+      /// requests, and easy handles are reset and pooled instead of being
+      /// recreated for every request.
+      ///
+      /// Requests using the native Backend bypass the multi handle: they run
+      /// over reactor sockets, kept alive in a per-host pool of their own.
       class Service:
         public boost::asio::io_service::service,
         public elle::Printable
@@ -38,6 +57,105 @@ namespace elle
       private:
         std::unordered_map<void*, Request::Impl*> _requests;
 
+      /*--------.
+      | Handles |
+      `--------*/
+      public:
+        /// An easy handle, reused from the pool if possible.
+        ///
+        /// @return The handle, or null if none could be created.
+        CURL*
+        acquire();
+        /// Reset an easy handle and return it to the pool.
+        void
+        release(CURL* handle);
+        /// The number of idle easy handles in the pool.
+        std::size_t
+        pooled() const;
+        /// The maximum number of idle easy handles kept in the pool.
+        ELLE_ATTRIBUTE_RW(std::size_t, max_pooled);
+      private:
+        ELLE_ATTRIBUTE(std::vector<CURL*>, handles);
+        /// DNS and TLS session caches shared by requests outside of a Client.
+        ELLE_ATTRIBUTE_R(CURLSH*, share);
+
+      /*--------------.
+      | Configuration |
+      `--------------*/
+      public:
+        /// The maximum number of connections to a single host, 0 for no limit.
+        /// Requests over the limit are queued until a connection frees up.
+        void
+        max_host_connections(long count);
+        /// The maximum number of simultaneously open connections, 0 for no
+        /// limit.
+        void
+        max_total_connections(long count);
+        /// The maximum number of concurrent streams on an HTTP/2 connection.
+        void
+        max_concurrent_streams(long count);
+        /// The maximum number of idle connections kept in the cache.
+        void
+        max_connects(long count);
+        /// Whether HTTP/1.1 requests over TLS offer HTTP/2 through ALPN.
+        ELLE_ATTRIBUTE_RW(bool, http2);
+
+      /*-------------------.
+      | Native connections |
+      `-------------------*/
+      public:
+        /// A connection for a native request, reused if one is idle.
+        ///
+        /// @param reused Set to whether an idle connection was reused.
+        std::unique_ptr<network::Socket>
+        connection(std::string const& scheme,
+                   std::string const& host,
+                   int port,
+                   bool& reused);
+        /// Keep a connection for subsequent native requests to the same host.
+        void
+        recycle(std::string const& scheme,
+                std::string const& host,
+                int port,
+                std::unique_ptr<network::Socket> socket);
+        /// The number of idle native connections.
+        std::size_t
+        idle_connections() const;
+        /// The maximum number of idle native connections kept per host.
+        ELLE_ATTRIBUTE_RW(std::size_t, max_idle_connections);
+        /// How long an idle native connection is kept. Stay below the
+        /// keep-alive timeout of the servers.
+        ELLE_ATTRIBUTE_RW(Duration, idle_timeout);
+      private:
+        struct Idle
+        {
+          std::unique_ptr<network::Socket> socket;
+          Time since;
+        };
+        ELLE_ATTRIBUTE((std::unordered_map<std::string, std::vector<Idle>>),
+                       idle);
+
+      /*-----------.
+      | Statistics |
+      `-----------*/
+      public:
+        struct Statistics
+        {
+          /// The number of completed requests.
+          int requests = 0;
+          /// The number of requests served by an already open connection.
+          int reused = 0;
+          /// The number of requests served over HTTP/2.
+          int http2 = 0;
+          /// The fraction of requests that reused a connection.
+          double
+          reuse_rate() const;
+        };
+        ELLE_ATTRIBUTE_R(Statistics, statistics);
+      private:
+        void
+        _account(CURL* handle);
+
       /*-------.
       | Socket |
       `-------*/
@@ -87,17 +205,14 @@ namespace elle
                              curl_socket_t socket,
                              int action);
         void
-        handle_socket_ready(Request::Impl& r,
-                            SocketPtr socket,
+        handle_socket_ready(SocketPtr socket,
                             int action,
                             boost::system::error_code const& error,
                             size_t size);
         void
-        register_socket_write(Request::Impl& r,
-                              SocketPtr socket);
+        register_socket_write(SocketPtr socket);
         void
-        register_socket_read(Request::Impl& r,
-                             SocketPtr socket);
+        register_socket_read(SocketPtr socket);
 
       /*--------.
       | Timeout |
@@ -119,6 +119,9 @@ namespace elle
           case StatusCode::Expectation_Failed:
             output << "Expectation Failed";
             break;
+          case StatusCode::Request_Header_Fields_Too_Large:
+            output << "Request Header Fields Too Large";
+            break;
           case StatusCode::Internal_Server_Error:
             output << "Internal Server Error";
             break;
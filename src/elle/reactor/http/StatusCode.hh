@@ -47,6 +47,7 @@ namespace elle
         Requested_Range_Not_Satisfiable = 416,
         Expectation_Failed = 417,
         Unprocessable_Entity = 422,
+        Request_Header_Fields_Too_Large = 431,
         Internal_Server_Error = 500,
         Not_Implemented = 501,
         Bad_Gateway = 502,
@@ -31,11 +31,11 @@ namespace elle
     }
 
     bool
-    Mutex::_wait(Thread* thread, Waker const& waker)
+    Mutex::_wait(Handler& handler)
     {
       if (this->_locked)
       {
-        this->Waitable::_wait(thread, waker);
+        this->Waitable::_wait(handler);
         this->_locked = true;
         return true;
       }
@@ -56,7 +56,7 @@ namespace elle
       acquire() override;
     protected:
       bool
-      _wait(Thread* thread, Waker const& waker) override;
+      _wait(Handler& handler) override;
 
     private:
       /// Whether the Mutex is locked.
@@ -0,0 +1,289 @@
+#include <elle/reactor/network/ConnectionPool.hh>
+
+#include <exception>
+
+#include <elle/With.hh>
+#include <elle/log.hh>
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/network/Error.hh>
+#include <elle/reactor/scheduler.hh>
+#include <elle/reactor/signal.hh>
+
+ELLE_LOG_COMPONENT("elle.reactor.network.ConnectionPool");
+
+namespace elle
+{
+  namespace reactor
+  {
+    namespace network
+    {
+      namespace
+      {
+        std::string
+        peer(std::string const& host, std::string const& port)
+        {
+          return host + ":" + port;
+        }
+
+        /// The number of exceptions being unwound, or whether any is before
+        /// C++17.
+        int
+        uncaught_exceptions()
+        {
+#ifdef __cpp_lib_uncaught_exceptions
+          return std::uncaught_exceptions();
+#else
+          return std::uncaught_exception() ? 1 : 0;
+#endif
+        }
+
+        /// Alternate address families, starting with the preferred one, as
+        /// per RFC 8305 section 4.
+        ResolutionCache::EndPoints
+        interleave(ResolutionCache::EndPoints const& end_points)
+        {
+          if (end_points.empty())
+            return {};
+          auto const first = end_points.front().address().is_v6();
+          auto preferred = ResolutionCache::EndPoints{};
+          auto other = ResolutionCache::EndPoints{};
+          for (auto const& e: end_points)
+            (e.address().is_v6() == first ? preferred : other).push_back(e);
+          auto res = ResolutionCache::EndPoints{};
+          for (std::size_t i = 0; i < std::max(preferred.size(), other.size());
+               ++i)
+          {
+            if (i < preferred.size())
+              res.push_back(preferred[i]);
+            if (i < other.size())
+              res.push_back(other[i]);
+          }
+          return res;
+        }
+
+        /// Whether an idle connection can be used: the peer did not close it
+        /// and sent nothing unexpected.
+        bool
+        healthy(TCPSocket& socket)
+        {
+          if (socket.rdbuf()->in_avail() > 0)
+            return false;
+          auto& s = *socket.socket();
+          auto error = boost::system::error_code{};
+          char c;
+          s.non_blocking(true, error);
+          if (error)
+            return false;
+          auto const peeked = s.receive(boost::asio::buffer(&c, 1),
+                                        boost::asio::socket_base::message_peek,
+                                        error);
+          s.non_blocking(false, error);
+          return peeked == 0 && error == boost::asio::error::would_block;
+        }
+      }
+
+      /*-------------.
+      | Construction |
+      `-------------*/
+
+      ConnectionPool::ConnectionPool(int connecting)
+        : _idle()
+        , _connecting(connecting)
+        , _max_idle(8)
+        , _idle_timeout(std::chrono::seconds(60))
+        , _attempt_delay(std::chrono::milliseconds(250))
+        , _resolution_cache()
+        , _hits(0)
+        , _misses(0)
+      {}
+
+      ConnectionPool::~ConnectionPool()
+      {
+        this->clear();
+      }
+
+      /*------.
+      | Lease |
+      `------*/
+
+      ConnectionPool::Lease::Lease(ConnectionPool& pool,
+                                   std::string key,
+                                   std::unique_ptr<TCPSocket> socket,
+                                   bool reused)
+        : _pool(&pool)
+        , _key(std::move(key))
+        , _socket(std::move(socket))
+        , _reused(reused)
+        , _exceptions(uncaught_exceptions())
+      {}
+
+      ConnectionPool::Lease::Lease(Lease&& lease)
+        : _pool(lease._pool)
+        , _key(std::move(lease._key))
+        , _socket(std::move(lease._socket))
+        , _reused(lease._reused)
+        , _exceptions(uncaught_exceptions())
+      {}
+
+      ConnectionPool::Lease::~Lease()
+      {
+        // Connections left by an exception are in an unknown state. Leases
+        // created while unwinding are only concerned by newer exceptions.
+        if (this->_socket &&
+            uncaught_exceptions() <= this->_exceptions)
+          this->_pool->_release(this->_key, std::move(this->_socket));
+      }
+
+      TCPSocket&
+      ConnectionPool::Lease::operator *() const
+      {
+        return *this->_socket;
+      }
+
+      TCPSocket*
+      ConnectionPool::Lease::operator ->() const
+      {
+        return this->_socket.get();
+      }
+
+      void
+      ConnectionPool::Lease::discard()
+      {
+        ELLE_DEBUG("discard connection to %s", this->_key);
+        this->_socket.reset();
+      }
+
+      /*--------.
+      | Leasing |
+      `--------*/
+
+      ConnectionPool::Lease
+      ConnectionPool::lease(std::string const& host,
+                            std::string const& port,
+                            DurationOpt timeout)
+      {
+        auto key = peer(host, port);
+        ELLE_TRACE_SCOPE("%s: lease connection to %s", this, key);
+        auto it = this->_idle.find(key);
+        if (it != this->_idle.end())
+        {
+          auto& idle = it->second;
+          auto const now = Clock::now();
+          while (!idle.empty())
+          {
+            auto connection = std::move(idle.back());
+            idle.pop_back();
+            if (now - connection.since > this->_idle_timeout)
+              ELLE_DEBUG("drop connection idle for too long");
+            else if (!healthy(*connection.socket))
+              ELLE_DEBUG("drop closed connection");
+            else
+            {
+              ELLE_DEBUG("reuse idle connection");
+              ++this->_hits;
+              return Lease(*this, std::move(key),
+                           std::move(connection.socket), true);
+            }
+          }
+          this->_idle.erase(it);
+        }
+        ++this->_misses;
+        auto socket = this->connect(host, port, timeout);
+        return Lease(*this, std::move(key), std::move(socket), false);
+      }
+
+      ConnectionPool::Lease
+      ConnectionPool::lease(std::string const& host,
+                            int port,
+                            DurationOpt timeout)
+      {
+        return this->lease(host, std::to_string(port), timeout);
+      }
+
+      std::unique_ptr<TCPSocket>
+      ConnectionPool::connect(std::string const& host,
+                              std::string const& port,
+                              DurationOpt timeout)
+      {
+        ELLE_TRACE_SCOPE("%s: connect to %s", this, peer(host, port));
+        auto const end_points = interleave(
+          this->_resolution_cache.resolve_tcp(host, port, ResolveOptions(false)));
+        auto res = std::unique_ptr<TCPSocket>{};
+        auto error = std::exception_ptr{};
+        auto started = std::size_t(0);
+        auto failed = std::size_t(0);
+        auto progress = reactor::Signal("connection attempt");
+        elle::With<reactor::Scope>() << [&] (reactor::Scope& scope)
+        {
+          for (auto const& end_point: end_points)
+          {
+            if (res)
+              break;
+            ++started;
+            scope.run_background(
+              elle::sprintf("%s: connect to %s", this, end_point),
+              [&, end_point]
+              {
+                try
+                {
+                  reactor::Lock lock(this->_connecting);
+                  auto socket = std::make_unique<TCPSocket>(end_point, timeout);
+                  if (!res)
+                  {
+                    ELLE_DEBUG("connected to %s", end_point);
+                    res = std::move(socket);
+                  }
+                }
+                catch (Error const& e)
+                {
+                  ELLE_DEBUG("unable to connect to %s: %s", end_point, e);
+                  error = std::current_exception();
+                  ++failed;
+                }
+                progress.signal();
+              });
+            if (started < end_points.size())
+              reactor::wait(progress, this->_attempt_delay);
+          }
+          while (!res && failed < started)
+            reactor::wait(progress);
+          scope.terminate_now();
+        };
+        if (!res)
+        {
+          if (error)
+            std::rethrow_exception(error);
+          throw ResolutionError(host, "no address to connect to");
+        }
+        return res;
+      }
+
+      std::size_t
+      ConnectionPool::idle(std::string const& host,
+                           std::string const& port) const
+      {
+        auto it = this->_idle.find(peer(host, port));
+        return it == this->_idle.end() ? 0 : it->second.size();
+      }
+
+      void
+      ConnectionPool::clear()
+      {
+        this->_idle.clear();
+      }
+
+      void
+      ConnectionPool::_release(std::string const& key,
+                               std::unique_ptr<TCPSocket> socket)
+      {
+        if (this->_max_idle == 0)
+          return;
+        ELLE_DEBUG("%s: release connection to %s", this, key);
+        auto& idle = this->_idle[key];
+        idle.push_back(Idle{std::move(socket), Clock::now()});
+        while (idle.size() > this->_max_idle)
+          idle.pop_front();
+      }
+    }
+  }
+}
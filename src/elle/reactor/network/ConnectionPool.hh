@@ -0,0 +1,157 @@
+#pragma once
+
+#include <deque>
+#include <unordered_map>
+
+#include <elle/reactor/duration.hh>
+#include <elle/reactor/network/TCPSocket.hh>
+#include <elle/reactor/network/resolve.hh>
+#include <elle/reactor/semaphore.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    namespace network
+    {
+      /// Lease TCP connections to peers, reusing idle ones.
+      ///
+      /// New connections resolve hosts through a ResolutionCache and race
+      /// their addresses, alternating IPv6 and IPv4, as per RFC 8305 (happy
+      /// eyeballs). When a lease ends, its connection returns to an idle pool
+      /// for that peer, unless it was discarded or the lease ended because of
+      /// an exception. Idle connections are checked before being leased
+      /// again: closed ones, ones with pending data and ones idle for too
+      /// long are dropped.
+      ///
+      /// @code{.cc}
+      ///
+      /// elle::reactor::network::ConnectionPool pool;
+      /// {
+      ///   auto connection = pool.lease("example.com", 80);
+      ///   connection->write(request);
+      ///   // Read the whole response.
+      /// }
+      /// // Reuses the connection.
+      /// auto connection = pool.lease("example.com", 80);
+      ///
+      /// @endcode
+      class ConnectionPool
+      {
+      /*-------------.
+      | Construction |
+      `-------------*/
+      public:
+        /// Create a ConnectionPool.
+        ///
+        /// @param connecting The maximum number of concurrent connection
+        ///                   attempts.
+        ConnectionPool(int connecting = 64);
+        ConnectionPool(ConnectionPool const&) = delete;
+        ~ConnectionPool();
+
+      /*--------.
+      | Leasing |
+      `--------*/
+      public:
+        /// A connection leased from a ConnectionPool.
+        ///
+        /// Leases must not outlive their pool.
+        class Lease
+        {
+        public:
+          Lease(Lease&& lease);
+          ~Lease();
+          TCPSocket&
+          operator *() const;
+          TCPSocket*
+          operator ->() const;
+          /// Close the connection instead of returning it to the pool, e.g.
+          /// when a response was not read entirely.
+          void
+          discard();
+
+        private:
+          friend class ConnectionPool;
+          Lease(ConnectionPool& pool,
+                std::string key,
+                std::unique_ptr<TCPSocket> socket,
+                bool reused);
+          ELLE_ATTRIBUTE(ConnectionPool*, pool);
+          ELLE_ATTRIBUTE(std::string, key);
+          ELLE_ATTRIBUTE(std::unique_ptr<TCPSocket>, socket);
+          /// Whether the connection was idle in the pool.
+          ELLE_ATTRIBUTE_R(bool, reused);
+          /// Exceptions in flight when leased.
+          ELLE_ATTRIBUTE(int, exceptions);
+        };
+
+        /// Lease a connection to a peer, reusing an idle one if possible.
+        ///
+        /// @param host The name of the host.
+        /// @param port The port the host is listening to.
+        /// @param timeout The maximum duration before a new connection
+        ///                attempt times out.
+        Lease
+        lease(std::string const& host,
+              std::string const& port,
+              DurationOpt timeout = {});
+        /// @see ConnectionPool::lease.
+        Lease
+        lease(std::string const& host,
+              int port,
+              DurationOpt timeout = {});
+        /// Establish a new connection, outside of the pool.
+        ///
+        /// Attempts to successive addresses are started every attempt_delay,
+        /// or as soon as the previous one fails. The first to succeed wins.
+        ///
+        /// @throw The error of the last attempt, if all fail.
+        std::unique_ptr<TCPSocket>
+        connect(std::string const& host,
+                std::string const& port,
+                DurationOpt timeout = {});
+        /// The number of idle connections to a peer.
+        std::size_t
+        idle(std::string const& host, std::string const& port) const;
+        /// Close all idle connections.
+        void
+        clear();
+      private:
+        void
+        _release(std::string const& key, std::unique_ptr<TCPSocket> socket);
+        struct Idle
+        {
+          std::unique_ptr<TCPSocket> socket;
+          Time since;
+        };
+        /// Idle connections per peer, most recently used last.
+        ELLE_ATTRIBUTE((std::unordered_map<std::string, std::deque<Idle>>),
+                       idle);
+        ELLE_ATTRIBUTE(Semaphore, connecting);
+
+      /*--------------.
+      | Configuration |
+      `--------------*/
+      public:
+        /// The maximum number of idle connections kept per peer.
+        ELLE_ATTRIBUTE_RW(std::size_t, max_idle);
+        /// Idle connections older than this are closed.
+        ELLE_ATTRIBUTE_RW(Duration, idle_timeout);
+        /// The delay before trying the next address while an attempt is
+        /// pending.
+        ELLE_ATTRIBUTE_RW(Duration, attempt_delay);
+        ELLE_ATTRIBUTE_X(ResolutionCache, resolution_cache);
+
+      /*-----------.
+      | Statistics |
+      `-----------*/
+      public:
+        /// The number of leases served by idle connections.
+        ELLE_ATTRIBUTE_R(int, hits);
+        /// The number of leases that required a new connection.
+        ELLE_ATTRIBUTE_R(int, misses);
+      };
+    }
+  }
+}
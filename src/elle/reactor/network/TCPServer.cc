@@ -1,6 +1,13 @@
 #include <elle/reactor/network/TCPServer.hh>
+
+#ifdef ELLE_LINUX
+# include <netinet/tcp.h>
+#endif
+
+#include <elle/reactor/network/Error.hh>
 #include <elle/reactor/network/TCPSocket.hh>
 #include <elle/reactor/scheduler.hh>
+#include <elle/reactor/sleep.hh>
 
 ELLE_LOG_COMPONENT("elle.reactor.network.TCPServer");
 
@@ -16,8 +23,26 @@ namespace elle
       TCPServer::TCPServer(bool no_delay)
         : Super()
         , _no_delay(no_delay)
+        , _backlog(boost::asio::socket_base::max_connections)
+        , _reuse_port(false)
+        , _acceptors(1)
+        , _fast_open(0)
+        , _defer_accept()
+        , _extra_acceptors()
+        , _accept_threads()
+        , _sockets()
+        , _queue_depth_bench(std::make_shared<elle::Bench<int>>(
+                               "bench.reactor.network.TCPServer.queue"))
+        , _first_byte_bench(std::make_shared<elle::Bench<>>(
+                              "bench.reactor.network.TCPServer.first_byte"))
       {}
 
+      TCPServer::~TCPServer()
+      {
+        // Accept loops refer to our acceptors and channel.
+        this->_accept_threads.clear();
+      }
+
       /*----------.
       | Accepting |
       `----------*/
@@ -53,9 +78,122 @@ namespace elle
         return local_endpoint().port();
       }
 
+      namespace
+      {
+        template <typename Option>
+        void
+        set_option(TCPServer::Acceptor& acceptor,
+                   char const* name,
+                   Option const& option)
+        {
+          boost::system::error_code erc;
+          acceptor.set_option(option, erc);
+          if (erc)
+            ELLE_WARN("unable to set %s on %s: %s",
+                      name, acceptor.local_endpoint(), erc.message());
+        }
+      }
+
+      auto
+      TCPServer::_make_acceptor(EndPoint const& endpoint)
+        -> std::unique_ptr<Acceptor>
+      {
+        // Stop accepting on previous sockets before they are replaced.
+        this->_accept_threads.clear();
+        this->_extra_acceptors.clear();
+        auto const reuse_port = this->_reuse_port || this->_acceptors > 1;
+#ifndef SO_REUSEPORT
+        if (reuse_port)
+          throw Error("SO_REUSEPORT is not supported on this platform");
+#endif
+        auto open = [&] (EndPoint const& endpoint)
+        {
+          auto res = std::make_unique<Acceptor>(this->_scheduler.io_service());
+          res->open(endpoint.protocol());
+          res->set_option(Acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+          if (reuse_port)
+            res->set_option(
+              boost::asio::detail::socket_option::boolean<
+                SOL_SOCKET, SO_REUSEPORT>(true));
+#endif
+          res->bind(endpoint);
+#ifdef ELLE_LINUX
+          if (this->_defer_accept)
+            set_option(
+              *res, "TCP_DEFER_ACCEPT",
+              boost::asio::detail::socket_option::integer<
+                IPPROTO_TCP, TCP_DEFER_ACCEPT>(
+                  std::chrono::duration_cast<std::chrono::seconds>(
+                    *this->_defer_accept).count()));
+          if (this->_fast_open)
+            set_option(
+              *res, "TCP_FASTOPEN",
+              boost::asio::detail::socket_option::integer<
+                IPPROTO_TCP, TCP_FASTOPEN>(this->_fast_open));
+#else
+          if (this->_defer_accept || this->_fast_open)
+            ELLE_WARN("%s: TCP_DEFER_ACCEPT and TCP_FASTOPEN are only "
+                      "supported on Linux", *this);
+#endif
+          res->listen(this->_backlog);
+          return res;
+        };
+        auto res = open(endpoint);
+        if (this->_acceptors > 1)
+        {
+          // Bind to the actual port, in case an ephemeral one was picked.
+          auto const bound = res->local_endpoint();
+          for (int i = 1; i < this->_acceptors; ++i)
+            this->_extra_acceptors.emplace_back(open(bound));
+          auto loop = [this] (Acceptor& acceptor)
+          {
+            this->_accept_threads.emplace_back(
+              new Thread(this->_scheduler,
+                         elle::sprintf("%s: accept on %s",
+                                       *this, acceptor.local_endpoint()),
+                         [this, &acceptor] { this->_accept_loop(acceptor); }));
+          };
+          loop(*res);
+          for (auto& acceptor: this->_extra_acceptors)
+            loop(*acceptor);
+        }
+        ELLE_TRACE("%s: listen on %s with %s acceptor(s)",
+                   *this, res->local_endpoint(), this->_acceptors);
+        return res;
+      }
+
+      void
+      TCPServer::_accept_loop(Acceptor& acceptor)
+      {
+        while (true)
+        {
+          auto socket = elle::make_unique<AsioSocket>(
+            this->_scheduler.io_service());
+          EndPoint peer;
+          try
+          {
+            this->_accept(acceptor, *socket, peer);
+          }
+          catch (Error const& e)
+          {
+            // Typically running out of file descriptors: back off instead of
+            // spinning on the error.
+            ELLE_WARN("%s: accept failed: %s", *this, e);
+            reactor::sleep(100ms);
+            continue;
+          }
+          this->_sockets.put(this->_accepted(std::move(socket), peer));
+        }
+      }
+
       std::unique_ptr<TCPSocket>
       TCPServer::accept()
       {
+        if (this->_queue_depth_bench->enabled())
+          this->_queue_depth_bench->add(this->accept_queue_depth());
+        if (!this->_accept_threads.empty())
+          return this->_sockets.get();
         // Open a new raw socket.
         //
         // We can neither directly build the std::unique_ptr here, nor
@@ -66,21 +204,70 @@ namespace elle
           (reactor::Scheduler::scheduler()->io_service());
         EndPoint peer;
         this->_accept(*new_socket, peer);
+        return this->_accepted(std::move(new_socket), peer);
+      }
+
+      std::unique_ptr<TCPSocket>
+      TCPServer::_accepted(std::unique_ptr<AsioSocket> socket,
+                           EndPoint const& peer)
+      {
         // Socket is now connected so make it into a TCPSocket.
         //
         // Cannot use make_unique: private ctor.
         auto res = std::unique_ptr<TCPSocket>
-          (new TCPSocket(std::move(new_socket), peer));
+          (new TCPSocket(std::move(socket), peer));
         // TCP no delay disable Nagle's algorithm.
         if (this->_no_delay)
         {
           res->socket()->lowest_layer().set_option(
             boost::asio::ip::tcp::no_delay(true));
         }
+        if (this->_first_byte_bench->enabled())
+        {
+          // A null_buffers read completes on readability without consuming
+          // anything, ahead of the reads issued by the socket's user.
+          auto const start = Clock::now();
+          auto bench = this->_first_byte_bench;
+          res->socket()->async_read_some(
+            boost::asio::null_buffers(),
+            [bench, start] (boost::system::error_code const& erc, std::size_t)
+            {
+              if (!erc)
+                bench->add(Clock::now() - start);
+            });
+        }
         ELLE_TRACE("%s: got connection: %s", *this, *res);
         return res;
       }
 
+      /*--------.
+      | Metrics |
+      `--------*/
+
+      int
+      TCPServer::accept_queue_depth()
+      {
+        auto res = this->_sockets.size();
+#ifdef ELLE_LINUX
+        // On listening sockets, tcpi_unacked is the accept queue length.
+        auto kernel = [] (Acceptor& acceptor)
+        {
+          auto info = tcp_info{};
+          auto size = socklen_t(sizeof info);
+          if (::getsockopt(acceptor.native_handle(), IPPROTO_TCP, TCP_INFO,
+                           &info, &size) == 0)
+            return int(info.tcpi_unacked);
+          else
+            return 0;
+        };
+        if (this->acceptor())
+          res += kernel(*this->acceptor());
+        for (auto& acceptor: this->_extra_acceptors)
+          res += kernel(*acceptor);
+#endif
+        return res;
+      }
+
       std::unique_ptr<Socket>
       TCPServer::_accept()
       {
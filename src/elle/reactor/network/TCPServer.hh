@@ -1,5 +1,11 @@
 #pragma once
 
+#include <vector>
+
+#include <elle/bench.hh>
+#include <elle/reactor/Channel.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/duration.hh>
 #include <elle/reactor/network/server.hh>
 
 namespace elle
@@ -43,6 +49,14 @@ namespace elle
       /// // Result: "12AB3C".
       ///
       /// @endcode
+      ///
+      /// Under connection storms, a single listening socket becomes the
+      /// bottleneck. Setting acceptors() to N > 1 before listening binds N
+      /// sockets to the same port with SO_REUSEPORT: the kernel spreads
+      /// incoming connections over their accept queues, each drained by its
+      /// own accept loop into a common queue served by accept(). To spread the
+      /// load over several cores, run one TCPServer per Scheduler with
+      /// reuse_port() enabled on the same port.
       class TCPServer
         : public ProtoServer<boost::asio::ip::tcp::socket,
                              boost::asio::ip::tcp::endpoint,
@@ -59,6 +73,8 @@ namespace elle
         ///
         /// @param no_delay Disable Nagle's algorithm.
         TCPServer(bool no_delay = false);
+        /// Stop accept loops and destroy the TCPServer.
+        ~TCPServer() override;
 
         /// Get a TCPSocket bound to a peer.
         ///
@@ -92,10 +108,57 @@ namespace elle
       protected:
         EndPoint
         _default_endpoint() const override;
+        std::unique_ptr<Acceptor>
+        _make_acceptor(EndPoint const& endpoint) override;
         using Super::_accept;
         std::unique_ptr<Socket>
         _accept() override;
+      private:
+        std::unique_ptr<TCPSocket>
+        _accepted(std::unique_ptr<AsioSocket> socket, EndPoint const& peer);
+        void
+        _accept_loop(Acceptor& acceptor);
         ELLE_ATTRIBUTE_RX(bool, no_delay);
+
+      /*--------.
+      | Options |
+      `--------*/
+      public:
+        // Options are applied to listening sockets by the next listen.
+
+        /// Maximum length of each kernel accept queue.
+        ELLE_ATTRIBUTE_RW(int, backlog);
+        /// Whether to set SO_REUSEPORT, enabling several servers to listen on
+        /// the same port.
+        ELLE_ATTRIBUTE_RW(bool, reuse_port);
+        /// Number of listening sockets, each with its own accept loop. Implies
+        /// reuse_port if greater than one.
+        ELLE_ATTRIBUTE_RW(int, acceptors);
+        /// TCP_FASTOPEN queue length, or 0 to disable TCP Fast Open.
+        ELLE_ATTRIBUTE_RW(int, fast_open);
+        /// If set, enable TCP_DEFER_ACCEPT: connections are only accepted once
+        /// the peer sent data, or after the given delay.
+        ELLE_ATTRIBUTE_RW(DurationOpt, defer_accept);
+      private:
+        ELLE_ATTRIBUTE(std::vector<std::unique_ptr<Acceptor>>,
+                       extra_acceptors);
+        ELLE_ATTRIBUTE(std::vector<Thread::unique_ptr>, accept_threads);
+        /// Connections accepted by the accept loops.
+        ELLE_ATTRIBUTE(Channel<std::unique_ptr<TCPSocket>>, sockets);
+
+      /*--------.
+      | Metrics |
+      `--------*/
+      public:
+        /// Number of connections established but not yet returned by accept,
+        /// both in the kernel accept queues and in our own.
+        int
+        accept_queue_depth();
+      private:
+        /// Accept queue depth, sampled on every accept.
+        ELLE_ATTRIBUTE(std::shared_ptr<elle::Bench<int>>, queue_depth_bench);
+        /// Delay between accepting a connection and its first readable byte.
+        ELLE_ATTRIBUTE(std::shared_ptr<elle::Bench<>>, first_byte_bench);
       };
     }
   }
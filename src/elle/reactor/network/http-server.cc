@@ -1,7 +1,12 @@
+#include <algorithm>
+
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/join.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/utility/string_ref.hpp>
 
+#include <elle/err.hh>
+#include <elle/finally.hh>
 #include <elle/os/environ.hh>
 #include <elle/reactor/network/Error.hh>
 #include <elle/reactor/network/http-server.hh>
@@ -21,6 +26,45 @@ namespace
                             boost::algorithm::is_any_of(sep));
     return res;
   }
+
+  /// The lines of a request head, without their CRLF, pointing into it.
+  class Lines
+  {
+  public:
+    Lines(elle::ConstWeakBuffer head)
+      : _data(reinterpret_cast<char const*>(head.contents()), head.size())
+    {}
+
+    /// The next line, empty at the end of the head.
+    boost::string_ref
+    next()
+    {
+      auto const end = this->_data.find("\r\n");
+      auto const line = this->_data.substr(0, end);
+      this->_data.remove_prefix(
+        end == boost::string_ref::npos ? this->_data.size() : end + 2);
+      return line;
+    }
+
+  private:
+    boost::string_ref _data;
+  };
+
+  boost::string_ref
+  trim(boost::string_ref s)
+  {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+      s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+      s.remove_suffix(1);
+    return s;
+  }
+
+  bool
+  is(boost::string_ref a, char const* b)
+  {
+    return boost::algorithm::iequals(a, boost::string_ref(b));
+  }
 }
 
 namespace elle
@@ -33,6 +77,11 @@ namespace elle
         : _server(std::move(server))
         , _port(0)
         , _accepter()
+        , _max_connections(1024)
+        , _keep_alive_timeout(std::chrono::seconds(60))
+        , _max_header_size(8192)
+        , _max_body_size(64 * 1024 * 1024)
+        , _connections(0)
       {
         if (!this->_server)
         {
@@ -49,6 +98,11 @@ namespace elle
       }
 
       HttpServer::HttpServer(int port)
+        : _max_connections(1024)
+        , _keep_alive_timeout(std::chrono::seconds(60))
+        , _max_header_size(8192)
+        , _max_body_size(64 * 1024 * 1024)
+        , _connections(0)
       {
         auto server = std::make_unique<TCPServer>();
         server->listen(port);
@@ -79,12 +133,12 @@ namespace elle
         return elle::sprintf("http://127.0.0.1:%s/%s", this->port(), path);
       }
 
-      HttpServer::CommandLine::CommandLine(elle::Buffer const& buffer)
+      HttpServer::CommandLine::CommandLine(std::string const& line)
         : _path()
         , _method()
         , _version()
       {
-         auto const words = split(buffer, " ");
+         auto const words = split(line, " ");
          if (words.size() != 3)
            throw HttpServer::Exception(
              boost::algorithm::join(words, " "),
@@ -107,7 +161,7 @@ namespace elle
          try
          {
            this->_method = reactor::http::method::from_string(words[0]);
-           this->_version = reactor::http::version::from_string(words[2].substr(0, words[2].size() - 2));
+           this->_version = reactor::http::version::from_string(words[2]);
          }
          catch (elle::Exception const& e)
          {
@@ -143,6 +197,155 @@ namespace elle
                       this->path(), this->params(), this->method());
       }
 
+      struct HttpServer::Routes::Node
+      {
+        /// The static part of the path leading to this node.
+        std::string prefix;
+        /// Static children, each starting with a distinct character.
+        std::vector<std::unique_ptr<Node>> children;
+        /// The name of the parameter captured by this node, if any.
+        std::string name;
+        /// The child matching one path segment.
+        std::unique_ptr<Node> parameter;
+        /// The child matching the rest of the path.
+        std::unique_ptr<Node> wildcard;
+        MethodFunctions methods;
+
+        /// The node at the end of the static label, splitting edges that
+        /// only share part of it.
+        Node*
+        insert(std::string label)
+        {
+          auto node = this;
+          while (!label.empty())
+          {
+            auto const it = std::find_if(
+              node->children.begin(), node->children.end(),
+              [&] (std::unique_ptr<Node> const& child)
+              {
+                return child->prefix[0] == label[0];
+              });
+            if (it == node->children.end())
+            {
+              node->children.emplace_back(std::make_unique<Node>());
+              node->children.back()->prefix = std::move(label);
+              return node->children.back().get();
+            }
+            auto& child = *it;
+            auto const common = std::size_t(
+              std::mismatch(label.begin(), label.end(),
+                            child->prefix.begin(), child->prefix.end()).first
+              - label.begin());
+            if (common < child->prefix.size())
+            {
+              auto split = std::make_unique<Node>();
+              split->prefix = child->prefix.substr(0, common);
+              child->prefix.erase(0, common);
+              split->children.emplace_back(std::move(child));
+              child = std::move(split);
+            }
+            node = child.get();
+            label.erase(0, common);
+          }
+          return node;
+        }
+
+        Node const*
+        find(std::string const& path,
+             std::size_t pos,
+             std::vector<std::pair<std::string, std::string>>& captures) const
+        {
+          if (pos == path.size())
+            return this->methods.empty() ? nullptr : this;
+          for (auto const& child: this->children)
+            if (path.compare(pos, child->prefix.size(), child->prefix) == 0)
+            {
+              if (auto res =
+                  child->find(path, pos + child->prefix.size(), captures))
+                return res;
+              break;
+            }
+          if (this->parameter)
+          {
+            auto const end = std::min(path.find('/', pos), path.size());
+            if (end > pos)
+            {
+              captures.emplace_back(this->parameter->name,
+                                    path.substr(pos, end - pos));
+              if (auto res = this->parameter->find(path, end, captures))
+                return res;
+              captures.pop_back();
+            }
+          }
+          if (this->wildcard && !this->wildcard->methods.empty())
+          {
+            captures.emplace_back(this->wildcard->name, path.substr(pos));
+            return this->wildcard.get();
+          }
+          return nullptr;
+        }
+      };
+
+      HttpServer::Routes::Routes()
+        : _root(std::make_unique<Node>())
+      {}
+
+      HttpServer::Routes::~Routes() = default;
+
+      void
+      HttpServer::Routes::add(std::string const& route,
+                              http::Method method,
+                              Handler handler)
+      {
+        auto node = this->_root.get();
+        auto i = std::size_t(0);
+        while (i < route.size())
+        {
+          if (route[i] == ':' || route[i] == '*')
+          {
+            auto const end = std::min(route.find('/', i), route.size());
+            auto const name = route.substr(i + 1, end - i - 1);
+            if (name.empty())
+              elle::err("unnamed parameter in route %s", route);
+            if (route[i] == '*' && end != route.size())
+              elle::err("catch-all parameter %s does not end route %s",
+                        name, route);
+            auto& child = route[i] == ':' ? node->parameter : node->wildcard;
+            if (!child)
+            {
+              child = std::make_unique<Node>();
+              child->name = name;
+            }
+            else if (child->name != name)
+              elle::err("parameter %s of route %s conflicts with %s",
+                        name, route, child->name);
+            node = child.get();
+            i = end;
+          }
+          else
+          {
+            auto const end =
+              std::min(route.find_first_of(":*", i), route.size());
+            node = node->insert(route.substr(i, end - i));
+            i = end;
+          }
+        }
+        node->methods[method] = std::move(handler);
+      }
+
+      HttpServer::MethodFunctions const*
+      HttpServer::Routes::find(std::string const& path,
+                               Parameters& params) const
+      {
+        auto captures = std::vector<std::pair<std::string, std::string>>{};
+        auto const node = this->_root->find(path, 0, captures);
+        if (!node)
+          return nullptr;
+        for (auto& capture: captures)
+          params[capture.first] = std::move(capture.second);
+        return &node->methods;
+      }
+
       void
       HttpServer::_accept()
       {
@@ -150,13 +353,26 @@ namespace elle
         {
           while (true)
           {
+            while (this->_connections >= this->_max_connections)
+            {
+              ELLE_DEBUG("%s: %s connections, wait for one to close",
+                         *this, this->_connections);
+              reactor::wait(this->_connection_closed);
+            }
             auto socket = elle::utility::move_on_copy(this->_server->accept());
             ELLE_DEBUG("accept connection from %s", **socket);
             auto name = elle::sprintf("request %s", **socket);
+            ++this->_connections;
             scope.run_background(
               name,
               [this, socket]
               {
+                elle::SafeFinally closed(
+                  [this]
+                  {
+                    --this->_connections;
+                    this->_connection_closed.signal();
+                  });
                 try
                 {
                   std::unique_ptr<reactor::network::Socket> s =
@@ -185,79 +401,162 @@ namespace elle
       void
       HttpServer::_serve(std::unique_ptr<reactor::network::Socket> socket)
       {
+        this->_persistence[socket.get()] = Persistence::close;
+        elle::SafeFinally forget(
+          [&] { this->_persistence.erase(socket.get()); });
+        for (auto first = true; ; first = false)
+        {
+          auto head = elle::Buffer{};
+          try
+          {
+            // Pipelined requests are already buffered and read right away,
+            // idle connections are dropped after keep_alive_timeout.
+            head = socket->read_until(
+              "\r\n\r\n",
+              first ? DurationOpt() : DurationOpt(this->_keep_alive_timeout),
+              this->_max_header_size);
+          }
+          catch (TimeOut const&)
+          {
+            ELLE_TRACE("%s: close idle connection with %s", *this, socket);
+            return;
+          }
+          catch (ConnectionClosed const&)
+          {
+            if (first)
+              throw;
+            ELLE_TRACE("%s: connection closed by %s", *this, socket);
+            return;
+          }
+          // Without the terminator, the head was cut at max_header_size.
+          if (head.size() < 4 ||
+              !(head.range(head.size() - 4) == "\r\n\r\n"))
+          {
+            ELLE_TRACE("%s: header from %s exceeds %s bytes",
+                       *this, socket, this->_max_header_size);
+            this->_response(
+              *socket, http::StatusCode::Request_Header_Fields_Too_Large,
+              elle::ConstWeakBuffer("request header fields too large"));
+            break;
+          }
+          if (!this->_handle(*socket, head))
+            break;
+        }
+        ELLE_TRACE("%s: close connection with %s", *this, socket);
+      }
+
+      bool
+      HttpServer::_handle(reactor::network::Socket& socket,
+                          elle::Buffer const& head)
+      {
+        auto& persistence = this->_persistence.at(&socket);
+        persistence = Persistence::close;
         auto headers = this->_headers;
         auto cookies = Cookies{};
         try
         {
-          CommandLine cmd(socket->read_until("\r\n"));
+          auto lines = Lines(head);
+          CommandLine cmd(lines.next().to_string());
           ELLE_LOG_SCOPE("%s: handle request from %s: %s",
                          *this, socket, cmd);
-          auto route = this->_routes.find(cmd.path());
-          if (route == this->_routes.end())
+          for (auto line = lines.next(); !line.empty(); line = lines.next())
           {
-            ELLE_TRACE("%s: not found", *this);
-            throw Exception(cmd.path(), reactor::http::StatusCode::Not_Found);
-          }
-          if (route->second.find(cmd.method()) == route->second.end())
-          {
-            ELLE_TRACE("%s: method not allowed", *this);
-            throw Exception(cmd.path(),
-                            reactor::http::StatusCode::Method_Not_Allowed);
-          }
-          while (true)
-          {
-            auto buffer = socket->read_until("\r\n");
-            if (buffer == "\r\n")
-              break;
-            buffer.size(buffer.size() - 2);
-            ELLE_TRACE("%s: get header: %s", *this, buffer.string());
-            auto const words = split(buffer, " ");
-            auto expected_length = [&] (unsigned int length) {
-              if (words.size() != length)
-                throw Exception(cmd.path(),
-                                reactor::http::StatusCode::Bad_Request,
-                                elle::sprintf("%s: ill-formed", words));
-              };
-            if (words[0] == "Expect:")
+            ELLE_TRACE("%s: get header: %s", *this, line);
+            auto const colon = line.find(':');
+            if (colon == boost::string_ref::npos)
+              throw Exception(cmd.path(),
+                              reactor::http::StatusCode::Bad_Request,
+                              elle::sprintf("%s: ill-formed", line));
+            auto const name = trim(line.substr(0, colon));
+            auto const value = trim(line.substr(colon + 1));
+            if (is(name, "Expect"))
             {
-              expected_length(2);
-              if (words[1] == "100-continue")
+              if (is(value, "100-continue"))
                 headers["Expect"] = "1";
             }
-            else if (words[0] == "Content-Length:")
+            else if (is(name, "Content-Length"))
+              headers["Content-Length"] = value.to_string();
+            else if (is(name, "Content-Type"))
+              headers["Content-Type"] = value.to_string();
+            else if (is(name, "Transfer-Encoding"))
             {
-              expected_length(2);
-              headers["Content-Length"] = words[1];
-            }
-            else if (words[0] == "Content-Type:")
-            {
-              expected_length(2);
-              headers["Content-Type"] = words[1];
+              if (is(value, "chunked"))
+                headers["chunked"] = "1";
             }
-            else if (words[0] == "Transfer-Encoding:")
+            else if (is(name, "Set-Cookie") || is(name, "Cookie"))
+              for (auto const& cookie: split(value.to_string(), ";"))
+              {
+                auto const equal = cookie.find('=');
+                if (equal == std::string::npos)
+                  throw Exception(cmd.path(),
+                                  reactor::http::StatusCode::Bad_Request,
+                                  elle::sprintf("%s: ill-formed", line));
+                cookies[boost::algorithm::trim_copy(cookie.substr(0, equal))]
+                  = cookie.substr(equal + 1);
+              }
+            else if (is(name, "Connection"))
+              headers["Connection"] = value.to_string();
+          }
+          auto const chunked = headers.find("chunked") != headers.end();
+          auto const length = [&]
+          {
+            auto const it = headers.find("Content-Length");
+            if (it == headers.end())
+              return 0u;
+            try
             {
-              expected_length(2);
-              if (words[1] == "chunked")
-                headers["chunked"] = "1";
+              return boost::lexical_cast<unsigned int>(it->second);
             }
-            else if (words[0] == "Set-Cookie:" || words[0] == "Cookie:")
+            catch (boost::bad_lexical_cast const&)
             {
-              auto const chunks = split(words[1], "=");
-              if (chunks.size() != 2)
-                throw Exception(cmd.path(),
-                                reactor::http::StatusCode::Bad_Request,
-                                elle::sprintf("%s: ill-formed", words));
-              cookies[chunks[0]] = chunks[1];
+              throw Exception(cmd.path(),
+                              reactor::http::StatusCode::Bad_Request,
+                              "invalid Content-Length");
             }
-            else if (words[0] == "Connection:")
+          }();
+          auto const too_large = [&]
+          {
+            ELLE_TRACE("%s: body exceeds %s bytes",
+                       *this, this->_max_body_size);
+            return Exception(cmd.path(),
+                             reactor::http::StatusCode::Request_Entity_Too_Large,
+                             "request entity too large");
+          };
+          if (length > this->_max_body_size)
+            throw too_large();
+          auto const requested = [&]
+          {
+            auto const connection = headers.find("Connection");
+            if (connection != headers.end())
             {
-              expected_length(2);
-              headers["Connection"] = words[1];
+              if (is(connection->second, "close"))
+                return Persistence::close;
+              if (is(connection->second, "keep-alive"))
+                return Persistence::requested;
             }
+            return cmd.version() == http::Version::v10
+              ? Persistence::close : Persistence::requested;
+          }();
+          // The next request follows the body: if the request is rejected
+          // before it is read, the connection cannot be reused.
+          if (!chunked && length == 0)
+            persistence = requested;
+          auto params = cmd.params();
+          auto const route = this->_routes.find(cmd.path(), params);
+          if (!route)
+          {
+            ELLE_TRACE("%s: not found", *this);
+            throw Exception(cmd.path(), reactor::http::StatusCode::Not_Found);
+          }
+          auto const handler = route->find(cmd.method());
+          if (handler == route->end())
+          {
+            ELLE_TRACE("%s: method not allowed", *this);
+            throw Exception(cmd.path(),
+                            reactor::http::StatusCode::Method_Not_Allowed);
           }
-
           ELLE_TRACE("%s: cookies: %s", *this, cookies);
-          ELLE_TRACE("%s: parameters: %s", *this, cmd.params());
+          ELLE_TRACE("%s: parameters: %s", *this, params);
           elle::Buffer content;
           if (cmd.version() == http::Version::v11 &&
               headers.find("Expect") != headers.end())
@@ -267,28 +566,73 @@ namespace elle
               std::string answer(
                 "HTTP/1.1 100 Continue\r\n"
                 "\r\n");
-              socket->write(elle::ConstWeakBuffer(answer));
+              socket.write(elle::ConstWeakBuffer(answer));
             }
           }
-          if (headers.find("chunked") != headers.end())
+          if (chunked)
             ELLE_TRACE("%s: read chunked content", *this)
+            {
+              // Chunk size lines and trailers are bounded like the head.
+              auto line_limit = this->_max_header_size;
+              auto const read_line = [&]
+                {
+                  // A zero limit would not bound the read.
+                  if (line_limit == 0)
+                    throw Exception(
+                      cmd.path(),
+                      reactor::http::StatusCode::Request_Header_Fields_Too_Large,
+                      "chunk trailers too large");
+                  auto line =
+                    socket.read_until("\r\n", DurationOpt(), line_limit);
+                  if (line.size() < 2 ||
+                      !(line.range(line.size() - 2) == "\r\n"))
+                    throw Exception(
+                      cmd.path(),
+                      reactor::http::StatusCode::Request_Header_Fields_Too_Large,
+                      "chunk line too large");
+                  return line;
+                };
               while (true)
               {
-                socket->read_until("\r\n"); // Ignore the chunked header.
-                auto buffer = socket->read_until("\r\n");
-                if (buffer == "\r\n")
+                auto size = std::size_t(0);
+                try
+                {
+                  // Chunk extensions, if any, are ignored.
+                  size = std::stoul(read_line().string(), nullptr, 16);
+                }
+                catch (std::logic_error const&)
+                {
+                  throw Exception(cmd.path(),
+                                  reactor::http::StatusCode::Bad_Request,
+                                  "invalid chunk size");
+                }
+                if (size == 0)
+                {
+                  // Skip the trailers, bounded together.
+                  while (true)
+                  {
+                    auto const trailer = read_line();
+                    if (trailer == "\r\n")
+                      break;
+                    line_limit -= std::min(line_limit, trailer.size());
+                  }
                   break;
-                ELLE_DEBUG("%s: got content chunk from %s: %s",
-                           *this, socket, buffer.string());
-                content.append(buffer.contents(), buffer.size() - 2);
+                }
+                if (size > this->_max_body_size - content.size())
+                  throw too_large();
+                ELLE_DEBUG("%s: got content chunk of %s bytes from %s",
+                           *this, size, socket);
+                auto const offset = content.size();
+                content.size(offset + size);
+                socket.read(
+                  elle::WeakBuffer(content.mutable_contents() + offset, size));
+                socket.read(2);
               }
-          else
-          {
-            auto content_length =
-              boost::lexical_cast<unsigned int>(headers.at("Content-Length"));
+            }
+          else if (length)
             ELLE_TRACE("%s: read sized content", *this)
-              content = this->read_sized_content(*socket, content_length);
-          }
+              content = this->read_sized_content(socket, length);
+          persistence = requested;
           ELLE_DUMP("%s: content: %s", *this, content);
           // Check JSON is valid. When getting meta_data on S3, we send a JSON
           // mimetype but an empty body, skip this case (and fix it later
@@ -308,27 +652,119 @@ namespace elle
 
             }
           }
-          this->_response(
-            *socket,
-            http::StatusCode::OK,
-            route->second.at(cmd.method())
-              (headers, cookies, cmd.params(), content),
-            cookies);
+          if (handler->second.stream)
+            this->_stream(socket, cmd.version(), handler->second.stream,
+                          headers, cookies, params, content);
+          else
+            this->_response(
+              socket,
+              http::StatusCode::OK,
+              handler->second.function(headers, cookies, params, content),
+              cookies);
+        }
+        catch (reactor::Terminate const&)
+        {
+          throw;
         }
         catch (Exception const& e)
         {
           ELLE_WARN("%s: http exception: %s", *this, e.what());
-          this->_response(*socket, e.code(),
+          this->_response(socket, e.code(),
                           this->is_json(headers) ? e.body() : e.what(), cookies);
         }
         catch (elle::Exception const& e)
         {
           ELLE_WARN("%s: internal error: %s", *this, e.what());
-          this->_response(*socket,
+          this->_response(socket,
                           reactor::http::StatusCode::Internal_Server_Error,
                           e.what(), cookies);
         }
-        ELLE_TRACE("%s: close connection with %s", *this, socket);
+        return persistence == Persistence::confirmed;
+      }
+
+      void
+      HttpServer::_stream(reactor::network::Socket& socket,
+                          http::Version version,
+                          StreamFunction const& function,
+                          Headers const& headers,
+                          Cookies const& cookies,
+                          Parameters const& params,
+                          elle::Buffer const& content)
+      {
+        if (version == http::Version::v10)
+        {
+          // No chunked transfer encoding before HTTP/1.1.
+          auto response = elle::Buffer{};
+          function(headers, cookies, params, content,
+                   [&] (elle::ConstWeakBuffer data)
+                   {
+                     response.append(data.contents(), data.size());
+                   });
+          this->_response(socket, http::StatusCode::OK, response, cookies);
+          return;
+        }
+        auto& persistence = this->_persistence.at(&socket);
+        auto const keep_alive = persistence == Persistence::requested;
+        auto started = false;
+        // Send a chunk, preceded by the response head the first time.
+        auto const send = [&] (elle::ConstWeakBuffer data, bool last)
+        {
+          auto frame = elle::Buffer{};
+          if (!started)
+          {
+            auto fields = this->_headers;
+            fields.erase("Content-Length");
+            fields["Transfer-Encoding"] = "chunked";
+            fields["Connection"] = keep_alive ? "keep-alive" : "close";
+            auto answer = elle::sprintf(
+              "HTTP/1.1 %s %s\r\n"
+              "Server: Custom HTTP of doom\r\n",
+              (int) http::StatusCode::OK, http::StatusCode::OK);
+            for (auto const& value: fields)
+              answer += elle::sprintf("%s: %s\r\n", value.first, value.second);
+            answer += "\r\n";
+            frame.append(answer.data(), answer.size());
+            started = true;
+          }
+          if (data.size())
+          {
+            auto const size = elle::sprintf("%x\r\n", data.size());
+            frame.append(size.data(), size.size());
+            frame.append(data.contents(), data.size());
+            frame.append("\r\n", 2);
+          }
+          if (last)
+            frame.append("0\r\n\r\n", 5);
+          ELLE_DEBUG("%s: send %s bytes of chunked response to %s",
+                     *this, data.size(), socket);
+          socket.write(frame);
+        };
+        try
+        {
+          function(headers, cookies, params, content,
+                   [&] (elle::ConstWeakBuffer data)
+                   {
+                     // An empty chunk would end the response.
+                     if (data.size())
+                       send(data, false);
+                   });
+        }
+        catch (reactor::Terminate const&)
+        {
+          throw;
+        }
+        catch (elle::Exception const& e)
+        {
+          if (!started)
+            throw;
+          ELLE_WARN("%s: error streaming response, abort it: %s",
+                    *this, e.what());
+          persistence = Persistence::close;
+          return;
+        }
+        send({}, true);
+        if (keep_alive)
+          persistence = Persistence::confirmed;
       }
 
       void
@@ -337,7 +773,16 @@ namespace elle
                                  Function const& function)
       {
         ELLE_TRACE("%s: register %s on %s", *this, route, method);
-        this->_routes[route][method] = function;
+        this->_routes.add(route, method, Handler{function, {}});
+      }
+
+      void
+      HttpServer::register_stream(std::string const& route,
+                                  http::Method method,
+                                  StreamFunction const& function)
+      {
+        ELLE_TRACE("%s: register stream %s on %s", *this, route, method);
+        this->_routes.add(route, method, Handler{{}, function});
       }
 
       bool
@@ -353,26 +798,29 @@ namespace elle
                     elle::ConstWeakBuffer content,
                     Cookies const& cookies)
       {
+        auto const persistence = this->_persistence.find(&socket);
+        auto const keep_alive = persistence != this->_persistence.end() &&
+          persistence->second == Persistence::requested;
         Headers headers = this->_headers;
+        std::string answer = elle::sprintf(
+          "HTTP/1.1 %s %s\r\n"
+          "Server: Custom HTTP of doom\r\n",
+          (int) code, code);
+        headers["Content-Length"] = std::to_string(content.size());
+        headers["Connection"] = keep_alive ? "keep-alive" : "close";
+        for (auto const& value: headers)
+          answer += elle::sprintf("%s: %s\r\n", value.first, value.second);
+        answer += "\r\n";
+        auto response = elle::Buffer(answer.data(), answer.size());
+        response.append(content.contents(), content.size());
+        ELLE_TRACE("%s: send response to %s: %s %s",
+                   *this, socket, static_cast<int>(code), code)
         {
-          std::string response;
-          response += content.string();
-          std::string answer = elle::sprintf(
-            "HTTP/1.1 %s %s\r\n"
-            "Server: Custom HTTP of doom\r\n",
-            (int) code, code);
-          headers["Content-Length"] = std::to_string(response.size());
-          headers["Connection"] = "close";
-          for (auto const& value: headers)
-            answer += elle::sprintf("%s: %s\r\n", value.first, value.second);
-          answer += "\r\n" + response;
-          ELLE_TRACE("%s: send response to %s: %s %s",
-                     *this, socket, static_cast<int>(code), code)
-          {
-            ELLE_DUMP("%s", answer);
-            socket.write(elle::ConstWeakBuffer(answer));
-          }
+          ELLE_DUMP("%s", response);
+          socket.write(response);
         }
+        if (keep_alive)
+          persistence->second = Persistence::confirmed;
       }
 
       elle::Buffer
@@ -22,6 +22,8 @@
 #include <elle/reactor/network/TCPServer.hh>
 #include <elle/reactor/network/TCPSocket.hh>
 #include <elle/reactor/Thread.hh>
+#include <elle/reactor/duration.hh>
+#include <elle/reactor/signal.hh>
 #include <elle/utility/Move.hh>
 
 namespace elle
@@ -34,6 +36,12 @@ namespace elle
       ///
       /// N.B. This is not a fully compliant HTTP Server.
       ///
+      /// Connections are kept alive between requests unless the client asks
+      /// otherwise, and pipelined requests are answered in order. Routes may
+      /// hold parameters: `:name` matches one path segment and a trailing
+      /// `*name` the rest of the path, both available to the route function
+      /// among the Parameters.
+      ///
       /// \code{.cc}
       ///
       /// HTTPServer server;
@@ -125,6 +133,20 @@ namespace elle
                                                     Cookies const&,
                                                     Parameters const&,
                                                     elle::Buffer const&)>;
+        /// Send part of a streamed response body.
+        using Writer = std::function<void (elle::ConstWeakBuffer)>;
+        /// A route function streaming its response through the Writer.
+        using StreamFunction = std::function<void (Headers const&,
+                                                   Cookies const&,
+                                                   Parameters const&,
+                                                   elle::Buffer const&,
+                                                   Writer const&)>;
+        /// What to call for a route: either a Function or a StreamFunction.
+        struct Handler
+        {
+          Function function;
+          StreamFunction stream;
+        };
         // Matching a Method to a specific function.
         // e.g.: {GET -> get_function, POST -> post_function, ...}
         struct enum_hash
@@ -139,10 +161,34 @@ namespace elle
         };
         // XXX: Find better names.
         using MethodFunctions =
-          std::unordered_map<reactor::http::Method, Function, enum_hash>;
-        // Matching a route a MethodFunctions.
-        // e.g.: {"/foo" -> {GET -> get_function, POST -> post_function, ...}}
-        using Routes = std::unordered_map<std::string, MethodFunctions>;
+          std::unordered_map<reactor::http::Method, Handler, enum_hash>;
+        /// Radix tree matching routes to MethodFunctions.
+        ///
+        /// Static parts of the routes share their common prefixes, so a
+        /// lookup costs the length of the path rather than the number of
+        /// routes. Static edges are preferred over parameters, parameters
+        /// over catch-alls.
+        class Routes
+        {
+        public:
+          Routes();
+          ~Routes();
+          /// Register handler for method on route.
+          void
+          add(std::string const& route,
+              http::Method method,
+              Handler handler);
+          /// The functions of the route matching path.
+          ///
+          /// \param path The requested path.
+          /// \param params Filled with the route parameters on success.
+          /// \returns The MethodFunctions of the route, null if none matches.
+          MethodFunctions const*
+          find(std::string const& path, Parameters& params) const;
+        private:
+          struct Node;
+          ELLE_ATTRIBUTE(std::unique_ptr<Node>, root);
+        };
         ELLE_ATTRIBUTE_X(Routes, routes);
         ELLE_ATTRIBUTE(std::unique_ptr<reactor::network::Server>, server);
         ELLE_ATTRIBUTE_R(int, port);
@@ -153,13 +199,27 @@ namespace elle
                           check_method);
         ELLE_ATTRIBUTE_RW(std::function<void (bool)>, check_expect_continue);
         ELLE_ATTRIBUTE_RW(std::function<void (bool)>, check_chunked);
+        /// The maximum number of connections served at once, further clients
+        /// wait in the listen backlog.
+        ELLE_ATTRIBUTE_RW(int, max_connections);
+        /// How long an idle kept-alive connection waits for a new request.
+        ELLE_ATTRIBUTE_RW(Duration, keep_alive_timeout);
+        /// The maximum size of a request line and headers. Larger ones are
+        /// answered with 431 Request Header Fields Too Large.
+        ELLE_ATTRIBUTE_RW(std::size_t, max_header_size);
+        /// The maximum size of a request body. Larger ones are answered with
+        /// 413 Request Entity Too Large.
+        ELLE_ATTRIBUTE_RW(std::size_t, max_body_size);
+        /// The number of connections being served.
+        ELLE_ATTRIBUTE_R(int, connections);
+        ELLE_ATTRIBUTE(reactor::Signal, connection_closed);
 
       private:
         /// Extract method, path and version for the HTTP headers.
         struct CommandLine
           : public elle::Printable
         {
-          CommandLine(elle::Buffer const& buffer);
+          CommandLine(std::string const& line);
           /// Path requested.
           ELLE_ATTRIBUTE_R(std::string, path);
           /// Method used.
@@ -182,6 +242,32 @@ namespace elle
         virtual
         void
         _serve(std::unique_ptr<reactor::network::Socket> socket);
+        /// Answer the request whose head was read.
+        ///
+        /// \returns Whether the connection can carry another request.
+        bool
+        _handle(reactor::network::Socket& socket, elle::Buffer const& head);
+        void
+        _stream(reactor::network::Socket& socket,
+                http::Version version,
+                StreamFunction const& function,
+                Headers const& headers,
+                Cookies const& cookies,
+                Parameters const& params,
+                elle::Buffer const& content);
+        /// Whether a connection is to be kept alive after the response.
+        enum class Persistence
+        {
+          /// Close the connection after the response.
+          close,
+          /// The client asked to keep the connection alive.
+          requested,
+          /// The response announced the connection is kept alive.
+          confirmed,
+        };
+        ELLE_ATTRIBUTE(
+          (std::unordered_map<reactor::network::Socket const*, Persistence>),
+          persistence);
       public:
         /// Register a function to a pair (route / method).
         ///
@@ -193,6 +279,19 @@ namespace elle
         register_route(std::string const& route,
                        http::Method method,
                        Function const& function);
+        /// Register a function streaming its response to a pair
+        /// (route / method).
+        ///
+        /// The response is sent with chunked transfer encoding as the
+        /// function writes it, or buffered for HTTP/1.0 clients.
+        ///
+        /// \param route The route.
+        /// \param method The Method.
+        /// \param function The StreamFunction to call.
+        void
+        register_stream(std::string const& route,
+                        http::Method method,
+                        StreamFunction const& function);
         /// Check if content-type is application/json.
         ///
         /// \param headers The headers of the Request.
@@ -200,6 +299,10 @@ namespace elle
         bool
         is_json(Headers const& headers) const;
       protected:
+        /// Send a response.
+        ///
+        /// The connection is kept alive only if the response says so, which
+        /// overrides that write their own responses do not.
         virtual
         void
         _response(reactor::network::Socket& socket,
@@ -231,6 +231,111 @@ namespace elle
         auto hp = host_port(repr);
         return resolve<boost::asio::ip::udp>(std::get<0>(hp), std::get<1>(hp), opt);
       }
+
+      /*----------------.
+      | ResolutionCache |
+      `----------------*/
+
+      ResolutionCache::ResolutionCache(Duration ttl, Duration stale)
+        : _ttl(ttl)
+        , _stale(stale)
+        , _entries()
+      {}
+
+      ResolutionCache::~ResolutionCache()
+      {
+        this->clear();
+      }
+
+      ResolutionCache::EndPoints
+      ResolutionCache::resolve_tcp(std::string const& hostname,
+                                   std::string const& service,
+                                   ResolveOptions opt)
+      {
+        auto const key = elle::sprintf(
+          "%s:%s%s", hostname, service, opt.ipv4_only ? " (IPv4)" : "");
+        auto const now = Clock::now();
+        {
+          auto it = this->_entries.find(key);
+          if (it != this->_entries.end() && !it->second.end_points.empty())
+          {
+            auto& entry = it->second;
+            if (now < entry.expiration)
+            {
+              ELLE_DUMP("%s: cache hit", key);
+              return entry.end_points;
+            }
+            if (now < entry.expiration + this->_stale)
+            {
+              ELLE_DEBUG("%s: refresh stale cache entry", key);
+              this->_resolve(key, hostname, service, opt);
+              return entry.end_points;
+            }
+          }
+        }
+        ELLE_TRACE_SCOPE("%s: cache miss", key);
+        auto& resolution = *this->_resolve(key, hostname, service, opt).resolution;
+        reactor::wait(resolution);
+        auto it = this->_entries.find(key);
+        if (it == this->_entries.end())
+          throw ResolutionError(hostname, "resolution canceled");
+        if (it->second.error)
+          std::rethrow_exception(it->second.error);
+        return it->second.end_points;
+      }
+
+      ResolutionCache::Entry&
+      ResolutionCache::_resolve(std::string const& key,
+                                std::string const& hostname,
+                                std::string const& service,
+                                ResolveOptions opt)
+      {
+        auto& entry = this->_entries[key];
+        if (entry.resolution && !entry.resolution->done())
+          return entry;
+        entry.error = nullptr;
+        entry.resolution.reset(new Thread(
+          elle::sprintf("resolve %s", key),
+          [this, key, hostname, service, opt]
+          {
+            auto res = EndPoints{};
+            auto error = std::exception_ptr{};
+            try
+            {
+              res = resolve<boost::asio::ip::tcp>(hostname, service, opt);
+            }
+            catch (Error const&)
+            {
+              error = std::current_exception();
+            }
+            auto it = this->_entries.find(key);
+            if (it == this->_entries.end())
+              return;
+            auto& entry = it->second;
+            if (error)
+            {
+              // Keep serving stale results rather than failing.
+              if (entry.end_points.empty())
+                entry.error = error;
+              else
+                ELLE_WARN("unable to refresh resolution of %s: %s",
+                          key, elle::exception_string(error));
+            }
+            else
+            {
+              entry.end_points = std::move(res);
+              entry.expiration = Clock::now() + this->_ttl;
+              entry.error = nullptr;
+            }
+          }));
+        return entry;
+      }
+
+      void
+      ResolutionCache::clear()
+      {
+        this->_entries.clear();
+      }
     }
   }
 }
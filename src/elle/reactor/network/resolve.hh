@@ -1,8 +1,11 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
 #include <elle/reactor/asio.hh>
+#include <elle/reactor/duration.hh>
+#include <elle/reactor/Thread.hh>
 
 namespace elle
 {
@@ -80,6 +83,49 @@ namespace elle
       std::vector<boost::asio::ip::udp::endpoint>
       resolve_udp_repr(std::string const& repr,
                        ResolveOptions = {});
+
+      /// A cache of TCP resolutions.
+      ///
+      /// The system resolver does not expose record TTLs: entries expire
+      /// after a fixed ttl. Expired entries are still served for up to stale
+      /// while being refreshed in the background, so lookups of known hosts do
+      /// not wait for the DNS. Concurrent lookups of the same host share a
+      /// single resolution.
+      class ResolutionCache
+      {
+      public:
+        using EndPoints = std::vector<boost::asio::ip::tcp::endpoint>;
+        ResolutionCache(Duration ttl = std::chrono::minutes(1),
+                        Duration stale = std::chrono::minutes(10));
+        ~ResolutionCache();
+        /// @see resolve_tcp.
+        EndPoints
+        resolve_tcp(std::string const& hostname,
+                    std::string const& service,
+                    ResolveOptions opt = {});
+        /// Forget all resolutions.
+        void
+        clear();
+        ELLE_ATTRIBUTE_RW(Duration, ttl);
+        ELLE_ATTRIBUTE_RW(Duration, stale);
+
+      private:
+        struct Entry
+        {
+          EndPoints end_points;
+          Time expiration;
+          /// Error of the last resolution, when nothing was cached.
+          std::exception_ptr error;
+          Thread::unique_ptr resolution;
+        };
+        /// Start resolving @a key, unless already in progress.
+        Entry&
+        _resolve(std::string const& key,
+                 std::string const& hostname,
+                 std::string const& service,
+                 ResolveOptions opt);
+        ELLE_ATTRIBUTE((std::unordered_map<std::string, Entry>), entries);
+      };
     }
   }
 }
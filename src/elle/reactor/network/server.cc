@@ -38,8 +38,7 @@ namespace elle
       {
         try
         {
-          this->_acceptor.reset(
-            new Acceptor(this->_scheduler.io_service(), end_point));
+          this->_acceptor = this->_make_acceptor(end_point);
         }
         catch (boost::system::system_error& e)
         {
@@ -52,6 +51,15 @@ namespace elle
         }
       }
 
+      template <typename Socket, typename EndPoint, typename Acceptor>
+      std::unique_ptr<Acceptor>
+      ProtoServer<Socket, EndPoint, Acceptor>::_make_acceptor(
+        EndPoint const& end_point)
+      {
+        return std::make_unique<Acceptor>(
+          this->_scheduler.io_service(), end_point);
+      }
+
       template <typename Socket, typename EndPoint, typename Acceptor>
       void
       ProtoServer<Socket, EndPoint, Acceptor>::listen()
@@ -131,11 +139,18 @@ namespace elle
       ProtoServer<Socket, EndPoint, Acceptor>::_accept(
         AsioSocket& socket, EndPoint& peer)
       {
-        ELLE_TRACE_SCOPE("%s: wait for connection", *this);
         // FIXME: server should listen in ctor to avoid this crappy state ?
         ELLE_ASSERT(this->acceptor());
-        Accept<Socket, EndPoint, Acceptor> accept(
-          socket, peer, *this->_acceptor);
+        this->_accept(*this->_acceptor, socket, peer);
+      }
+
+      template <typename Socket, typename EndPoint, typename Acceptor>
+      void
+      ProtoServer<Socket, EndPoint, Acceptor>::_accept(
+        Acceptor& acceptor, AsioSocket& socket, EndPoint& peer)
+      {
+        ELLE_TRACE_SCOPE("%s: wait for connection", *this);
+        Accept<Socket, EndPoint, Acceptor> accept(socket, peer, acceptor);
         accept.run();
       }
 
@@ -89,8 +89,21 @@ namespace elle
         EndPoint
         local_endpoint() const;
       protected:
+        /// Wait for a connection on our acceptor.
         void
         _accept(AsioSocket& socket, EndPoint& peer);
+        /// Wait for a connection on the given acceptor.
+        void
+        _accept(Acceptor& acceptor, AsioSocket& socket, EndPoint& peer);
+        /// Create an acceptor listening on the given endpoint.
+        ///
+        /// Servers needing specific socket options may override this to set
+        /// them up between opening, binding and listening.
+        ///
+        /// \param endpoint Endpoint to listen to.
+        virtual
+        std::unique_ptr<Acceptor>
+        _make_acceptor(EndPoint const& endpoint);
         virtual
         EndPoint
         _default_endpoint() const = 0;
@@ -1,3 +1,10 @@
+#ifndef ELLE_WINDOWS
+# include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+
 #include <boost/asio/ssl.hpp>
 #include <boost/lexical_cast.hpp>
 
@@ -87,6 +94,19 @@ namespace elle
             return static_cast<unsigned char>(this->read_buffer[0]);
           }
 
+          std::streamsize
+          xsputn(char const* data, std::streamsize size) override
+          {
+            // Hand large writes directly to the socket instead of copying them
+            // through write_buffer in buffer_size pieces.
+            if (size < std::streamsize(Socket::buffer_size) || this->_pacified)
+              return std::streambuf::xsputn(data, size);
+            ELLE_TRACE_SCOPE("%s: write %s bytes through", *this, size);
+            this->sync();
+            this->_socket->write(elle::ConstWeakBuffer(data, size));
+            return size;
+          }
+
           char write_buffer[Socket::buffer_size];
           int
           overflow(int c) override
@@ -151,6 +171,91 @@ namespace elle
         static_cast<StreamBuffer*>(this->rdbuf())->pacified(true);
       }
 
+      /*------.
+      | Write |
+      `------*/
+
+      void
+      Socket::cork()
+      {}
+
+      void
+      Socket::uncork()
+      {}
+
+#ifndef ELLE_WINDOWS
+      /*------.
+      | Files |
+      `------*/
+
+      std::size_t
+      Socket::send_file(int fd, int64_t offset, std::size_t length)
+      {
+        ELLE_TRACE_SCOPE("%s: send %s bytes of file %s at offset %s",
+                         *this, length, fd, offset);
+        this->flush();
+        auto buffer = elle::Buffer(std::min(length, Socket::buffer_size));
+        auto sent = std::size_t(0);
+        while (sent < length)
+        {
+          auto const n = ::pread(fd, buffer.mutable_contents(),
+                                 std::min(length - sent, buffer.size()),
+                                 offset + sent);
+          if (n < 0)
+          {
+            if (errno == EINTR)
+              continue;
+            throw Error(elle::sprintf("unable to read file %s: %s",
+                                      fd, std::strerror(errno)));
+          }
+          if (n == 0)
+            break;
+          this->write(elle::ConstWeakBuffer(buffer.contents(), n));
+          sent += n;
+        }
+        return sent;
+      }
+
+      void
+      Socket::receive_to_file(int fd, int64_t offset, std::size_t length,
+                              DurationOpt timeout)
+      {
+        ELLE_TRACE_SCOPE("%s: receive %s bytes to file %s at offset %s",
+                         *this, length, fd, offset);
+        auto buffer = elle::Buffer(std::min(length, Socket::buffer_size));
+        auto received = std::size_t(0);
+        while (received < length)
+        {
+          auto const size = Size(std::min(length - received, buffer.size()));
+          auto const n = [&]
+          {
+            // Bytes already buffered by the IOStream go first.
+            if (this->rdbuf()->in_avail() > 0)
+              return Size(this->rdbuf()->sgetn(
+                reinterpret_cast<char*>(buffer.mutable_contents()),
+                std::min<std::streamsize>(size, this->rdbuf()->in_avail())));
+            else
+              return this->read_some(
+                elle::WeakBuffer(buffer.mutable_contents(), size), timeout);
+          }();
+          for (auto written = Size(0); written < n;)
+          {
+            auto const w = ::pwrite(fd, buffer.contents() + written,
+                                    n - written, offset + received + written);
+            if (w < 0)
+            {
+              if (errno == EINTR)
+                continue;
+              throw Error(elle::sprintf("unable to write file %s: %s",
+                                        fd, std::strerror(errno)));
+            }
+            written += w;
+          }
+          received += n;
+        }
+      }
+#endif
+
       /*-----.
       | Read |
       `-----*/
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <exception>
+#include <list>
+#include <vector>
+
 #include <elle/Buffer.hh>
 #include <elle/IOStream.hh>
 #include <elle/attribute.hh>
@@ -86,6 +90,16 @@ namespace elle
         virtual
         void
         write(elle::ConstWeakBuffer buffer) = 0;
+        /// Hold writes until the matching uncork, to send them at once.
+        ///
+        /// Calls nest. This is a hint: sockets may ignore it.
+        virtual
+        void
+        cork();
+        /// Release a cork, sending held writes once the last one is released.
+        virtual
+        void
+        uncork();
 
       /*-----.
       | Read |
@@ -136,11 +150,51 @@ namespace elle
         /// @param delimiter The delimiter.
         /// @param timeout The maximum duration before reading times out because
         ///                the delimiter wasn't found.
+        /// @param limit If not zero, the maximum number of bytes to read: if
+        ///              the delimiter doesn't end them, that many bytes are
+        ///              returned without it.
         /// @returns An elle::Buffer containing the data.
         virtual
         elle::Buffer
         read_until(std::string const& delimiter,
-                   DurationOpt opt = {}) = 0;
+                   DurationOpt opt = {},
+                   std::size_t limit = 0) = 0;
+
+#ifndef ELLE_WINDOWS
+      /*-------.
+      | Files |
+      `-------*/
+      public:
+        /// Send part of a file.
+        ///
+        /// Pending writes are sent first. The default implementation reads
+        /// the file through a buffer and writes it; sockets that can send it
+        /// without copying it through user space override it.
+        ///
+        /// @param fd The file descriptor to read from.
+        /// @param offset The offset to start reading at.
+        /// @param length The number of bytes to send.
+        /// @returns The number of bytes sent, less than length only if the end
+        ///          of the file was reached.
+        virtual
+        std::size_t
+        send_file(int fd, int64_t offset, std::size_t length);
+        /// Receive data into part of a file.
+        ///
+        /// The default implementation reads through a buffer and writes it to
+        /// the file; sockets that can transfer it without copying it through
+        /// user space override it.
+        ///
+        /// @param fd The file descriptor to write to.
+        /// @param offset The offset to start writing at.
+        /// @param length The number of bytes to receive.
+        /// @param timeout The maximum duration before reading times out because
+        ///                no data is available.
+        virtual
+        void
+        receive_to_file(int fd, int64_t offset, std::size_t length,
+                        DurationOpt timeout = {});
+#endif
 
      /*----------------.
      | Pretty printing |
@@ -315,7 +369,8 @@ namespace elle
         /// @see Socket::read_until.
         elle::Buffer
         read_until(std::string const& delimiter,
-                   DurationOpt opt = {}) override;
+                   DurationOpt opt = {},
+                   std::size_t limit = 0) override;
 
       private:
         /// Read data from the Socket.
@@ -342,14 +397,117 @@ namespace elle
         /// @Socket::write.
         void
         write(elle::ConstWeakBuffer buffer) override;
+        /// Whether outgoing data is transformed by the kernel, e.g. with
+        /// kernel TLS, in which case writes bypass the upper layers of the
+        /// stream and go straight to the lowest layer socket.
+        virtual
+        bool
+        write_offloaded() const;
       protected:
         void
         _final_flush();
       private:
         void
         _async_write();
+        /// A write sent by the asynchronous writer.
+        struct AsyncWrite
+        {
+          elle::Buffer buffer;
+          /// For gathered writes, the sequence number of the last one.
+          uint64_t seq;
+        };
         ELLE_ATTRIBUTE(Mutex, write_mutex);
-        ELLE_ATTRIBUTE(std::list<elle::Buffer>, async_writes);
+        ELLE_ATTRIBUTE(std::list<AsyncWrite>, async_writes);
+
+      /*-----------.
+      | Coalescing |
+      `-----------*/
+      public:
+        /// @see Socket::cork.
+        void
+        cork() override;
+        /// @see Socket::uncork.
+        void
+        uncork() override;
+        /// Writes smaller than this many bytes issued while another write is
+        /// in progress are copied and sent along with the next write, in a
+        /// single vectored write, instead of waiting for their turn. Zero, the
+        /// default, disables coalescing.
+        Size
+        coalesce_threshold() const;
+        void
+        coalesce_threshold(Size threshold);
+        /// If set, small writes are held for up to this delay while less than
+        /// coalesce_threshold bytes are pending instead of being sent right
+        /// away. Failures of such delayed writes are raised by the next write.
+        DurationOpt const&
+        coalesce_delay() const;
+        void
+        coalesce_delay(DurationOpt delay);
+        /// The number of vectored writes that sent gathered writes.
+        uint64_t
+        coalesce_batches() const;
+      private:
+        void
+        _coalesced_write(elle::ConstWeakBuffer buffer);
+        /// Send pending writes, at least up to the given sequence number.
+        ///
+        /// @pre _write_mutex is held.
+        void
+        _flush_pending(uint64_t until);
+        /// Hand pending copies to the asynchronous writer, if no writer holds
+        /// or waits for the lock.
+        void
+        _flush_pending_async();
+        /// A write gathered for the next vectored write.
+        struct Pending
+        {
+          /// Copy of consecutive small writes.
+          elle::Buffer copy;
+          /// Data of a larger write whose issuer waits for completion.
+          elle::ConstWeakBuffer data;
+          /// The sequence number of the last write gathered here.
+          uint64_t seq = 0;
+        };
+        struct Coalescing
+        {
+          Size threshold = 0;
+          DurationOpt delay;
+          int corked = 0;
+          std::vector<Pending> pending;
+          Size pending_size = 0;
+          /// Sequence numbers of the last gathered, sent and failed writes.
+          uint64_t gathered = 0;
+          uint64_t sent = 0;
+          uint64_t failed = 0;
+          std::exception_ptr error;
+          /// Failure of delayed writes, raised by the next write.
+          std::exception_ptr async_error;
+          uint64_t batches = 0;
+          /// Flushes writes held by coalesce_delay.
+          std::shared_ptr<AsioTimer> timer;
+          bool armed = false;
+        };
+        ELLE_ATTRIBUTE(Coalescing, coalescing);
+
+#ifndef ELLE_WINDOWS
+      /*-------.
+      | Files |
+      `-------*/
+      public:
+        /// @see Socket::send_file.
+        ///
+        /// On Linux, plain sockets and sockets whose writes are offloaded use
+        /// sendfile(2).
+        std::size_t
+        send_file(int fd, int64_t offset, std::size_t length) override;
+        /// @see Socket::receive_to_file.
+        ///
+        /// On Linux, plain sockets use splice(2).
+        void
+        receive_to_file(int fd, int64_t offset, std::size_t length,
+                        DurationOpt timeout = {}) override;
+#endif
 
       /*-----------------.
       | Concrete sockets |
@@ -1,6 +1,22 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#ifdef ELLE_LINUX
+# include <fcntl.h>
+# include <sys/sendfile.h>
+# include <unistd.h>
+#endif
+
 #include <elle/Lazy.hh>
+#include <elle/finally.hh>
 #include <elle/format/hexadecimal.hh>
+#include <elle/reactor/network/Error.hh>
 #include <elle/reactor/network/SocketOperation.hxx>
+#include <elle/reactor/scheduler.hh>
 
 namespace elle
 {
@@ -245,6 +261,12 @@ namespace elle
           try
           {
             this->flush();
+            if (!this->_coalescing.pending.empty())
+            {
+              this->_coalescing.corked = 0;
+              Lock lock(this->_write_mutex);
+              this->_flush_pending(this->_coalescing.gathered);
+            }
           }
           catch (...)
           {
@@ -411,6 +433,36 @@ namespace elle
         return read.read();
       }
 
+      namespace details
+      {
+        /// Match the delimiter within the first bytes of the stream, or
+        /// match these bytes if they don't contain it.
+        struct BoundedMatch
+        {
+          using iterator = boost::asio::buffers_iterator<
+            boost::asio::streambuf::const_buffers_type>;
+          using result_type = std::pair<iterator, bool>;
+
+          result_type
+          operator ()(iterator begin, iterator end) const
+          {
+            auto const size = std::size_t(end - begin);
+            auto const last = begin + std::min(size, this->limit);
+            auto const found = std::search(
+              begin, last, this->delimiter.begin(), this->delimiter.end());
+            if (found != last)
+              return {found + this->delimiter.size(), true};
+            else if (size >= this->limit)
+              return {last, true};
+            else
+              return {begin, false};
+          }
+
+          std::string delimiter;
+          std::size_t limit;
+        };
+      }
+
       template <typename PlainSocket, typename AsioSocket>
       class ReadUntil:
         public DataOperation<typename SocketSpecialization<AsioSocket>::Socket>
@@ -423,11 +475,13 @@ namespace elle
         ReadUntil(PlainSocket& plain,
                   AsioSocket& socket,
                   boost::asio::streambuf& buffer,
-                  std::string  delimiter):
+                  std::string  delimiter,
+                  std::size_t limit):
           Super(Spe::socket(socket)),
           _socket(plain),
           _streambuffer(buffer),
           _delimiter(std::move(delimiter)),
+          _limit(limit),
           _buffer()
         {}
 
@@ -435,15 +489,23 @@ namespace elle
         void
         _start() override
         {
-          boost::asio::async_read_until(
-            *this->_socket.socket(),
-            this->_streambuffer,
-            this->_delimiter,
-            [this](const boost::system::error_code& error,
-                   std::size_t read)
+          auto handler = [this](const boost::system::error_code& error,
+                                std::size_t read)
             {
               this->_wakeup(error, read);
-            });
+            };
+          if (this->_limit)
+            boost::asio::async_read_until(
+              *this->_socket.socket(),
+              this->_streambuffer,
+              details::BoundedMatch{this->_delimiter, this->_limit},
+              handler);
+          else
+            boost::asio::async_read_until(
+              *this->_socket.socket(),
+              this->_streambuffer,
+              this->_delimiter,
+              handler);
         }
 
         void
@@ -470,18 +532,21 @@ namespace elle
         ELLE_ATTRIBUTE(PlainSocket&, socket);
         ELLE_ATTRIBUTE(boost::asio::streambuf&, streambuffer);
         ELLE_ATTRIBUTE(std::string, delimiter);
+        ELLE_ATTRIBUTE(std::size_t, limit);
         ELLE_ATTRIBUTE_RX(elle::Buffer, buffer);
       };
 
       template <typename AsioSocket, typename EndPoint>
       elle::Buffer
       StreamSocket<AsioSocket, EndPoint>::read_until(std::string const& delimiter,
-                                                     DurationOpt timeout)
+                                                     DurationOpt timeout,
+                                                     std::size_t limit)
       {
         ELLE_LOG_COMPONENT("elle.reactor.network.Socket");
         ELLE_TRACE_SCOPE("%s: read until %s", *this, delimiter);
         ReadUntil<Self, AsioSocket> read(*this, *this->socket(),
-                                         this->_streambuffer, delimiter);
+                                         this->_streambuffer, delimiter,
+                                         limit);
         bool finished;
         try
         {
@@ -504,7 +569,28 @@ namespace elle
       | Write |
       `------*/
 
-      template <typename PlainSocket, typename AsioSocket>
+      namespace details
+      {
+        /// Write to the stream, or straight to its lowest layer if writes are
+        /// offloaded to the kernel.
+        template <typename AsioSocket, typename Buffers, typename Handler>
+        void
+        async_write(AsioSocket& socket, bool offloaded,
+                    Buffers const& buffers, Handler&& handler)
+        {
+          if (offloaded)
+            boost::asio::async_write(
+              SocketSpecialization<AsioSocket>::socket(socket),
+              buffers, std::forward<Handler>(handler));
+          else
+            boost::asio::async_write(
+              socket, buffers, std::forward<Handler>(handler));
+        }
+      }
+
+      template <typename PlainSocket,
+                typename AsioSocket,
+                typename Buffers = std::array<boost::asio::const_buffer, 1>>
       class Write:
         public DataOperation<typename SocketSpecialization<AsioSocket>::Socket>
       {
@@ -515,9 +601,18 @@ namespace elle
         Write(PlainSocket& plain,
               AsioSocket& socket,
               elle::ConstWeakBuffer buffer)
+          : Write(plain, socket,
+                  Buffers{{boost::asio::const_buffer(buffer.contents(),
+                                                     buffer.size())}})
+        {}
+
+        /// Write several buffers at once, using vectored I/O.
+        Write(PlainSocket& plain,
+              AsioSocket& socket,
+              Buffers buffers)
           : Super(Spe::socket(socket))
           , _socket(plain)
-          , _buffer(std::move(buffer))
+          , _buffers(std::move(buffers))
           , _written(0)
         {}
 
@@ -525,9 +620,10 @@ namespace elle
         void
         _start() override
         {
-          boost::asio::async_write(
+          details::async_write(
             *this->_socket.socket(),
-            boost::asio::buffer(this->_buffer.contents(), this->_buffer.size()),
+            this->_socket.write_offloaded(),
+            this->_buffers,
             [this](const boost::system::error_code& error,
                    std::size_t written)
             {
@@ -550,7 +646,7 @@ namespace elle
         }
 
         ELLE_ATTRIBUTE(PlainSocket const&, socket);
-        ELLE_ATTRIBUTE(elle::ConstWeakBuffer, buffer);
+        ELLE_ATTRIBUTE(Buffers, buffers);
         ELLE_ATTRIBUTE_R(Size, written);
       };
 
@@ -561,6 +657,9 @@ namespace elle
         ELLE_LOG_COMPONENT("elle.reactor.network.Socket");
         if (reactor::scheduler().current())
         {
+          if (this->_coalescing.corked || this->_coalescing.threshold)
+            this->_coalesced_write(buffer);
+          else
           {
             Lock lock(this->_write_mutex);
             ELLE_TRACE_SCOPE("%s: write %s bytes", this, buffer.size());
@@ -571,11 +670,19 @@ namespace elle
         }
         else
         {
-          this->_async_writes.emplace_back(buffer.contents(), buffer.size());
+          this->_async_writes.push_back(
+            AsyncWrite{elle::Buffer(buffer.contents(), buffer.size()), 0});
           this->_async_write();
         }
       }
 
+      template <typename AsioSocket, typename EndPoint>
+      bool
+      StreamSocket<AsioSocket, EndPoint>::write_offloaded() const
+      {
+        return false;
+      }
+
       template <typename AsioSocket, typename EndPoint>
       void
       StreamSocket<AsioSocket, EndPoint>::_async_write()
@@ -584,31 +691,491 @@ namespace elle
         if (!this->_async_writes.empty() && !this->_write_mutex.locked())
         {
           this->_write_mutex.acquire();
-          auto& buffer = this->_async_writes.front();
+          auto& buffer = this->_async_writes.front().buffer;
           ELLE_TRACE_SCOPE(
             "%s: write %s bytes asynchronously", this, buffer.size());
           auto asio_buffer =
             boost::asio::buffer(buffer.contents(), buffer.size());
-          boost::asio::async_write(
+          details::async_write(
             *this->socket(),
+            this->write_offloaded(),
             asio_buffer,
             [this]
             (const boost::system::error_code& error, std::size_t written)
             {
+              auto const seq = this->_async_writes.front().seq;
               this->_async_writes.pop_front();
               if (error == boost::system::errc::operation_canceled)
                 return;
-              else if (error)
+              auto& c = this->_coalescing;
+              if (error)
+              {
                 // FIXME: what do with other errors ?
                 ELLE_WARN("asynchronous write error on %s: %s",
                           this, error.message());
+                if (seq)
+                {
+                  // Writers of gathered copies are gone, tell the next one.
+                  c.failed = std::max(c.failed, seq);
+                  c.error = c.async_error = std::make_exception_ptr(
+                    Error(elle::sprintf("coalesced write failed: %s",
+                                        error.message())));
+                }
+              }
+              c.sent = std::max(c.sent, seq);
               ELLE_TRACE_SCOPE(
                 "%s: %s bytes written asynchronously", this, written);
               this->_write_mutex.release();
+              this->_flush_pending_async();
               this->_async_write();
             });
         }
       }
+
+      /*-----------.
+      | Coalescing |
+      `-----------*/
+
+      template <typename AsioSocket, typename EndPoint>
+      void
+      StreamSocket<AsioSocket, EndPoint>::cork()
+      {
+        ++this->_coalescing.corked;
+      }
+
+      template <typename AsioSocket, typename EndPoint>
+      void
+      StreamSocket<AsioSocket, EndPoint>::uncork()
+      {
+        auto& c = this->_coalescing;
+        ELLE_ASSERT_GT(c.corked, 0);
+        if (--c.corked == 0 && !c.pending.empty())
+        {
+          Lock lock(this->_write_mutex);
+          this->_flush_pending(c.gathered);
+        }
+        this->_async_write();
+      }
+
+      template <typename AsioSocket, typename EndPoint>
+      Size
+      StreamSocket<AsioSocket, EndPoint>::coalesce_threshold() const
+      {
+        return this->_coalescing.threshold;
+      }
+
+      template <typename AsioSocket, typename EndPoint>
+      void
+      StreamSocket<AsioSocket, EndPoint>::coalesce_threshold(Size threshold)
+      {
+        this->_coalescing.threshold = threshold;
+      }
+
+      template <typename AsioSocket, typename EndPoint>
+      DurationOpt const&
+      StreamSocket<AsioSocket, EndPoint>::coalesce_delay() const
+      {
+        return this->_coalescing.delay;
+      }
+
+      template <typename AsioSocket, typename EndPoint>
+      void
+      StreamSocket<AsioSocket, EndPoint>::coalesce_delay(DurationOpt delay)
+      {
+        this->_coalescing.delay = std::move(delay);
+      }
+
+      template <typename AsioSocket, typename EndPoint>
+      uint64_t
+      StreamSocket<AsioSocket, EndPoint>::coalesce_batches() const
+      {
+        return this->_coalescing.batches;
+      }
+
+      template <typename AsioSocket, typename EndPoint>
+      void
+      StreamSocket<AsioSocket, EndPoint>::_coalesced_write(
+        elle::ConstWeakBuffer buffer)
+      {
+        ELLE_LOG_COMPONENT("elle.reactor.network.Socket");
+        auto& c = this->_coalescing;
+        if (c.async_error)
+          std::rethrow_exception(std::exchange(c.async_error, {}));
+        if (buffer.size() == 0)
+          return;
+        auto const small = c.corked || buffer.size() < c.threshold;
+        if (small)
+        {
+          // Merge with the previous write if it was copied too.
+          if (c.pending.empty() || c.pending.back().data.contents())
+            c.pending.emplace_back();
+          c.pending.back().copy.append(buffer.contents(), buffer.size());
+        }
+        else
+          c.pending.emplace_back(Pending{{}, buffer});
+        c.pending_size += buffer.size();
+        auto const seq = c.pending.back().seq = ++c.gathered;
+        if (small)
+        {
+          if (c.corked)
+          {
+            ELLE_DEBUG("%s: hold %s bytes until uncorked", this, buffer.size());
+            return;
+          }
+          if (this->_write_mutex.locked())
+          {
+            ELLE_DEBUG("%s: gather %s bytes with the write in progress",
+                       this, buffer.size());
+            return;
+          }
+          if (c.delay && c.pending_size < c.threshold)
+          {
+            ELLE_DEBUG("%s: hold %s bytes for up to %s",
+                       this, buffer.size(), *c.delay);
+            if (!c.armed)
+            {
+              if (!c.timer)
+                c.timer = std::make_shared<AsioTimer>(
+                  reactor::scheduler().io_service());
+              c.timer->expires_from_now(*c.delay);
+              c.armed = true;
+              // The timer dies with the socket: don't touch it afterwards.
+              auto timer = std::weak_ptr<AsioTimer>(c.timer);
+              c.timer->async_wait(
+                [this, timer] (boost::system::error_code const& error)
+                {
+                  if (error || timer.expired())
+                    return;
+                  this->_coalescing.armed = false;
+                  this->_flush_pending_async();
+                  this->_async_write();
+                });
+            }
+            return;
+          }
+        }
+        Lock lock(this->_write_mutex);
+        if (c.sent < seq)
+          this->_flush_pending(seq);
+        else if (seq <= c.failed)
+          // Sent by another writer, along with others, and failed.
+          std::rethrow_exception(c.error);
+      }
+
+      template <typename AsioSocket, typename EndPoint>
+      void
+      StreamSocket<AsioSocket, EndPoint>::_flush_pending(uint64_t until)
+      {
+        ELLE_LOG_COMPONENT("elle.reactor.network.Socket");
+        auto& c = this->_coalescing;
+        // Writes may be gathered while we send, loop until exhausted. Corked
+        // writes are only sent if they precede a write we must complete.
+        while (!c.pending.empty() && (!c.corked || c.sent < until))
+        {
+          auto pending = std::move(c.pending);
+          c.pending.clear();
+          auto const seq = c.gathered;
+          ELLE_TRACE_SCOPE("%s: write %s bytes from %s writes",
+                           this, c.pending_size, seq - c.sent);
+          c.pending_size = 0;
+          ++c.batches;
+          auto buffers = std::vector<boost::asio::const_buffer>{};
+          buffers.reserve(pending.size());
+          for (auto const& p: pending)
+            if (p.data.contents())
+              buffers.emplace_back(p.data.contents(), p.data.size());
+            else
+              buffers.emplace_back(p.copy.contents(), p.copy.size());
+          try
+          {
+            Write<Self, AsioSocket, std::vector<boost::asio::const_buffer>>
+              write(*this, *this->socket(), std::move(buffers));
+            write.run();
+          }
+          catch (...)
+          {
+            // Writers whose data was part of this batch must fail too.
+            c.sent = c.failed = seq;
+            c.error = std::make_exception_ptr(
+              Error(elle::sprintf("coalesced write failed: %s",
+                                  elle::exception_string())));
+            throw;
+          }
+          c.sent = seq;
+        }
+      }
+
+      template <typename AsioSocket, typename EndPoint>
+      void
+      StreamSocket<AsioSocket, EndPoint>::_flush_pending_async()
+      {
+        auto& c = this->_coalescing;
+        // Otherwise, the writer holding the lock sends pending writes.
+        if (c.pending.empty() || c.corked || this->_write_mutex.locked())
+          return;
+        // Data is only referenced by writers waiting for the lock, which may
+        // have been released without being taken yet: they send it along
+        // with what follows. Only copies before it can go, merged in at most
+        // one buffer. They count as sent once written.
+        auto& front = c.pending.front();
+        if (front.data.contents())
+          return;
+        ++c.batches;
+        c.pending_size -= front.copy.size();
+        this->_async_writes.push_back(
+          AsyncWrite{std::move(front.copy), front.seq});
+        c.pending.erase(c.pending.begin());
+      }
+
+#ifndef ELLE_WINDOWS
+      /*------.
+      | Files |
+      `------*/
+
+#ifdef ELLE_LINUX
+      namespace details
+      {
+        /// Throw the exception matching errno after a failed system call.
+        [[noreturn]]
+        inline
+        void
+        raise_errno(char const* call)
+        {
+          auto const error = errno;
+          if (error == EPIPE || error == ECONNRESET)
+            throw ConnectionClosed();
+          else
+            throw Error(elle::sprintf("%s: %s", call, std::strerror(error)));
+        }
+
+        /// Copy @a size bytes, available in @a pipe, to @a fd at @a position.
+        inline
+        void
+        copy_pipe(int pipe, int fd, loff_t position, std::size_t size)
+        {
+          auto buffer = elle::Buffer(size);
+          for (auto read = std::size_t(0); read < size;)
+          {
+            auto const n = ::read(pipe, buffer.mutable_contents() + read,
+                                  size - read);
+            if (n < 0)
+            {
+              if (errno == EINTR)
+                continue;
+              raise_errno("read");
+            }
+            read += n;
+          }
+          for (auto written = std::size_t(0); written < size;)
+          {
+            auto const n = ::pwrite(fd, buffer.contents() + written,
+                                    size - written, position + written);
+            if (n < 0)
+            {
+              if (errno == EINTR)
+                continue;
+              raise_errno("pwrite");
+            }
+            written += n;
+          }
+        }
+      }
+
+      /// Wait until a socket is readable or writable, without transferring
+      /// any data.
+      template <typename AsioSocket>
+      class Ready
+        : public DataOperation<AsioSocket>
+      {
+      public:
+        using Super = DataOperation<AsioSocket>;
+        Ready(AsioSocket& socket, bool write)
+          : Super(socket)
+          , _write(write)
+        {}
+
+        void
+        print(std::ostream& stream) const override
+        {
+          elle::fprintf(stream, "wait for %s on %s",
+                        this->_write ? "writability" : "readability",
+                        this->socket().native_handle());
+        }
+
+      protected:
+        void
+        _start() override
+        {
+          auto wakeup = [this] (boost::system::error_code const& error,
+                                std::size_t)
+            {
+              this->_wakeup(error);
+            };
+          if (this->_write)
+            this->socket().async_write_some(boost::asio::null_buffers(),
+                                            wakeup);
+          else
+            this->socket().async_read_some(boost::asio::null_buffers(),
+                                           wakeup);
+        }
+
+      private:
+        ELLE_ATTRIBUTE(bool, write);
+      };
+#endif
+
+      template <typename AsioSocket, typename EndPoint>
+      std::size_t
+      StreamSocket<AsioSocket, EndPoint>::send_file(
+        int fd, int64_t offset, std::size_t length)
+      {
+        ELLE_LOG_COMPONENT("elle.reactor.network.Socket");
+        using Spe = SocketSpecialization<AsioSocket>;
+#ifdef ELLE_LINUX
+        // Layered streams, such as SSL, must transform data in user space
+        // unless the kernel does it for them.
+        if (std::is_same<typename Spe::Socket, AsioSocket>::value ||
+            this->write_offloaded())
+        {
+          ELLE_TRACE_SCOPE("%s: send %s bytes of file %s at offset %s",
+                           this, length, fd, offset);
+          // Previous writes go first.
+          this->flush();
+          auto const sent = [&] () -> boost::optional<std::size_t>
+          {
+            Lock lock(this->_write_mutex);
+            this->_flush_pending(this->_coalescing.gathered);
+            auto& socket = Spe::socket(*this->socket());
+            socket.native_non_blocking(true);
+            auto position = off_t(offset);
+            auto res = std::size_t(0);
+            while (res < length)
+            {
+              // Linux transfers at most 0x7ffff000 bytes per call.
+              auto const n = ::sendfile(
+                socket.native_handle(), fd, &position,
+                std::min<std::size_t>(length - res, 0x7ffff000));
+              if (n > 0)
+              {
+                res += n;
+                // The socket buffer might never fill up: let others run.
+                reactor::yield();
+              }
+              else if (n == 0)
+                break;
+              else if (errno == EAGAIN || errno == EWOULDBLOCK)
+              {
+                auto ready = Ready<typename Spe::Socket>(socket, true);
+                ready.run();
+              }
+              else if (errno == EINTR)
+                continue;
+              else if ((errno == EINVAL || errno == ENOSYS) && res == 0)
+                return boost::none;
+              else
+                details::raise_errno("sendfile");
+            }
+            return res;
+          }();
+          if (sent)
+            return *sent;
+          ELLE_TRACE("%s: sendfile is unsupported for file %s, fall back to "
+                     "buffered copy", this, fd);
+        }
+#endif
+        return Super::send_file(fd, offset, length);
+      }
+
+      template <typename AsioSocket, typename EndPoint>
+      void
+      StreamSocket<AsioSocket, EndPoint>::receive_to_file(
+        int fd, int64_t offset, std::size_t length, DurationOpt timeout)
+      {
+        ELLE_LOG_COMPONENT("elle.reactor.network.Socket");
+        using Spe = SocketSpecialization<AsioSocket>;
+#ifdef ELLE_LINUX
+        if (std::is_same<typename Spe::Socket, AsioSocket>::value)
+        {
+          ELLE_TRACE_SCOPE("%s: receive %s bytes to file %s at offset %s",
+                           this, length, fd, offset);
+          auto received = std::size_t(0);
+          // Bytes already buffered in user space go first.
+          if (this->rdbuf()->in_avail() > 0 || this->_streambuffer.size())
+          {
+            auto const buffered = std::min<std::size_t>(
+              length,
+              std::max<std::streamsize>(this->rdbuf()->in_avail(), 0) +
+              this->_streambuffer.size());
+            Super::receive_to_file(fd, offset, buffered, timeout);
+            received += buffered;
+          }
+          if (received == length)
+            return;
+          int pipe[2];
+          if (::pipe2(pipe, O_CLOEXEC | O_NONBLOCK) != 0)
+            details::raise_errno("pipe2");
+          elle::SafeFinally close_pipe([&]
+            {
+              ::close(pipe[0]);
+              ::close(pipe[1]);
+            });
+          auto& socket = Spe::socket(*this->socket());
+          socket.native_non_blocking(true);
+          auto position = loff_t(offset + received);
+          while (received < length)
+          {
+            auto n = ::splice(socket.native_handle(), nullptr, pipe[1], nullptr,
+                              std::min<std::size_t>(length - received, 1 << 16),
+                              SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n == 0)
+              throw ConnectionClosed();
+            else if (n < 0)
+            {
+              if (errno == EAGAIN || errno == EWOULDBLOCK)
+              {
+                auto ready = Ready<typename Spe::Socket>(socket, false);
+                if (!ready.run(timeout))
+                  throw TimeOut();
+              }
+              else if (errno != EINTR)
+                details::raise_errno("splice");
+              continue;
+            }
+            // Drain the pipe into the file.
+            while (n > 0)
+            {
+              auto const w = ::splice(pipe[0], nullptr, fd, &position, n,
+                                      SPLICE_F_MOVE);
+              if (w < 0)
+              {
+                if (errno == EINVAL || errno == ENOSYS)
+                {
+                  // The file does not accept splice, e.g. opened with
+                  // O_APPEND or on some filesystems. The bytes in the pipe
+                  // already left the socket: copy them, then the rest
+                  // through user space.
+                  ELLE_TRACE("%s: splice is unsupported for file %s, fall "
+                             "back to buffered copy", this, fd);
+                  details::copy_pipe(pipe[0], fd, position, n);
+                  received += n;
+                  Super::receive_to_file(
+                    fd, offset + received, length - received, timeout);
+                  return;
+                }
+                else if (errno != EINTR)
+                  details::raise_errno("splice");
+                continue;
+              }
+              n -= w;
+              received += w;
+            }
+          }
+          return;
+        }
+#endif
+        Super::receive_to_file(fd, offset, length, timeout);
+      }
+#endif
     }
   }
 }
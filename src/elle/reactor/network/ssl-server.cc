@@ -27,7 +27,11 @@ namespace elle
         , _handshake_thread(elle::sprintf("%s handshake", *this),
                             [this] { this->_handshake(); })
         , _shutdown_asynchronous(false)
-      {}
+        , _handshake_bench(std::make_shared<elle::Bench<>>(
+                             "bench.reactor.network.SSLServer.handshake"))
+      {
+        this->_certificate->server_session_cache();
+      }
 
       SSLServer::~SSLServer()
       {
@@ -84,7 +88,10 @@ namespace elle
                 ELLE_TRACE_SCOPE("%s: handshake %s", *this, *socket.value);
                 try
                 {
+                  auto const start = Clock::now();
                   socket->_server_handshake(this->_handshake_timeout);
+                  if (this->_handshake_bench->enabled())
+                    this->_handshake_bench->add(Clock::now() - start);
                   this->_sockets.put(socket);
                 }
                 catch (reactor::network::TimeOut const&)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <elle/bench.hh>
 #include <elle/reactor/Channel.hh>
 #include <elle/reactor/network/server.hh>
 #include <elle/reactor/network/ssl-socket.hh>
@@ -69,6 +70,9 @@ namespace elle
       public:
         /// Create an SSLServer with the given certificate.
         ///
+        /// Sessions are cached so clients can resume them, see
+        /// SSLCertificate::server_session_cache.
+        ///
         /// @param certificate An SSLCertificate to check socket authenticity.
         /// @param handshake_timeout The maximum duration before the handshake
         ///                          times out.
@@ -109,6 +113,8 @@ namespace elle
         ELLE_ATTRIBUTE(reactor::Channel<std::unique_ptr<SSLSocket>>, sockets);
         ELLE_ATTRIBUTE(reactor::Thread, handshake_thread);
         ELLE_ATTRIBUTE_RW(bool, shutdown_asynchronous);
+        /// Duration of successful handshakes.
+        ELLE_ATTRIBUTE(std::shared_ptr<elle::Bench<>>, handshake_bench);
       };
     }
   }
@@ -1,3 +1,38 @@
+#include <cstring>
+#include <utility>
+
+#include <openssl/opensslv.h>
+
+// TLS 1.3, and the key log and HKDF it relies on.
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+# define ELLE_REACTOR_TLS_1_3
+#endif
+
+#if defined ELLE_LINUX && defined ELLE_REACTOR_TLS_1_3
+# if __has_include(<linux/tls.h>)
+#  include <linux/tls.h>
+#  include <netinet/tcp.h>
+#  include <poll.h>
+#  include <sys/socket.h>
+#  ifndef SOL_TLS
+#   define SOL_TLS 282
+#  endif
+#  ifndef TCP_ULP
+#   define TCP_ULP 31
+#  endif
+#  ifdef TLS_1_3_VERSION
+#   define ELLE_REACTOR_KERNEL_TLS
+#  endif
+# endif
+#endif
+
+#include <openssl/evp.h>
+#ifdef ELLE_REACTOR_TLS_1_3
+# include <openssl/kdf.h>
+#endif
+#include <openssl/ssl.h>
+
+#include <elle/format/hexadecimal.hh>
 #include <elle/log.hh>
 #include <elle/reactor/network/SocketOperation.hh>
 #include <elle/reactor/network/Error.hh>
@@ -5,7 +40,6 @@
 #include <elle/reactor/network/ssl-socket.hh>
 #include <elle/reactor/scheduler.hh>
 #include <elle/utility/Move.hh>
-#include <utility>
 
 ELLE_LOG_COMPONENT("elle.reactor.network.SSLSocket");
 
@@ -15,10 +49,102 @@ namespace elle
   {
     namespace network
     {
+      namespace
+      {
+        /// Index of the SSLSocket in its SSL handle extra data.
+        int
+        socket_index()
+        {
+          static int const res =
+            SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+          return res;
+        }
+
+        SSLSocket*
+        ssl_socket(SSL const* ssl)
+        {
+          return static_cast<SSLSocket*>(SSL_get_ex_data(ssl, socket_index()));
+        }
+      }
+
+      /*----------------.
+      | SSLSessionCache |
+      `----------------*/
+
+      SSLSessionCache::SSLSessionCache(std::size_t capacity)
+        : _capacity(capacity)
+      {}
+
+      std::shared_ptr<SSLSessionCache> const&
+      SSLSessionCache::global()
+      {
+        static auto const res = std::make_shared<SSLSessionCache>();
+        return res;
+      }
+
+      SSLSessionCache::Session
+      SSLSessionCache::get(std::string const& key)
+      {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        auto it = this->_index.find(key);
+        if (it == this->_index.end())
+          return nullptr;
+        this->_entries.splice(this->_entries.begin(), this->_entries,
+                              it->second);
+        return it->second->second;
+      }
+
+      void
+      SSLSessionCache::put(std::string const& key, Session session)
+      {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        auto it = this->_index.find(key);
+        if (it != this->_index.end())
+        {
+          it->second->second = std::move(session);
+          this->_entries.splice(this->_entries.begin(), this->_entries,
+                                it->second);
+          return;
+        }
+        this->_entries.emplace_front(key, std::move(session));
+        this->_index.emplace(key, this->_entries.begin());
+        while (this->_entries.size() > this->_capacity)
+        {
+          this->_index.erase(this->_entries.back().first);
+          this->_entries.pop_back();
+        }
+      }
+
+      void
+      SSLSessionCache::erase(std::string const& key)
+      {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        auto it = this->_index.find(key);
+        if (it != this->_index.end())
+        {
+          this->_entries.erase(it->second);
+          this->_index.erase(it);
+        }
+      }
+
+      std::size_t
+      SSLSessionCache::size() const
+      {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        return this->_entries.size();
+      }
+
+      /*---------------.
+      | SSLCertificate |
+      `---------------*/
+
       SSLCertificate::SSLCertificate(SSLCertificateMethod meth)
         : _context(meth)
+        , _session_cache()
+        , _kernel_tls(false)
       {
         this->_context.set_options(boost::asio::ssl::verify_none);
+        this->session_cache(SSLSessionCache::global());
       }
 
       SSLCertificate::SSLCertificate(std::vector<char> const& certificate,
@@ -26,6 +152,8 @@ namespace elle
                                      std::vector<char> const& dh,
                                      SSLCertificateMethod meth)
         : _context(meth)
+        , _session_cache()
+        , _kernel_tls(false)
       {
         using boost::asio::const_buffer;
         this->_context.set_options(boost::asio::ssl::verify_none);
@@ -42,6 +170,8 @@ namespace elle
                                      std::string const& dhfile,
                                      SSLCertificateMethod meth)
         : _context(meth)
+        , _session_cache()
+        , _kernel_tls(false)
       {
         this->_context.set_options(boost::asio::ssl::verify_none);
         this->_context.use_certificate_file(certificate,
@@ -51,6 +181,55 @@ namespace elle
         this->_context.use_tmp_dh_file(dhfile);
       }
 
+      void
+      SSLCertificate::server_session_cache(std::size_t size,
+                                           Duration lifetime)
+      {
+        auto ctx = this->_context.native_handle();
+        SSL_CTX_set_session_cache_mode(
+          ctx, SSL_CTX_get_session_cache_mode(ctx) | SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(ctx, size);
+        SSL_CTX_set_timeout(
+          ctx,
+          std::chrono::duration_cast<std::chrono::seconds>(lifetime).count());
+        // Session ticket keys belong to the context: all connections accepted
+        // with it can resume each other's sessions.
+        static unsigned char const id[] = "elle.reactor";
+        SSL_CTX_set_session_id_context(ctx, id, sizeof(id) - 1);
+      }
+
+      void
+      SSLCertificate::session_cache(std::shared_ptr<SSLSessionCache> cache)
+      {
+        auto ctx = this->_context.native_handle();
+        auto mode = SSL_CTX_get_session_cache_mode(ctx);
+        if (cache)
+        {
+          // Sessions are stored in our cache only: the internal one is keyed
+          // by session id, not by peer.
+          SSL_CTX_set_session_cache_mode(
+            ctx, mode | SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+          SSL_CTX_sess_set_new_cb(ctx, &SSLSocket::_new_session);
+        }
+        else
+        {
+          SSL_CTX_set_session_cache_mode(ctx, mode & ~SSL_SESS_CACHE_CLIENT);
+          SSL_CTX_sess_set_new_cb(ctx, nullptr);
+        }
+        this->_session_cache = std::move(cache);
+      }
+
+      void
+      SSLCertificate::kernel_tls(bool enable)
+      {
+        auto ctx = this->_context.native_handle();
+#ifdef ELLE_REACTOR_TLS_1_3
+        SSL_CTX_set_keylog_callback(ctx, enable ? &SSLSocket::_keylog : nullptr);
+#endif
+        SSL_CTX_set_msg_callback(ctx, enable ? &SSLSocket::_message : nullptr);
+        this->_kernel_tls = enable;
+      }
+
       SSLCertificateOwner::SSLCertificateOwner(
         std::shared_ptr<SSLCertificate> certificate)
         : _certificate(std::move(certificate))
@@ -73,8 +252,10 @@ namespace elle
                   reactor::Scheduler::scheduler()->io_service(),
                   this->certificate()->context()),
                 endpoint, timeout)
+        , _ktls()
         , _shutdown_asynchronous(false)
         , _timeout(timeout)
+        , _session_cache(this->certificate()->session_cache())
       {
         this->_client_handshake();
       }
@@ -94,8 +275,10 @@ namespace elle
                   reactor::Scheduler::scheduler()->io_service(),
                   certificate.context()),
                 endpoint, timeout)
+        , _ktls()
         , _shutdown_asynchronous(false)
         , _timeout(timeout)
+        , _session_cache(certificate.session_cache())
       {
         this->_server_handshake(this->_timeout);
       }
@@ -126,6 +309,8 @@ namespace elle
           ELLE_ABORT("unexpected error in SSL shutdown: %s",
                      elle::exception_string());
         }
+        OPENSSL_cleanse(this->_ktls.secret.mutable_contents(),
+                        this->_ktls.secret.size());
       }
 
       SSLSocket::SSLSocket(std::unique_ptr<SSLStream> socket,
@@ -134,8 +319,10 @@ namespace elle
                            DurationOpt handshake_timeout)
         : SSLCertificateOwner(certificate)
         , Super(std::move(socket), endpoint)
+        , _ktls()
         , _shutdown_asynchronous(false)
         , _timeout(std::move(handshake_timeout))
+        , _session_cache()
       {}
 
       /*----------------.
@@ -148,30 +335,400 @@ namespace elle
         s << "SSLSocket(" << peer() << ")";
       }
 
+      /*---------.
+      | Sessions |
+      `---------*/
+
+      bool
+      SSLSocket::resumed() const
+      {
+        return SSL_session_reused(this->_socket->native_handle());
+      }
+
+      int
+      SSLSocket::_new_session(SSL* ssl, SSL_SESSION* session)
+      {
+        auto socket = ssl_socket(ssl);
+        if (!socket || !socket->_session_cache)
+          return 0;
+#ifdef ELLE_REACTOR_TLS_1_3
+        if (!SSL_SESSION_is_resumable(session))
+          return 0;
+#endif
+        ELLE_DEBUG("%s: cache new session", *socket);
+        // Returning 1 hands our reference over to the cache.
+        socket->_session_cache->put(
+          elle::sprintf("%s", socket->peer()),
+          SSLSessionCache::Session(session, &SSL_SESSION_free));
+        return 1;
+      }
+
+      /*------------.
+      | Kernel TLS |
+      `------------*/
+
+      bool
+      SSLSocket::write_offloaded() const
+      {
+        return this->_ktls.enabled;
+      }
+
+      void
+      SSLSocket::_keylog(SSL const* ssl, char const* line)
+      {
+        // "<label> <client random> <secret>", in hexadecimal.
+        auto socket = ssl_socket(ssl);
+        if (!socket)
+          return;
+        auto const label = SSL_is_server(ssl) ?
+          "SERVER_TRAFFIC_SECRET_0 " : "CLIENT_TRAFFIC_SECRET_0 ";
+        if (std::strncmp(line, label, std::strlen(label)) != 0)
+          return;
+        if (auto secret = std::strrchr(line, ' '))
+          socket->_ktls.secret =
+            elle::format::hexadecimal::decode(std::string(secret + 1));
+      }
+
+      void
+      SSLSocket::_message(int write, int, int content_type,
+                          void const* buffer, std::size_t size,
+                          SSL* ssl, void*)
+      {
+        auto socket = ssl_socket(ssl);
+        if (!socket || size == 0 ||
+            (content_type != SSL3_RT_HANDSHAKE &&
+             content_type != SSL3_RT_ALERT))
+          return;
+        auto const message = static_cast<unsigned char const*>(buffer);
+#ifdef ELLE_REACTOR_KERNEL_TLS
+        if (socket->_ktls.enabled)
+        {
+          if (write)
+            // OpenSSL output is discarded, the kernel sends it instead.
+            socket->_kernel_tls_record(
+              content_type, elle::ConstWeakBuffer(buffer, size));
+          else if (content_type == SSL3_RT_HANDSHAKE &&
+                   message[0] == SSL3_MT_KEY_UPDATE && size == 5 &&
+                   message[4] == SSL_KEY_UPDATE_REQUESTED)
+          {
+            // OpenSSL would only answer on its next write, which never
+            // comes: answer with a KeyUpdate that requests nothing back.
+            unsigned char const update[] =
+              {SSL3_MT_KEY_UPDATE, 0, 0, 1, SSL_KEY_UPDATE_NOT_REQUESTED};
+            socket->_kernel_tls_record(
+              SSL3_RT_HANDSHAKE, elle::ConstWeakBuffer(update, sizeof(update)));
+          }
+          return;
+        }
+#endif
+        // Once established, only post-handshake messages are sent by
+        // OpenSSL, one record each: session tickets and key updates.
+        if (!write || content_type != SSL3_RT_HANDSHAKE ||
+            socket->_ktls.secret.empty())
+          return;
+        if (message[0] == SSL3_MT_NEWSESSION_TICKET)
+          ++socket->_ktls.records;
+#ifdef ELLE_REACTOR_TLS_1_3
+        else if (message[0] == SSL3_MT_KEY_UPDATE)
+          socket->_ktls.rekeyed = true;
+#endif
+      }
+
+#ifdef ELLE_REACTOR_KERNEL_TLS
+      namespace
+      {
+        /// HKDF-Expand-Label from RFC 8446, with an empty context.
+        elle::Buffer
+        expand_label(EVP_MD const* md,
+                     elle::ConstWeakBuffer secret,
+                     std::string const& label,
+                     std::size_t size)
+        {
+          auto const full = "tls13 " + label;
+          auto info = elle::Buffer();
+          unsigned char const header[] = {
+            static_cast<unsigned char>(size >> 8),
+            static_cast<unsigned char>(size),
+            static_cast<unsigned char>(full.size()),
+          };
+          info.append(header, sizeof(header));
+          info.append(full.data(), full.size());
+          info.append("\0", 1);
+          auto ctx = std::unique_ptr<EVP_PKEY_CTX, void (*)(EVP_PKEY_CTX*)>(
+            EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr), &EVP_PKEY_CTX_free);
+          auto res = elle::Buffer(size);
+          if (!ctx ||
+              EVP_PKEY_derive_init(ctx.get()) <= 0 ||
+              EVP_PKEY_CTX_hkdf_mode(
+                ctx.get(), EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) <= 0 ||
+              EVP_PKEY_CTX_set_hkdf_md(ctx.get(), md) <= 0 ||
+              EVP_PKEY_CTX_set1_hkdf_key(
+                ctx.get(), secret.contents(), secret.size()) <= 0 ||
+              EVP_PKEY_CTX_add1_hkdf_info(
+                ctx.get(), info.contents(), info.size()) <= 0 ||
+              EVP_PKEY_derive(ctx.get(), res.mutable_contents(), &size) <= 0)
+            return {};
+          return res;
+        }
+
+        template <typename Info>
+        bool
+        kernel_tls_info(Info& info,
+                        EVP_MD const* md,
+                        elle::ConstWeakBuffer secret,
+                        uint64_t sequence)
+        {
+          auto const key = expand_label(md, secret, "key", sizeof(info.key));
+          auto const iv = expand_label(
+            md, secret, "iv", sizeof(info.salt) + sizeof(info.iv));
+          if (key.empty() || iv.empty())
+            return false;
+          std::memcpy(info.key, key.contents(), sizeof(info.key));
+          std::memcpy(info.salt, iv.contents(), sizeof(info.salt));
+          std::memcpy(info.iv, iv.contents() + sizeof(info.salt),
+                      sizeof(info.iv));
+          for (int i = sizeof(info.rec_seq) - 1; i >= 0; --i, sequence >>= 8)
+            info.rec_seq[i] = sequence & 0xff;
+          return true;
+        }
+
+        /// Send a record of the given type, encrypted by the kernel.
+        bool
+        kernel_tls_send(int fd, unsigned char type,
+                        elle::ConstWeakBuffer payload)
+        {
+          char control[CMSG_SPACE(sizeof(unsigned char))] = {};
+          auto iov = iovec{const_cast<unsigned char*>(payload.contents()),
+                           payload.size()};
+          auto message = msghdr{};
+          message.msg_iov = &iov;
+          message.msg_iovlen = 1;
+          message.msg_control = control;
+          message.msg_controllen = sizeof(control);
+          auto cmsg = CMSG_FIRSTHDR(&message);
+          cmsg->cmsg_level = SOL_TLS;
+          cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+          cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+          *CMSG_DATA(cmsg) = type;
+          while (true)
+          {
+            auto const sent =
+              ::sendmsg(fd, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (sent >= 0)
+              return std::size_t(sent) == payload.size();
+            if (errno == EINTR)
+              continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+              return false;
+            // Control records are a few bytes: wait for room rather than
+            // queue them behind the writers.
+            auto ready = pollfd{fd, POLLOUT, 0};
+            if (::poll(&ready, 1, 1000) <= 0)
+              return false;
+          }
+        }
+      }
+#endif
+
+      namespace
+      {
+        void
+        forget(elle::Buffer& secret)
+        {
+          OPENSSL_cleanse(secret.mutable_contents(), secret.size());
+          secret = {};
+        }
+      }
+
+      void
+      SSLSocket::_kernel_tls_setup()
+      {
+#ifdef ELLE_REACTOR_KERNEL_TLS
+        auto ssl = this->_socket->native_handle();
+        if (SSL_version(ssl) != TLS1_3_VERSION ||
+            this->_ktls.secret.empty() || this->_ktls.rekeyed)
+        {
+          ELLE_DEBUG("%s: kernel TLS requires TLS 1.3", *this);
+          return forget(this->_ktls.secret);
+        }
+        auto const fd = this->_socket->next_layer().native_handle();
+        if (::setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0)
+        {
+          ELLE_DEBUG("%s: kernel TLS is unavailable: %s",
+                     *this, std::strerror(errno));
+          return forget(this->_ktls.secret);
+        }
+        // Without TLS_TX, the socket keeps behaving as a plain one.
+        if (!this->_kernel_tls_transmit(this->_ktls.records))
+          return forget(this->_ktls.secret);
+        ELLE_TRACE("%s: encryption offloaded to the kernel", *this);
+        this->_ktls.enabled = true;
+        // Records OpenSSL would write from now on bypass the kernel sequence
+        // numbers: discard them, _message hands them to the kernel instead.
+        // The secret is kept to follow key updates.
+        SSL_set0_wbio(ssl, BIO_new(BIO_s_null()));
+#else
+        forget(this->_ktls.secret);
+#endif
+      }
+
+      bool
+      SSLSocket::_kernel_tls_transmit(uint64_t sequence)
+      {
+#ifdef ELLE_REACTOR_KERNEL_TLS
+        auto ssl = this->_socket->native_handle();
+        auto const configure = [&] (auto& info, EVP_MD const* md)
+          {
+            info.info.version = TLS_1_3_VERSION;
+            if (!kernel_tls_info(info, md, this->_ktls.secret, sequence))
+              return false;
+            auto const fd = this->_socket->next_layer().native_handle();
+            if (::setsockopt(fd, SOL_TLS, TLS_TX, &info, sizeof(info)) != 0)
+            {
+              ELLE_DEBUG("%s: kernel TLS transmission is unavailable: %s",
+                         *this, std::strerror(errno));
+              return false;
+            }
+            return true;
+          };
+        auto const cipher = SSL_CIPHER_get_id(SSL_get_current_cipher(ssl));
+        auto res = false;
+        if (cipher == TLS1_3_CK_AES_128_GCM_SHA256)
+        {
+          auto info = tls12_crypto_info_aes_gcm_128{};
+          info.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+          res = configure(info, EVP_sha256());
+          OPENSSL_cleanse(&info, sizeof(info));
+        }
+        else if (cipher == TLS1_3_CK_AES_256_GCM_SHA384)
+        {
+          auto info = tls12_crypto_info_aes_gcm_256{};
+          info.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+          res = configure(info, EVP_sha384());
+          OPENSSL_cleanse(&info, sizeof(info));
+        }
+        else
+          ELLE_DEBUG("%s: no kernel TLS for cipher %s",
+                     *this, SSL_get_cipher_name(ssl));
+        return res;
+#else
+        return false;
+#endif
+      }
+
+      void
+      SSLSocket::_kernel_tls_record(int type, elle::ConstWeakBuffer payload)
+      {
+#ifdef ELLE_REACTOR_KERNEL_TLS
+        if (this->_ktls.failed)
+          return;
+        ELLE_TRACE_SCOPE("%s: send a record of type %s through the kernel",
+                         *this, type);
+        auto const fd = this->_socket->next_layer().native_handle();
+        if (!kernel_tls_send(fd, type, payload))
+          return this->_kernel_tls_fail(
+            elle::sprintf("unable to send record: %s", std::strerror(errno)));
+        if (type != SSL3_RT_HANDSHAKE || payload[0] != SSL3_MT_KEY_UPDATE)
+          return;
+        // Switch to our next traffic secret, from RFC 8446 section 7.2.
+        auto ssl = this->_socket->native_handle();
+        auto const md =
+          SSL_CIPHER_get_handshake_digest(SSL_get_current_cipher(ssl));
+        auto next =
+          expand_label(md, this->_ktls.secret, "traffic upd", EVP_MD_size(md));
+        forget(this->_ktls.secret);
+        this->_ktls.secret = std::move(next);
+        if (this->_ktls.secret.empty() || !this->_kernel_tls_transmit(0))
+          this->_kernel_tls_fail("the kernel cannot update keys");
+#endif
+      }
+
+      void
+      SSLSocket::_kernel_tls_fail(std::string const& reason)
+      {
+#ifdef ELLE_REACTOR_KERNEL_TLS
+        // Writing more would corrupt the stream: fail writers instead.
+        ELLE_WARN("%s: %s, stop writing", *this, reason);
+        this->_ktls.failed = true;
+        forget(this->_ktls.secret);
+        ::shutdown(this->_socket->next_layer().native_handle(), SHUT_WR);
+#endif
+      }
+
+      void
+      SSLSocket::_kernel_tls_close()
+      {
+#ifdef ELLE_REACTOR_KERNEL_TLS
+        ELLE_TRACE_SCOPE("%s: send close_notify through the kernel", *this);
+        this->flush();
+        // A warning level close_notify alert, in an alert record.
+        unsigned char const alert[] = {1, 0};
+        auto const fd = this->_socket->next_layer().native_handle();
+        if (this->_ktls.failed)
+          ELLE_DEBUG("%s: writing was shut down", *this);
+        else if (!kernel_tls_send(
+                   fd, SSL3_RT_ALERT, elle::ConstWeakBuffer(alert, 2)))
+          ELLE_DEBUG("%s: unable to send close_notify: %s",
+                     *this, std::strerror(errno));
+        SSL_set_shutdown(this->_socket->native_handle(), SSL_SENT_SHUTDOWN);
+        forget(this->_ktls.secret);
+#endif
+      }
+
       /*---------------.
       | SSL connection |
       `---------------*/
 
+      void
+      SSLSocket::_handshake_prepare(bool client)
+      {
+        auto ssl = this->_socket->native_handle();
+        SSL_set_ex_data(ssl, socket_index(), this);
+        if (client && this->_session_cache)
+        {
+          auto const key = elle::sprintf("%s", this->peer());
+          if (auto session = this->_session_cache->get(key))
+          {
+            ELLE_DEBUG("%s: offer cached session", *this);
+            SSL_set_session(ssl, session.get());
+#ifdef ELLE_REACTOR_TLS_1_3
+            // TLS 1.3 tickets should be used once: new ones are issued.
+            if (SSL_SESSION_get_protocol_version(session.get()) ==
+                TLS1_3_VERSION)
+              this->_session_cache->erase(key);
+#endif
+          }
+        }
+      }
+
       void
       SSLSocket::_client_handshake()
       {
         ELLE_TRACE_SCOPE("%s: handshake as client", *this);
+        this->_handshake_prepare(true);
         auto handshaker =
           SSLHandshake<SSLStream>(*this->_socket,
                                   SSLStream::handshake_type::client);
         if (!handshaker.run(this->_timeout))
           throw TimeOut();
+        ELLE_DEBUG("%s: %s session established",
+                   *this, this->resumed() ? "resumed" : "new");
+        this->_kernel_tls_setup();
       }
 
       void
       SSLSocket::_server_handshake(reactor::DurationOpt const& timeout)
       {
         ELLE_TRACE_SCOPE("%s: handshake as server", *this);
+        this->_handshake_prepare(false);
         auto handshaker =
           SSLHandshake<SSLStream>(*this->_socket,
                                   SSLStream::handshake_type::server);
         if (!handshaker.run(timeout))
           throw TimeOut();
+        ELLE_DEBUG("%s: %s session established",
+                   *this, this->resumed() ? "resumed" : "new");
+        this->_kernel_tls_setup();
       }
 
 
@@ -209,9 +766,15 @@ namespace elle
       void
       SSLSocket::_shutdown()
       {
-        if (this->_shutdown_asynchronous)
+        if (this->_ktls.enabled)
+          // OpenSSL no longer knows our sequence number.
+          this->_kernel_tls_close();
+        else if (this->_shutdown_asynchronous)
         {
           ELLE_TRACE_SCOPE("%s: shutdown SSL asynchronously", *this);
+          // The SSL handle outlives us.
+          SSL_set_ex_data(this->_socket->native_handle(), socket_index(),
+                          nullptr);
           auto const has_timeout = bool(this->_timeout);
           auto socket_raw = this->_socket.get();
           auto socket = elle::utility::move_on_copy(this->_socket);
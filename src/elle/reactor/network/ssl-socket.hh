@@ -1,5 +1,9 @@
 #pragma once
 
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 #include <elle/reactor/network/socket.hh>
 #include <elle/reactor/network/resolve.hh>
 #include <elle/reactor/network/TCPSocket.hh>
@@ -15,6 +19,39 @@ namespace elle
   {
     namespace network
     {
+      /// Client side cache of TLS sessions, to resume them when reconnecting
+      /// to the same peer instead of performing a full handshake.
+      ///
+      /// Least recently used sessions are evicted beyond capacity. Caches may
+      /// be shared by sockets of several schedulers.
+      class SSLSessionCache
+      {
+      public:
+        using Session = std::shared_ptr<SSL_SESSION>;
+        SSLSessionCache(std::size_t capacity = 256);
+        /// The cache used by default client contexts.
+        static
+        std::shared_ptr<SSLSessionCache> const&
+        global();
+        /// The session to resume with peer @a key, if any.
+        Session
+        get(std::string const& key);
+        void
+        put(std::string const& key, Session session);
+        void
+        erase(std::string const& key);
+        std::size_t
+        size() const;
+
+      private:
+        using Entries = std::list<std::pair<std::string, Session>>;
+        ELLE_ATTRIBUTE_R(std::size_t, capacity);
+        ELLE_ATTRIBUTE(std::mutex, mutex, mutable);
+        ELLE_ATTRIBUTE(Entries, entries);
+        ELLE_ATTRIBUTE((std::unordered_map<std::string, Entries::iterator>),
+                       index);
+      };
+
       /// An SSL context.
       ///
       /// SSLCertificate is just an helper for boost::asio::ssl::context.
@@ -27,7 +64,8 @@ namespace elle
         ///
         /// Initialize the underlying context with the given method and set
         /// verify to none.
-        /// This is the client implementation of the SSLCertificate.
+        /// This is the client implementation of the SSLCertificate. Sessions
+        /// are cached in SSLSessionCache::global().
         ///
         /// @param meth The ssl::context::method to use.
         SSLCertificate(SSLCertificateMethod meth =
@@ -58,6 +96,43 @@ namespace elle
 
       private:
         ELLE_ATTRIBUTE_RX(boost::asio::ssl::context, context);
+
+      /*---------.
+      | Sessions |
+      `---------*/
+      public:
+        /// Let servers using this context resume sessions, from a cache of
+        /// @a size sessions or from session tickets, shared by all their
+        /// connections.
+        void
+        server_session_cache(std::size_t size = 20480,
+                             Duration lifetime = std::chrono::hours(2));
+        /// Cache sessions established by clients using this context to resume
+        /// them on reconnection. Null disables resumption.
+        void
+        session_cache(std::shared_ptr<SSLSessionCache> cache);
+        ELLE_ATTRIBUTE_R(std::shared_ptr<SSLSessionCache>, session_cache);
+
+      /*-----------.
+      | Kernel TLS |
+      `-----------*/
+      public:
+        /// Hand encryption of outgoing data over to the kernel once TLS 1.3
+        /// connections using AES-GCM are established, where the kernel and
+        /// OpenSSL (1.1.1 or later) support it. Negotiating TLS 1.3 requires
+        /// a version-flexible method such as `sslv23_server`. Writes, including SSLSocket::send_file, then use the
+        /// plain socket paths.
+        ///
+        /// Decryption stays in user space. Records OpenSSL writes afterwards,
+        /// alerts and key updates, are sent through the kernel, and peer
+        /// requests for a key update are answered the same way. Following a
+        /// key update requires a kernel able to change transmission keys:
+        /// otherwise, or if such a record cannot be sent, the connection is
+        /// shut down for writing rather than corrupted, failing writers. This
+        /// is disabled by default.
+        void
+        kernel_tls(bool enable);
+        ELLE_ATTRIBUTE_R(bool, kernel_tls);
       };
 
       using SSLStream = boost::asio::ssl::stream<boost::asio::ip::tcp::socket>;
@@ -132,6 +207,68 @@ namespace elle
         void
         print(std::ostream& s) const;
 
+      /*---------.
+      | Sessions |
+      `---------*/
+      public:
+        /// Whether the handshake resumed a previous session.
+        bool
+        resumed() const;
+
+      /*-----------.
+      | Kernel TLS |
+      `-----------*/
+      public:
+        /// Whether outgoing data is encrypted by the kernel.
+        ///
+        /// @see SSLCertificate::kernel_tls.
+        bool
+        write_offloaded() const override;
+      private:
+        friend class SSLCertificate;
+        /// Record our traffic secret when OpenSSL logs it.
+        static
+        void
+        _keylog(SSL const* ssl, char const* line);
+        /// Count records OpenSSL sends with our traffic secret, or send them
+        /// through the kernel once it encrypts.
+        static
+        void
+        _message(int write, int version, int content_type,
+                 void const* buffer, std::size_t size, SSL* ssl, void*);
+        /// Store a new session in the client session cache.
+        static
+        int
+        _new_session(SSL* ssl, SSL_SESSION* session);
+        /// Configure kernel TLS transmission, if possible.
+        void
+        _kernel_tls_setup();
+        /// Hand our traffic secret over to the kernel.
+        bool
+        _kernel_tls_transmit(uint64_t sequence);
+        /// Send a record through the kernel, following key updates.
+        void
+        _kernel_tls_record(int type, elle::ConstWeakBuffer payload);
+        /// Shut writing down once the kernel cannot follow the session.
+        void
+        _kernel_tls_fail(std::string const& reason);
+        /// Send a close_notify alert through the kernel.
+        void
+        _kernel_tls_close();
+        struct KernelTLS
+        {
+          bool enabled = false;
+          /// Whether writing was shut down.
+          bool failed = false;
+          /// Our current application traffic secret.
+          elle::Buffer secret;
+          /// Records OpenSSL sent with it, i.e. the next sequence number.
+          uint64_t records = 0;
+          /// Whether OpenSSL changed keys since.
+          bool rekeyed = false;
+        };
+        ELLE_ATTRIBUTE(KernelTLS, ktls);
+
       /*-----------.
       | Connection |
       `-----------*/
@@ -146,12 +283,17 @@ namespace elle
         _client_handshake();
         void
         _server_handshake(reactor::DurationOpt const& timeout);
+        /// Attach this socket to its SSL handle and, as a client, offer the
+        /// cached session.
+        void
+        _handshake_prepare(bool client);
         void
         _shutdown();
 
       private:
         ELLE_ATTRIBUTE_RW(bool, shutdown_asynchronous);
         ELLE_ATTRIBUTE(DurationOpt, timeout);
+        ELLE_ATTRIBUTE(std::shared_ptr<SSLSessionCache>, session_cache);
       };
     }
   }
@@ -368,7 +368,8 @@ namespace elle
 
       elle::Buffer
       UDPSocket::read_until(std::string const& delimiter,
-                 DurationOpt opt)
+                 DurationOpt opt,
+                 std::size_t limit)
       {
         throw std::runtime_error("Not implemented.");
       }
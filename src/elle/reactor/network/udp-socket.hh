@@ -85,7 +85,8 @@ namespace elle
         /// In UDPSocket, this means read data from a connected Socket.
         elle::Buffer
         read_until(std::string const& delimiter,
-                   DurationOpt opt = {}) override;
+                   DurationOpt opt = {},
+                   std::size_t limit = 0) override;
         /// Read data from an EndPoint.
         ///
         /// \param buffer The destination buffer.
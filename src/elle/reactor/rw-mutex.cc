@@ -14,10 +14,10 @@ namespace elle
     /*-------.
     | Signal |
     `-------*/
-    Thread*
+    Resumable*
     RWMutex::WriteMutex::_signal_one()
     {
-      Thread* thread = Waitable::_signal_one();
+      Resumable* thread = Waitable::_signal_one();
       this->_locked = thread;
       return thread;
     }
@@ -90,10 +90,10 @@ namespace elle
     }
 
     bool
-    RWMutex::WriteMutex::_wait(Thread* thread, Waker const& waker)
+    RWMutex::WriteMutex::_wait(Handler& handler)
     {
-      ELLE_TRACE_SCOPE("%s: lock for writing by %s", *this, *thread);
-      if (_locked == thread)
+      ELLE_TRACE_SCOPE("%s: lock for writing by %s", *this, *handler.resumable);
+      if (_locked == handler.resumable)
       {
         ELLE_TRACE_SCOPE("%s: already locked for writing by this"
                          " thread %s times.", *this, _locked_recursive);
@@ -110,7 +110,7 @@ namespace elle
           ELLE_TRACE("%s: already locked for writing, waiting.", *this);
           ELLE_ASSERT(_locked);
         }
-        bool res = Waitable::_wait(thread, waker);
+        bool res = Waitable::_wait(handler);
         return res;
       }
       else
@@ -130,12 +130,12 @@ namespace elle
     {}
 
     bool
-    RWMutex::_wait(Thread* thread, Waker const& waker)
+    RWMutex::_wait(Handler& handler)
     {
-      ELLE_TRACE_SCOPE("%s: lock for reading by %s", *this, *thread);
+      ELLE_TRACE_SCOPE("%s: lock for reading by %s", *this, *handler.resumable);
       if (this->_write._locked)
         {
-          if (_write._locked == thread)
+          if (_write._locked == handler.resumable)
             {
               ELLE_TRACE("%s: already locked for writing by this thread"
                              " %s times", *this, _write._locked_recursive);
@@ -143,7 +143,7 @@ namespace elle
             }
           else
             ELLE_TRACE("%s: already locked for writing, waiting", *this)
-              return Waitable::_wait(thread, waker);
+              return Waitable::_wait(handler);
         }
       else
       {
@@ -38,14 +38,14 @@ namespace elle
       protected:
         virtual
         bool
-        _wait(Thread* thread, Waker const& waker) override;
+        _wait(Handler& handler) override;
         virtual
-        Thread*
+        Resumable*
         _signal_one() override;
 
       private:
         ELLE_ATTRIBUTE(RWMutex&, owner);
-        ELLE_ATTRIBUTE(reactor::Thread*, locked);
+        ELLE_ATTRIBUTE(reactor::Resumable*, locked);
         ELLE_ATTRIBUTE(int, locked_recursive);
         friend class RWMutex;
       };
@@ -54,7 +54,7 @@ namespace elle
     protected:
       virtual
       bool
-      _wait(Thread* thread, Waker const& waker) override;
+      _wait(Handler& handler) override;
     private:
       WriteMutex _write;
       ELLE_ATTRIBUTE_R(int, readers);
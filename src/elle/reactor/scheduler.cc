@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <elle/Measure.hh>
 #include <elle/Plugin.hh>
 #include <elle/assert.hh>
@@ -45,11 +47,20 @@ namespace elle
       : _done(false)
       , _shallstop(false)
       , _current(nullptr)
+      , _tasks()
+      , _tasks_ready()
+      , _simulated(false)
+      , _virtual_time()
+      , _origin(std::chrono::steady_clock::now())
+      , _timers(Duration::zero())
+      , _delayed()
       , _background_service_work(
            std::make_unique<boost::asio::io_service::work>(this->_background_service))
       , _background_pool_free(0)
       , _io_service_work(
            std::make_unique<boost::asio::io_service::work>(this->_io_service))
+      , _wakeup(this->_io_service)
+      , _wakeup_at()
 #if defined REACTOR_CORO_BACKEND_IO
       , _manager(new backend::coro_io::Backend())
 #elif defined REACTOR_CORO_BACKEND_BOOST_CONTEXT
@@ -155,8 +166,8 @@ namespace elle
           for (auto t: thread.waited())
             std::cerr << "      " << *t << std::endl;
           std::cerr << "    waiters:" << std::endl;
-          for (auto t: thread.waiters())
-            std::cerr << "      " << *(t.first) << std::endl;
+          for (auto const& h: thread.waiters())
+            std::cerr << "      " << *h.resumable << std::endl;
           std::cerr << "    backtrace:" << std::endl;
           // FIXME: Indent the backtrace
           std::cerr << thread.backtrace() << std::endl;
@@ -179,6 +190,12 @@ namespace elle
         for (auto thread: this->_starting)
           print_thread(*thread);
       }
+      if (!this->_tasks.empty())
+      {
+        std::cerr << "== TASKS ==" << std::endl;
+        for (auto const& task: this->_tasks)
+          std::cerr << "  " << task << ": " << task.state() << std::endl;
+      }
     }
 
     /*----.
@@ -219,6 +236,7 @@ namespace elle
       this->_io_service_work = nullptr;
       // Cancel all pending signal handlers.
       this->_signal_handlers.clear();
+      this->_wakeup.cancel();
       this->_io_service.run();
       this->_done = true;
       {
@@ -263,11 +281,18 @@ namespace elle
             ELLE_TRACE("Scheduler: schedule %s", *t);
             this->_step(t);
           }
+      if (!this->_tasks_ready.empty())
+        this->_tasks_run();
       ELLE_TRACE("%s: run asynchronous jobs", *this)
       {
         ELLE_MEASURE_SCOPE("Asio callbacks");
         try
         {
+          if (!this->_timers.empty())
+          {
+            auto n = this->_timers.advance(this->_elapsed());
+            ELLE_DEBUG("%s: %s timers expired", *this, n);
+          }
           this->_io_service.reset();
           auto n = this->_io_service.poll();
           ELLE_DEBUG("%s: %s callback called", *this, n);
@@ -286,16 +311,46 @@ namespace elle
           this->terminate();
         }
       }
-      if (this->_running.empty() && this->_starting.empty())
+      if (this->_running.empty() && this->_starting.empty() &&
+          this->_tasks_ready.empty())
       {
-        if (this->_frozen.empty())
+        if (this->_frozen.empty() && this->_timers.empty() &&
+            this->_tasks.empty())
         {
           ELLE_TRACE_SCOPE("%s: no threads left, we're done", *this);
           return false;
         }
+        else if (this->_simulated && !this->_timers.empty())
+        {
+          // Expire timers on the next step, as if we waited for them.
+          this->_virtual_time =
+            std::max(this->_virtual_time, Time(this->_timers.next()));
+          ELLE_TRACE("%s: nothing to do, advance virtual time to %s",
+                     *this, this->_virtual_time.time_since_epoch());
+        }
         else
-          while (this->_running.empty() && this->_starting.empty())
+          while (this->_running.empty() && this->_starting.empty() &&
+                 this->_tasks_ready.empty())
           {
+            if (!this->_timers.empty())
+            {
+              auto const next = this->_timers.next();
+              if (next <= this->_elapsed())
+                break;
+              // Rearming cancels the pending wait, which wakes us up: only
+              // do it when the next deadline changed.
+              if (this->_wakeup_at != next)
+              {
+                this->_wakeup_at = next;
+                this->_wakeup.expires_at(this->_origin + next);
+                this->_wakeup.async_wait(
+                  [this] (boost::system::error_code const& e)
+                  {
+                    if (!e)
+                      this->_wakeup_at.reset();
+                  });
+              }
+            }
             ELLE_TRACE_SCOPE("%s: nothing to do, "
                        "polling asio in a blocking fashion", *this);
             this->_io_service.reset();
@@ -353,6 +408,34 @@ namespace elle
       }
     }
 
+    void
+    Scheduler::_tasks_run()
+    {
+      ELLE_TRACE_SCOPE("%s: run tasks", *this);
+      // Tasks made ready meanwhile run on the next step.
+      auto ready = Task::Ready();
+      ready.swap(this->_tasks_ready);
+      while (!ready.empty())
+      {
+        auto& task = ready.front();
+        ready.pop_front();
+        try
+        {
+          task._run();
+        }
+        catch (...)
+        {
+          ELLE_LOG_LEVEL_SCOPE(
+            DBG ? elle::log::Logger::Level::log : elle::log::Logger::Level::trace,
+            DBG ? elle::log::Logger::Type::warning : elle::log::Logger::Type::info,
+            "%s: exception escaped, terminating: %s",
+            task, elle::exception_string());
+          this->_eptr = std::current_exception();
+          this->terminate();
+        }
+      }
+    }
+
     /*-------------------.
     | Threads management |
     `-------------------*/
@@ -416,6 +499,9 @@ namespace elle
         t->_scheduler_release();
       }
       this->_starting.clear();
+      this->_delayed.clear();
+      while (!this->_tasks.empty())
+        this->_tasks.front().terminate();
       for (Thread* t: Threads(this->_running))
         if (t != this->_current)
         {
@@ -538,12 +624,53 @@ namespace elle
                           std::function<void ()> const&  f,
                           Duration delay)
     {
-      run_later(name,
-                [this, f, delay]
-                {
-                  this->current()->sleep(delay);
-                  f();
-                });
+      auto timer = this->_delayed.emplace(this->_delayed.end());
+      this->_timer_arm(
+        *timer, delay,
+        [this, timer, name, f]
+        {
+          this->_delayed.erase(timer);
+          ELLE_TRACE_SCOPE("%s: run %s", *this, name);
+          f();
+        });
+    }
+
+    /*-----.
+    | Time |
+    `-----*/
+
+    Time
+    Scheduler::now() const
+    {
+      if (this->_simulated)
+        return this->_virtual_time;
+      else
+        return Clock::now();
+    }
+
+    void
+    Scheduler::simulated(bool simulated)
+    {
+      this->_simulated = simulated;
+      this->_timers.reset(this->_elapsed());
+    }
+
+    void
+    Scheduler::_timer_arm(TimerWheel::Timer& timer,
+                          Duration delay,
+                          std::function<void ()> action)
+    {
+      this->_timers.arm(timer, this->_elapsed() + delay, std::move(action));
+    }
+
+    Duration
+    Scheduler::_elapsed() const
+    {
+      if (this->_simulated)
+        return this->_virtual_time.time_since_epoch();
+      else
+        return std::chrono::duration_cast<Duration>(
+          std::chrono::steady_clock::now() - this->_origin);
     }
 
     /*----------------.
@@ -687,6 +814,15 @@ namespace elle
       o.run();
     }
 
+    Time
+    now()
+    {
+      if (auto sched = Scheduler::scheduler())
+        return sched->now();
+      else
+        return Clock::now();
+    }
+
     void
     yield()
     {
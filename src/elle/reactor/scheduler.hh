@@ -1,5 +1,6 @@
 #pragma once
 
+#include <list>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -8,6 +9,7 @@
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
+#include <boost/optional.hpp>
 #ifdef ELLE_WINDOWS
 # include <winsock2.h>
 #endif
@@ -17,6 +19,8 @@
 #include <elle/Printable.hh>
 #include <elle/attribute.hh>
 #include <elle/reactor/asio.hh>
+#include <elle/reactor/Task.hh>
+#include <elle/reactor/TimerWheel.hh>
 #include <elle/reactor/duration.hh>
 #include <elle/reactor/fwd.hh>
 #include <elle/reactor/backend/fwd.hh>
@@ -188,6 +192,19 @@ namespace elle
       ELLE_ATTRIBUTE(Threads, running);
       ELLE_ATTRIBUTE(Threads, frozen);
 
+    /*-----------------.
+    | Tasks management |
+    `-----------------*/
+    private:
+      friend class Task;
+      /// Run the Tasks that are ready, in order.
+      void
+      _tasks_run();
+      /// Tasks that are not done.
+      ELLE_ATTRIBUTE(Task::Tasks, tasks);
+      /// Tasks ready to run.
+      ELLE_ATTRIBUTE(Task::Ready, tasks_ready);
+
     /*-------------------------.
     | Thread Exception Handler |
     `-------------------------*/
@@ -229,6 +246,11 @@ namespace elle
                 std::function<void ()> const& f);
       /// Run the given operation after a given delay.
       ///
+      /// The operation runs from a timer, in the scheduler context, and must
+      /// not yield: use run_later from it to start a thread. Pending
+      /// operations keep the scheduler running, and are canceled when it is
+      /// terminated.
+      ///
       /// @param name A descriptive name of the operation, for debugging.
       /// @param f The operation to run later.
       /// @param delay The delay before running the operation.
@@ -237,6 +259,43 @@ namespace elle
                  std::function<void ()> const& f,
                  Duration delay);
 
+    /*-----.
+    | Time |
+    `-----*/
+    public:
+      /// The current time: the system time, or the virtual time if the
+      /// Scheduler is simulated.
+      Time
+      now() const;
+      /// Whether time is simulated.
+      ///
+      /// Sleeps, wait timeouts and TimeoutGuards then expire in virtual time,
+      /// which starts at the epoch and only advances when no thread can run:
+      /// the clock jumps to the nearest deadline instead of waiting for it.
+      /// Runs take no real time and do not depend on the speed of the
+      /// machine, as long as threads do not wait for actual I/O, which does
+      /// not hold virtual time back. Armed timers keep their remaining delay
+      /// when it changes.
+      ELLE_ATTRIBUTE_Rw(bool, simulated);
+    private:
+      friend class Sleep;
+      friend class TimeoutGuard;
+      /// Run @a action from the scheduler after @a delay.
+      void
+      _timer_arm(TimerWheel::Timer& timer,
+                 Duration delay,
+                 std::function<void ()> action);
+      /// The time elapsed since the origin of the timer wheel: steady time
+      /// since construction, or the virtual time.
+      Duration
+      _elapsed() const;
+      ELLE_ATTRIBUTE(Time, virtual_time);
+      ELLE_ATTRIBUTE(std::chrono::steady_clock::time_point, origin);
+      /// Sleeps, wait timeouts, TimeoutGuards and delayed operations.
+      ELLE_ATTRIBUTE(TimerWheel, timers);
+      /// The call_later timers.
+      ELLE_ATTRIBUTE(std::list<TimerWheel::Timer>, delayed);
+
     /*----------------.
     | Background jobs |
     `----------------*/
@@ -290,6 +349,10 @@ namespace elle
     public:
       ELLE_ATTRIBUTE_RX(boost::asio::io_service, io_service);
       ELLE_ATTRIBUTE(std::unique_ptr<boost::asio::io_service::work>, io_service_work);
+      /// Wakes the scheduler up for the next timer, while it blocks on asio.
+      ELLE_ATTRIBUTE(boost::asio::steady_timer, wakeup);
+      /// The wheel time the wakeup timer is armed for.
+      ELLE_ATTRIBUTE(boost::optional<Duration>, wakeup_at);
 
     /*--------.
     | Details |
@@ -318,6 +381,10 @@ namespace elle
     /// @param action The action to run in background.
     void
     background(std::function<void()> const& action);
+    /// The current time of the current scheduler, or the system time
+    /// outside of any scheduler.
+    Time
+    now();
     /// Yield execution for this scheduler round.
     void
     yield();
@@ -28,11 +28,11 @@ namespace elle
     }
 
     bool
-    Semaphore::_wait(Thread* thread, Waker const& waker)
+    Semaphore::_wait(Handler& handler)
     {
       if (this->_count <= 0)
       {
-        this->Waitable::_wait(thread, waker);
+        this->Waitable::_wait(handler);
         return true;
       }
       else
@@ -37,7 +37,7 @@ namespace elle
       /// \param waker The Waker to invoke.
       /// \returns Whether the Thread waited.
       bool
-      _wait(Thread* thread, Waker const& waker) override;
+      _wait(Handler& handler) override;
 
     private:
       /// Number of potential acquirers.
@@ -9,7 +9,7 @@ namespace elle
     Sleep::Sleep(Scheduler& scheduler, Duration d)
       : Operation(scheduler)
       , _duration(d)
-      , _timer(scheduler.io_service(), d)
+      , _timer()
     {}
 
     /*----------.
@@ -25,21 +25,15 @@ namespace elle
     void
     Sleep::_abort()
     {
-      _timer.cancel();
-      _signal();
+      this->_timer.cancel();
+      this->_signal();
     }
 
     void
     Sleep::_start()
     {
-      _timer.async_wait([this](const boost::system::error_code& error)
-                        {
-                          if (error == boost::asio::error::operation_aborted)
-                            return;
-                          if (error)
-                            _raise<Exception>(error.message());
-                          this->_signal();
-                        });
+      this->sched()._timer_arm(this->_timer, this->_duration,
+                               [this] { this->_signal(); });
     }
   }
 }
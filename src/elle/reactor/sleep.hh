@@ -1,7 +1,8 @@
 #pragma once
 
-#include <elle/reactor/asio.hh>
+#include <elle/reactor/duration.hh>
 #include <elle/reactor/Operation.hh>
+#include <elle/reactor/TimerWheel.hh>
 
 namespace elle
 {
@@ -48,7 +49,7 @@ namespace elle
 
     private:
       Duration _duration;
-      AsioTimer _timer;
+      TimerWheel::Timer _timer;
     };
   }
 }
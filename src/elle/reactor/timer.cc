@@ -112,12 +112,12 @@ namespace elle
 
     // waitable interface
     bool
-    Timer::_wait(Thread* thread, Waker const& waker)
+    Timer::_wait(Handler& handler)
     {
       if (this->_finished)
         return false;
       else
-        return Waitable::_wait(thread, waker);
+        return Waitable::_wait(handler);
     }
   }
 }
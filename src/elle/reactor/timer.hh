@@ -55,7 +55,7 @@ namespace elle
     protected:
       virtual
       bool
-      _wait(Thread* thread, Waker const& waker) override;
+      _wait(Handler& handler) override;
     private:
       void
       _on_timer(const boost::system::error_code& erc);
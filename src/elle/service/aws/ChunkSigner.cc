@@ -0,0 +1,96 @@
+#include <elle/service/aws/ChunkSigner.hh>
+
+#include <elle/cryptography/hash.hh>
+#include <elle/format/hexadecimal.hh>
+#include <elle/log.hh>
+#include <elle/print.hh>
+
+ELLE_LOG_COMPONENT("elle.services.aws.ChunkSigner");
+
+namespace elle
+{
+  namespace service
+  {
+    namespace aws
+    {
+      namespace
+      {
+        /// The SHA-256 of nothing, part of every chunk string to sign.
+        auto const empty_sha256 = std::string(
+          "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        /// The length of a hexadecimal signature.
+        auto const signature_size = std::size_t(64);
+
+        uint64_t
+        frame_size(uint64_t size)
+        {
+          // <hex size>;chunk-signature=<signature>\r\n<data>\r\n
+          return elle::sprintf("%x", size).size() +
+            std::string(";chunk-signature=").size() + signature_size + 2 +
+            size + 2;
+        }
+      }
+
+      std::string const
+      ChunkSigner::content_sha256("STREAMING-AWS4-HMAC-SHA256-PAYLOAD");
+
+      /*-------------.
+      | Construction |
+      `-------------*/
+
+      ChunkSigner::ChunkSigner(SigningKey key,
+                               RequestTime const& request_time,
+                               CredentialScope const& credential_scope,
+                               std::string seed_signature)
+        : _key(std::move(key))
+        , _request_time(request_time)
+        , _credential_scope(credential_scope)
+        , _signature(std::move(seed_signature))
+      {}
+
+      /*--------.
+      | Signing |
+      `--------*/
+
+      elle::Buffer
+      ChunkSigner::chunk(elle::ConstWeakBuffer const& data)
+      {
+        auto const digest =
+          elle::cryptography::hash(data, elle::cryptography::Oneway::sha256);
+        auto const hashed = elle::format::hexadecimal::encode(digest);
+        StringToSign string_to_sign(
+          this->_request_time, this->_credential_scope,
+          elle::print("{}\n{}\n{}", this->_signature, empty_sha256, hashed),
+          SigningMethod::aws4_hmac_sha256_payload);
+        this->_signature = this->_key.sign_message(string_to_sign.string());
+        ELLE_DUMP("%s: sign %s bytes: %s", this, data.size(), this->_signature);
+        auto res = elle::Buffer(elle::sprintf(
+          "%x;chunk-signature=%s\r\n", data.size(), this->_signature));
+        res.capacity(frame_size(data.size()));
+        res.append(data.contents(), data.size());
+        res.append("\r\n", 2);
+        return res;
+      }
+
+      uint64_t
+      ChunkSigner::encoded_size(uint64_t size, std::size_t chunk_size)
+      {
+        auto const full = size / chunk_size;
+        auto const rest = size % chunk_size;
+        return full * frame_size(chunk_size) +
+          (rest ? frame_size(rest) : 0) +
+          frame_size(0);
+      }
+
+      /*----------.
+      | Printable |
+      `----------*/
+
+      void
+      ChunkSigner::print(std::ostream& stream) const
+      {
+        elle::fprintf(stream, "ChunkSigner(%s)", this->_credential_scope);
+      }
+    }
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+
+#include <elle/Buffer.hh>
+#include <elle/Printable.hh>
+#include <elle/attribute.hh>
+#include <elle/service/aws/SigningKey.hh>
+#include <elle/service/aws/StringToSign.hh>
+
+namespace elle
+{
+  namespace service
+  {
+    namespace aws
+    {
+      /// Sign the chunks of a STREAMING-AWS4-HMAC-SHA256-PAYLOAD body.
+      ///
+      /// Each chunk signature covers the chunk and the previous signature,
+      /// starting with the signature of the request headers, so the body can
+      /// be sent as it is read instead of being hashed beforehand.
+      ///
+      /// http://docs.aws.amazon.com/AmazonS3/latest/API/sigv4-streaming.html
+      class ChunkSigner
+        : public elle::Printable
+      {
+      /*-------------.
+      | Construction |
+      `-------------*/
+      public:
+        ChunkSigner(SigningKey key,
+                    RequestTime const& request_time,
+                    CredentialScope const& credential_scope,
+                    std::string seed_signature);
+
+      /*--------.
+      | Signing |
+      `--------*/
+      public:
+        /// Sign and frame the next chunk of the body. The last chunk must be
+        /// empty.
+        elle::Buffer
+        chunk(elle::ConstWeakBuffer const& data);
+        /// The size of a @a size bytes body once framed in chunks of
+        /// @a chunk_size bytes.
+        static
+        uint64_t
+        encoded_size(uint64_t size, std::size_t chunk_size);
+        /// The `x-amz-content-sha256` of streamed bodies.
+        static
+        std::string const
+        content_sha256;
+      private:
+        ELLE_ATTRIBUTE(SigningKey, key);
+        ELLE_ATTRIBUTE(RequestTime, request_time);
+        ELLE_ATTRIBUTE(CredentialScope, credential_scope);
+        /// The signature of the last chunk.
+        ELLE_ATTRIBUTE_R(std::string, signature);
+
+      /*----------.
+      | Printable |
+      `----------*/
+      public:
+        void
+        print(std::ostream& stream) const override;
+      };
+    }
+  }
+}
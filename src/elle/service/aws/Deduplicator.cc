@@ -0,0 +1,266 @@
+#include <elle/service/aws/Deduplicator.hh>
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <ostream>
+#include <sstream>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <elle/With.hh>
+#include <elle/archive/chunker.hh>
+#include <elle/cryptography/hash.hh>
+#include <elle/err.hh>
+#include <elle/format/hexadecimal.hh>
+#include <elle/log.hh>
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/scheduler.hh>
+#include <elle/reactor/signal.hh>
+
+ELLE_LOG_COMPONENT("elle.services.aws.Deduplicator");
+
+namespace elle
+{
+  namespace service
+  {
+    namespace aws
+    {
+      namespace
+      {
+        std::string
+        sha256(elle::ConstWeakBuffer const& data)
+        {
+          auto const digest =
+            elle::cryptography::hash(data, elle::cryptography::Oneway::sha256);
+          return elle::format::hexadecimal::encode(digest);
+        }
+
+        bool
+        valid_hash(std::string const& hash)
+        {
+          return hash.size() == 64 &&
+            std::all_of(hash.begin(), hash.end(),
+                        [] (char c)
+                        {
+                          return std::isxdigit(static_cast<unsigned char>(c));
+                        });
+        }
+      }
+
+      /*-------------.
+      | Construction |
+      `-------------*/
+
+      Deduplicator::Deduplicator(S3& s3,
+                                 boost::filesystem::path index,
+                                 int concurrency)
+        : _s3(s3)
+        , _index_path(std::move(index))
+        , _index()
+        , _concurrency(concurrency)
+        , _chunk_size(1024 * 1024)
+      {
+        this->_index_load();
+      }
+
+      /*----------.
+      | Manifests |
+      `----------*/
+
+      std::string
+      Deduplicator::manifest_dump(Manifest const& manifest)
+      {
+        auto res = std::string{};
+        res.reserve(manifest.size() * 80);
+        for (auto const& chunk: manifest)
+          res += elle::sprintf("%s %s\n", chunk.hash, chunk.size);
+        return res;
+      }
+
+      Deduplicator::Manifest
+      Deduplicator::manifest_load(elle::ConstWeakBuffer const& data)
+      {
+        auto res = Manifest{};
+        std::stringstream input(data.string());
+        auto chunk = Chunk{};
+        while (input >> chunk.hash >> chunk.size)
+        {
+          if (!valid_hash(chunk.hash))
+            elle::err("invalid chunk hash in manifest: %s", chunk.hash);
+          res.emplace_back(chunk);
+        }
+        if (!input.eof())
+          elle::err("invalid manifest after %s chunks", res.size());
+        return res;
+      }
+
+      /*----------.
+      | Transfers |
+      `----------*/
+
+      std::string
+      Deduplicator::_chunk_name(std::string const& hash)
+      {
+        return "chunks/" + hash;
+      }
+
+      bool
+      Deduplicator::stored(std::string const& hash) const
+      {
+        return this->_index.count(hash) != 0;
+      }
+
+      Deduplicator::Upload
+      Deduplicator::upload(std::string const& object_name,
+                           std::istream& input)
+      {
+        ELLE_TRACE_SCOPE("%s: upload %s", this, object_name);
+        auto res = Upload{};
+        auto chunker = elle::archive::Chunker(input, this->_chunk_size);
+        // Chunks being uploaded, not to be uploaded twice by two workers.
+        auto pending = std::unordered_set<std::string>{};
+        auto done = false;
+        elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+        {
+          for (int i = 0; i < this->_concurrency; ++i)
+            scope.run_background(
+              elle::sprintf("%s: upload worker %s", this, i),
+              [&]
+              {
+                // Chunks are read and listed in the manifest without
+                // yielding, so the manifest is in stream order.
+                while (!done)
+                {
+                  auto chunk = chunker.next();
+                  if (!chunk)
+                  {
+                    done = true;
+                    break;
+                  }
+                  auto hash = sha256(*chunk);
+                  res.manifest.emplace_back(Chunk{hash, chunk->size()});
+                  if (this->stored(hash) || !pending.insert(hash).second)
+                  {
+                    ELLE_DEBUG("%s: skip stored chunk %s", this, hash);
+                    ++res.deduplicated;
+                    res.deduplicated_bytes += chunk->size();
+                    continue;
+                  }
+                  ELLE_DEBUG("%s: upload chunk %s (%s bytes)",
+                             this, hash, chunk->size());
+                  this->_s3.put_object(*chunk, _chunk_name(hash));
+                  this->_index_add(hash);
+                  pending.erase(hash);
+                  ++res.uploaded;
+                  res.uploaded_bytes += chunk->size();
+                }
+              });
+          elle::reactor::wait(scope);
+        };
+        // The manifest goes last, so it never references missing chunks.
+        this->_s3.put_object(
+          elle::ConstWeakBuffer(manifest_dump(res.manifest)), object_name);
+        ELLE_TRACE("%s: uploaded %s chunks (%s bytes), deduplicated %s "
+                   "(%s bytes)", this, res.uploaded, res.uploaded_bytes,
+                   res.deduplicated, res.deduplicated_bytes);
+        return res;
+      }
+
+      void
+      Deduplicator::download(std::string const& object_name,
+                             std::ostream& output)
+      {
+        ELLE_TRACE_SCOPE("%s: download %s", this, object_name);
+        auto const manifest_data = this->_s3.get_object(object_name);
+        auto const manifest = manifest_load(manifest_data);
+        auto const count = int(manifest.size());
+        // Chunks fetched and not yet written, at most concurrency of them
+        // including those being fetched.
+        auto fetched = std::map<int, elle::Buffer>{};
+        auto next_fetch = 0;
+        auto next_write = 0;
+        auto available = elle::reactor::Signal("chunk available");
+        auto written = elle::reactor::Signal("chunk written");
+        elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+        {
+          for (int i = 0; i < std::min(this->_concurrency, count); ++i)
+            scope.run_background(
+              elle::sprintf("%s: download worker %s", this, i),
+              [&]
+              {
+                while (next_fetch < count)
+                {
+                  auto const index = next_fetch++;
+                  while (index >= next_write + this->_concurrency)
+                    elle::reactor::wait(written);
+                  auto const& chunk = manifest[index];
+                  auto data = this->_s3.get_object(_chunk_name(chunk.hash));
+                  if (data.size() != chunk.size || sha256(data) != chunk.hash)
+                    elle::err("%s: chunk %s of %s is corrupted",
+                              this, chunk.hash, object_name);
+                  fetched.emplace(index, std::move(data));
+                  available.signal();
+                }
+              });
+          while (next_write < count)
+          {
+            auto it = fetched.find(next_write);
+            if (it == fetched.end())
+            {
+              elle::reactor::wait(available);
+              continue;
+            }
+            output.write(reinterpret_cast<char const*>(it->second.contents()),
+                         it->second.size());
+            if (!output)
+              elle::err("%s: unable to write %s", this, object_name);
+            fetched.erase(it);
+            ++next_write;
+            written.signal();
+          }
+          elle::reactor::wait(scope);
+        };
+      }
+
+      /*------.
+      | Index |
+      `------*/
+
+      void
+      Deduplicator::_index_load()
+      {
+        boost::filesystem::ifstream input(this->_index_path);
+        auto hash = std::string{};
+        while (std::getline(input, hash))
+          // Skip a line truncated by an interrupted write.
+          if (valid_hash(hash))
+            this->_index.emplace(hash);
+        ELLE_TRACE("%s: %s chunks in index %s",
+                   this, this->_index.size(), this->_index_path);
+      }
+
+      void
+      Deduplicator::_index_add(std::string const& hash)
+      {
+        boost::filesystem::ofstream output(this->_index_path,
+                                           std::ios::app);
+        output << hash << '\n';
+        output.flush();
+        if (!output)
+          elle::err("%s: unable to write index %s", this, this->_index_path);
+        this->_index.emplace(hash);
+      }
+
+      /*----------.
+      | Printable |
+      `----------*/
+
+      void
+      Deduplicator::print(std::ostream& stream) const
+      {
+        elle::fprintf(stream, "Deduplicator(%s)", this->_s3);
+      }
+    }
+  }
+}
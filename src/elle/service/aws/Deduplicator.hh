@@ -0,0 +1,143 @@
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+#include <elle/Printable.hh>
+#include <elle/attribute.hh>
+#include <elle/service/aws/S3.hh>
+
+namespace elle
+{
+  namespace service
+  {
+    namespace aws
+    {
+      /// Upload streams as deduplicated, content-defined chunks.
+      ///
+      /// Streams are split by an elle::archive::Chunker and each chunk is
+      /// stored once, as `chunks/<SHA-256>`. The object itself is a manifest
+      /// listing its chunks, so uploading a new snapshot of an archive only
+      /// sends the chunks it does not share with previous ones.
+      ///
+      /// Chunks known to be stored are recorded in a local index file, so
+      /// no request is needed to skip them. The index is only ever appended
+      /// to, once a chunk is stored: an interrupted upload resumes without
+      /// sending its chunks again. Chunks deleted from the bucket behind the
+      /// index's back must also be removed from the index.
+      ///
+      /// @code{.cc}
+      ///
+      /// elle::service::aws::Deduplicator dedup(s3, "chunks.index");
+      /// elle::archive::archive(Format::tar, {root}, "snapshot.tar");
+      /// std::ifstream input("snapshot.tar", std::ios::binary);
+      /// dedup.upload("snapshots/monday", input);
+      /// std::ofstream output("restored.tar", std::ios::binary);
+      /// dedup.download("snapshots/monday", output);
+      ///
+      /// @endcode
+      class Deduplicator
+        : public elle::Printable
+      {
+      /*-------------.
+      | Construction |
+      `-------------*/
+      public:
+        /// Create a Deduplicator.
+        ///
+        /// @param s3          The S3 bucket to store chunks and manifests in.
+        /// @param index       The local index of stored chunks, created if
+        ///                    it does not exist.
+        /// @param concurrency The number of chunks transferred concurrently.
+        Deduplicator(S3& s3,
+                     boost::filesystem::path index,
+                     int concurrency = 8);
+
+      /*----------.
+      | Manifests |
+      `----------*/
+      public:
+        /// A chunk of an object.
+        struct Chunk
+        {
+          /// The hexadecimal SHA-256 of the chunk.
+          std::string hash;
+          std::size_t size;
+        };
+        using Manifest = std::vector<Chunk>;
+        /// Serialize a manifest, one `<hash> <size>` line per chunk.
+        static
+        std::string
+        manifest_dump(Manifest const& manifest);
+        /// Parse a serialized manifest.
+        static
+        Manifest
+        manifest_load(elle::ConstWeakBuffer const& data);
+
+      /*----------.
+      | Transfers |
+      `----------*/
+      public:
+        /// What an upload did.
+        struct Upload
+        {
+          Manifest manifest;
+          /// The number of chunks sent.
+          int uploaded = 0;
+          /// The number of bytes sent.
+          S3::FileSize uploaded_bytes = 0;
+          /// The number of chunks already stored.
+          int deduplicated = 0;
+          /// The number of bytes not sent since already stored.
+          S3::FileSize deduplicated_bytes = 0;
+        };
+        /// Upload the chunks of @a input that are not stored yet, then its
+        /// manifest as @a object_name.
+        Upload
+        upload(std::string const& object_name, std::istream& input);
+        /// Reassemble @a object_name from its chunks into @a output.
+        ///
+        /// Chunks are checked against their hash.
+        void
+        download(std::string const& object_name, std::ostream& output);
+        /// Whether a chunk is known to be stored.
+        bool
+        stored(std::string const& hash) const;
+      private:
+        static
+        std::string
+        _chunk_name(std::string const& hash);
+        void
+        _index_load();
+        void
+        _index_add(std::string const& hash);
+        ELLE_ATTRIBUTE(S3&, s3);
+        ELLE_ATTRIBUTE_R(boost::filesystem::path, index_path);
+        ELLE_ATTRIBUTE(std::unordered_set<std::string>, index);
+
+      /*--------------.
+      | Configuration |
+      `--------------*/
+      public:
+        /// The number of chunks transferred concurrently.
+        ELLE_ATTRIBUTE_RW(int, concurrency);
+        /// The average chunk size.
+        ///
+        /// Changing it changes all chunk boundaries, and no chunk will be
+        /// shared with objects uploaded before.
+        ELLE_ATTRIBUTE_RW(std::size_t, chunk_size);
+
+      /*----------.
+      | Printable |
+      `----------*/
+      public:
+        void
+        print(std::ostream& stream) const override;
+      };
+    }
+  }
+}
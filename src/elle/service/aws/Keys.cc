@@ -41,6 +41,8 @@ namespace elle
         {
         case SigningMethod::aws4_hmac_sha256:
           return stream << "AWS4-HMAC-SHA256";
+        case SigningMethod::aws4_hmac_sha256_payload:
+          return stream << "AWS4-HMAC-SHA256-PAYLOAD";
         }
         elle::unreachable();
       }
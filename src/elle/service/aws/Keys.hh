@@ -38,6 +38,8 @@ namespace elle
       enum class SigningMethod
       {
         aws4_hmac_sha256,
+        /// The chunks of a STREAMING-AWS4-HMAC-SHA256-PAYLOAD body.
+        aws4_hmac_sha256_payload,
       };
 
       std::ostream&
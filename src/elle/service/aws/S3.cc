@@ -2,12 +2,14 @@
 #include <boost/property_tree/xml_parser.hpp>
 
 #include <elle/cryptography/hash.hh>
+#include <elle/err.hh>
 #include <elle/finally.hh>
 #include <elle/format/base64.hh>
 #include <elle/format/hexadecimal.hh>
 #include <elle/log.hh>
 #include <elle/os/environ.hh>
 #include <elle/print.hh>
+#include <elle/service/aws/ChunkSigner.hh>
 #include <elle/service/aws/Exceptions.hh>
 #include <elle/service/aws/Keys.hh>
 #include <elle/service/aws/S3.hh>
@@ -168,6 +170,40 @@ namespace elle
           return etag->second;
       }
 
+      std::string
+      S3::put_object(std::istream& object,
+                     FileSize size,
+                     std::string const& object_name,
+                     S3::StorageClass storage_class,
+                     std::size_t chunk_size)
+      {
+        ELLE_TRACE_SCOPE("%s: PUT streamed block: %s (%s bytes)",
+                         *this, object_name, size);
+        RequestHeaders headers;
+        if (storage_class != StorageClass::Default)
+          headers["x-amz-storage-class"] = to_string(storage_class);
+        auto const url = elle::print("/%s/%s",
+                                     this->_credentials.folder(), object_name);
+        auto const stream = Stream{object, size, chunk_size};
+        auto request = _build_send_request(
+          RequestKind::data, url,
+          "put_object",
+          http::Method::PUT,
+          {}, headers,
+          "binary/octet-stream",
+          {},
+          {},
+          {},
+          0,
+          &stream);
+        auto const& response = request->headers();
+        auto etag = response.find("ETag");
+        if (etag == response.end())
+          return "";
+        else
+          return etag->second;
+      }
+
       auto
       S3::list_remote_folder(std::string const& marker)
         -> List
@@ -206,6 +242,55 @@ namespace elle
         return result;
       }
 
+      void
+      S3::get_object(std::string const& object_name,
+                     std::ostream& output,
+                     RequestHeaders headers,
+                     std::size_t buffer_size)
+      {
+        ELLE_TRACE_SCOPE("%s: stream remote object", *this);
+        auto const url = elle::print("/%s/%s",
+                                     this->_credentials.folder(), object_name);
+        ELLE_DEBUG("url: %s", url);
+        auto request =
+          this->_build_send_request(RequestKind::stream, url,
+                                    elle::print("get_object(%s)", headers),
+                                    http::Method::GET,
+                                    RequestQuery(),
+                                    headers,
+                                    "application/json",
+                                    elle::ConstWeakBuffer(),
+                                    {},
+                                    {},
+                                    buffer_size);
+        auto block = std::vector<char>(64 * 1024);
+        auto const digest = elle::cryptography::hash(
+          [&] () -> elle::ConstWeakBuffer
+          {
+            request->read(block.data(), block.size());
+            auto const size = request->gcount();
+            output.write(block.data(), size);
+            if (!output)
+              elle::err("%s: unable to write %s", *this, object_name);
+            return elle::ConstWeakBuffer(block.data(), size);
+          },
+          elle::cryptography::Oneway::md5);
+        // Report failures that occurred after the headers were received.
+        elle::reactor::wait(*request);
+        auto const etag = request->headers().find("ETag");
+        if (etag != request->headers().end())
+        {
+          auto const calcd_md5 = elle::format::hexadecimal::encode(digest);
+          auto const aws_md5 = etag->second.substr(1, etag->second.size() - 2);
+          if (aws_md5.find('-') == std::string::npos && calcd_md5 != aws_md5)
+            throw aws::CorruptedData(
+              elle::print("%s: GET data corrupt: %s != %s", *this, calcd_md5,
+                          aws_md5));
+        }
+        else
+          ELLE_DUMP("server did not include ETag");
+      }
+
       elle::Buffer
       S3::get_object_chunk(std::string const& object_name,
                            FileSize offset, FileSize size)
@@ -276,13 +361,7 @@ namespace elle
           }
           xml += "</Delete>";
           elle::ConstWeakBuffer payload(xml);
-          // build the request
-          RequestHeaders headers;
-          auto hashed =
-            elle::cryptography::hash(
-              payload,
-              elle::cryptography::Oneway::md5);
-          headers["Content-MD5"] = elle::format::base64::encode(hashed).string();
+          // build the request, Content-MD5 is added along the payload hash.
           RequestQuery query;
           query["delete"] = "";
 
@@ -291,7 +370,7 @@ namespace elle
                                     "delete_folder",
                                     http::Method::POST,
                                     query,
-                                    headers,
+                                    {},
                                     "text/xml",
                                     payload);
         }
@@ -433,17 +512,31 @@ namespace elle
       std::vector<S3::MultiPartChunk>
       S3::multipart_list(std::string const& object_name,
                          std::string const& upload_key)
+      {
+        std::vector<S3::MultiPartChunk> res;
+        for (auto const& part: this->multipart_parts(object_name, upload_key))
+          if (part.size < 5 * 1024 * 1024)
+            ELLE_WARN("Multipart chunk %s/%s is too small: %s, dropping",
+                      part.chunk, part.etag, part.size);
+          else
+            res.emplace_back(part.chunk, part.etag);
+        return res;
+      }
+
+      std::vector<S3::MultiPartStored>
+      S3::multipart_parts(std::string const& object_name,
+                          std::string const& upload_key)
       {
         ELLE_TRACE_SCOPE("%s: LIST multipart chunks", *this);
 
-        std::vector<S3::MultiPartChunk> res;
-        int max_id = -1;
+        std::vector<S3::MultiPartStored> res;
+        auto marker = boost::optional<int>{};
         while (true)
         {
           RequestQuery query;
-           query["uploadId"] = upload_key;
-          if (max_id != -1)
-            query["part-number-marker"] = std::to_string(max_id);
+          query["uploadId"] = upload_key;
+          if (marker)
+            query["part-number-marker"] = std::to_string(*marker);
           auto url = elle::print("/%s/%s",
                                  this->_credentials.folder(),
                                  object_name);
@@ -457,31 +550,26 @@ namespace elle
           using boost::property_tree::ptree;
           ptree response;
           read_xml(*request, response);
-          for (auto const& part: response.get_child("ListPartsResult"))
+          auto const& result = response.get_child("ListPartsResult");
+          for (auto const& part: result)
           {
             if (part.first != "Part")
               continue;
-            MultiPartChunk chunk(part.second.get<int>("PartNumber") -1,
-                                 part.second.get<std::string>("ETag"));
-            ELLE_DUMP("listed chunk %s %s", chunk.first, chunk.second);
-            int size = part.second.get<int>("Size");
-            if (size < 5 * 1024 * 1024)
-            {
-              ELLE_WARN("Multipart chunk %s/%s is too small: %s, dropping",
-                        chunk.first, chunk.second, size);
-            }
-            else
-              res.push_back(chunk);
+            res.push_back(MultiPartStored{
+                part.second.get<int>("PartNumber") - 1,
+                part.second.get<std::string>("ETag"),
+                part.second.get<FileSize>("Size")});
+            ELLE_DUMP("listed chunk %s %s", res.back().chunk, res.back().etag);
           }
-          if (!response.get<bool>("ListPartsResult.IsTruncated", false))
+          if (!result.get<bool>("IsTruncated", false))
             return res;
-          // recompute max_id for next request
-          max_id = std::max_element(res.begin(), res.end(),
-            [] (MultiPartChunk const& a, MultiPartChunk const& b)
-            {
-              return a.first < b.first;
-            })->first + 1;
-          ELLE_DUMP("Marker for next iteration is %s", max_id);
+          // Pages hold up to 1000 parts, S3 tells where the next one starts.
+          auto const next = result.get_optional<int>("NextPartNumberMarker");
+          if (!next || (marker && *next <= *marker))
+            elle::err("%s: invalid part number marker listing %s",
+                      *this, object_name);
+          marker = next;
+          ELLE_DUMP("Marker for next iteration is %s", *marker);
         }
       }
 
@@ -498,14 +586,25 @@ namespace elle
         return elle::format::hexadecimal::encode(hashed);
       }
 
-      std::string
-      S3::_sha256_hexdigest(elle::ConstWeakBuffer const& buffer)
+      std::pair<std::string, std::string>
+      S3::_payload_digests(elle::ConstWeakBuffer const& buffer)
       {
-        auto hashed =
-          elle::cryptography::hash(
-            buffer,
-            elle::cryptography::Oneway::sha256);
-        return elle::format::hexadecimal::encode(hashed);
+        // Feed both functions block by block so the payload is read from
+        // memory once.
+        auto const block_size = std::size_t(64 * 1024);
+        auto offset = std::size_t(0);
+        auto digests = elle::cryptography::hash(
+          [&]
+          {
+            auto const size = std::min(block_size, buffer.size() - offset);
+            auto block = elle::ConstWeakBuffer(buffer.contents() + offset, size);
+            offset += size;
+            return block;
+          },
+          {elle::cryptography::Oneway::sha256,
+           elle::cryptography::Oneway::md5});
+        return {elle::format::hexadecimal::encode(digests[0]),
+                elle::format::base64::encode(digests[1]).string()};
       }
 
       std::string
@@ -526,6 +625,22 @@ namespace elle
                                  });
       }
 
+      std::string
+      S3::_signature(RequestTime const& request_time,
+                     CanonicalRequest const& canonical_request)
+      {
+        StringToSign string_to_sign(
+          this->_make_string_to_sign(
+            request_time, canonical_request.sha256_hash()));
+        // http://docs.aws.amazon.com/AmazonS3/latest/API/sig-v4-header-based-auth.html
+        aws::SigningKey key(this->_credentials.access_key_id(),
+                            this->_credentials.secret_access_key(),
+                            request_time,
+                            _credentials.region(),
+                            Service::s3);
+        return key.sign_message(string_to_sign.string());
+      }
+
       aws::StringToSign
       S3::_make_string_to_sign(RequestTime const& request_time,
                                std::string const& canonical_request_sha256)
@@ -570,22 +685,14 @@ namespace elle
       http::Request::Configuration
       S3::_initialize_request(RequestKind kind,
                               RequestTime request_time,
-                              CanonicalRequest const& canonical_request,
+                              std::string const& signature,
                               const RequestHeaders& initial_headers,
-                              Duration timeout)
+                              Duration timeout,
+                              std::size_t buffer_size)
       {
 
         // Make headers.
         RequestHeaders headers(initial_headers);
-        StringToSign string_to_sign(
-          this->_make_string_to_sign(
-            request_time, canonical_request.sha256_hash()));
-        // Make Authorization header.
-        // http://docs.aws.amazon.com/AmazonS3/latest/API/sig-v4-header-based-auth.html
-        aws::SigningKey key(this->_credentials.secret_access_key(),
-                            request_time,
-                            _credentials.region(),
-                            Service::s3);
         // Make authentication string.
         // Order matters for services like minio.
         // Add credential string.
@@ -600,8 +707,7 @@ namespace elle
           signed_headers_str.substr(0, signed_headers_str.size() - 1);
         auth_str += elle::print(", SignedHeaders=%s", signed_headers_str);
         // Add signature string.
-        auth_str += elle::print(", Signature=%s",
-                                key.sign_message(string_to_sign.string()));
+        auth_str += elle::print(", Signature=%s", signature);
         ELLE_DUMP("Final authorization string: '%s'", auth_str);
         headers["Authorization"] = auth_str;
 
@@ -616,12 +722,54 @@ namespace elle
           http::Request::Configuration(total_timeout,
                                        stall_timeout,
                                        http::Version::v11);
+        res.buffer_size(buffer_size);
         // Add headers to request.
         for (auto header: headers)
           res.header_add(header.first, header.second);
         return res;
       }
 
+      void
+      S3::_write_stream(http::Request& request,
+                        Stream const& stream,
+                        RequestTime const& request_time,
+                        std::string const& signature)
+      {
+        ChunkSigner signer(
+          aws::SigningKey(this->_credentials.access_key_id(),
+                          this->_credentials.secret_access_key(),
+                          request_time,
+                          this->_credentials.region(),
+                          Service::s3),
+          request_time,
+          CredentialScope(request_time, Service::s3,
+                          this->_credentials.region()),
+          signature);
+        auto block = elle::Buffer(stream.chunk_size);
+        auto sent = FileSize(0);
+        while (true)
+        {
+          auto const size =
+            std::size_t(std::min<FileSize>(stream.chunk_size,
+                                           stream.size - sent));
+          if (size)
+          {
+            stream.input.read(reinterpret_cast<char*>(block.mutable_contents()),
+                              size);
+            if (std::size_t(stream.input.gcount()) != size)
+              elle::err("%s: body ended after %s bytes instead of %s",
+                        *this, sent + stream.input.gcount(), stream.size);
+          }
+          auto const frame =
+            signer.chunk(elle::ConstWeakBuffer(block.contents(), size));
+          request.write(reinterpret_cast<char const*>(frame.contents()),
+                        frame.size());
+          if (!size)
+            break;
+          sent += size;
+        }
+      }
+
       /// Get the redirect host from the error message.
       /// See: http://docs.aws.amazon.com/AmazonS3/latest/dev/Redirects.html
 namespace
@@ -770,7 +918,9 @@ namespace
         std::string const& content_type,
         elle::ConstWeakBuffer const& payload,
         DurationOpt timeout_opt,
-        boost::optional<std::function<void (int)>> const& progress_callback
+        boost::optional<std::function<void (int)>> const& progress_callback,
+        std::size_t buffer_size,
+        Stream const* stream
         )
       {
         auto const timeout
@@ -782,8 +932,27 @@ namespace
         static int max_attempts = elle::os::getenv("INFINIT_S3_MAX_ATTEMPTS", 0);
         // If we receive a temporary redirect, we need to use a different host.
         auto override_host = boost::optional<std::string>{};
+        // Hash the payload once for all attempts. Streamed bodies are signed
+        // chunk by chunk as they are sent instead.
+        auto digests = std::pair<std::string, std::string>{};
+        if (stream)
+          digests.first = ChunkSigner::content_sha256;
+        else
+          digests = this->_payload_digests(payload);
+        auto const stream_start =
+          stream ? stream->input.tellg() : std::streampos(-1);
+        auto first = true;
         while (true)
         {
+          if (stream && !first)
+          {
+            stream->input.clear();
+            stream->input.seekg(stream_start);
+            if (stream_start == std::streampos(-1) || !stream->input)
+              elle::err("%s: unable to rewind the body of %s to retry",
+                        *this, operation);
+          }
+          first = false;
           URL const hostname(this->hostname(this->_credentials, override_host));
           // Ensure that we reset the override_host;
           override_host = boost::none;
@@ -795,7 +964,17 @@ namespace
           request_time -= this->_credentials.skew();
           RequestHeaders headers(extra_headers);
           headers["x-amz-date"] = this->_amz_date(request_time);
-          headers["x-amz-content-sha256"] = this->_sha256_hexdigest(payload);
+          headers["x-amz-content-sha256"] = digests.first;
+          if (payload.size() && !headers.count("Content-MD5"))
+            headers["Content-MD5"] = digests.second;
+          if (stream)
+          {
+            headers["Content-Encoding"] = "aws-chunked";
+            headers["Content-Length"] = std::to_string(
+              ChunkSigner::encoded_size(stream->size, stream->chunk_size));
+            headers["x-amz-decoded-content-length"] =
+              std::to_string(stream->size);
+          }
           if (this->_credentials.session_token())
           {
             headers["x-amz-security-token"] =
@@ -813,10 +992,16 @@ namespace
           // http://docs.aws.amazon.com/AmazonS3/latest/API/sig-v4-header-based-auth.html
           CanonicalRequest canonical_request(
             method, uri_encode(canonical_uri, false), query, headers,
-            this->_signed_headers(headers), this->_sha256_hexdigest(payload)
+            this->_signed_headers(headers), digests.first
           );
+          auto const signature =
+            this->_signature(request_time, canonical_request);
           http::Request::Configuration cfg(this->_initialize_request(
-            kind, request_time, canonical_request, headers, timeout));
+            kind, request_time, signature, headers, timeout,
+            buffer_size));
+          // Send streamed bodies as they are signed.
+          if (stream)
+            cfg.chunked_transfers(true);
           std::string full_url = elle::print(
             "%s%s%s",
             hostname.join(),
@@ -839,12 +1024,19 @@ namespace
                   progress_callback.get()(p.upload_current);
                 });
             }
-            if (payload.size())
+            if (stream)
+              this->_write_stream(*request, *stream, request_time, signature);
+            else if (payload.size())
             {
               request->write(reinterpret_cast<char const*>(payload.contents()),
                 payload.size());
             }
-            elle::reactor::wait(*request);
+            // Streamed bodies are read by the caller, only wait for the
+            // status.
+            if (kind == RequestKind::stream)
+              request->status();
+            else
+              elle::reactor::wait(*request);
           }
           catch (elle::reactor::network::Error const& e)
           {
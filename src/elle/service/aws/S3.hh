@@ -86,6 +86,18 @@ namespace elle
           RequestQuery const& query = {},
           StorageClass storage_class = StorageClass::Default,
           boost::optional<ProgressCallback> const& progress_callback = {});
+        /// Put an object of @a size bytes, read from @a object as it is sent.
+        ///
+        /// The body is signed chunk by chunk (STREAMING-AWS4-HMAC-SHA256-PAYLOAD)
+        /// so the upload starts without hashing the whole object first. Failed
+        /// attempts are only retried if @a object can be rewound.
+        /// @return the object ETag.
+        std::string
+        put_object(std::istream& object,
+                   FileSize size,
+                   std::string const& object_name,
+                   StorageClass storage_class = StorageClass::Default,
+                   std::size_t chunk_size = 64 * 1024);
 
         /// A list of all files names and their respective sizes inside
         /// the remote folder.
@@ -103,6 +115,17 @@ namespace elle
         elle::Buffer
         get_object(std::string const& object_name,
                    RequestHeaders headers = RequestHeaders());
+        /// Fetch an object, writing it to @a output as it is received.
+        ///
+        /// At most @a buffer_size bytes are held in memory: the download is
+        /// paused while @a output lags behind. The content is checked against
+        /// its ETag as it streams. Failures after the body started streaming
+        /// are not retried since @a output cannot be rewound.
+        void
+        get_object(std::string const& object_name,
+                   std::ostream& output,
+                   RequestHeaders headers = RequestHeaders(),
+                   std::size_t buffer_size = 4 * 1024 * 1024);
         /// Fetch one chunk of an object.
         elle::Buffer
         get_object_chunk(std::string const& object_name,
@@ -148,10 +171,26 @@ namespace elle
         multipart_abort(std::string const& object_name,
                         std::string const& upload_key);
 
+        /// List the parts of a multipart upload large enough to be
+        /// finalized, i.e. at least 5 MiB.
         std::vector<MultiPartChunk>
         multipart_list(std::string const& object_name,
                        std::string const& upload_key);
 
+        /// A part stored by a multipart upload.
+        struct MultiPartStored
+        {
+          /// The part number, from 0 as for multipart_upload.
+          int chunk;
+          std::string etag;
+          FileSize size;
+        };
+        /// List all parts stored by a multipart upload, following the
+        /// listing across pages.
+        std::vector<MultiPartStored>
+        multipart_parts(std::string const& object_name,
+                        std::string const& upload_key);
+
         /*-----------.
         | Attributes |
         `-----------*/
@@ -172,14 +211,22 @@ namespace elle
         enum class RequestKind
         {
           control, // Expected a small amount of data in/out
-          data // expected to transfer some amount of data in our out
+          data, // expected to transfer some amount of data in our out
+          stream, // like data, with the response read as it is received
         };
 
         std::string
         _md5_digest(elle::ConstWeakBuffer const& buffer);
 
+        /// The hexadecimal SHA-256 and base64 MD5 of a payload, computed in a
+        /// single pass.
+        std::pair<std::string, std::string>
+        _payload_digests(elle::ConstWeakBuffer const& buffer);
+
+        /// The signature of a request.
         std::string
-        _sha256_hexdigest(elle::ConstWeakBuffer const& buffer);
+        _signature(RequestTime const& request_time,
+                   CanonicalRequest const& canonical_request);
 
         std::string
         _amz_date(RequestTime const& request_time);
@@ -197,9 +244,10 @@ namespace elle
         elle::reactor::http::Request::Configuration
         _initialize_request(RequestKind kind,
                             RequestTime request_time,
-                            CanonicalRequest const& canonical_request,
+                            std::string const& signature,
                             const RequestHeaders& initial_headers,
-                            Duration timeout);
+                            Duration timeout,
+                            std::size_t buffer_size = 0);
 
         /// Check return code and throw appropriate exception if error
         /// ELLE_WARN the request response in case of error
@@ -208,6 +256,21 @@ namespace elle
         _check_request_status(elle::reactor::http::Request& request,
                               std::string const& operation);
 
+        /// A body sent with STREAMING-AWS4-HMAC-SHA256-PAYLOAD.
+        struct Stream
+        {
+          std::istream& input;
+          FileSize size;
+          std::size_t chunk_size;
+        };
+
+        /// Sign and send a streamed body.
+        void
+        _write_stream(elle::reactor::http::Request& request,
+                      Stream const& stream,
+                      RequestTime const& request_time,
+                      std::string const& signature);
+
         /// Build and emit request, retries in case of credentials expiry kind
         /// is used to switch between global duration timeout and stall timeout.
         std::unique_ptr<elle::reactor::http::Request>
@@ -221,7 +284,9 @@ namespace elle
           std::string const& content_type = "application/json",
           elle::ConstWeakBuffer const& payload = elle::ConstWeakBuffer(),
           DurationOpt timeout = {},
-          boost::optional<ProgressCallback> const& progress_callback = {});
+          boost::optional<ProgressCallback> const& progress_callback = {},
+          std::size_t buffer_size = 0,
+          Stream const* stream = nullptr);
 
         /*----------.
         | Printable |
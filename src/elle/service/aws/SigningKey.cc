@@ -1,3 +1,7 @@
+#include <mutex>
+#include <unordered_map>
+
+#include <elle/cryptography/hash.hh>
 #include <elle/cryptography/hmac.hh>
 #include <elle/format/hexadecimal.hh>
 #include <elle/printf.hh>
@@ -41,6 +45,47 @@ namespace elle
         return k_signing;
       }
 
+      /// Signing keys only depend on the day, so derive them once per day,
+      /// access key, region and service rather than once per request.
+      ///
+      /// Entries are indexed by a digest of these, and dropped when the day
+      /// changes.
+      static
+      elle::Buffer
+      _cached_digest(std::string const& aws_access_key_id,
+                     std::string const& aws_secret,
+                     RequestTime const& request_time,
+                     std::string const& aws_region,
+                     Service const& aws_service)
+      {
+        static std::mutex mutex;
+        static std::string day;
+        static std::unordered_map<std::string, elle::Buffer> cache;
+        auto const date = date::format("%Y%m%d", request_time);
+        auto const key = elle::cryptography::hash(
+          elle::sprintf("%s\n%s\n%s\n%s",
+                        aws_access_key_id, date, aws_region, aws_service),
+          elle::cryptography::Oneway::sha256).string();
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(key);
+        if (it != cache.end())
+          return it->second;
+        // Requests from before the day changed are rare, don't cache them.
+        if (date < day)
+          return
+            _create_digest(aws_secret, request_time, aws_region, aws_service);
+        // Keys of past days are never used again.
+        if (date > day || cache.size() >= 64)
+        {
+          cache.clear();
+          day = date;
+        }
+        auto digest =
+          _create_digest(aws_secret, request_time, aws_region, aws_service);
+        cache.emplace(key, digest);
+        return digest;
+      }
+
       SigningKey::SigningKey(std::string const& aws_secret,
                              RequestTime const& request_time,
                              std::string const& aws_region,
@@ -48,6 +93,15 @@ namespace elle
         _key(_create_digest(aws_secret, request_time, aws_region, aws_service))
       {}
 
+      SigningKey::SigningKey(std::string const& aws_access_key_id,
+                             std::string const& aws_secret,
+                             RequestTime const& request_time,
+                             std::string const& aws_region,
+                             Service const& aws_service):
+        _key(_cached_digest(aws_access_key_id, aws_secret, request_time,
+                            aws_region, aws_service))
+      {}
+
       std::string
       SigningKey::sign_message(std::string const& message)
       {
@@ -25,6 +25,12 @@ namespace elle
                    RequestTime const& request_time,
                    std::string const& aws_region,
                    Service const& aws_service);
+        /// Derive the key once per day, access key, region and service.
+        SigningKey(std::string const& aws_access_key_id,
+                   std::string const& aws_secret,
+                   RequestTime const& request_time,
+                   std::string const& aws_region,
+                   Service const& aws_service);
 
         std::string
         sign_message(std::string const& message);
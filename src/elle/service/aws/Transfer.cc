@@ -0,0 +1,245 @@
+#include <elle/service/aws/Transfer.hh>
+
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <unordered_map>
+
+#include <elle/With.hh>
+#include <elle/err.hh>
+#include <elle/log.hh>
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/scheduler.hh>
+#include <elle/reactor/signal.hh>
+
+ELLE_LOG_COMPONENT("elle.services.aws.Transfer");
+
+namespace elle
+{
+  namespace service
+  {
+    namespace aws
+    {
+      namespace
+      {
+        /// The maximum number of parts of a multipart upload.
+        auto const parts_maximum = S3::FileSize(10000);
+        /// The minimum size of all parts but the last one.
+        auto const part_size_floor = std::size_t(5 * 1024 * 1024);
+
+        int
+        parts(S3::FileSize size, std::size_t part_size)
+        {
+          return std::max(1, int((size + part_size - 1) / part_size));
+        }
+      }
+
+      /*-------------.
+      | Construction |
+      `-------------*/
+
+      Transfer::Transfer(S3& s3, int concurrency)
+        : _s3(s3)
+        , _concurrency(concurrency)
+        , _part_size_minimum(8 * 1024 * 1024)
+        , _attempts(5)
+        , _backoff(std::chrono::milliseconds(200))
+      {}
+
+      /*----------.
+      | Transfers |
+      `----------*/
+
+      std::size_t
+      Transfer::part_size(S3::FileSize size) const
+      {
+        auto const mib = S3::FileSize(1024 * 1024);
+        auto res = std::max<S3::FileSize>(
+          std::max(this->_part_size_minimum, part_size_floor),
+          (size + parts_maximum - 1) / parts_maximum);
+        // Round up to a MiB.
+        return std::size_t((res + mib - 1) / mib * mib);
+      }
+
+      template <typename F>
+      auto
+      Transfer::_attempt(std::string const& operation, F const& f)
+        -> decltype(f())
+      {
+        auto delay = this->_backoff;
+        for (int attempt = 1;; ++attempt)
+        {
+          try
+          {
+            return f();
+          }
+          catch (AWSException const& e)
+          {
+            if (attempt >= this->_attempts)
+              throw;
+            ELLE_WARN("%s: %s failed (attempt %s): %s",
+                      this, operation, attempt, e.what());
+          }
+          elle::reactor::sleep(delay);
+          delay *= 2;
+        }
+      }
+
+      std::string
+      Transfer::upload(std::string const& object_name,
+                       S3::FileSize size,
+                       Source const& source)
+      {
+        auto upload_key = this->_s3.multipart_initialize(object_name);
+        this->upload(object_name, upload_key, size, source);
+        return upload_key;
+      }
+
+      void
+      Transfer::upload(std::string const& object_name,
+                       std::string const& upload_key,
+                       S3::FileSize size,
+                       Source const& source)
+      {
+        auto const part_size = this->part_size(size);
+        auto const count = parts(size, part_size);
+        ELLE_TRACE_SCOPE("%s: upload %s in %s parts of %s bytes",
+                         this, object_name, count, part_size);
+        auto etags = std::unordered_map<int, std::string>{};
+        for (auto const& part: this->_s3.multipart_parts(object_name,
+                                                         upload_key))
+        {
+          // Parts past the end are left out of the object.
+          if (part.chunk >= count)
+            continue;
+          // Parts stored with another part size do not fit: replace them.
+          auto const offset = S3::FileSize(part.chunk) * part_size;
+          auto const length = std::min<S3::FileSize>(part_size, size - offset);
+          if (part.size == length)
+            etags.emplace(part.chunk, part.etag);
+          else
+            ELLE_WARN("%s: stored part %s has %s bytes instead of %s",
+                      this, part.chunk, part.size, length);
+        }
+        if (!etags.empty())
+          ELLE_TRACE("%s: resume with %s parts already uploaded",
+                     this, etags.size());
+        auto next = 0;
+        elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+        {
+          for (int i = 0; i < std::min(this->_concurrency, count); ++i)
+            scope.run_background(
+              elle::sprintf("%s: upload worker %s", this, i),
+              [&]
+              {
+                while (next < count)
+                {
+                  auto const part = next++;
+                  if (etags.count(part))
+                    continue;
+                  auto const offset = S3::FileSize(part) * part_size;
+                  auto const length =
+                    std::size_t(std::min<S3::FileSize>(part_size,
+                                                       size - offset));
+                  auto const data = source(offset, length);
+                  if (data.size() != length)
+                    elle::err("%s: source yielded %s bytes instead of %s",
+                              this, data.size(), length);
+                  etags[part] = this->_attempt(
+                    elle::sprintf("upload of part %s", part),
+                    [&]
+                    {
+                      return this->_s3.multipart_upload(
+                        object_name, upload_key, data, part);
+                    });
+                  ELLE_DEBUG("%s: uploaded part %s", this, part);
+                }
+              });
+          elle::reactor::wait(scope);
+        };
+        auto chunks = std::vector<S3::MultiPartChunk>(etags.begin(),
+                                                      etags.end());
+        std::sort(chunks.begin(), chunks.end());
+        this->_s3.multipart_finalize(object_name, upload_key, chunks);
+      }
+
+      void
+      Transfer::download(std::string const& object_name,
+                         S3::FileSize size,
+                         std::ostream& output)
+      {
+        if (size == 0)
+          return;
+        auto const part_size = this->part_size(size);
+        auto const count = parts(size, part_size);
+        ELLE_TRACE_SCOPE("%s: download %s in %s parts of %s bytes",
+                         this, object_name, count, part_size);
+        // Parts fetched and not yet written, at most concurrency of them
+        // including those being fetched.
+        auto fetched = std::map<int, elle::Buffer>{};
+        auto next_fetch = 0;
+        auto next_write = 0;
+        auto available = elle::reactor::Signal("part available");
+        auto written = elle::reactor::Signal("part written");
+        elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+        {
+          for (int i = 0; i < std::min(this->_concurrency, count); ++i)
+            scope.run_background(
+              elle::sprintf("%s: download worker %s", this, i),
+              [&]
+              {
+                while (next_fetch < count)
+                {
+                  auto const part = next_fetch++;
+                  while (part >= next_write + this->_concurrency)
+                    elle::reactor::wait(written);
+                  auto const offset = S3::FileSize(part) * part_size;
+                  auto const length =
+                    std::min<S3::FileSize>(part_size, size - offset);
+                  auto data = this->_attempt(
+                    elle::sprintf("download of part %s", part),
+                    [&]
+                    {
+                      return this->_s3.get_object_chunk(
+                        object_name, offset, length);
+                    });
+                  if (data.size() != length)
+                    elle::err("%s: part %s has %s bytes instead of %s",
+                              this, part, data.size(), length);
+                  ELLE_DEBUG("%s: downloaded part %s", this, part);
+                  fetched.emplace(part, std::move(data));
+                  available.signal();
+                }
+              });
+          while (next_write < count)
+          {
+            auto it = fetched.find(next_write);
+            if (it == fetched.end())
+            {
+              elle::reactor::wait(available);
+              continue;
+            }
+            output.write(reinterpret_cast<char const*>(it->second.contents()),
+                         it->second.size());
+            if (!output)
+              elle::err("%s: unable to write %s", this, object_name);
+            fetched.erase(it);
+            ++next_write;
+            written.signal();
+          }
+          elle::reactor::wait(scope);
+        };
+      }
+
+      /*----------.
+      | Printable |
+      `----------*/
+
+      void
+      Transfer::print(std::ostream& stream) const
+      {
+        elle::fprintf(stream, "Transfer(%s)", this->_s3);
+      }
+    }
+  }
+}
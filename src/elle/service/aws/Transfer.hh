@@ -0,0 +1,113 @@
+#pragma once
+
+#include <functional>
+#include <iosfwd>
+
+#include <elle/Buffer.hh>
+#include <elle/Printable.hh>
+#include <elle/attribute.hh>
+#include <elle/service/aws/S3.hh>
+
+namespace elle
+{
+  namespace service
+  {
+    namespace aws
+    {
+      /// Transfer large objects through concurrent part requests.
+      ///
+      /// Uploads are split in parts sent concurrently as a multipart upload.
+      /// An interrupted upload resumes from the parts S3 already stored,
+      /// sending again those stored with a different part size.
+      /// Downloads fetch concurrent byte ranges and write them in order. In
+      /// both directions, at most `concurrency` parts are held in memory.
+      ///
+      /// Failed parts are retried `attempts` times, waiting `backoff` and then
+      /// twice as long after each failure.
+      ///
+      /// @code{.cc}
+      ///
+      /// elle::service::aws::Transfer transfer(s3);
+      /// transfer.upload("object", size,
+      ///                 [&] (S3::FileSize offset, std::size_t size)
+      ///                 {
+      ///                   return read(file, offset, size);
+      ///                 });
+      /// std::ofstream output("object");
+      /// transfer.download("object", size, output);
+      ///
+      /// @endcode
+      class Transfer
+        : public elle::Printable
+      {
+      /*-------------.
+      | Construction |
+      `-------------*/
+      public:
+        /// Create a Transfer.
+        ///
+        /// @param s3          The S3 bucket to transfer objects with.
+        /// @param concurrency The number of parts transferred concurrently.
+        Transfer(S3& s3, int concurrency = 8);
+
+      /*----------.
+      | Transfers |
+      `----------*/
+      public:
+        /// Read @a size bytes at @a offset of the content to upload.
+        using Source =
+          std::function<elle::Buffer (S3::FileSize offset, std::size_t size)>;
+        /// Upload an object through a new multipart upload.
+        ///
+        /// @return The upload key, to resume the upload if it fails.
+        std::string
+        upload(std::string const& object_name,
+               S3::FileSize size,
+               Source const& source);
+        /// Upload an object through an existing multipart upload, skipping
+        /// parts already stored.
+        void
+        upload(std::string const& object_name,
+               std::string const& upload_key,
+               S3::FileSize size,
+               Source const& source);
+        /// Download an object of @a size bytes into @a output.
+        void
+        download(std::string const& object_name,
+                 S3::FileSize size,
+                 std::ostream& output);
+        /// The size of parts used to transfer @a size bytes.
+        ///
+        /// Parts are at least `part_size_minimum` large, and large enough for
+        /// the object to fit in the 10000 parts S3 accepts.
+        std::size_t
+        part_size(S3::FileSize size) const;
+      private:
+        template <typename F>
+        auto
+        _attempt(std::string const& operation, F const& f) -> decltype(f());
+        ELLE_ATTRIBUTE(S3&, s3);
+
+      /*--------------.
+      | Configuration |
+      `--------------*/
+      public:
+        /// The number of parts transferred concurrently.
+        ELLE_ATTRIBUTE_RW(int, concurrency);
+        /// The minimum size of parts, no smaller than the 5 MiB S3 accepts.
+        ELLE_ATTRIBUTE_RW(std::size_t, part_size_minimum);
+        /// The number of attempts for each part.
+        ELLE_ATTRIBUTE_RW(int, attempts);
+        /// The delay before the first retry of a part.
+        ELLE_ATTRIBUTE_RW(Duration, backoff);
+
+      /*----------.
+      | Printable |
+      `----------*/
+      public:
+        void
+        print(std::ostream& stream) const override;
+      };
+    }
+  }
+}
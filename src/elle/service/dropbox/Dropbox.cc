@@ -1,4 +1,5 @@
 #include <elle/IntRange.hh>
+#include <elle/err.hh>
 #include <elle/find.hh>
 #include <elle/log.hh>
 #include <elle/reactor/Barrier.hh>
@@ -8,41 +9,12 @@
 #include <elle/reactor/scheduler.hh>
 #include <elle/serialization/json.hh>
 #include <elle/service/dropbox/Dropbox.hh>
+#include <elle/service/dropbox/MetadataCache.hh>
 
 ELLE_LOG_COMPONENT("elle.services.dropbox.Dropbox");
 
 namespace bfs = boost::filesystem;
 
-std::string
-to_lower(bfs::path const& p)
-{
-  return boost::to_lower_copy(p.string());
-}
-
-struct HashPath
-{
-  size_t
-  operator()(bfs::path const& p) const
-  {
-    return std::hash<std::string>()(to_lower(p));
-  }
-};
-
-struct ComparePath
-{
-  size_t
-  operator()(bfs::path const& lhs,
-             bfs::path const& rhs) const
-  {
-    return to_lower(lhs) == to_lower(rhs);
-  }
-};
-
-/// A case insensitive map of paths.
-template <typename Value>
-using PathMap
-  = std::unordered_map<bfs::path, Value, HashPath, ComparePath>;
-
 ELLE_DAS_SERIALIZE(elle::service::dropbox::Longpoll);
 ELLE_DAS_SERIALIZE(elle::service::dropbox::Delta);
 
@@ -81,11 +53,10 @@ namespace elle
         : public Dropbox::Cache
       {
       public:
-        LongPollCache(Dropbox& dropbox, bool full = true)
+        LongPollCache(Dropbox& dropbox, bfs::path const& root, bool full = true)
           : _dropbox(dropbox)
-          , _full(full)
           , _initialized()
-          , _metadata()
+          , _metadata(root, full)
           , _poll_thread(elle::sprintf("%s poll thread", *this),
                          [this] { this->_poll(); })
         {}
@@ -99,13 +70,13 @@ namespace elle
         boost::optional<Metadata>
         metadata(bfs::path const& path) override
         {
-          if (auto it = elle::find(this->_metadata, path))
+          if (auto res = this->_metadata.find(path))
           {
             ELLE_DEBUG_SCOPE("%s: retreive metadata for %s", *this, path);
-            ELLE_DUMP("%s: %s", *this, it->second);
-            return it->second;
+            ELLE_DUMP("%s: %s", *this, res.get());
+            return res;
           }
-          else if (this->_full)
+          else if (this->_metadata.full())
             throw NoSuchFile(path);
           else
             // FIXME: even if not full, if we have the parent directory we can
@@ -117,108 +88,43 @@ namespace elle
         metadata_update(bfs::path const&,
                         Metadata value) override
         {
-          bfs::path path(value.path);
-          ELLE_DEBUG_SCOPE("%s: store metadata for %s", *this, path);
-          { ELLE_DUMP("%s: %s", *this, value); } // Braces for gcc warnings.
-          // Update metadata
-          {
-            // Preserve previously registered folder content.
-            if (value.is_dir && !value.contents)
-              if (auto it = elle::find(this->_metadata, path))
-              {
-                ELLE_DEBUG("%s: preserve contents: %s",
-                           *this, it->second.contents);
-                value.contents = std::move(it->second.contents);
-              }
-            this->_metadata[path] = value;
-          }
-          // Update parent metadata
-          auto parent_path = path.parent_path();
-          ELLE_DEBUG("%s: register in parent metadata: %s", *this, parent_path)
-          {
-            auto it = this->_metadata.find(parent_path);
-            if (it == this->_metadata.end())
-            {
-              if (!this->_full || parent_path == "/")
-                return;
-              ELLE_DEBUG("%s: create parent folder metadata: %s", *this,
-                         parent_path);
-              Metadata m;
-              m.is_dir = true;
-              m.path = parent_path.string();
-              m.bytes = 0;
-              it = this->_metadata.emplace(parent_path, std::move(m)).first;
-            }
-            auto& parent_metadata = it->second;
-            if (parent_metadata.is_dir)
-            {
-              if (!parent_metadata.contents)
-                parent_metadata.contents.emplace();
-              Metadata::Content content;
-              content.path = std::move(value.path);
-              content.is_dir = value.is_dir;
-              content.bytes = value.bytes;
-              content.client_mtime = value.client_mtime;
-              content.modified = value.modified;
-              for (auto& entry: parent_metadata.contents.get())
-                if (entry.path == path)
-                {
-                  ELLE_DEBUG("%s: update metadata in %s", *this, parent_path);
-                  entry = std::move(content);
-                  return;
-                }
-              ELLE_DEBUG("%s: push metadata in %s", *this, parent_path);
-              parent_metadata.contents.get().emplace_back(std::move(content));
-            }
-            else
-              ELLE_ERR("%s: parent path %s metadata is not a directory: %s",
-                       *this, parent_path, parent_metadata);
-          }
+          this->_metadata.update(std::move(value));
         }
 
         void
         metadata_delete(bfs::path const& path) override
         {
-          ELLE_DEBUG_SCOPE("%s: delete metadata for %s", *this, path);
-          this->_metadata.erase(path);
-          auto parent_path = path.parent_path();
-          if (auto it = elle::find(this->_metadata, parent_path))
-          {
-            auto& parent_metadata = it->second;
-            if (parent_metadata.is_dir && parent_metadata.contents)
-            {
-              auto& contents = parent_metadata.contents.get();
-              for (auto it = contents.begin(); it != contents.end(); ++it)
-                if (it->path == path)
-                {
-                  ELLE_DEBUG_SCOPE("%s: delete metadata in %s",
-                                   *this, parent_path);
-                  contents.erase(it);
-                  break;
-                }
-            }
-          }
+          this->_metadata.remove(path);
         }
 
       private:
         void
         _poll()
         {
-          if (this->_full)
+          this->_metadata.load();
+          if (!this->_metadata.cursor().empty())
+            // Serve the persisted metadata and catch up in the background.
+            this->_initialized.open();
+          if (this->_metadata.full())
           {
             this->_apply_delta();
             // Fetch "/" manually as it is not returned by the intial delta.
-            this->_full = false;
-            this->_dropbox.metadata("/");
-            this->_full = true;
+            if (!this->_metadata.find("/"))
+            {
+              this->_metadata.full(false);
+              this->_dropbox.metadata("/");
+              this->_metadata.full(true);
+            }
           }
-          else
-            this->_cursor = this->_dropbox.delta_latest_cursor();
-          this->_initialized.open();
+          else if (this->_metadata.cursor().empty())
+            this->_metadata.cursor(this->_dropbox.delta_latest_cursor());
+          if (!this->_initialized.opened())
+            this->_initialized.open();
           while (true)
           {
             ELLE_TRACE_SCOPE("%s: longpoll", *this);
-            auto longpoll = this->_dropbox.longpoll_delta(this->_cursor);
+            auto longpoll =
+              this->_dropbox.longpoll_delta(this->_metadata.cursor());
             if (longpoll.changes)
             {
               ELLE_TRACE_SCOPE("%s: longpoll signalled changes", *this);
@@ -242,29 +148,16 @@ namespace elle
           Delta delta;
           do
           {
-            delta = this->_dropbox.delta(this->_cursor);
-            if (!this->_cursor.empty() && delta.reset)
-            {
-              ELLE_ABORT("delta asked to reset the whole thing, "
-                         "not implemented yet");
-            }
-            ELLE_DEBUG("%s: new cursor: %s", *this, delta.cursor);
-            this->_cursor = delta.cursor;
-            for (auto const& entry: delta.entries)
-              if (entry.second)
-                this->metadata_update(entry.first, entry.second.get());
-              else
-                this->metadata_delete(entry.first);
+            delta = this->_dropbox.delta(this->_metadata.cursor());
+            this->_metadata.apply(delta);
           }
           while (delta.has_more);
         }
 
         ELLE_ATTRIBUTE(Dropbox&, dropbox);
-        ELLE_ATTRIBUTE(bool, full);
         ELLE_ATTRIBUTE_RX(elle::reactor::Barrier, initialized);
-        ELLE_ATTRIBUTE(PathMap<Metadata>, metadata);
+        ELLE_ATTRIBUTE(MetadataCache, metadata);
         ELLE_ATTRIBUTE(elle::reactor::Thread, poll_thread);
-        ELLE_ATTRIBUTE(std::string, cursor);
       };
 
       class Dropbox::FileCache
@@ -351,7 +244,8 @@ namespace elle
           conf.header_add(
             "Range",
             elle::sprintf("bytes=%s-%s", range.start(), range.end() - 1));
-          auto data = this->_dropbox._get(this->_path, std::move(conf));
+          auto data =
+            this->_dropbox._get(this->_path, std::move(conf)).response();
           if (signed(data.size()) != range.size())
           {
             ELLE_ERR("%s: fetched data size mismatch (%s instead of %s), "
@@ -387,10 +281,10 @@ namespace elle
         : Error(path, "no such file")
       {}
 
-      Dropbox::Dropbox(std::string token, int block_size)
+      Dropbox::Dropbox(std::string token, int block_size, bfs::path cache)
         : _token(std::move(token))
         , _block_size(block_size)
-        , _cache(new LongPollCache(*this))
+        , _cache(new LongPollCache(*this, cache))
       {
         elle::reactor::wait(
           static_cast<LongPollCache*>(this->_cache.get())->initialized());
@@ -480,7 +374,10 @@ namespace elle
       elle::Buffer
       Dropbox::get(bfs::path const& path) const
       {
-        return this->_get(path, elle::reactor::http::Request::Configuration());
+        auto r = this->_get(path, elle::reactor::http::Request::Configuration());
+        auto res = r.response();
+        ELLE_DEBUG("%s: got %s bytes", *this, res.size());
+        return res;
       }
 
       elle::Buffer
@@ -499,7 +396,25 @@ namespace elle
         return elle::Buffer(it->second._contents.contents() + offset, size);
       }
 
-      elle::Buffer
+      void
+      Dropbox::get(bfs::path const& path,
+                   std::ostream& output,
+                   std::size_t buffer_size) const
+      {
+        auto conf = elle::reactor::http::Request::Configuration();
+        conf.buffer_size(buffer_size);
+        auto r = this->_get(path, std::move(conf));
+        auto const written =
+          std::copy(std::istreambuf_iterator<char>(r),
+                    std::istreambuf_iterator<char>(),
+                    std::ostreambuf_iterator<char>(output));
+        // Report failures that occurred after the headers were received.
+        r.wait();
+        if (written.failed())
+          elle::err("%s: unable to write %s", *this, path.string());
+      }
+
+      elle::reactor::http::Request
       Dropbox::_get(bfs::path const& path,
                     elle::reactor::http::Request::Configuration conf) const
       {
@@ -518,11 +433,7 @@ namespace elle
 
         if (r.status() == elle::reactor::http::StatusCode::OK ||
             r.status() == elle::reactor::http::StatusCode::Partial_Content)
-        {
-          auto res = r.response();
-          ELLE_DEBUG("%s: got %s bytes", *this, res.size());
-          return res;
-        }
+          return r;
         else if (r.status() == elle::reactor::http::StatusCode::Not_Found)
         {
           ELLE_TRACE("%s: file not found", *this);
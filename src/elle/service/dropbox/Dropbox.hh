@@ -134,7 +134,14 @@ namespace elle
       class Dropbox
       {
       public:
-        Dropbox(std::string token, int block_size = 1048576);
+        /// Create a Dropbox client.
+        ///
+        /// @param cache A directory where metadata is persisted across
+        ///              restarts, so they only fetch changes since the last
+        ///              run. Empty to keep metadata in memory only.
+        Dropbox(std::string token,
+                int block_size = 1048576,
+                boost::filesystem::path cache = {});
         ~Dropbox();
 
         AccountInfo
@@ -156,6 +163,13 @@ namespace elle
         elle::Buffer
         get(boost::filesystem::path const& path, int offset, int size) const;
 
+        /// Fetch a file, writing it to @a output as it is received and
+        /// holding at most @a buffer_size bytes in memory.
+        void
+        get(boost::filesystem::path const& path,
+            std::ostream& output,
+            std::size_t buffer_size = 4 * 1024 * 1024) const;
+
         bool
         put(boost::filesystem::path const& path,
             elle::WeakBuffer const& content,
@@ -208,7 +222,8 @@ namespace elle
         void
         _check_path(boost::filesystem::path const& path) const;
 
-        elle::Buffer
+        /// A request fetching a file, whose body is yet to be read.
+        elle::reactor::http::Request
         _get(boost::filesystem::path const& path,
              elle::reactor::http::Request::Configuration conf) const;
 
@@ -0,0 +1,616 @@
+#include <elle/service/dropbox/MetadataCache.hh>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef ELLE_WINDOWS
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <elle/err.hh>
+#include <elle/find.hh>
+#include <elle/log.hh>
+#include <elle/serialization/binary.hh>
+
+ELLE_LOG_COMPONENT("elle.services.dropbox.MetadataCache");
+
+namespace bfs = boost::filesystem;
+
+namespace elle
+{
+  namespace service
+  {
+    namespace dropbox
+    {
+      namespace
+      {
+        /// Metadata as persisted, without directory contents: they are
+        /// rebuilt from the entries of the children.
+        struct StoredMetadata
+        {
+          StoredMetadata() = default;
+
+          StoredMetadata(Metadata const& m)
+            : path(m.path)
+            , is_dir(m.is_dir)
+            , bytes(m.bytes)
+            , client_mtime(m.client_mtime)
+            , modified(m.modified)
+            , read_only(m.read_only)
+          {}
+
+          Metadata
+          metadata() const
+          {
+            Metadata res;
+            res.path = this->path;
+            res.is_dir = this->is_dir;
+            res.bytes = this->bytes;
+            res.client_mtime = this->client_mtime;
+            res.modified = this->modified;
+            res.read_only = this->read_only;
+            return res;
+          }
+
+          void
+          serialize(elle::serialization::Serializer& s)
+          {
+            s.serialize("path", this->path);
+            s.serialize("is_dir", this->is_dir);
+            s.serialize("bytes", this->bytes);
+            s.serialize("client_mtime", this->client_mtime);
+            s.serialize("modified", this->modified);
+            s.serialize("read_only", this->read_only);
+          }
+
+          std::string path;
+          bool is_dir;
+          int64_t bytes;
+          boost::optional<std::string> client_mtime;
+          boost::optional<std::string> modified;
+          boost::optional<bool> read_only;
+        };
+
+        /// The changes of a delta page, as journaled.
+        struct Page
+        {
+          void
+          serialize(elle::serialization::Serializer& s)
+          {
+            s.serialize("cursor", this->cursor);
+            s.serialize("updates", this->updates);
+            s.serialize("deletes", this->deletes);
+          }
+
+          std::string cursor;
+          std::vector<StoredMetadata> updates;
+          std::vector<std::string> deletes;
+        };
+
+        /// All entries at a given cursor.
+        struct Snapshot
+        {
+          void
+          serialize(elle::serialization::Serializer& s)
+          {
+            s.serialize("cursor", this->cursor);
+            s.serialize("generation", this->generation);
+            s.serialize("entries", this->entries);
+          }
+
+          std::string cursor;
+          /// The journal holding the pages applied since.
+          int generation = 0;
+          std::vector<StoredMetadata> entries;
+        };
+
+        [[noreturn]]
+        void
+        fail(std::string const& action)
+        {
+          elle::err("unable to %s: %s", action, std::strerror(errno));
+        }
+
+        void
+        sync(int fd, bfs::path const& path)
+        {
+#ifdef ELLE_WINDOWS
+          if (::_commit(fd) != 0)
+#else
+          if (::fsync(fd) != 0)
+#endif
+            fail(elle::sprintf("sync %s", path));
+        }
+
+        void
+        write_all(int fd, elle::ConstWeakBuffer data, bfs::path const& path)
+        {
+          auto p = data.contents();
+          auto size = data.size();
+          while (size)
+          {
+            auto const written = ::write(fd, p, size);
+            if (written < 0)
+            {
+              if (errno == EINTR)
+                continue;
+              fail(elle::sprintf("write %s", path));
+            }
+            p += written;
+            size -= written;
+          }
+        }
+
+        int
+        open(bfs::path const& path, bool append)
+        {
+#ifdef ELLE_WINDOWS
+          auto const fd = ::_open(
+            path.string().c_str(),
+            _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC),
+            _S_IREAD | _S_IWRITE);
+#else
+          auto const fd = ::open(
+            path.string().c_str(),
+            O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC),
+            0600);
+#endif
+          if (fd < 0)
+            fail(elle::sprintf("open %s", path));
+          return fd;
+        }
+
+        /// Make the creation, removal or renaming of entries in @a dir
+        /// durable.
+        void
+        sync_directory(bfs::path const& dir)
+        {
+#ifndef ELLE_WINDOWS
+          auto const fd = ::open(dir.string().c_str(), O_RDONLY | O_CLOEXEC);
+          if (fd < 0)
+            fail(elle::sprintf("open %s", dir));
+          auto const res = ::fsync(fd);
+          ::close(fd);
+          if (res != 0)
+            fail(elle::sprintf("sync %s", dir));
+#endif
+        }
+      }
+
+      /// Persist the metadata of a MetadataCache in a directory: a snapshot
+      /// of all entries and a journal of the delta pages applied since.
+      ///
+      /// Journal records are prefixed with their size, appended and synced
+      /// before the page is considered applied, so a crash can only lose the
+      /// last, incomplete record, which is dropped on load. Once the journal
+      /// outgrows the snapshot, a new snapshot is synced, renamed over the old
+      /// one and the rename synced before the journal is dropped, so a crash
+      /// in between replays either the old snapshot and journal or the new
+      /// snapshot alone.
+      class MetadataStore
+      {
+      public:
+        MetadataStore(bfs::path root)
+          : _root(std::move(root))
+          , _generation(0)
+          , _journal(-1)
+          , _journal_size(0)
+          , _snapshot_size(0)
+        {
+          bfs::create_directories(this->_root);
+        }
+
+        ~MetadataStore()
+        {
+          if (this->_journal >= 0)
+            ::close(this->_journal);
+        }
+
+        /// Load the snapshot and replay the journal.
+        ///
+        /// @return The cursor of the last change applied.
+        std::string
+        load(std::function<void (Metadata)> const& update,
+             std::function<void (bfs::path const&)> const& remove)
+        {
+          ELLE_TRACE_SCOPE("%s: load", *this);
+          auto cursor = std::string{};
+          auto const snapshot_path = this->_root / "snapshot";
+          if (bfs::exists(snapshot_path))
+          {
+            std::ifstream input(snapshot_path.string(), std::ios::binary);
+            auto snapshot =
+              elle::serialization::binary::deserialize<Snapshot>(input, false);
+            ELLE_DEBUG("%s: %s entries at generation %s",
+                       *this, snapshot.entries.size(), snapshot.generation);
+            this->_snapshot_size = bfs::file_size(snapshot_path);
+            this->_generation = snapshot.generation;
+            cursor = std::move(snapshot.cursor);
+            for (auto const& entry: snapshot.entries)
+              update(entry.metadata());
+          }
+          this->_remove_journals();
+          auto const journal_path = this->_journal_path();
+          auto valid = uint64_t(0);
+          auto torn = false;
+          if (bfs::exists(journal_path))
+          {
+            std::ifstream input(journal_path.string(), std::ios::binary);
+            auto pages = 0;
+            while (true)
+            {
+              uint32_t size;
+              if (!input.read(reinterpret_cast<char*>(&size), sizeof(size)))
+                break;
+              auto record = elle::Buffer(size);
+              if (!input.read(reinterpret_cast<char*>(
+                                record.mutable_contents()), size))
+                break;
+              Page page;
+              try
+              {
+                page = elle::serialization::binary::deserialize<Page>(
+                  record, false);
+              }
+              catch (elle::serialization::Error const& e)
+              {
+                ELLE_WARN("%s: drop corrupted journal record: %s", *this, e);
+                break;
+              }
+              for (auto const& entry: page.updates)
+                update(entry.metadata());
+              for (auto const& path: page.deletes)
+                remove(path);
+              cursor = std::move(page.cursor);
+              valid += sizeof(size) + size;
+              ++pages;
+            }
+            ELLE_DEBUG("%s: replayed %s journal pages", *this, pages);
+            // Drop the incomplete record a crash may have left.
+            if (valid != bfs::file_size(journal_path))
+            {
+              ELLE_TRACE("%s: truncate journal to %s bytes", *this, valid);
+              bfs::resize_file(journal_path, valid);
+              torn = true;
+            }
+          }
+          this->_journal_size = valid;
+          this->_open_journal();
+          if (torn)
+            sync(this->_journal, journal_path);
+          return cursor;
+        }
+
+        /// Journal the changes of a delta page.
+        void
+        append(Page const& page)
+        {
+          auto const record = elle::serialization::binary::serialize(
+            page, false);
+          auto const size = uint32_t(record.size());
+          auto frame = elle::Buffer();
+          frame.append(&size, sizeof(size));
+          frame.append(record.contents(), record.size());
+          auto const path = this->_journal_path();
+          write_all(this->_journal, frame, path);
+          sync(this->_journal, path);
+          this->_journal_size += frame.size();
+        }
+
+        /// Whether replaying the journal costs more than loading a new
+        /// snapshot.
+        bool
+        compaction_due() const
+        {
+          return this->_journal_size >
+            std::max<uint64_t>(this->_snapshot_size, 1024 * 1024);
+        }
+
+        /// Replace the snapshot and start a new, empty journal.
+        void
+        snapshot(Snapshot snapshot)
+        {
+          ELLE_TRACE_SCOPE("%s: snapshot %s entries",
+                           *this, snapshot.entries.size());
+          snapshot.generation = this->_generation + 1;
+          auto const data =
+            elle::serialization::binary::serialize(snapshot, false);
+          auto const path = this->_root / "snapshot";
+          auto const tmp = this->_root / "snapshot.tmp";
+          {
+            auto const fd = open(tmp, false);
+            try
+            {
+              write_all(fd, data, tmp);
+              sync(fd, tmp);
+            }
+            catch (...)
+            {
+              ::close(fd);
+              throw;
+            }
+            ::close(fd);
+          }
+          auto error = boost::system::error_code{};
+          bfs::rename(tmp, path, error);
+          if (error)
+            elle::err("%s: unable to rename %s to %s: %s",
+                      *this, tmp, path, error.message());
+          // The journal may only go once the new snapshot is sure to replace
+          // the old one.
+          sync_directory(this->_root);
+          this->_snapshot_size = data.size();
+          this->_generation = snapshot.generation;
+          this->_journal_size = 0;
+          this->_remove_journals();
+          this->_open_journal();
+        }
+
+      private:
+        bfs::path
+        _journal_path() const
+        {
+          return this->_root / elle::sprintf("journal.%s", this->_generation);
+        }
+
+        void
+        _open_journal()
+        {
+          if (this->_journal >= 0)
+          {
+            ::close(this->_journal);
+            this->_journal = -1;
+          }
+          this->_journal = open(this->_journal_path(), true);
+        }
+
+        /// Remove journals of other generations.
+        void
+        _remove_journals()
+        {
+          auto const current = this->_journal_path().filename();
+          for (auto const& entry: bfs::directory_iterator(this->_root))
+          {
+            auto const name = entry.path().filename();
+            if (boost::starts_with(name.string(), "journal.") &&
+                name != current)
+            {
+              ELLE_DEBUG("%s: remove stale %s", *this, name);
+              bfs::remove(entry.path());
+            }
+          }
+        }
+
+        ELLE_ATTRIBUTE(bfs::path, root);
+        ELLE_ATTRIBUTE(int, generation);
+        ELLE_ATTRIBUTE(int, journal);
+        ELLE_ATTRIBUTE(uint64_t, journal_size);
+        ELLE_ATTRIBUTE(uint64_t, snapshot_size);
+      };
+
+      MetadataCache::MetadataCache(bfs::path const& root, bool full)
+        : _full(full)
+        , _cursor()
+        , _metadata()
+        , _rebuilding()
+        , _store(root.empty() ? nullptr : new MetadataStore(root))
+      {}
+
+      MetadataCache::~MetadataCache() = default;
+
+      void
+      MetadataCache::load()
+      {
+        if (this->_store)
+          this->_cursor = this->_store->load(
+            [this] (Metadata m) { this->_update(this->_metadata, std::move(m)); },
+            [this] (bfs::path const& p) { this->_delete(this->_metadata, p); });
+      }
+
+      boost::optional<Metadata>
+      MetadataCache::find(bfs::path const& path) const
+      {
+        if (auto it = elle::find(this->_metadata, path))
+          return it->second.metadata;
+        else
+          return {};
+      }
+
+      std::size_t
+      MetadataCache::size() const
+      {
+        return this->_metadata.size();
+      }
+
+      void
+      MetadataCache::update(Metadata value)
+      {
+        this->_update(this->_metadata, std::move(value));
+      }
+
+      void
+      MetadataCache::remove(bfs::path const& path)
+      {
+        this->_delete(this->_metadata, path);
+      }
+
+      void
+      MetadataCache::apply(Delta const& delta)
+      {
+        if (!this->_cursor.empty() && delta.reset)
+        {
+          // Keep serving the current metadata while the new one is
+          // fetched. The root is not part of deltas, carry it over.
+          ELLE_TRACE("%s: delta reset, rebuild metadata", *this);
+          this->_rebuilding.emplace();
+          if (auto root = elle::find(this->_metadata, "/"))
+          {
+            auto metadata = root->second.metadata;
+            metadata.contents.reset();
+            this->_rebuilding->emplace("/", Entry{std::move(metadata), {}});
+          }
+        }
+        ELLE_DEBUG("%s: new cursor: %s", *this, delta.cursor);
+        auto& index = this->_rebuilding ? *this->_rebuilding : this->_metadata;
+        auto page = Page{};
+        page.cursor = delta.cursor;
+        for (auto const& entry: delta.entries)
+          if (entry.second)
+          {
+            if (this->_store)
+              page.updates.emplace_back(entry.second.get());
+            this->_update(index, entry.second.get());
+          }
+          else
+          {
+            if (this->_store)
+              page.deletes.emplace_back(entry.first);
+            this->_delete(index, entry.first);
+          }
+        this->_cursor = delta.cursor;
+        // A rebuild is only persisted once complete.
+        if (this->_store && !this->_rebuilding)
+          this->_store->append(page);
+        if (delta.has_more)
+          return;
+        if (this->_rebuilding)
+        {
+          ELLE_TRACE("%s: metadata rebuilt with %s entries",
+                     *this, this->_rebuilding->size());
+          this->_metadata = std::move(*this->_rebuilding);
+          this->_rebuilding.reset();
+          if (this->_store)
+            this->_snapshot();
+        }
+        else if (this->_store && this->_store->compaction_due())
+          this->_snapshot();
+      }
+
+      void
+      MetadataCache::_update(Index& index, Metadata value)
+      {
+        bfs::path path(value.path);
+        ELLE_DEBUG_SCOPE("%s: store metadata for %s", *this, path);
+        { ELLE_DUMP("%s: %s", *this, value); } // Braces for gcc warnings.
+        // Update metadata
+        {
+          auto& entry = index[path];
+          // Preserve previously registered folder content.
+          if (value.is_dir && !value.contents)
+          {
+            if (entry.metadata.contents)
+            {
+              ELLE_DEBUG("%s: preserve contents: %s",
+                         *this, entry.metadata.contents);
+              value.contents = std::move(entry.metadata.contents);
+            }
+          }
+          else
+          {
+            entry.children.clear();
+            if (value.contents)
+              for (std::size_t i = 0; i < value.contents->size(); ++i)
+                entry.children[(*value.contents)[i].path] = i;
+          }
+          entry.metadata = std::move(value);
+        }
+        // Update parent metadata
+        auto parent_path = path.parent_path();
+        ELLE_DEBUG("%s: register in parent metadata: %s", *this, parent_path)
+        {
+          auto it = index.find(parent_path);
+          if (it == index.end())
+          {
+            // The root has no parent.
+            if (!this->_full || parent_path == "/" || parent_path.empty())
+              return;
+            ELLE_DEBUG("%s: create parent folder metadata: %s", *this,
+                       parent_path);
+            Metadata m;
+            m.is_dir = true;
+            m.path = parent_path.string();
+            m.bytes = 0;
+            it = index.emplace(parent_path, Entry{std::move(m), {}}).first;
+          }
+          auto& parent = it->second;
+          auto& parent_metadata = parent.metadata;
+          if (parent_metadata.is_dir)
+          {
+            if (!parent_metadata.contents)
+              parent_metadata.contents.emplace();
+            auto const& stored = index.at(path).metadata;
+            Metadata::Content content;
+            content.path = stored.path;
+            content.is_dir = stored.is_dir;
+            content.bytes = stored.bytes;
+            content.client_mtime = stored.client_mtime;
+            content.modified = stored.modified;
+            auto& contents = parent_metadata.contents.get();
+            auto child = parent.children.find(path);
+            if (child != parent.children.end())
+            {
+              ELLE_DEBUG("%s: update metadata in %s", *this, parent_path);
+              contents[child->second] = std::move(content);
+            }
+            else
+            {
+              ELLE_DEBUG("%s: push metadata in %s", *this, parent_path);
+              parent.children.emplace(path, contents.size());
+              contents.emplace_back(std::move(content));
+            }
+          }
+          else
+            ELLE_ERR("%s: parent path %s metadata is not a directory: %s",
+                     *this, parent_path, parent_metadata);
+        }
+      }
+
+      void
+      MetadataCache::_delete(Index& index, bfs::path const& path)
+      {
+        ELLE_DEBUG_SCOPE("%s: delete metadata for %s", *this, path);
+        index.erase(path);
+        auto parent_path = path.parent_path();
+        if (auto it = elle::find(index, parent_path))
+        {
+          auto& parent = it->second;
+          auto child = parent.children.find(path);
+          if (parent.metadata.is_dir && parent.metadata.contents &&
+              child != parent.children.end())
+          {
+            ELLE_DEBUG_SCOPE("%s: delete metadata in %s", *this, parent_path);
+            // Move the last child in the hole to erase in constant time.
+            auto& contents = parent.metadata.contents.get();
+            auto const position = child->second;
+            parent.children.erase(child);
+            if (position != contents.size() - 1)
+            {
+              contents[position] = std::move(contents.back());
+              parent.children[contents[position].path] = position;
+            }
+            contents.pop_back();
+          }
+        }
+      }
+
+      void
+      MetadataCache::_snapshot()
+      {
+        auto snapshot = Snapshot{};
+        snapshot.cursor = this->_cursor;
+        snapshot.entries.reserve(this->_metadata.size());
+        for (auto const& entry: this->_metadata)
+          snapshot.entries.emplace_back(entry.second.metadata);
+        this->_store->snapshot(std::move(snapshot));
+      }
+    }
+  }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <elle/attribute.hh>
+#include <elle/optional.hh>
+
+#include <elle/service/dropbox/Dropbox.hh>
+
+namespace elle
+{
+  namespace service
+  {
+    namespace dropbox
+    {
+      inline
+      std::string
+      to_lower(boost::filesystem::path const& p)
+      {
+        return boost::to_lower_copy(p.string());
+      }
+
+      struct HashPath
+      {
+        size_t
+        operator()(boost::filesystem::path const& p) const
+        {
+          return std::hash<std::string>()(to_lower(p));
+        }
+      };
+
+      struct ComparePath
+      {
+        bool
+        operator()(boost::filesystem::path const& lhs,
+                   boost::filesystem::path const& rhs) const
+        {
+          return to_lower(lhs) == to_lower(rhs);
+        }
+      };
+
+      /// A case insensitive map of paths.
+      template <typename Value>
+      using PathMap = std::unordered_map<
+        boost::filesystem::path, Value, HashPath, ComparePath>;
+
+      class MetadataStore;
+
+      /// The metadata of a Dropbox, kept up to date by applying delta pages
+      /// and optionally persisted in a directory across restarts.
+      class MetadataCache
+      {
+      public:
+        /// Create a cache.
+        ///
+        /// @param root The directory to persist metadata into, empty to keep
+        ///             them in memory only.
+        /// @param full Whether the cache holds every entry, i.e. whether a
+        ///             missing entry does not exist.
+        MetadataCache(boost::filesystem::path const& root = {},
+                      bool full = true);
+        ~MetadataCache();
+
+        /// Load the persisted metadata and their cursor, if any.
+        void
+        load();
+
+        /// The metadata of @a path, if known.
+        boost::optional<Metadata>
+        find(boost::filesystem::path const& path) const;
+
+        /// The number of entries.
+        std::size_t
+        size() const;
+
+        /// Store the metadata of an entry and register it in its parent.
+        void
+        update(Metadata value);
+
+        /// Forget an entry and remove it from its parent.
+        void
+        remove(boost::filesystem::path const& path);
+
+        /// Apply and persist a delta page.
+        ///
+        /// On a reset, the current metadata keep being served until the last
+        /// page of the new ones is applied.
+        void
+        apply(Delta const& delta);
+
+        ELLE_ATTRIBUTE_RW(bool, full);
+        /// The cursor of the last delta page applied.
+        ELLE_ATTRIBUTE_RW(std::string, cursor);
+
+      private:
+        /// The metadata of an entry, and for directories the position of each
+        /// child in its contents.
+        struct Entry
+        {
+          Metadata metadata;
+          PathMap<std::size_t> children;
+        };
+        using Index = PathMap<Entry>;
+
+        void
+        _update(Index& index, Metadata value);
+
+        void
+        _delete(Index& index, boost::filesystem::path const& path);
+
+        void
+        _snapshot();
+
+        ELLE_ATTRIBUTE(Index, metadata);
+        /// The metadata being fetched again after a delta reset.
+        ELLE_ATTRIBUTE(boost::optional<Index>, rebuilding);
+        ELLE_ATTRIBUTE(std::unique_ptr<MetadataStore>, store);
+      };
+    }
+  }
+}
@@ -1,7 +1,15 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <sstream>
 #include <unordered_set>
+#include <vector>
 
+#include <boost/algorithm/string/join.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 
+#include <elle/archive/chunker.hh>
 #include <elle/archive/zip.hh>
 #include <elle/attribute.hh>
 #include <elle/filesystem.hh>
@@ -383,6 +391,68 @@ archiving_error(elle::archive::Format fmt)
   }
 }
 
+static
+std::map<std::string, std::string>
+tree_content(bfs::path const& root)
+{
+  auto res = std::map<std::string, std::string>{};
+  for (auto const& p: bfs::recursive_directory_iterator(root))
+    if (bfs::is_regular_file(p))
+    {
+      bfs::ifstream input(p.path(), std::ios::binary);
+      auto content = std::stringstream{};
+      content << input.rdbuf();
+      res[bfs::relative(p.path(), root).string()] = content.str();
+    }
+  return res;
+}
+
+static
+void
+archive_parallel(elle::archive::Format fmt)
+{
+  auto const input = TemporaryDirectory("parallel");
+  auto const root = input.path() / "tree";
+  for (int i = 0; i < 200; ++i)
+  {
+    auto const dir =
+      root / elle::sprintf("%s", i % 7) / elle::sprintf("%s", i % 3);
+    bfs::create_directories(dir);
+    bfs::ofstream(dir / elle::sprintf("file%s", i))
+      << std::string(i * 37, 'a' + i % 26);
+  }
+  // Larger than what is read and written in the background.
+  bfs::ofstream(root / "large") << std::string(5 * 1024 * 1024 + 3, 'l');
+#ifndef ELLE_WINDOWS
+  bfs::ofstream(root / "script") << "#!/bin/sh";
+  bfs::permissions(root / "script", bfs::add_perms | bfs::owner_exe);
+#endif
+  auto const expected = tree_content(root);
+  BOOST_CHECK_EQUAL(expected.size(),
+                    202 + (bfs::exists(root / "script") ? 1 : 0));
+  auto const output = TemporaryDirectory("output");
+  for (auto archive_jobs: {1, 4})
+  {
+    auto const path =
+      output.path() / elle::sprintf("%s.archive", archive_jobs);
+    elle::archive::archive(fmt, {root}, path, {}, {}, false, archive_jobs);
+    for (auto extract_jobs: {1, 4})
+    {
+      auto const decompress = TemporaryDirectory("decompress");
+      elle::archive::extract(path, decompress.path(), extract_jobs);
+      BOOST_CHECK(tree_content(decompress.path() / "tree") == expected);
+#ifndef ELLE_WINDOWS
+      BOOST_CHECK(
+        bfs::status(decompress.path() / "tree" / "script").permissions() &
+        bfs::owner_exe);
+#endif
+      // Extracting over existing files replaces them.
+      elle::archive::extract(path, decompress.path(), extract_jobs);
+      BOOST_CHECK(tree_content(decompress.path() / "tree") == expected);
+    }
+  }
+}
+
 #define FORMAT(Fmt)                                     \
   namespace Fmt                                         \
   {                                                     \
@@ -394,6 +464,7 @@ archiving_error(elle::archive::Format fmt)
       void duplicate()    { archive_duplicate(fmt); }   \
       void symboliclink() { archive_symlink(fmt); }     \
       void error()        { archiving_error(fmt); }     \
+      void parallel()     { archive_parallel(fmt); }    \
     }                                                   \
   }
 
@@ -402,6 +473,81 @@ FORMAT(tar)
 FORMAT(tar_gzip)
 #undef FORMAT
 
+namespace chunker
+{
+  namespace
+  {
+    std::string
+    random_data(std::size_t size)
+    {
+      auto gen = std::mt19937{42};
+      auto res = std::string(size, 0);
+      for (auto& c: res)
+        c = char(gen());
+      return res;
+    }
+
+    std::vector<std::string>
+    chunks(std::string const& data, std::size_t average)
+    {
+      auto input = std::stringstream(data);
+      auto chunker = elle::archive::Chunker(input, average);
+      auto res = std::vector<std::string>{};
+      while (auto chunk = chunker.next())
+        res.emplace_back(chunk->string());
+      BOOST_CHECK_EQUAL(chunker.offset(), data.size());
+      return res;
+    }
+
+    void
+    sizes()
+    {
+      auto const data = random_data(4 * 1024 * 1024);
+      auto const res = chunks(data, 16 * 1024);
+      BOOST_CHECK_EQUAL(boost::algorithm::join(res, ""), data);
+      for (auto it = res.begin(); it != res.end(); ++it)
+      {
+        BOOST_CHECK_LE(it->size(), 64 * 1024);
+        if (it + 1 != res.end())
+          BOOST_CHECK_GE(it->size(), 4 * 1024);
+      }
+      // Normalized chunking keeps the average close to the target.
+      auto const average = data.size() / res.size();
+      BOOST_CHECK_GT(average, 12 * 1024);
+      BOOST_CHECK_LT(average, 28 * 1024);
+      // Boundaries depend on the content only.
+      BOOST_CHECK(chunks(data, 16 * 1024) == res);
+    }
+
+    void
+    shift()
+    {
+      auto const data = random_data(1024 * 1024);
+      auto const before = chunks(data, 8 * 1024);
+      auto edited = data;
+      edited.insert(300 * 1024, "inserted");
+      edited.erase(700 * 1024, 100);
+      auto const after = chunks(edited, 8 * 1024);
+      auto const known =
+        std::unordered_set<std::string>(before.begin(), before.end());
+      auto const changed = std::count_if(
+        after.begin(), after.end(),
+        [&] (std::string const& c) { return !known.count(c); });
+      // Only the chunks around each edit change.
+      BOOST_CHECK_LE(changed, 4);
+    }
+
+    void
+    empty()
+    {
+      BOOST_CHECK(chunks("", 8 * 1024).empty());
+      BOOST_CHECK_EQUAL(chunks("small", 8 * 1024).size(), 1);
+      auto input = std::stringstream();
+      BOOST_CHECK_THROW(elle::archive::Chunker(input, 16), elle::Error);
+    }
+  }
+}
+
 ELLE_TEST_SUITE()
 {
   auto& master = boost::unit_test::framework::master_test_suite();
@@ -419,6 +565,7 @@ ELLE_TEST_SUITE()
     if (!musl)                                  \
       suite->add(BOOST_TEST_CASE(symboliclink));\
     suite->add(BOOST_TEST_CASE(error));         \
+    suite->add(BOOST_TEST_CASE(parallel));      \
   }                                             \
 
   FORMAT(zip);
@@ -426,4 +573,11 @@ ELLE_TEST_SUITE()
   FORMAT(tar_gzip);
 
 #undef FORMAT
+  {
+    auto suite = BOOST_TEST_SUITE("chunker");
+    master.add(suite);
+    suite->add(BOOST_TEST_CASE(chunker::sizes));
+    suite->add(BOOST_TEST_CASE(chunker::shift));
+    suite->add(BOOST_TEST_CASE(chunker::empty));
+  }
 }
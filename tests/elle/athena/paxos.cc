@@ -1,6 +1,7 @@
 #include <boost/range/adaptor/sliced.hpp>
 #include <boost/range/irange.hpp>
 
+#include <elle/filesystem/TemporaryDirectory.hh>
 #include <elle/serialization/binary.hh>
 #include <elle/serialization/json.hh>
 #include <elle/test.hh>
@@ -9,8 +10,11 @@
 #include <elle/reactor/scheduler.hh>
 #include <elle/reactor/signal.hh>
 
+#include <elle/athena/paxos/Batcher.hh>
 #include <elle/athena/paxos/Client.hh>
+#include <elle/athena/paxos/Journal.hh>
 #include <elle/athena/paxos/Server.hh>
+#include <elle/athena/paxos/Simulation.hh>
 
 ELLE_LOG_COMPONENT("elle.athena.paxos.test");
 
@@ -84,6 +88,16 @@ public:
     return this->_paxos.get(q);
   }
 
+
+  typename Client::Response
+  lead(
+    typename paxos::Server<T, Version, ServerId>::Quorum const& q,
+    typename Client::Proposal const& p,
+    elle::Duration lease) override
+  {
+    return this->_paxos.lead(q, p, lease);
+  }
+
   ELLE_ATTRIBUTE_RW((paxos::Server<T, Version, ServerId>&), paxos);
 };
 
@@ -110,6 +124,15 @@ public:
     return res;
   }
 
+  typename Client::Response
+  lead(typename Client::Quorum const& q,
+       typename Client::Proposal const& p,
+       elle::Duration lease) override
+  {
+    this->_leading(p);
+    return Super::lead(q, p, lease);
+  }
+
   typename Client::Proposal
   accept(typename Client::Quorum const& q,
          typename Client::Proposal const& p,
@@ -131,10 +154,19 @@ public:
     this->_confirmed(p);
   }
 
+  boost::optional<typename Client::Accepted>
+  get(typename Client::Quorum const& q) override
+  {
+    this->_getting();
+    return Super::get(q);
+  }
+
   ELLE_ATTRIBUTE_RX(boost::signals2::signal<void (Server::Proposal const&)>,
                     proposing);
   ELLE_ATTRIBUTE_RX(boost::signals2::signal<void (Server::Proposal const&)>,
                     proposed);
+  ELLE_ATTRIBUTE_RX(boost::signals2::signal<void (Server::Proposal const&)>,
+                    leading);
   ELLE_ATTRIBUTE_RX(boost::signals2::signal<void (Server::Proposal const&)>,
                     accepting);
   ELLE_ATTRIBUTE_RX(boost::signals2::signal<void (Server::Proposal const&)>,
@@ -143,6 +175,7 @@ public:
                     confirming);
   ELLE_ATTRIBUTE_RX(boost::signals2::signal<void (Server::Proposal const&)>,
                     confirmed);
+  ELLE_ATTRIBUTE_RX(boost::signals2::signal<void ()>, getting);
 };
 
 template <typename Peer = YAInstrumentedPeer, typename Servers>
@@ -1404,6 +1437,524 @@ ELLE_TEST_SCHEDULED(self_conflict2)
   };
 }
 
+/// A peer answering after a delay.
+class SlowPeer
+  : public Peer<int, int, int>
+{
+public:
+  using Super = Peer<int, int, int>;
+
+  SlowPeer(int id, Server& paxos, elle::Duration delay)
+    : Super(id, paxos)
+    , _delay(delay)
+  {}
+
+  typename Client::Response
+  propose(typename Client::Quorum const& q,
+          typename Client::Proposal const& p) override
+  {
+    elle::reactor::sleep(this->_delay);
+    return Super::propose(q, p);
+  }
+
+  typename Client::Proposal
+  accept(typename Client::Quorum const& q,
+         typename Client::Proposal const& p,
+         elle::Option<int, typename Client::Quorum> const& value) override
+  {
+    elle::reactor::sleep(this->_delay);
+    return Super::accept(q, p, value);
+  }
+
+  void
+  confirm(typename Client::Quorum const& q,
+          typename Client::Proposal const& p) override
+  {
+    elle::reactor::sleep(this->_delay);
+    Super::confirm(q, p);
+  }
+
+  ELLE_ATTRIBUTE(elle::Duration, delay);
+};
+
+ELLE_TEST_SCHEDULED(early_return)
+{
+  auto const delay = std::chrono::milliseconds(200);
+  std::vector<Server> servers{
+    {11, Server::Quorum{11, 12, 13}},
+    {12, Server::Quorum{11, 12, 13}},
+    {13, Server::Quorum{11, 12, 13}},
+  };
+  auto peers = Peers{};
+  peers.emplace_back(std::make_unique<Peer<int, int, int>>(11, servers[0]));
+  peers.emplace_back(std::make_unique<Peer<int, int, int>>(12, servers[1]));
+  peers.emplace_back(std::make_unique<SlowPeer>(13, servers[2], delay));
+  auto client = Client(1, std::move(peers));
+  client.early_return(true);
+  auto durations = std::vector<elle::Duration>{};
+  for (auto version: irange(0, 50))
+  {
+    auto const start = std::chrono::steady_clock::now();
+    BOOST_CHECK(!client.choose(version, version));
+    durations.emplace_back(
+      std::chrono::duration_cast<elle::Duration>(
+        std::chrono::steady_clock::now() - start));
+  }
+  std::sort(durations.begin(), durations.end());
+  auto const p50 = durations[durations.size() / 2];
+  auto const p99 = durations[durations.size() * 99 / 100];
+  ELLE_LOG("choose latency with a peer delayed by %s: p50 %s, p99 %s",
+           delay, p50, p99);
+  BOOST_CHECK_LT(p99, delay);
+  BOOST_CHECK_EQUAL(client.get(), 49);
+  BOOST_CHECK_EQUAL(client.peers()[0]->latency().stragglers(), 0);
+  BOOST_CHECK_EQUAL(client.peers()[0]->latency().samples(), 150);
+  BOOST_CHECK_EQUAL(client.peers()[2]->latency().samples(), 0);
+  BOOST_CHECK_GT(client.peers()[2]->latency().stragglers(), 0);
+  // The slow peer is left behind, but catches up when it is needed.
+  client.peers()[0].reset(new UnavailablePeer<int, int, int>(11));
+  BOOST_CHECK(!client.choose(50, 50));
+  BOOST_CHECK_EQUAL(servers[2].current_value()->value.get<int>(), 50);
+}
+
+ELLE_TEST_SCHEDULED(multi_paxos)
+{
+  std::vector<Server> servers{
+    {11, Server::Quorum{11, 12, 13}},
+    {12, Server::Quorum{11, 12, 13}},
+    {13, Server::Quorum{11, 12, 13}},
+  };
+  auto const lease = elle::Duration(std::chrono::milliseconds(500));
+  auto leader = make_client(1, servers);
+  leader.lease(lease);
+  auto leads = 0;
+  auto proposals = 0;
+  for (auto& peer: leader.peers())
+  {
+    auto& p = static_cast<YAInstrumentedPeer&>(*peer);
+    p.leading().connect([&] (Server::Proposal const&) { ++leads; });
+    p.proposing().connect([&] (Server::Proposal const&) { ++proposals; });
+  }
+  BOOST_CHECK(!leader.choose(0, 0));
+  BOOST_CHECK(leader.leading());
+  BOOST_CHECK_EQUAL(leads, 3);
+  // Later versions skip the proposal phase.
+  for (auto version: irange(1, 10))
+    BOOST_CHECK(!leader.choose(version, version));
+  BOOST_CHECK_EQUAL(leads, 3);
+  BOOST_CHECK_EQUAL(proposals, 0);
+  BOOST_CHECK_EQUAL(leader.get(), 9);
+  // Other proposers wait for the lease to expire.
+  auto other = make_client(2, servers);
+  BOOST_CHECK(!other.choose(10, 10));
+  BOOST_CHECK(!leader.leading());
+  // The former leader falls back to a classic round.
+  auto chosen = leader.choose(10, 11);
+  BOOST_REQUIRE(chosen);
+  BOOST_CHECK_EQUAL(chosen->get<int>(), 10);
+  BOOST_CHECK_EQUAL(leads, 6);
+  BOOST_CHECK(!leader.choose(11, 11));
+  BOOST_CHECK(leader.leading());
+  BOOST_CHECK(!leader.choose(12, 12));
+  BOOST_CHECK_EQUAL(leads, 9);
+  BOOST_CHECK_EQUAL(other.get(), 12);
+}
+
+ELLE_TEST_SCHEDULED(multi_paxos_old_version)
+{
+  auto const quorum = Server::Quorum{11, 12, 13};
+  auto const lease = elle::Duration(std::chrono::milliseconds(500));
+  Server old(11, quorum, {}, elle::Version(0, 4, 0));
+  BOOST_CHECK_THROW(old.lead(quorum, Server::Proposal(0, 1, 1), lease),
+                    elle::Error);
+  BOOST_CHECK(!old.leader());
+  // Classic rounds still work.
+  BOOST_CHECK_NO_THROW(old.propose(quorum, Server::Proposal(0, 1, 1)));
+  Server current(11, quorum, {}, elle::Version(0, 5, 0));
+  current.lead(quorum, Server::Proposal(0, 1, 1), lease);
+  BOOST_CHECK(current.leader());
+}
+
+ELLE_TEST_SCHEDULED(batcher)
+{
+  using Batch = std::vector<int>;
+  using BatchServer = paxos::Server<Batch, int, int>;
+  using BatchClient = paxos::Client<Batch, int, int>;
+  using Batcher = paxos::Batcher<int, int, int>;
+  std::vector<BatchServer> servers{
+    {11, BatchServer::Quorum{11, 12, 13}},
+    {12, BatchServer::Quorum{11, 12, 13}},
+    {13, BatchServer::Quorum{11, 12, 13}},
+  };
+  auto make = [&] (int id)
+    {
+      auto peers = BatchClient::Peers{};
+      for (auto& s: servers)
+        peers.emplace_back(std::make_unique<Peer<Batch, int, int>>(s.id(), s));
+      return BatchClient(id, std::move(peers));
+    };
+  auto client_1 = make(1);
+  auto client_2 = make(2);
+  Batcher batcher_1(client_1);
+  Batcher batcher_2(client_2);
+  // Every batch decided, as seen by either batcher.
+  auto decided = std::map<int, Batch>{};
+  auto record = [&] (int version, Batch const& batch)
+    {
+      auto it = decided.emplace(version, batch);
+      BOOST_CHECK(it.first->second == batch);
+    };
+  batcher_1.decided().connect(record);
+  batcher_2.decided().connect(record);
+  auto const count = 100;
+  auto versions = std::vector<int>(count, -1);
+  elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+  {
+    for (auto i: irange(0, count))
+      scope.run_background(
+        elle::sprintf("submitter %s", i),
+        [&, i]
+        {
+          auto& batcher = i % 2 ? batcher_2 : batcher_1;
+          versions[i] = batcher.submit(i);
+        });
+    elle::reactor::wait(scope);
+  };
+  // Concurrent updates share rounds.
+  BOOST_CHECK_LT(int(decided.size()), count);
+  BOOST_CHECK_EQUAL(decided.rbegin()->first + 1, int(decided.size()));
+  // Every update is decided exactly once, at the version it was reported
+  // at, and in submission order for a given batcher.
+  auto seen = std::vector<int>(count, 0);
+  auto last = std::vector<int>{-1, -1};
+  for (auto const& d: decided)
+    for (auto update: d.second)
+    {
+      ++seen[update];
+      BOOST_CHECK_EQUAL(versions[update], d.first);
+      BOOST_CHECK_LT(last[update % 2], update);
+      last[update % 2] = update;
+    }
+  for (auto i: irange(0, count))
+    BOOST_CHECK_EQUAL(seen[i], 1);
+  BOOST_CHECK(client_1.get() == decided.rbegin()->second);
+}
+
+template <typename T, typename Version, typename ServerId>
+class FlakyPeer
+  : public Peer<T, Version, ServerId>
+{
+public:
+  using Super = Peer<T, Version, ServerId>;
+  using Client = paxos::Client<T, Version, ServerId>;
+
+  FlakyPeer(ServerId id, paxos::Server<T, Version, ServerId>& paxos)
+    : Super(id, paxos)
+    , lost_confirmations(0)
+    , crash(false)
+  {}
+
+  typename Client::Response
+  propose(typename Client::Quorum const& q,
+          typename Client::Proposal const& p) override
+  {
+    if (this->crash)
+    {
+      this->crash = false;
+      throw std::runtime_error("crash");
+    }
+    return Super::propose(q, p);
+  }
+
+  void
+  confirm(typename Client::Quorum const& q,
+          typename Client::Proposal const& p) override
+  {
+    if (this->lost_confirmations > 0)
+    {
+      --this->lost_confirmations;
+      throw paxos::Unavailable();
+    }
+    Super::confirm(q, p);
+  }
+
+  int lost_confirmations;
+  bool crash;
+};
+
+ELLE_TEST_SCHEDULED(batcher_failure)
+{
+  using Batch = std::vector<int>;
+  using BatchServer = paxos::Server<Batch, int, int>;
+  using BatchClient = paxos::Client<Batch, int, int>;
+  using Batcher = paxos::Batcher<int, int, int>;
+  std::vector<BatchServer> servers{
+    {11, BatchServer::Quorum{11, 12, 13}},
+    {12, BatchServer::Quorum{11, 12, 13}},
+    {13, BatchServer::Quorum{11, 12, 13}},
+  };
+  auto peers = BatchClient::Peers{};
+  auto flaky = std::vector<FlakyPeer<Batch, int, int>*>{};
+  for (auto& s: servers)
+  {
+    auto peer = std::make_unique<FlakyPeer<Batch, int, int>>(s.id(), s);
+    flaky.emplace_back(peer.get());
+    peers.emplace_back(std::move(peer));
+  }
+  auto client = BatchClient(1, std::move(peers));
+  Batcher batcher(client);
+  auto decided = std::vector<std::pair<int, Batch>>{};
+  batcher.decided().connect(
+    [&] (int version, Batch const& batch)
+    {
+      decided.emplace_back(version, batch);
+    });
+  // The batch is accepted but its confirmation lost: it is completed when
+  // retried at the same version instead of failing or being chosen again.
+  for (auto peer: flaky)
+    peer->lost_confirmations = 1;
+  BOOST_CHECK_EQUAL(batcher.submit(1), 0);
+  BOOST_CHECK_EQUAL(decided.size(), 1u);
+  BOOST_CHECK(decided.at(0) == std::make_pair(0, Batch{1}));
+  // Unexpected errors fail the submitters, and the batcher carries on.
+  flaky[0]->crash = true;
+  BOOST_CHECK_THROW(batcher.submit(2), std::runtime_error);
+  BOOST_CHECK_EQUAL(batcher.submit(3), 1);
+  BOOST_CHECK(client.get() == Batch{3});
+  BOOST_CHECK_EQUAL(decided.size(), 2u);
+  // Persistent failures fail the submitters after max_attempts rounds.
+  for (auto peer: flaky)
+    peer->lost_confirmations = 1000;
+  batcher.max_attempts(2);
+  BOOST_CHECK_THROW(batcher.submit(4), paxos::TooFewPeers);
+  // Destroying a batcher fails its submitters.
+  auto other = std::make_unique<Batcher>(client);
+  other->max_attempts(1000);
+  auto failed = false;
+  elle::reactor::Thread submitter(
+    "submitter",
+    [&]
+    {
+      try
+      {
+        other->submit(5);
+      }
+      catch (elle::Error const&)
+      {
+        failed = true;
+      }
+    });
+  elle::reactor::sleep(std::chrono::milliseconds(300));
+  BOOST_CHECK(!failed);
+  other.reset();
+  elle::reactor::wait(submitter);
+  BOOST_CHECK(failed);
+}
+
+ELLE_TEST_SCHEDULED(lease_read)
+{
+  std::vector<Server> servers{
+    {11, Server::Quorum{11, 12, 13}},
+    {12, Server::Quorum{11, 12, 13}},
+    {13, Server::Quorum{11, 12, 13}},
+  };
+  auto leader = make_client(1, servers);
+  leader.lease(elle::Duration(std::chrono::milliseconds(500)));
+  auto gets = 0;
+  for (auto& peer: leader.peers())
+    static_cast<YAInstrumentedPeer&>(*peer).getting().connect(
+      [&] { ++gets; });
+  BOOST_CHECK(!leader.reading());
+  BOOST_CHECK(!leader.choose(0, 0));
+  BOOST_CHECK(leader.reading());
+  // The leader reads locally.
+  BOOST_CHECK_EQUAL(leader.get(), 0);
+  BOOST_CHECK(!leader.choose(1, 1));
+  BOOST_CHECK_EQUAL(leader.get(), 1);
+  BOOST_CHECK_EQUAL(gets, 0);
+  // Other clients read from a majority.
+  auto other = make_client(2, servers);
+  BOOST_CHECK_EQUAL(other.get(), 1);
+  // Past the lease, the leader reads from a majority too.
+  elle::reactor::sleep(std::chrono::milliseconds(500));
+  BOOST_CHECK(!leader.reading());
+  BOOST_CHECK_EQUAL(leader.get(), 1);
+  BOOST_CHECK_EQUAL(gets, 3);
+  // Reads stop being local before the lease ends, by the clock drift
+  // margin.
+  leader.clock_drift(0.5);
+  BOOST_CHECK(!leader.choose(2, 2));
+  BOOST_CHECK(leader.reading());
+  elle::reactor::sleep(std::chrono::milliseconds(300));
+  BOOST_CHECK(leader.leading());
+  BOOST_CHECK(!leader.reading());
+  BOOST_CHECK_EQUAL(leader.get(), 2);
+  BOOST_CHECK_EQUAL(gets, 6);
+}
+
+ELLE_TEST_SCHEDULED(journal)
+{
+  using Journal = paxos::Journal<int, int, int>;
+  auto const dir = elle::filesystem::TemporaryDirectory{};
+  auto const quorum = Server::Quorum{11, 12, 13};
+  auto journals = std::vector<std::unique_ptr<Journal>>{};
+  auto open = [&]
+    {
+      journals.clear();
+      for (auto id: quorum)
+        journals.emplace_back(
+          std::make_unique<Journal>(dir.path() / std::to_string(id),
+                                    Server(id, quorum)));
+    };
+  auto make_client = [&]
+    {
+      auto peers = Peers{};
+      for (auto& j: journals)
+        peers.emplace_back(
+          std::make_unique<Peer<int, int, int>>(j->server().id(), j->server()));
+      return Client(1, std::move(peers));
+    };
+  open();
+  {
+    auto client = make_client();
+    for (auto version: irange(0, 10))
+      BOOST_CHECK(!client.choose(version, version));
+    // A propose, an accept and a confirm per version.
+    for (auto& j: journals)
+      BOOST_CHECK_EQUAL(j->records(), 30);
+  }
+  ELLE_LOG("recover from the log")
+  {
+    open();
+    auto client = make_client();
+    BOOST_CHECK_EQUAL(client.get(), 9);
+    BOOST_CHECK(!client.choose(10, 10));
+    BOOST_CHECK_EQUAL(client.choose(10, 11)->get<int>(), 10);
+  }
+  ELLE_LOG("compact the log")
+  {
+    for (auto& j: journals)
+      j->compaction_threshold(4);
+    auto client = make_client();
+    for (auto version: irange(11, 20))
+      BOOST_CHECK(!client.choose(version, version));
+    for (auto& j: journals)
+    {
+      BOOST_CHECK_LT(j->records(), 4);
+      BOOST_CHECK(boost::filesystem::exists(j->path() / "snapshot"));
+    }
+  }
+  ELLE_LOG("recover from a snapshot and a torn log")
+  {
+    journals.clear();
+    {
+      boost::filesystem::ofstream log(
+        dir.path() / "11" / "log", std::ios::app | std::ios::binary);
+      log << "torn";
+    }
+    open();
+    auto client = make_client();
+    BOOST_CHECK_EQUAL(client.get(), 19);
+    BOOST_CHECK(!client.choose(20, 20));
+    BOOST_CHECK_EQUAL(client.get(), 20);
+  }
+  ELLE_LOG("share syncs between concurrent changes")
+  {
+    Journal j(dir.path() / "group", Server(1, {1}));
+    elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+    {
+      for (auto round: irange(0, 10))
+        scope.run_background(
+          elle::sprintf("propose %s", round),
+          [&, round]
+          {
+            j.server().propose({1}, Server::Proposal(0, round, 1));
+          });
+      elle::reactor::wait(scope);
+    };
+    BOOST_CHECK_EQUAL(j.records(), 10);
+    BOOST_CHECK_LT(j.syncs(), 10);
+  }
+}
+
+ELLE_TEST_SCHEDULED(simulation)
+{
+  using Simulation = paxos::Simulation<int, int, int>;
+  auto& sched = elle::reactor::scheduler();
+  sched.simulated(true);
+  elle::SafeFinally real([&] { sched.simulated(false); });
+  struct Run
+  {
+    elle::Duration elapsed;
+    int messages;
+    std::map<int, int> decided;
+  };
+  // Clients choose concurrently over a lossy network, while one server is
+  // cut off and another unreachable from one client for a while.
+  auto run = [&] (std::uint32_t seed)
+    {
+      Simulation simulation({11, 12, 13, 14, 15}, seed);
+      simulation.latency(Simulation::uniform(std::chrono::milliseconds(1),
+                                             std::chrono::milliseconds(10)));
+      simulation.drop(0.01);
+      simulation.timeout(std::chrono::milliseconds(50));
+      auto const start = sched.now();
+      auto const versions = 50;
+      auto res = Run{};
+      elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+      {
+        for (auto id: irange(1, 4))
+          scope.run_background(
+            elle::sprintf("client %s", id),
+            [&, id]
+            {
+              auto client = simulation.client(id);
+              auto version = 0;
+              while (version < versions)
+              {
+                try
+                {
+                  auto choice = client.choose(version, id * 1000 + version);
+                  auto const chosen =
+                    choice ? choice->get<int>() : id * 1000 + version;
+                  // Every client sees the same value chosen.
+                  auto it = res.decided.emplace(version, chosen);
+                  BOOST_CHECK_EQUAL(it.first->second, chosen);
+                  version += 1;
+                }
+                catch (paxos::TooFewPeers const&)
+                {}
+              }
+            });
+        scope.run_background(
+          "partition",
+          [&]
+          {
+            elle::reactor::sleep(std::chrono::milliseconds(100));
+            simulation.isolate(15);
+            simulation.disconnect(1, 11);
+            elle::reactor::sleep(std::chrono::milliseconds(200));
+            simulation.heal();
+          });
+        elle::reactor::wait(scope);
+      };
+      BOOST_CHECK_EQUAL(int(res.decided.size()), versions);
+      res.elapsed = sched.now() - start;
+      res.messages = simulation.messages();
+      ELLE_LOG("seed %s: %s messages, %s lost, in %s",
+               seed, simulation.messages(), simulation.lost(), res.elapsed);
+      return res;
+    };
+  for (auto seed: irange(0, 10))
+    run(seed);
+  // Runs are reproducible from their seed.
+  auto const first = run(42);
+  auto const second = run(42);
+  BOOST_CHECK(first.elapsed == second.elapsed);
+  BOOST_CHECK_EQUAL(first.messages, second.messages);
+  BOOST_CHECK(first.decided == second.decided);
+}
+
 ELLE_TEST_SUITE()
 {
   auto& suite = boost::unit_test::framework::master_test_suite();
@@ -1426,6 +1977,14 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(partial_in_progress), 0, valgrind(5));
   suite.add(BOOST_TEST_CASE(self_conflict), 0, valgrind(5));
   suite.add(BOOST_TEST_CASE(self_conflict2), 0, valgrind(5));
+  suite.add(BOOST_TEST_CASE(early_return), 0, valgrind(10));
+  suite.add(BOOST_TEST_CASE(multi_paxos), 0, valgrind(5));
+  suite.add(BOOST_TEST_CASE(multi_paxos_old_version), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(batcher), 0, valgrind(5));
+  suite.add(BOOST_TEST_CASE(batcher_failure), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(lease_read), 0, valgrind(5));
+  suite.add(BOOST_TEST_CASE(journal), 0, valgrind(5));
+  suite.add(BOOST_TEST_CASE(simulation), 0, valgrind(5));
   {
     auto quorum = BOOST_TEST_SUITE("quorum");
     suite.add(quorum);
@@ -1,7 +1,10 @@
+#include <functional>
 #include <sstream>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 
+#include <elle/format/codec.hh>
 #include <elle/format/gzip.hh>
 #include <elle/test.hh>
 
@@ -126,6 +129,108 @@ flush()
   }
 }
 
+static
+std::string
+gunzip(std::string const& data)
+{
+  return elle::format::gzip::decompress(elle::ConstWeakBuffer(data)).string();
+}
+
+static
+void
+round_trip()
+{
+  auto const data = content();
+  auto const compressed =
+    elle::format::gzip::compress(elle::ConstWeakBuffer(data));
+  BOOST_CHECK_LT(compressed.size(), data.size() / 10);
+  BOOST_CHECK(gunzip(compressed.string()) == data);
+  std::stringstream buffer;
+  {
+    elle::format::gzip::Stream filter(buffer, false);
+    filter << data;
+  }
+  BOOST_CHECK(gunzip(buffer.str()) == data);
+  BOOST_CHECK_THROW(gunzip(compressed.string().substr(0, 100)),
+                    elle::Exception);
+}
+
+static
+void
+parallel(int jobs, elle::Buffer::Size block_size)
+{
+  auto const data = content();
+  std::stringstream buffer;
+  auto runs = 0;
+  {
+    elle::format::gzip::ParallelStream filter(
+      buffer, jobs, block_size, -1,
+      [&] (std::vector<std::function<void ()>> const& batch)
+      {
+        BOOST_CHECK_LE(int(batch.size()), jobs);
+        ++runs;
+        for (auto const& job: batch)
+          job();
+      });
+    filter << data.substr(0, 1000);
+    filter.flush();
+    filter << data.substr(1000);
+  }
+  BOOST_CHECK_GT(runs, 0);
+  // Priming blocks with the previous one keeps the ratio.
+  BOOST_CHECK_LE(buffer.str().size(), data.size() * 10 / 100);
+  BOOST_CHECK(gunzip(buffer.str()) == data);
+}
+
+static
+void
+parallel_threads()
+{
+  auto const data = content() + content();
+  std::stringstream buffer;
+  {
+    elle::format::gzip::ParallelStream filter(buffer, 4, 1 << 15);
+    filter << data;
+  }
+  BOOST_CHECK(gunzip(buffer.str()) == data);
+}
+
+static
+void
+parallel_empty()
+{
+  std::stringstream buffer;
+  {
+    elle::format::gzip::ParallelStream filter(buffer, 4);
+  }
+  BOOST_CHECK_EQUAL(gunzip(buffer.str()), "");
+}
+
+static
+void
+codecs()
+{
+  auto const data = content();
+  for (auto codec: {elle::format::Codec::none, elle::format::Codec::gzip})
+  {
+    BOOST_TEST_MESSAGE(codec);
+    auto const compressed =
+      elle::format::compress(codec, elle::ConstWeakBuffer(data));
+    BOOST_CHECK(elle::format::decompress(codec, compressed).string() == data);
+    for (auto jobs: {1, 4})
+    {
+      std::stringstream buffer;
+      {
+        auto stream = elle::format::compressor(codec, buffer, jobs);
+        *stream << data;
+      }
+      auto const output = buffer.str();
+      BOOST_CHECK(elle::format::decompress(
+                    codec, elle::ConstWeakBuffer(output)).string() == data);
+    }
+  }
+}
+
 ELLE_TEST_SUITE()
 {
   auto& suite = boost::unit_test::framework::master_test_suite();
@@ -139,4 +244,11 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(empty_content));
   suite.add(BOOST_TEST_CASE(empty_content_noflush));
   suite.add(BOOST_TEST_CASE(flush));
+  suite.add(BOOST_TEST_CASE(round_trip));
+  suite.add(BOOST_TEST_CASE(std::bind(parallel, 1, 1 << 15)));
+  suite.add(BOOST_TEST_CASE(std::bind(parallel, 3, 1 << 15)));
+  suite.add(BOOST_TEST_CASE(std::bind(parallel, 2, 1 << 20)));
+  suite.add(BOOST_TEST_CASE(parallel_threads));
+  suite.add(BOOST_TEST_CASE(parallel_empty));
+  suite.add(BOOST_TEST_CASE(codecs));
 }
@@ -1,3 +1,4 @@
+#include <map>
 #include <utility>
 
 #include <boost/algorithm/string.hpp>
@@ -14,9 +15,11 @@
 #include <elle/reactor/http/Client.hh>
 #include <elle/reactor/http/EscapedString.hh>
 #include <elle/reactor/http/Request.hh>
+#include <elle/reactor/http/Service.hh>
 #include <elle/reactor/http/exceptions.hh>
 #include <elle/reactor/network/Error.hh>
 #include <elle/reactor/network/TCPServer.hh>
+#include <elle/reactor/network/TCPSocket.hh>
 #include <elle/reactor/scheduler.hh>
 #include <elle/reactor/semaphore.hh>
 #include <elle/reactor/signal.hh>
@@ -764,6 +767,74 @@ ELLE_TEST_SCHEDULED(keep_alive)
   BOOST_CHECK_EQUAL(content, "dead");
 }
 
+ELLE_TEST_SCHEDULED(handle_pool)
+{
+  HTTPServer server;
+  server.register_route(
+    "/pool", elle::reactor::http::Method::GET,
+    [&] (HTTPServer::Headers const&,
+         HTTPServer::Cookies const& cookies,
+         HTTPServer::Parameters const&,
+         elle::Buffer const&) -> std::string
+    {
+      BOOST_CHECK(cookies.empty());
+      return "pool";
+    });
+  auto& service = boost::asio::use_service<elle::reactor::http::Service>(
+    elle::reactor::scheduler().io_service());
+  auto const requests = service.statistics().requests;
+  {
+    auto conf = elle::reactor::http::Request::Configuration{};
+    conf.cookies()["left"] = "over";
+    elle::reactor::http::Request r(server.url("pool"),
+                                   elle::reactor::http::Method::GET,
+                                   conf);
+    BOOST_CHECK_EQUAL(r.response(), "pool");
+  }
+  BOOST_CHECK_GE(service.pooled(), 1u);
+  auto const pooled = service.pooled();
+  {
+    // Reuses the pooled handle, without the previous request cookies.
+    elle::reactor::http::Request r(server.url("pool"));
+    BOOST_CHECK_EQUAL(service.pooled(), pooled - 1);
+    BOOST_CHECK_EQUAL(r.response(), "pool");
+  }
+  BOOST_CHECK_EQUAL(service.pooled(), pooled);
+  BOOST_CHECK_EQUAL(service.statistics().requests, requests + 2);
+  BOOST_CHECK_LE(service.statistics().reused, service.statistics().requests);
+}
+
+ELLE_TEST_SCHEDULED(bounded_buffer)
+{
+  HTTPServer server;
+  auto const size = 4 * 1024 * 1024;
+  server.register_route(
+    "/big", elle::reactor::http::Method::GET,
+    [&] (HTTPServer::Headers const&,
+         HTTPServer::Cookies const&,
+         HTTPServer::Parameters const&,
+         elle::Buffer const&) -> std::string
+    {
+      return std::string(size, 'x');
+    });
+  auto conf = elle::reactor::http::Request::Configuration{};
+  conf.buffer_size(64 * 1024);
+  elle::reactor::http::Request r(server.url("big"),
+                                 elle::reactor::http::Method::GET,
+                                 conf);
+  // Only waits for the headers.
+  BOOST_CHECK_EQUAL(r.status(), elle::reactor::http::StatusCode::OK);
+  // Lag behind so the transfer pauses.
+  elle::reactor::sleep(100ms);
+  auto read = 0;
+  char buffer[4096];
+  while (r.read(buffer, sizeof buffer), r.gcount())
+    read += r.gcount();
+  r.wait();
+  BOOST_CHECK_EQUAL(read, size);
+  BOOST_CHECK_GT(r.pause_count(), 0);
+}
+
 class RedirectHTTPServer
   : public HTTPServer
 {
@@ -789,6 +860,395 @@ ELLE_TEST_SCHEDULED(redirection)
   BOOST_CHECK_EQUAL(r.headers().at("Location"), "http://example.org/other");
 }
 
+ELLE_TEST_SCHEDULED(pipelining)
+{
+  HTTPServer server;
+  server.register_route("/echo/:word", elle::reactor::http::Method::GET,
+                        [&] (HTTPServer::Headers const&,
+                             HTTPServer::Cookies const&,
+                             HTTPServer::Parameters const& params,
+                             elle::Buffer const&) -> std::string
+                          {
+                            return params.at("word");
+                          });
+  server.register_route("/echo", elle::reactor::http::Method::POST,
+                        [&] (HTTPServer::Headers const&,
+                             HTTPServer::Cookies const&,
+                             HTTPServer::Parameters const&,
+                             elle::Buffer const& body) -> std::string
+                          {
+                            return body.string();
+                          });
+  elle::reactor::network::TCPSocket socket("127.0.0.1", server.port());
+  // All requests in one go, the last one closing the connection.
+  socket.write(elle::ConstWeakBuffer(
+                 "GET /echo/one HTTP/1.1\r\n"
+                 "Host: localhost\r\n"
+                 "\r\n"
+                 "POST /echo HTTP/1.1\r\n"
+                 "Content-Length: 3\r\n"
+                 "\r\n"
+                 "two"
+                 "GET /404 HTTP/1.1\r\n"
+                 "\r\n"
+                 "GET /echo/three HTTP/1.1\r\n"
+                 "Connection: close\r\n"
+                 "\r\n"));
+  auto response = [&] (std::string const& status,
+                       std::string const& connection)
+    {
+      auto const head = socket.read_until("\r\n\r\n").string();
+      BOOST_CHECK(boost::starts_with(head, "HTTP/1.1 " + status));
+      BOOST_CHECK(boost::contains(head, "Connection: " + connection));
+      auto const length = head.find("Content-Length: ") + 16;
+      return socket.read(
+        std::stoul(head.substr(length, head.find("\r\n", length) - length)))
+        .string();
+    };
+  BOOST_CHECK_EQUAL(response("200", "keep-alive"), "one");
+  BOOST_CHECK_EQUAL(response("200", "keep-alive"), "two");
+  response("404", "keep-alive");
+  BOOST_CHECK_EQUAL(response("200", "close"), "three");
+  BOOST_CHECK_THROW(socket.read_some(1),
+                    elle::reactor::network::ConnectionClosed);
+}
+
+ELLE_TEST_SCHEDULED(route_parameters)
+{
+  HTTPServer server;
+  auto route = [&] (std::string const& name)
+    {
+      server.register_route(
+        name, elle::reactor::http::Method::GET,
+        [name] (HTTPServer::Headers const&,
+                HTTPServer::Cookies const&,
+                HTTPServer::Parameters const& params,
+                elle::Buffer const&) -> std::string
+        {
+          auto res = name;
+          for (auto const& p: std::map<std::string, std::string>(
+                 params.begin(), params.end()))
+            res += elle::sprintf(" %s=%s", p.first, p.second);
+          return res;
+        });
+    };
+  route("/objects");
+  route("/objects/list");
+  route("/objects/:name");
+  route("/objects/:name/meta");
+  route("/options");
+  route("/files/*path");
+  auto get = [&] (std::string const& path)
+    {
+      return elle::reactor::http::get(server.url(path)).string();
+    };
+  BOOST_CHECK_EQUAL(get("objects"), "/objects");
+  BOOST_CHECK_EQUAL(get("objects/list"), "/objects/list");
+  BOOST_CHECK_EQUAL(get("objects/lis"), "/objects/:name name=lis");
+  BOOST_CHECK_EQUAL(get("objects/foo"), "/objects/:name name=foo");
+  BOOST_CHECK_EQUAL(get("objects/foo/meta?x=y"),
+                    "/objects/:name/meta name=foo x=y");
+  BOOST_CHECK_EQUAL(get("options"), "/options");
+  BOOST_CHECK_EQUAL(get("files/a/b/c"), "/files/*path path=a/b/c");
+  for (auto path: {"object", "objects/foo/bar", "files/", "optionss"})
+  {
+    elle::reactor::http::Request r(server.url(path));
+    BOOST_CHECK_EQUAL(r.status(), elle::reactor::http::StatusCode::Not_Found);
+  }
+  BOOST_CHECK_THROW(route("/objects/:id"), elle::Error);
+  BOOST_CHECK_THROW(route("/files/*path/more"), elle::Error);
+}
+
+ELLE_TEST_SCHEDULED(chunked_response)
+{
+  HTTPServer server;
+  server.register_stream(
+    "/stream", elle::reactor::http::Method::GET,
+    [&] (HTTPServer::Headers const&,
+         HTTPServer::Cookies const&,
+         HTTPServer::Parameters const&,
+         elle::Buffer const&,
+         HTTPServer::Writer const& write)
+    {
+      for (auto chunk: {"lorem ", "", "ipsum ", "dolor"})
+      {
+        write(elle::ConstWeakBuffer(chunk));
+        elle::reactor::yield();
+      }
+    });
+  elle::reactor::http::Request r(server.url("stream"));
+  BOOST_CHECK_EQUAL(r.status(), elle::reactor::http::StatusCode::OK);
+  BOOST_CHECK_EQUAL(r.headers().at("Transfer-Encoding"), "chunked");
+  BOOST_CHECK_EQUAL(r.response(), "lorem ipsum dolor");
+  // The connection survives for the next request.
+  BOOST_CHECK_EQUAL(elle::reactor::http::get(server.url("stream")).string(),
+                    "lorem ipsum dolor");
+}
+
+/// Read a response from the socket, returning its head and its content.
+static
+std::pair<std::string, std::string>
+read_response(elle::reactor::network::TCPSocket& socket,
+              elle::DurationOpt timeout = {})
+{
+  auto head = socket.read_until("\r\n\r\n", timeout).string();
+  auto const length = head.find("Content-Length: ") + 16;
+  auto content = socket.read(
+    std::stoul(head.substr(length, head.find("\r\n", length) - length)))
+    .string();
+  return {std::move(head), std::move(content)};
+}
+
+static
+void
+register_ok(HTTPServer& server)
+{
+  server.register_route("/", elle::reactor::http::Method::GET,
+                        [&] (HTTPServer::Headers const&,
+                             HTTPServer::Cookies const&,
+                             HTTPServer::Parameters const&,
+                             elle::Buffer const&) -> std::string
+                          {
+                            return "ok";
+                          });
+}
+
+ELLE_TEST_SCHEDULED(max_header_size)
+{
+  HTTPServer server;
+  server.max_header_size(128);
+  register_ok(server);
+  {
+    elle::reactor::network::TCPSocket socket("127.0.0.1", server.port());
+    socket.write(elle::ConstWeakBuffer(
+                   "GET / HTTP/1.1\r\n"
+                   "X-Padding: " + std::string(64, 'x') + "\r\n"
+                   "\r\n"));
+    auto const response = read_response(socket);
+    BOOST_CHECK(boost::starts_with(response.first, "HTTP/1.1 200"));
+    BOOST_CHECK_EQUAL(response.second, "ok");
+  }
+  {
+    // Small enough to be read at once, so the server doesn't reset the
+    // connection with unread data when closing it.
+    elle::reactor::network::TCPSocket socket("127.0.0.1", server.port());
+    socket.write(elle::ConstWeakBuffer(
+                   "GET / HTTP/1.1\r\n"
+                   "X-Padding: " + std::string(256, 'x') + "\r\n"
+                   "\r\n"));
+    auto const response = read_response(socket);
+    BOOST_CHECK(boost::starts_with(response.first, "HTTP/1.1 431"));
+    BOOST_CHECK(boost::contains(response.first, "Connection: close"));
+    BOOST_CHECK_THROW(socket.read_some(1),
+                      elle::reactor::network::ConnectionClosed);
+  }
+}
+
+ELLE_TEST_SCHEDULED(max_body_size)
+{
+  HTTPServer server;
+  server.max_body_size(16);
+  server.register_route("/", elle::reactor::http::Method::POST,
+                        [&] (HTTPServer::Headers const&,
+                             HTTPServer::Cookies const&,
+                             HTTPServer::Parameters const&,
+                             elle::Buffer const& body) -> std::string
+                          {
+                            return std::to_string(body.size());
+                          });
+  auto const post = [&] (std::string const& request)
+    {
+      elle::reactor::network::TCPSocket socket("127.0.0.1", server.port());
+      socket.write(elle::ConstWeakBuffer(request));
+      return read_response(socket);
+    };
+  {
+    auto const response = post("POST / HTTP/1.1\r\n"
+                               "Content-Length: 16\r\n"
+                               "\r\n" + std::string(16, 'x'));
+    BOOST_CHECK(boost::starts_with(response.first, "HTTP/1.1 200"));
+    BOOST_CHECK_EQUAL(response.second, "16");
+  }
+  // Rejected before reading the body.
+  BOOST_CHECK(boost::starts_with(
+                post("POST / HTTP/1.1\r\n"
+                     "Content-Length: 1000000000\r\n"
+                     "\r\n").first,
+                "HTTP/1.1 413"));
+  {
+    auto const response = post("POST / HTTP/1.1\r\n"
+                               "Transfer-Encoding: chunked\r\n"
+                               "\r\n"
+                               "8\r\n" + std::string(8, 'x') + "\r\n"
+                               "8\r\n" + std::string(8, 'x') + "\r\n"
+                               "0\r\n"
+                               "\r\n");
+    BOOST_CHECK(boost::starts_with(response.first, "HTTP/1.1 200"));
+    BOOST_CHECK_EQUAL(response.second, "16");
+  }
+  BOOST_CHECK(boost::starts_with(
+                post("POST / HTTP/1.1\r\n"
+                     "Transfer-Encoding: chunked\r\n"
+                     "\r\n"
+                     "8\r\n" + std::string(8, 'x') + "\r\n"
+                     "ffffffff\r\n").first,
+                "HTTP/1.1 413"));
+  // Chunk lines are bounded like headers.
+  server.max_header_size(64);
+  BOOST_CHECK(boost::starts_with(
+                post("POST / HTTP/1.1\r\n"
+                     "Transfer-Encoding: chunked\r\n"
+                     "\r\n"
+                     "8;" + std::string(128, 'x') + "\r\n").first,
+                "HTTP/1.1 431"));
+}
+
+ELLE_TEST_SCHEDULED(max_connections)
+{
+  HTTPServer server;
+  server.max_connections(1);
+  register_ok(server);
+  auto const get = elle::ConstWeakBuffer("GET / HTTP/1.1\r\n\r\n");
+  elle::reactor::network::TCPSocket first("127.0.0.1", server.port());
+  first.write(get);
+  BOOST_CHECK_EQUAL(read_response(first).second, "ok");
+  BOOST_CHECK_EQUAL(server.connections(), 1);
+  // The second client waits in the backlog while the first is kept alive.
+  elle::reactor::network::TCPSocket second("127.0.0.1", server.port());
+  second.write(get);
+  BOOST_CHECK_THROW(second.read_until("\r\n\r\n", 300ms),
+                    elle::reactor::network::TimeOut);
+  BOOST_CHECK_EQUAL(server.connections(), 1);
+  first.write(elle::ConstWeakBuffer(
+                "GET / HTTP/1.1\r\n"
+                "Connection: close\r\n"
+                "\r\n"));
+  BOOST_CHECK_EQUAL(read_response(first).second, "ok");
+  BOOST_CHECK_EQUAL(read_response(second, 5s).second, "ok");
+  BOOST_CHECK_EQUAL(server.connections(), 1);
+}
+
+ELLE_TEST_SCHEDULED(keep_alive_timeout)
+{
+  HTTPServer server;
+  server.keep_alive_timeout(500ms);
+  register_ok(server);
+  auto const get = elle::ConstWeakBuffer("GET / HTTP/1.1\r\n\r\n");
+  elle::reactor::network::TCPSocket socket("127.0.0.1", server.port());
+  socket.write(get);
+  BOOST_CHECK(boost::contains(read_response(socket).first,
+                              "Connection: keep-alive"));
+  // A request within the timeout reuses the connection.
+  elle::reactor::sleep(100ms);
+  socket.write(get);
+  BOOST_CHECK_EQUAL(read_response(socket).second, "ok");
+  BOOST_CHECK_EQUAL(server.connections(), 1);
+  // An idle connection is closed.
+  BOOST_CHECK_THROW(socket.read_some(1, 5s),
+                    elle::reactor::network::ConnectionClosed);
+  BOOST_CHECK_EQUAL(server.connections(), 0);
+}
+
+ELLE_TEST_SCHEDULED(native_backend)
+{
+  HTTPServer server;
+  server.register_route(
+    "/echo/:word", elle::reactor::http::Method::POST,
+    [&] (HTTPServer::Headers const&,
+         HTTPServer::Cookies const& cookies,
+         HTTPServer::Parameters const& params,
+         elle::Buffer const& body) -> std::string
+    {
+      auto res = params.at("word") + ":" + body.string();
+      for (auto const& cookie: cookies)
+        res += elle::sprintf(":%s=%s", cookie.first, cookie.second);
+      return res;
+    });
+  server.register_route(
+    "/big", elle::reactor::http::Method::GET,
+    [&] (HTTPServer::Headers const&,
+         HTTPServer::Cookies const&,
+         HTTPServer::Parameters const&,
+         elle::Buffer const&) -> std::string
+    {
+      return std::string(1024 * 1024, 'x');
+    });
+  auto conf = elle::reactor::http::Request::Configuration{};
+  conf.backend(elle::reactor::http::Backend::native);
+  auto& service = boost::asio::use_service<elle::reactor::http::Service>(
+    elle::reactor::scheduler().io_service());
+  auto const stats = service.statistics();
+  for (auto chunked: {false, true})
+  {
+    auto c = conf;
+    c.chunked_transfers(chunked);
+    c.cookies()["flavor"] = "chocolate";
+    elle::reactor::http::Request r(server.url("echo/cookie"),
+                                   elle::reactor::http::Method::POST,
+                                   "text/plain", c);
+    r << "body";
+    BOOST_CHECK_EQUAL(r.response(), "cookie:body:flavor=chocolate");
+    BOOST_CHECK_EQUAL(r.status(), elle::reactor::http::StatusCode::OK);
+    BOOST_CHECK_EQUAL(r.headers().at("Server"), "Custom HTTP of doom");
+  }
+  {
+    elle::reactor::http::Request r(server.url("404"),
+                                   elle::reactor::http::Method::GET, conf);
+    BOOST_CHECK_EQUAL(r.status(),
+                      elle::reactor::http::StatusCode::Not_Found);
+  }
+  {
+    auto c = conf;
+    c.buffer_size(64 * 1024);
+    elle::reactor::http::Request r(server.url("big"),
+                                   elle::reactor::http::Method::GET, c);
+    BOOST_CHECK_EQUAL(r.status(), elle::reactor::http::StatusCode::OK);
+    elle::reactor::sleep(100ms);
+    BOOST_CHECK_EQUAL(r.response().size(), 1024 * 1024);
+    BOOST_CHECK_GT(r.pause_count(), 0);
+  }
+  // Subsequent requests go through the kept-alive connection.
+  BOOST_CHECK_EQUAL(service.statistics().requests, stats.requests + 4);
+  BOOST_CHECK_GE(service.statistics().reused, stats.reused + 1);
+  BOOST_CHECK_GE(service.idle_connections(), 1u);
+  {
+    // HttpServer only keeps a few headers, check the raw request.
+    elle::reactor::network::TCPServer raw;
+    raw.listen();
+    auto head = std::string{};
+    elle::reactor::Thread serve(
+      "serve",
+      [&]
+      {
+        auto socket = raw.accept();
+        head = socket->read_until("\r\n\r\n").string();
+        socket->write(elle::ConstWeakBuffer(
+                        "HTTP/1.1 200 OK\r\n"
+                        "Content-Length: 0\r\n"
+                        "Connection: close\r\n"
+                        "\r\n"));
+      });
+    auto c = conf;
+    c.header_add("X-Flavor", "vanilla");
+    elle::reactor::http::Request r(
+      elle::sprintf("http://127.0.0.1:%s/", raw.port()),
+      elle::reactor::http::Method::GET, c);
+    BOOST_CHECK_EQUAL(r.status(), elle::reactor::http::StatusCode::OK);
+    elle::reactor::wait(serve);
+    BOOST_CHECK(boost::contains(head, "\r\nX-Flavor: vanilla\r\n"));
+  }
+  {
+    auto c = conf;
+    c.timeout(500ms);
+    elle::reactor::network::TCPServer silent;
+    silent.listen();
+    elle::reactor::http::Request r(
+      elle::sprintf("http://127.0.0.1:%s/", silent.port()),
+      elle::reactor::http::Method::GET, c);
+    BOOST_CHECK_THROW(r.wait(), elle::reactor::http::Timeout);
+  }
+}
+
 ELLE_TEST_SUITE()
 {
   auto& suite = boost::unit_test::framework::master_test_suite();
@@ -818,5 +1278,15 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(download_stall), 0, valgrind(40));
   suite.add(BOOST_TEST_CASE(query_string), 0, valgrind(1));
   suite.add(BOOST_TEST_CASE(keep_alive), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(handle_pool), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(bounded_buffer), 0, valgrind(5));
   suite.add(BOOST_TEST_CASE(redirection), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(pipelining), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(route_parameters), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(chunked_response), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(max_header_size), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(max_body_size), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(max_connections), 0, valgrind(10));
+  suite.add(BOOST_TEST_CASE(keep_alive_timeout), 0, valgrind(10));
+  suite.add(BOOST_TEST_CASE(native_backend), 0, valgrind(5));
 }
@@ -1,17 +1,30 @@
+#include <fstream>
 #include <memory>
+#include <random>
 #include <utility>
+#include <vector>
+
+#ifndef ELLE_WINDOWS
+# include <fcntl.h>
+# include <unistd.h>
+#endif
 
 #include <boost/bind.hpp>
 
 #include <elle/Buffer.hh>
+#include <elle/filesystem/TemporaryFile.hh>
+#include <elle/finally.hh>
+#include <elle/fstream.hh>
 #include <elle/log.hh>
 #include <elle/memory.hh>
 #include <elle/os/environ.hh>
 #include <elle/test.hh>
+#include <elle/With.hh>
 #include <elle/utility/Move.hh>
 
 #include <elle/reactor/asio.hh>
 #include <elle/reactor/Scope.hh>
+#include <elle/reactor/network/ConnectionPool.hh>
 #include <elle/reactor/network/Error.hh>
 #include <elle/reactor/network/resolve.hh>
 #include <elle/reactor/network/TCPServer.hh>
@@ -488,7 +501,7 @@ read_until()
     sched, "main",
     []
     {
-      ContentServer server("foo\r\nx\r\nbar\r\n");
+      ContentServer server("foo\r\nx\r\nbar\r\nlonger\r\n");
 
       elle::reactor::network::TCPSocket sock("127.0.0.1", server.port());
       BOOST_CHECK_EQUAL(sock.read_until("\r\n"), "foo\r\n");
@@ -497,6 +510,9 @@ read_until()
       BOOST_CHECK_EQUAL(c, 'x');
       BOOST_CHECK_EQUAL(sock.read_until("\r\n"), "\r\n");
       BOOST_CHECK_EQUAL(sock.read_until("\r\n"), "bar\r\n");
+      // Stop at the limit if the delimiter doesn't end within it.
+      BOOST_CHECK_EQUAL(sock.read_until("\r\n", {}, 4), "long");
+      BOOST_CHECK_EQUAL(sock.read_until("\r\n", {}, 4), "er\r\n");
     });
 
   sched.run();
@@ -801,6 +817,301 @@ ELLE_TEST_SCHEDULED(async_write)
   elle::reactor::wait(read);
 }
 
+/*------------.
+| Coalescing |
+`------------*/
+
+ELLE_TEST_SCHEDULED(coalesce)
+{
+  elle::reactor::network::TCPServer server;
+  server.listen();
+  elle::reactor::Barrier read;
+  elle::reactor::Thread accept(
+    "accept",
+    [&]
+    {
+      auto socket = server.accept();
+      BOOST_TEST(socket->read(18) == "foobarbazquuxlarge");
+      BOOST_TEST(socket->read(4) == "0123");
+      read.open();
+    });
+  TCPSocket socket("127.0.0.1", server.port());
+  socket.coalesce_threshold(4);
+  socket.cork();
+  socket.write("foo");
+  socket.write("bar");
+  elle::reactor::Thread writer(
+    "writer",
+    [&]
+    {
+      // Corked, this is held too, even though it is large.
+      socket.write("baz");
+      socket.write("quux");
+    });
+  elle::reactor::wait(writer);
+  socket.uncork();
+  socket.write("large");
+  // Concurrent small writes are gathered with the one in progress, in order.
+  elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+  {
+    for (auto c: {"0", "1", "2", "3"})
+      scope.run_background(c, [&socket, c] { socket.write(c); });
+    scope.wait();
+  };
+  elle::reactor::wait(read);
+}
+
+ELLE_TEST_SCHEDULED(coalesce_gather)
+{
+  auto const large = std::string(32 * 1024 * 1024, 'L');
+  elle::reactor::network::TCPServer server;
+  server.listen();
+  elle::reactor::Barrier go;
+  elle::reactor::Thread accept(
+    "accept",
+    [&]
+    {
+      auto socket = server.accept();
+      elle::reactor::wait(go);
+      BOOST_TEST(socket->read(large.size()).string() == large);
+      BOOST_TEST(socket->read(4) == "0123");
+    });
+  TCPSocket socket("127.0.0.1", server.port());
+  socket.coalesce_threshold(4);
+  elle::reactor::Thread writer(
+    "writer", [&] { socket.write(elle::ConstWeakBuffer(large)); });
+  elle::reactor::yield();
+  elle::reactor::yield();
+  // The large write is in progress, small ones are gathered and return.
+  for (auto c: {"0", "1", "2", "3"})
+    socket.write(c);
+  BOOST_TEST(socket.coalesce_batches() == 1u);
+  go.open();
+  elle::reactor::wait(writer);
+  // They went out in one write, right after the large one.
+  BOOST_TEST(socket.coalesce_batches() == 2u);
+  elle::reactor::wait(accept);
+}
+
+ELLE_TEST_SCHEDULED(coalesce_delay_race)
+{
+  // Small writes held by coalesce_delay are flushed from a timer, which may
+  // fire while large writes wait for the lock. It must leave the latter to
+  // their writers, and keep the order.
+  auto const rounds = 100;
+  auto const size = 64 * 1024;
+  auto const total = rounds * (2 * size + 8);
+  elle::reactor::network::TCPServer server;
+  server.listen();
+  auto received = std::string();
+  elle::reactor::Thread accept(
+    "accept",
+    [&]
+    {
+      auto socket = server.accept();
+      received = socket->read(total).string();
+    });
+  TCPSocket socket("127.0.0.1", server.port());
+  socket.coalesce_threshold(16);
+  socket.coalesce_delay(1ms);
+  auto expected = std::string();
+  auto write = [&] (std::string const& data)
+    {
+      expected += data;
+      socket.write(elle::ConstWeakBuffer(data));
+    };
+  auto random = std::mt19937(42);
+  for (int i = 0; i < rounds; ++i)
+    elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+    {
+      write(elle::sprintf("%04d", i));
+      for (auto c: {'a', 'b'})
+        scope.run_background(
+          elle::sprintf("large %s", c),
+          [&, c] { write(std::string(size, c)); });
+      elle::reactor::yield();
+      write(elle::sprintf("%04d", i));
+      elle::reactor::sleep(std::chrono::microseconds(
+        std::uniform_int_distribution<int>(0, 2000)(random)));
+      scope.wait();
+    };
+  elle::reactor::wait(accept);
+  BOOST_TEST(received.size() == expected.size());
+  BOOST_TEST((received == expected));
+}
+
+/*----------.
+| Acceptors |
+`----------*/
+
+#ifdef ELLE_LINUX
+ELLE_TEST_SCHEDULED(multiple_acceptors)
+{
+  auto const clients = 16;
+  elle::reactor::network::TCPServer server;
+  server.acceptors(4);
+  server.backlog(64);
+  server.fast_open(16);
+  server.defer_accept(1s);
+  server.listen();
+  BOOST_TEST(server.reuse_port() == false);
+  auto sockets = std::vector<std::unique_ptr<TCPSocket>>{};
+  for (int i = 0; i < clients; ++i)
+  {
+    sockets.emplace_back(
+      std::make_unique<TCPSocket>("127.0.0.1", server.port()));
+    // Deferred accept: connections are only handed over with data.
+    sockets.back()->write(elle::ConstWeakBuffer("x"));
+  }
+  for (int i = 0; i < clients; ++i)
+  {
+    auto socket = server.accept();
+    BOOST_TEST(socket->read(1) == "x");
+  }
+  BOOST_TEST(server.accept_queue_depth() == 0);
+}
+#endif
+
+/*------.
+| Files |
+`------*/
+
+#ifndef ELLE_WINDOWS
+ELLE_TEST_SCHEDULED(send_file)
+{
+  auto const size = 3 * elle::reactor::network::Socket::buffer_size + 42;
+  auto data = std::string(size, 0);
+  for (std::size_t i = 0; i < size; ++i)
+    data[i] = static_cast<char>(i % 251);
+  auto source = elle::filesystem::TemporaryFile("source");
+  auto target = elle::filesystem::TemporaryFile("target");
+  std::ofstream(source.path().string(), std::ios::binary) << data;
+  int in = ::open(source.path().string().c_str(), O_RDONLY);
+  int out = ::open(target.path().string().c_str(),
+                   O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  BOOST_REQUIRE(in >= 0 && out >= 0);
+  elle::SafeFinally close([&] { ::close(in); ::close(out); });
+  elle::reactor::network::TCPServer server;
+  server.listen();
+  elle::reactor::Thread serve(
+    "serve",
+    [&]
+    {
+      auto socket = server.accept();
+      // Pending stream data goes out before the file.
+      *socket << "header\n";
+      BOOST_TEST(socket->send_file(in, 0, size) == size);
+      // Short at end of file.
+      BOOST_TEST(socket->send_file(in, size - 2, 16) == 2);
+    });
+  TCPSocket socket("127.0.0.1", server.port());
+  // Reading a line may buffer part of the file already.
+  BOOST_TEST(socket.read_until("\n") == "header\n");
+  socket.receive_to_file(out, 0, size + 2, 10s);
+  elle::reactor::wait(serve);
+  BOOST_TEST(elle::content(target.path()) == data + data.substr(size - 2));
+}
+
+ELLE_TEST_SCHEDULED(receive_to_file_unspliceable)
+{
+  auto const size = 3 * elle::reactor::network::Socket::buffer_size + 42;
+  auto data = std::string(size, 0);
+  for (std::size_t i = 0; i < size; ++i)
+    data[i] = static_cast<char>(i % 251);
+  auto target = elle::filesystem::TemporaryFile("target");
+  // Files opened for appending reject splice.
+  int out = ::open(target.path().string().c_str(),
+                   O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600);
+  BOOST_REQUIRE(out >= 0);
+  elle::SafeFinally close([&] { ::close(out); });
+  elle::reactor::network::TCPServer server;
+  server.listen();
+  elle::reactor::Thread serve(
+    "serve",
+    [&]
+    {
+      auto socket = server.accept();
+      socket->write(elle::ConstWeakBuffer(data));
+      socket->write("trailer\n");
+    });
+  TCPSocket socket("127.0.0.1", server.port());
+  socket.receive_to_file(out, 0, size, 10s);
+  // No byte was lost, and the stream is still in sync.
+  BOOST_TEST(elle::content(target.path()) == data);
+  BOOST_TEST(socket.read_until("\n") == "trailer\n");
+  elle::reactor::wait(serve);
+}
+#endif
+
+/*-----------------.
+| Connection pool |
+`-----------------*/
+
+ELLE_TEST_SCHEDULED(connection_pool)
+{
+  elle::reactor::network::TCPServer server;
+  server.listen();
+  auto const port = server.port();
+  elle::reactor::Thread serve(
+    "serve",
+    [&]
+    {
+      elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+      {
+        while (true)
+        {
+          auto socket = elle::utility::move_on_copy(server.accept());
+          scope.run_background(
+            "echo",
+            [socket]
+            {
+              try
+              {
+                while (true)
+                {
+                  auto line = socket->read_until("\n");
+                  socket->write(line);
+                }
+              }
+              catch (elle::reactor::network::ConnectionClosed const&)
+              {}
+            });
+        }
+      };
+    });
+  elle::reactor::network::ConnectionPool pool;
+  auto const exchange = [&]
+    {
+      auto connection = pool.lease("localhost", port);
+      connection->write("ping\n");
+      BOOST_TEST(connection->read_until("\n") == "ping\n");
+      return connection.reused();
+    };
+  BOOST_TEST(!exchange());
+  BOOST_TEST(pool.idle("localhost", std::to_string(port)) == 1u);
+  BOOST_TEST(exchange());
+  BOOST_TEST(pool.hits() == 1);
+  BOOST_TEST(pool.misses() == 1);
+  // Discarded connections are not reused.
+  {
+    auto connection = pool.lease("localhost", port);
+    connection.discard();
+  }
+  BOOST_TEST(pool.idle("localhost", std::to_string(port)) == 0u);
+  BOOST_TEST(!exchange());
+  // Connections with unread data are not reused.
+  {
+    auto connection = pool.lease("localhost", port);
+    connection->write("ping\n");
+    elle::reactor::sleep(100ms);
+  }
+  BOOST_TEST(!exchange());
+  // Connections closed by the peer are not reused.
+  serve.terminate_now();
+  elle::reactor::sleep(100ms);
+  BOOST_TEST(!pool.lease("localhost", port).reused());
+}
+
 /*-----------.
 | Test suite |
 `-----------*/
@@ -840,4 +1151,15 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(read_terminate_recover_iostream), 0, 1);
   suite.add(BOOST_TEST_CASE(read_terminate_deadlock), 0, 1);
   suite.add(BOOST_TEST_CASE(async_write), 0, 10);
+  suite.add(BOOST_TEST_CASE(coalesce), 0, 10);
+  suite.add(BOOST_TEST_CASE(coalesce_gather), 0, 10);
+  suite.add(BOOST_TEST_CASE(coalesce_delay_race), 0, 30);
+#ifdef ELLE_LINUX
+  suite.add(BOOST_TEST_CASE(multiple_acceptors), 0, 10);
+#endif
+#ifndef ELLE_WINDOWS
+  suite.add(BOOST_TEST_CASE(send_file), 0, 10);
+  suite.add(BOOST_TEST_CASE(receive_to_file_unspliceable), 0, 10);
+#endif
+  suite.add(BOOST_TEST_CASE(connection_pool), 0, 10);
 }
@@ -1,6 +1,10 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <random>
+
+#include <boost/asio/coroutine.hpp>
+#include <boost/optional.hpp>
 
 #include "reactor.hh"
 
@@ -12,8 +16,11 @@
 #include <elle/reactor/Channel.hh>
 #include <elle/reactor/MultiLockBarrier.hh>
 #include <elle/reactor/OrWaitable.hh>
+#include <elle/reactor/RingBuffer.hh>
 #include <elle/reactor/Scope.hh>
+#include <elle/reactor/Task.hh>
 #include <elle/reactor/TimeoutGuard.hh>
+#include <elle/reactor/TimerWheel.hh>
 #include <elle/reactor/asio.hh>
 #include <elle/reactor/duration.hh>
 #include <elle/reactor/exception.hh>
@@ -289,7 +296,7 @@ namespace waitable
     }
 
     bool
-    _wait(elle::reactor::Thread*, Waker const&) override
+    _wait(Handler&) override
     {
       return false;
     }
@@ -334,6 +341,52 @@ namespace waitable
     }
   }
 
+  ELLE_TEST_SCHEDULED(logical_or_timeout)
+  {
+    elle::reactor::Barrier a("A");
+    elle::reactor::Barrier b("B");
+    {
+      auto w = a || b;
+      BOOST_CHECK(!elle::reactor::wait(w, 10ms));
+      BOOST_CHECK(w.waiters().empty());
+    }
+    BOOST_CHECK(a.waiters().empty());
+    BOOST_CHECK(b.waiters().empty());
+  }
+
+  ELLE_TEST_SCHEDULED(many)
+  {
+    // More waitables than handlers held inline.
+    auto barriers = std::vector<elle::reactor::Barrier>(5);
+    auto waitables = elle::reactor::Waitables{};
+    for (auto& b: barriers)
+      waitables.push_back(&b);
+    bool beacon = false;
+    elle::reactor::Thread waiter(
+      "waiter",
+      [&]
+      {
+        elle::reactor::wait(waitables);
+        beacon = true;
+      });
+    elle::reactor::yield();
+    for (auto& b: barriers)
+    {
+      BOOST_CHECK_EQUAL(b.waiters().size(), 1);
+      BOOST_CHECK(!beacon);
+      b.open();
+      elle::reactor::yield();
+    }
+    elle::reactor::yield();
+    BOOST_CHECK(beacon);
+    for (auto& b: barriers)
+      b.close();
+    barriers[2].open();
+    BOOST_CHECK(!elle::reactor::wait(waitables, 10ms));
+    for (auto& b: barriers)
+      BOOST_CHECK(b.waiters().empty());
+  }
+
   ELLE_TEST_SCHEDULED(boost_signal)
   {
     boost::signals2::signal<void ()> signal;
@@ -1069,6 +1122,44 @@ ELLE_TEST_SCHEDULED(test_sleep_timing)
   }
 }
 
+static
+void
+test_sleep_simulated()
+{
+  elle::reactor::Scheduler sched;
+  sched.simulated(true);
+  auto const epoch = elle::Time();
+  int step = 0;
+  elle::reactor::Thread s1(
+    sched, "sleeper1",
+    [&]
+    {
+      elle::reactor::sleep(2h);
+      BOOST_CHECK_EQUAL(step, 1);
+      BOOST_CHECK(sched.now() == epoch + 2h);
+      ++step;
+    });
+  elle::reactor::Thread s2(
+    sched, "sleeper2",
+    [&]
+    {
+      elle::reactor::Barrier never;
+      BOOST_CHECK(!elle::reactor::wait(never, 30min));
+      BOOST_CHECK(sched.now() == epoch + 30min);
+      BOOST_CHECK_THROW(
+        {
+          elle::reactor::TimeoutGuard guard(30min);
+          elle::reactor::sleep(1h);
+        },
+        elle::reactor::Timeout);
+      BOOST_CHECK(sched.now() == epoch + 1h);
+      BOOST_CHECK_EQUAL(step, 0);
+      ++step;
+    });
+  sched.run();
+  BOOST_CHECK_EQUAL(step, 2);
+}
+
 /*------.
 | Every |
 `------*/
@@ -2901,6 +2992,100 @@ namespace channel
   }
 }
 
+namespace channel
+{
+  ELLE_TEST_SCHEDULED(batch)
+  {
+    using Channel =
+      elle::reactor::Channel<int, elle::reactor::RingBuffer<int>>;
+    Channel channel;
+    channel.max_size(4);
+    auto puts = 0;
+    auto gets = 0;
+    channel.on_put().connect([&] { ++puts; });
+    channel.on_get().connect([&] { ++gets; });
+    elle::With<elle::reactor::Scope>() << [&](elle::reactor::Scope &s)
+    {
+      s.run_background(
+        "writer",
+        [&]
+        {
+          auto data = std::vector<int>{};
+          for (int i = 0; i < 10; ++i)
+            data.push_back(i);
+          channel.put_batch(std::move(data));
+          channel.put(10);
+        });
+      s.run_background(
+        "reader",
+        [&]
+        {
+          auto expected = 0;
+          while (expected <= 10)
+          {
+            auto batch = channel.get_batch(3);
+            BOOST_CHECK_LE(batch.size(), 3u);
+            BOOST_CHECK_LE(channel.size(), 4);
+            for (auto i: batch)
+              BOOST_CHECK_EQUAL(i, expected++);
+          }
+        });
+      elle::reactor::wait(s);
+    };
+    // Signals are emitted per batch.
+    BOOST_CHECK_LT(puts, 11);
+    BOOST_CHECK_LT(gets, 11);
+  }
+
+  ELLE_TEST_SCHEDULED(ring_buffer)
+  {
+    elle::reactor::RingBuffer<std::string> ring(3);
+    BOOST_CHECK_EQUAL(ring.capacity(), 4u);
+    // Wrap around, then grow while wrapped.
+    for (int i = 0; i < 3; ++i)
+      ring.push(std::to_string(i));
+    ring.pop();
+    ring.pop();
+    for (int i = 3; i < 8; ++i)
+      ring.push(std::to_string(i));
+    BOOST_CHECK_EQUAL(ring.size(), 6u);
+    BOOST_CHECK_EQUAL(ring.capacity(), 8u);
+    for (int i = 2; i < 8; ++i)
+    {
+      BOOST_CHECK_EQUAL(ring.front(), std::to_string(i));
+      ring.pop();
+    }
+    BOOST_CHECK(ring.empty());
+  }
+
+  ELLE_TEST_SCHEDULED(mt_put)
+  {
+    elle::reactor::Channel<int> channel;
+    auto const threads = 4;
+    auto const count = 10000;
+    auto producers = std::vector<std::thread>{};
+    for (int t = 0; t < threads; ++t)
+      producers.emplace_back(
+        [&, t]
+        {
+          for (int i = 0; i < count; ++i)
+            channel.mt_put(t * count + i);
+        });
+    // Every element is received, in order for a given thread.
+    auto last = std::vector<int>(threads, -1);
+    for (int i = 0; i < threads * count; )
+      for (auto v: channel.get_batch(count))
+      {
+        BOOST_CHECK_LT(last[v / count], v % count);
+        last[v / count] = v % count;
+        ++i;
+      }
+    for (auto& p: producers)
+      p.join();
+    BOOST_CHECK(channel.empty());
+  }
+}
+
 ELLE_TEST_SCHEDULED(test_released_signal)
 {
   using elle::reactor::Thread;
@@ -3117,6 +3302,86 @@ namespace timer
     t.terminate_now();
     BOOST_CHECK_EQUAL(v, 3);
   }
+
+  static
+  void
+  wheel()
+  {
+    using elle::reactor::TimerWheel;
+    TimerWheel wheel(0ms);
+    auto random = std::mt19937(42);
+    auto now = elle::Duration(0);
+    auto const count = 1000;
+    auto timers = std::vector<TimerWheel::Timer>(count);
+    auto deadlines = std::vector<elle::Duration>(count);
+    auto expired = std::vector<elle::Duration>(count, -1ms);
+    for (int i = 0; i < count; ++i)
+    {
+      // Spread deadlines over every level of the wheel, and beyond.
+      deadlines[i] = std::chrono::milliseconds(
+        std::uniform_int_distribution<std::int64_t>(
+          0, std::int64_t(1) << (i % 40))(random));
+      wheel.arm(timers[i], deadlines[i], [&, i] { expired[i] = now; });
+    }
+    for (int i = 0; i < count; i += 5)
+      timers[i].cancel();
+    BOOST_CHECK_EQUAL(wheel.size(), count - count / 5);
+    // Timers may rearm themselves and cancel others.
+    TimerWheel::Timer periodic;
+    int ticks = 0;
+    std::function<void ()> tick = [&]
+      {
+        if (++ticks < 3)
+          wheel.arm(periodic, now + 10ms, tick);
+        else
+          timers[39].cancel();
+      };
+    wheel.arm(periodic, 10ms, tick);
+    while (!wheel.empty())
+    {
+      now = std::max(now, wheel.next());
+      wheel.advance(now);
+    }
+    BOOST_CHECK_EQUAL(ticks, 3);
+    for (int i = 0; i < count; ++i)
+      if (i % 5 == 0 || (i == 39 && deadlines[i] > 30ms))
+        BOOST_CHECK(expired[i] == -1ms);
+      else
+        BOOST_CHECK(expired[i] == deadlines[i]);
+  }
+
+  static
+  void
+  call_later()
+  {
+    elle::reactor::Scheduler sched;
+    auto order = std::vector<int>{};
+    elle::reactor::Thread main(
+      sched, "main",
+      [&]
+      {
+        for (auto i: {3, 1, 2})
+          sched.call_later(elle::sprintf("call %s", i),
+                           [&, i] { order.push_back(i); },
+                           i * 10ms);
+        sched.call_later(
+          "spawn",
+          [&]
+          {
+            sched.run_later("spawned", [&]
+              {
+                elle::reactor::sleep(10ms);
+                order.push_back(4);
+              });
+          },
+          40ms);
+      });
+    // Pending calls keep the scheduler running once every thread is done.
+    auto const start = elle::Clock::now();
+    sched.run();
+    BOOST_CHECK_EQUAL(order, std::vector<int>({1, 2, 3, 4}));
+    BOOST_CHECK(elle::Clock::now() - start >= 50ms);
+  }
 }
 
 namespace timeout_
@@ -3180,6 +3445,165 @@ namespace timeout_
   }
 }
 
+namespace task
+{
+  ELLE_TEST_SCHEDULED(basic)
+  {
+    elle::reactor::Barrier barrier;
+    auto steps = std::vector<int>{};
+    elle::reactor::Task task(
+      "task",
+      [&, step = 0] (elle::reactor::Task& self) mutable
+      {
+        steps.push_back(step);
+        if (step++ == 0)
+          self.wait(barrier);
+        else if (step == 2)
+          self.sleep(10ms);
+      });
+    elle::reactor::yield();
+    BOOST_CHECK_EQUAL(task.state(), elle::reactor::Task::State::waiting);
+    BOOST_CHECK_EQUAL(steps, std::vector<int>({0}));
+    barrier.open();
+    elle::reactor::wait(task);
+    BOOST_CHECK(task.done());
+    BOOST_CHECK_EQUAL(steps, std::vector<int>({0, 1, 2}));
+  }
+
+  ELLE_TEST_SCHEDULED(coroutine)
+  {
+    elle::reactor::Barrier barrier;
+    auto values = std::vector<int>{};
+    elle::reactor::Task task(
+      "task",
+      [&, coro = boost::asio::coroutine(), i = 0]
+      (elle::reactor::Task& self) mutable
+      {
+        BOOST_ASIO_CORO_REENTER(coro)
+        {
+          for (i = 0; i < 3; ++i)
+          {
+            values.push_back(i);
+            BOOST_ASIO_CORO_YIELD self.yield();
+          }
+          BOOST_ASIO_CORO_YIELD self.wait(barrier);
+          values.push_back(i);
+        }
+      });
+    while (values.size() < 3)
+      elle::reactor::yield();
+    BOOST_CHECK(!task.done());
+    barrier.open();
+    elle::reactor::wait(task);
+    BOOST_CHECK_EQUAL(values, std::vector<int>({0, 1, 2, 3}));
+  }
+
+  ELLE_TEST_SCHEDULED(timeout)
+  {
+    elle::reactor::Barrier barrier;
+    auto timed_out = boost::optional<bool>{};
+    elle::reactor::Task task(
+      "task",
+      [&] (elle::reactor::Task& self)
+      {
+        if (!timed_out)
+        {
+          timed_out = false;
+          self.wait(barrier, 10ms);
+        }
+        else
+          timed_out = self.timed_out();
+      });
+    elle::reactor::wait(task);
+    BOOST_CHECK(timed_out && *timed_out);
+    BOOST_CHECK_EQUAL(barrier.waiters().size(), 0);
+  }
+
+  ELLE_TEST_SCHEDULED(managed_exception)
+  {
+    elle::reactor::Barrier barrier;
+    elle::reactor::Task task(
+      "task",
+      [&, waited = false] (elle::reactor::Task& self) mutable
+      {
+        if (!waited)
+        {
+          waited = true;
+          self.wait(barrier);
+        }
+        else
+          throw BeaconException();
+      });
+    task.managed(true);
+    barrier.open();
+    BOOST_CHECK_THROW(elle::reactor::wait(task), BeaconException);
+    BOOST_CHECK(task.done());
+    BOOST_CHECK(task.exception_thrown());
+  }
+
+  static
+  void
+  unmanaged_exception()
+  {
+    elle::reactor::Scheduler sched;
+    elle::reactor::Task task(
+      sched, "task",
+      [] (elle::reactor::Task&) { throw BeaconException(); });
+    BOOST_CHECK_THROW(sched.run(), BeaconException);
+  }
+
+  ELLE_TEST_SCHEDULED(terminate)
+  {
+    elle::reactor::Barrier barrier;
+    int runs = 0;
+    elle::reactor::Task task(
+      "task",
+      [&] (elle::reactor::Task& self)
+      {
+        ++runs;
+        self.wait(barrier);
+      });
+    elle::reactor::Thread waiter(
+      "waiter", [&] { elle::reactor::wait(task); });
+    elle::reactor::yield();
+    elle::reactor::yield();
+    BOOST_CHECK_EQUAL(runs, 1);
+    task.terminate();
+    elle::reactor::wait(waiter);
+    BOOST_CHECK_EQUAL(barrier.waiters().size(), 0);
+    barrier.open();
+    elle::reactor::yield();
+    BOOST_CHECK_EQUAL(runs, 1);
+  }
+
+  ELLE_TEST_SCHEDULED(fan_out)
+  {
+    auto const count = valgrind(10000, 10);
+    elle::reactor::Barrier barrier;
+    int done = 0;
+    auto tasks = std::vector<std::unique_ptr<elle::reactor::Task>>{};
+    for (int i = 0; i < count; ++i)
+      tasks.emplace_back(std::make_unique<elle::reactor::Task>(
+        elle::sprintf("task %s", i),
+        [&, waited = false] (elle::reactor::Task& self) mutable
+        {
+          if (!waited)
+          {
+            waited = true;
+            self.wait(barrier);
+          }
+          else
+            ++done;
+        }));
+    elle::reactor::yield();
+    BOOST_CHECK_EQUAL(barrier.waiters().size(), count);
+    barrier.open();
+    for (auto& task: tasks)
+      elle::reactor::wait(*task);
+    BOOST_CHECK_EQUAL(done, count);
+  }
+}
+
 namespace non_interruptible
 {
   ELLE_TEST_SCHEDULED(terminate)
@@ -3370,6 +3794,12 @@ ELLE_TEST_SUITE()
     channels->add(BOOST_TEST_CASE(open_close), 0, valgrind(1, 5));
     auto exception = &channel::exception;
     channels->add(BOOST_TEST_CASE(exception), 0, valgrind(1, 5));
+    auto batch = &channel::batch;
+    channels->add(BOOST_TEST_CASE(batch), 0, valgrind(1, 5));
+    auto ring_buffer = &channel::ring_buffer;
+    channels->add(BOOST_TEST_CASE(ring_buffer), 0, valgrind(1, 5));
+    auto mt_put = &channel::mt_put;
+    channels->add(BOOST_TEST_CASE(mt_put), 0, valgrind(5, 5));
   }
 
   {
@@ -3378,6 +3808,8 @@ ELLE_TEST_SUITE()
     using namespace waitable;
     subsuite->add(BOOST_TEST_CASE(exception_no_wait), 0, valgrind(1, 5));
     subsuite->add(BOOST_TEST_CASE(logical_or), 0, valgrind(1, 5));
+    subsuite->add(BOOST_TEST_CASE(logical_or_timeout), 0, valgrind(1, 5));
+    subsuite->add(BOOST_TEST_CASE(many), 0, valgrind(1, 5));
     subsuite->add(BOOST_TEST_CASE(boost_signal), 0, valgrind(1, 5));
     subsuite->add(BOOST_TEST_CASE(boost_signal_args), 0, valgrind(1, 5));
     subsuite->add(BOOST_TEST_CASE(boost_signal_predicate), 0, valgrind(1, 5));
@@ -3426,6 +3858,10 @@ ELLE_TEST_SUITE()
     timer->add(BOOST_TEST_CASE(terminate_after_start), 0, valgrind(1, 5));
     auto terminate_now_after_start = &timer::terminate_now_after_start;
     timer->add(BOOST_TEST_CASE(terminate_now_after_start), 0, valgrind(1, 5));
+    auto wheel = &timer::wheel;
+    timer->add(BOOST_TEST_CASE(wheel), 0, valgrind(1, 5));
+    auto call_later = &timer::call_later;
+    timer->add(BOOST_TEST_CASE(call_later), 0, valgrind(1, 5));
   }
 
   // Scope
@@ -3457,6 +3893,7 @@ ELLE_TEST_SUITE()
     boost::unit_test::framework::master_test_suite().add(sleep);
     sleep->add(BOOST_TEST_CASE(test_sleep_interleave), 0, valgrind(1, 5));
     sleep->add(BOOST_TEST_CASE(test_sleep_timing), 0, valgrind(10, 3));
+    sleep->add(BOOST_TEST_CASE(test_sleep_simulated), 0, valgrind(1, 5));
   }
 
   {
@@ -3594,6 +4031,25 @@ ELLE_TEST_SUITE()
     s->add(BOOST_TEST_CASE(race_condition), 0, valgrind(1, 5));
   }
 
+  {
+    boost::unit_test::test_suite* s = BOOST_TEST_SUITE("task");
+    boost::unit_test::framework::master_test_suite().add(s);
+    auto basic = &task::basic;
+    s->add(BOOST_TEST_CASE(basic), 0, valgrind(1, 5));
+    auto coroutine = &task::coroutine;
+    s->add(BOOST_TEST_CASE(coroutine), 0, valgrind(1, 5));
+    auto timeout = &task::timeout;
+    s->add(BOOST_TEST_CASE(timeout), 0, valgrind(1, 5));
+    auto managed_exception = &task::managed_exception;
+    s->add(BOOST_TEST_CASE(managed_exception), 0, valgrind(1, 5));
+    auto unmanaged_exception = &task::unmanaged_exception;
+    s->add(BOOST_TEST_CASE(unmanaged_exception), 0, valgrind(1, 5));
+    auto terminate = &task::terminate;
+    s->add(BOOST_TEST_CASE(terminate), 0, valgrind(1, 5));
+    auto fan_out = &task::fan_out;
+    s->add(BOOST_TEST_CASE(fan_out), 0, valgrind(1, 5));
+  }
+
 #if !defined(ELLE_WINDOWS) && !defined(ELLE_IOS)
   {
     boost::unit_test::test_suite* system_signals =
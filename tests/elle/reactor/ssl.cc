@@ -1,12 +1,23 @@
+#include <fstream>
+#include <thread>
+
 #include <unistd.h>
 #ifdef ELLE_WINDOWS
 # include <winsock2.h>
+#else
+# include <arpa/inet.h>
+# include <fcntl.h>
+# include <netinet/in.h>
+# include <sys/socket.h>
 #endif
 
+#include <openssl/ssl.h>
+
 #include <boost/algorithm/string/predicate.hpp> // boost::contains
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#include <elle/filesystem/TemporaryFile.hh>
 #include <elle/finally.hh>
 #include <elle/os/environ.hh>
 #include <elle/test.hh>
@@ -38,7 +49,8 @@ extern const std::vector<char> server_dh1024;
 
 static
 std::unique_ptr<SSLCertificate>
-load_certificate()
+load_certificate(SSLCertificate::SSLCertificateMethod method =
+                   boost::asio::ssl::context::tlsv1_server)
 {
   namespace bfs = boost::filesystem;
   auto tmp = bfs::path{};
@@ -66,7 +78,8 @@ load_certificate()
   }
   return std::make_unique<SSLCertificate>(cert.string(),
                                            key.string(),
-                                           dh1024.string());
+                                           dh1024.string(),
+                                           method);
 }
 
 static
@@ -424,6 +437,126 @@ ELLE_TEST_SCHEDULED(handshake_error)
   };
 }
 
+// Reconnecting resumes the session.
+ELLE_TEST_SCHEDULED(session_resumption)
+{
+  SSLServer server(load_certificate());
+  server.listen();
+  elle::reactor::Thread accept(
+    "accept",
+    [&]
+    {
+      for (int i = 0; i < 2; ++i)
+      {
+        auto socket = server.accept();
+        socket->write(std::string("ping\n"));
+        BOOST_TEST(socket->read_until("\n") == "pong\n");
+      }
+    });
+  for (int i = 0; i < 2; ++i)
+  {
+    SSLSocket socket("127.0.0.1", std::to_string(server.port()));
+    BOOST_TEST(socket.resumed() == (i == 1));
+    // Reading processes the session tickets sent along.
+    BOOST_TEST(socket.read_until("\n") == "ping\n");
+    socket.write(std::string("pong\n"));
+  }
+  elle::reactor::wait(accept);
+}
+
+#ifndef ELLE_WINDOWS
+// Data goes through whether or not the kernel encrypts it.
+ELLE_TEST_SCHEDULED(kernel_tls)
+{
+  auto certificate = load_certificate(boost::asio::ssl::context::sslv23_server);
+  certificate->kernel_tls(true);
+  SSLServer server(std::move(certificate));
+  server.listen();
+  auto const data = std::string(1 << 20, 'x') + "\n";
+  elle::reactor::Thread serve(
+    "serve",
+    [&]
+    {
+      auto socket = server.accept();
+      ELLE_LOG("kernel TLS: %s", socket->write_offloaded());
+      socket->write(data);
+      *socket << "buffered\n";
+      auto file = elle::filesystem::TemporaryFile("kernel_tls");
+      std::ofstream(file.path().string(), std::ios::binary) << data;
+      auto fd = ::open(file.path().string().c_str(), O_RDONLY);
+      BOOST_REQUIRE(fd >= 0);
+      elle::SafeFinally close([fd] { ::close(fd); });
+      BOOST_TEST(socket->send_file(fd, 0, data.size()) == data.size());
+    });
+  SSLSocket socket("127.0.0.1", std::to_string(server.port()));
+  BOOST_TEST(socket.read(data.size()) == data);
+  BOOST_TEST(socket.read_until("\n") == "buffered\n");
+  BOOST_TEST(socket.read(data.size()) == data);
+  elle::reactor::wait(serve);
+}
+
+# if OPENSSL_VERSION_NUMBER >= 0x10101000L
+// A peer requesting a key update either keeps reading what we write, or sees
+// writing shut down if the kernel cannot follow, never a corrupted stream.
+ELLE_TEST_SCHEDULED(kernel_tls_key_update)
+{
+  auto certificate = load_certificate(boost::asio::ssl::context::sslv23_server);
+  certificate->kernel_tls(true);
+  SSLServer server(std::move(certificate));
+  server.listen();
+  auto received = std::string();
+  // A plain OpenSSL client, to request the update.
+  std::thread client(
+    [&, port = server.port()]
+    {
+      auto ctx = std::unique_ptr<SSL_CTX, void (*)(SSL_CTX*)>(
+        SSL_CTX_new(TLS_client_method()), &SSL_CTX_free);
+      SSL_CTX_set_min_proto_version(ctx.get(), TLS1_3_VERSION);
+      auto fd = ::socket(AF_INET, SOCK_STREAM, 0);
+      elle::SafeFinally close([fd] { ::close(fd); });
+      auto address = sockaddr_in{};
+      address.sin_family = AF_INET;
+      address.sin_port = htons(port);
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      if (::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                    sizeof(address)) != 0)
+        return;
+      auto ssl = std::unique_ptr<SSL, void (*)(SSL*)>(
+        SSL_new(ctx.get()), &SSL_free);
+      SSL_set_fd(ssl.get(), fd);
+      if (SSL_connect(ssl.get()) != 1 ||
+          SSL_key_update(ssl.get(), SSL_KEY_UPDATE_REQUESTED) != 1 ||
+          SSL_write(ssl.get(), "ping\n", 5) != 5)
+        return;
+      char buffer[16];
+      auto const size = SSL_read(ssl.get(), buffer, sizeof(buffer));
+      if (size > 0)
+        received.assign(buffer, size);
+    });
+  elle::SafeFinally join([&] { client.join(); });
+  auto written = false;
+  {
+    auto socket = server.accept();
+    ELLE_LOG("kernel TLS: %s", socket->write_offloaded());
+    BOOST_TEST(socket->read_until("\n") == "ping\n");
+    try
+    {
+      socket->write(std::string("pong\n"));
+      written = true;
+    }
+    catch (elle::Error const& e)
+    {
+      ELLE_LOG("write failed: %s", e);
+      BOOST_TEST(socket->write_offloaded());
+    }
+  }
+  join.abort();
+  client.join();
+  BOOST_TEST(received == (written ? "pong\n" : ""));
+}
+# endif
+#endif
+
 // Check we flush before shutting down the door.
 ELLE_TEST_SCHEDULED(shutdown_flush)
 {
@@ -720,6 +853,13 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(connection_closed), 0, valgrind(1));
   suite.add(BOOST_TEST_CASE(handshake_stuck), 0, valgrind(1));
   suite.add(BOOST_TEST_CASE(handshake_error), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(session_resumption), 0, valgrind(1));
+#ifndef ELLE_WINDOWS
+  suite.add(BOOST_TEST_CASE(kernel_tls), 0, valgrind(5));
+# if OPENSSL_VERSION_NUMBER >= 0x10101000L
+  suite.add(BOOST_TEST_CASE(kernel_tls_key_update), 0, valgrind(5));
+# endif
+#endif
   suite.add(BOOST_TEST_CASE(shutdown_flush), 0, valgrind(1));
   suite.add(BOOST_TEST_CASE(shutdown_asynchronous), 0, valgrind(5));
   suite.add(BOOST_TEST_CASE(shutdown_asynchronous_timeoutless), 0, valgrind(1));
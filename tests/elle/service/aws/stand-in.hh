@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+#include <elle/Buffer.hh>
+#include <elle/attribute.hh>
+#include <elle/print.hh>
+#include <elle/utility/Move.hh>
+
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/network/Error.hh>
+#include <elle/reactor/network/TCPServer.hh>
+#include <elle/reactor/network/TCPSocket.hh>
+#include <elle/reactor/scheduler.hh>
+
+/// An in-memory S3 stand-in.
+///
+/// It implements just enough of the S3 API for object PUTs and GETs, ranged
+/// GETs and multipart uploads. Objects are keyed by their path, i.e.
+/// `/<bucket>/<folder>/<name>`.
+class S3StandIn
+{
+public:
+  using Fields = std::unordered_map<std::string, std::string>;
+  /// A request received, before it is handled.
+  struct Request
+  {
+    std::string method;
+    std::string path;
+    Fields query;
+    /// With lowercase names.
+    Fields headers;
+  };
+
+  /// Create a stand-in delaying every response by @a latency.
+  S3StandIn(elle::reactor::Duration latency = {})
+    : _hook()
+    , _page_size(1000)
+    , _puts(0)
+    , _latency(latency)
+    , _uploads(0)
+  {
+    this->_server.listen();
+    this->_accept.reset(new elle::reactor::Thread(
+      "accept",
+      [this]
+      {
+        while (true)
+        {
+          auto socket = elle::utility::move_on_copy(this->_server.accept());
+          this->_connections.emplace_back(new elle::reactor::Thread(
+            "serve", [this, socket] { this->_serve(**socket); }));
+        }
+      }));
+  }
+
+  int
+  port() const
+  {
+    return this->_server.port();
+  }
+
+  /// Called before handling each request, possibly sleeping: returning false
+  /// fails the request with a fatal 400 Bad Request.
+  ELLE_ATTRIBUTE_RW(std::function<bool (Request const&)>, hook);
+  /// The maximum number of parts listed at once.
+  ELLE_ATTRIBUTE_RW(int, page_size);
+  /// The number of objects and parts stored.
+  ELLE_ATTRIBUTE_R(int, puts);
+  ELLE_ATTRIBUTE_RX((std::unordered_map<std::string, elle::Buffer>), objects);
+
+private:
+  void
+  _serve(elle::reactor::network::TCPSocket& socket)
+  {
+    try
+    {
+      while (true)
+      {
+        auto line = socket.read_until("\r\n").string();
+        boost::trim_right(line);
+        auto words = std::vector<std::string>{};
+        boost::split(words, line, boost::is_any_of(" "));
+        auto request = Request{words.at(0), "", {}, {}};
+        while (true)
+        {
+          auto header = socket.read_until("\r\n").string();
+          if (header == "\r\n")
+            break;
+          auto colon = header.find(':');
+          request.headers[boost::to_lower_copy(header.substr(0, colon))] =
+            boost::trim_copy(header.substr(colon + 1));
+        }
+        if (request.headers.count("expect"))
+          socket.write(elle::ConstWeakBuffer("HTTP/1.1 100 Continue\r\n\r\n"));
+        auto body = elle::Buffer();
+        if (request.headers.count("content-length"))
+        {
+          body.size(std::stoul(request.headers["content-length"]));
+          socket.read(elle::WeakBuffer(body));
+        }
+        elle::reactor::sleep(this->_latency);
+        auto const target = words.at(1);
+        auto const question = target.find('?');
+        request.path = target.substr(0, question);
+        if (question != std::string::npos)
+        {
+          auto parameters = std::vector<std::string>{};
+          boost::split(parameters, target.substr(question + 1),
+                       boost::is_any_of("&"));
+          for (auto const& p: parameters)
+          {
+            auto equal = p.find('=');
+            request.query[p.substr(0, equal)] =
+              equal == std::string::npos ? "" : p.substr(equal + 1);
+          }
+        }
+        if (this->_hook && !this->_hook(request))
+          this->_respond(socket, "400 Bad Request", elle::ConstWeakBuffer(
+                           "<Error><Code>InvalidRequest</Code></Error>"));
+        else
+          this->_handle(socket, request, body);
+      }
+    }
+    catch (elle::reactor::network::ConnectionClosed const&)
+    {}
+  }
+
+  void
+  _respond(elle::reactor::network::TCPSocket& socket,
+           std::string const& status,
+           elle::ConstWeakBuffer content,
+           std::string const& extra = "")
+  {
+    socket.write(elle::ConstWeakBuffer(elle::print(
+      "HTTP/1.1 {}\r\nContent-Length: {}\r\n{}\r\n",
+      status, content.size(), extra)));
+    socket.write(content);
+  }
+
+  void
+  _handle(elle::reactor::network::TCPSocket& socket,
+          Request const& request,
+          elle::Buffer& body)
+  {
+    auto const& method = request.method;
+    auto const& path = request.path;
+    auto const& query = request.query;
+    auto respond = [&] (std::string const& status,
+                        elle::ConstWeakBuffer content,
+                        std::string const& extra = "")
+      {
+        this->_respond(socket, status, content, extra);
+      };
+    if (method == "POST" && query.count("uploads"))
+    {
+      auto const id = elle::print("upload-{}", ++this->_uploads);
+      this->_parts[id];
+      respond("200 OK", elle::ConstWeakBuffer(elle::print(
+                "<InitiateMultipartUploadResult><UploadId>{}</UploadId>"
+                "</InitiateMultipartUploadResult>", id)));
+    }
+    else if (method == "PUT" && query.count("partNumber"))
+    {
+      auto const part = std::stoi(query.at("partNumber"));
+      this->_parts.at(query.at("uploadId"))[part] = std::move(body);
+      ++this->_puts;
+      respond("200 OK", {}, elle::print("ETag: \"part-{}\"\r\n", part));
+    }
+    else if (method == "GET" && query.count("uploadId"))
+    {
+      auto const& parts = this->_parts.at(query.at("uploadId"));
+      auto const marker = query.count("part-number-marker") ?
+        std::stoi(query.at("part-number-marker")) : 0;
+      auto listing = std::string("<ListPartsResult>");
+      auto it = parts.upper_bound(marker);
+      for (int i = 0; it != parts.end() && i < this->_page_size; ++it, ++i)
+        listing += elle::print(
+          "<Part><PartNumber>{}</PartNumber><ETag>\"part-{}\"</ETag>"
+          "<Size>{}</Size></Part>",
+          it->first, it->first, it->second.size());
+      if (it != parts.end())
+        listing += elle::print(
+          "<IsTruncated>true</IsTruncated>"
+          "<NextPartNumberMarker>{}</NextPartNumberMarker>",
+          std::prev(it)->first);
+      else
+        listing += "<IsTruncated>false</IsTruncated>";
+      listing += "</ListPartsResult>";
+      respond("200 OK", elle::ConstWeakBuffer(listing));
+    }
+    else if (method == "POST" && query.count("uploadId"))
+    {
+      // Only the parts listed make up the object.
+      auto const& parts = this->_parts.at(query.at("uploadId"));
+      auto& object = this->_objects[path];
+      object.size(0);
+      auto const completion = body.string();
+      auto const tag = std::string("<PartNumber>");
+      for (auto pos = completion.find(tag); pos != std::string::npos;
+           pos = completion.find(tag, pos + 1))
+      {
+        auto const& part =
+          parts.at(std::stoi(completion.substr(pos + tag.size())));
+        object.append(part.contents(), part.size());
+      }
+      this->_parts.erase(query.at("uploadId"));
+      respond("200 OK", elle::ConstWeakBuffer(
+                "<CompleteMultipartUploadResult>"
+                "</CompleteMultipartUploadResult>"));
+    }
+    else if (method == "PUT")
+    {
+      this->_objects[path] = std::move(body);
+      ++this->_puts;
+      respond("200 OK", {});
+    }
+    else if (method == "GET" && this->_objects.count(path))
+    {
+      auto const& object = this->_objects.at(path);
+      auto begin = std::size_t(0);
+      auto end = object.size() - 1;
+      auto const range = request.headers.find("range");
+      if (range != request.headers.end())
+      {
+        auto const bounds = range->second.substr(range->second.find('=') + 1);
+        auto const dash = bounds.find('-');
+        begin = std::stoul(bounds.substr(0, dash));
+        end = std::min(end, std::stoul(bounds.substr(dash + 1)));
+      }
+      respond(range != request.headers.end() ?
+              "206 Partial Content" : "200 OK",
+              elle::ConstWeakBuffer(object.contents() + begin,
+                                    object.empty() ? 0 : end - begin + 1));
+    }
+    else
+      respond("404 Not Found", {});
+  }
+
+  ELLE_ATTRIBUTE(elle::reactor::Duration, latency);
+  ELLE_ATTRIBUTE(elle::reactor::network::TCPServer, server);
+  ELLE_ATTRIBUTE(std::vector<elle::reactor::Thread::unique_ptr>, connections);
+  ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr, accept);
+  /// Stored parts by upload identifier.
+  ELLE_ATTRIBUTE(
+    (std::unordered_map<std::string, std::map<int, elle::Buffer>>), parts);
+  ELLE_ATTRIBUTE(int, uploads);
+};
@@ -0,0 +1,244 @@
+#include <fstream>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <elle/filesystem/TemporaryDirectory.hh>
+#include <elle/test.hh>
+
+#include <elle/service/dropbox/MetadataCache.hh>
+
+using namespace elle::service::dropbox;
+
+namespace bfs = boost::filesystem;
+
+static
+Metadata
+file(std::string path, int64_t bytes = 0)
+{
+  Metadata res;
+  res.is_dir = false;
+  res.path = std::move(path);
+  res.bytes = bytes;
+  return res;
+}
+
+static
+Metadata
+folder(std::string path)
+{
+  Metadata res;
+  res.is_dir = true;
+  res.path = std::move(path);
+  res.bytes = 0;
+  return res;
+}
+
+static
+Delta
+page(std::string cursor,
+     std::vector<Metadata> updates,
+     std::vector<std::string> deletes = {},
+     bool reset = false,
+     bool has_more = false)
+{
+  Delta res;
+  res.reset = reset;
+  res.cursor = std::move(cursor);
+  res.has_more = has_more;
+  for (auto& m: updates)
+  {
+    auto key = to_lower(m.path);
+    res.entries.emplace(std::move(key), std::move(m));
+  }
+  for (auto& path: deletes)
+    res.entries.emplace(to_lower(path), boost::none);
+  return res;
+}
+
+static
+void
+root(MetadataCache& cache)
+{
+  // The root is not part of deltas and fetched aside.
+  cache.full(false);
+  cache.update(folder("/"));
+  cache.full(true);
+}
+
+static
+std::vector<std::string>
+contents(MetadataCache const& cache, std::string const& path)
+{
+  auto res = std::vector<std::string>{};
+  for (auto const& c: cache.find(path).get().contents.get())
+    res.emplace_back(c.path);
+  return res;
+}
+
+static
+void
+indexing()
+{
+  MetadataCache cache;
+  cache.update(folder("/a"));
+  cache.update(file("/a/x"));
+  cache.update(file("/a/y"));
+  cache.update(file("/a/z"));
+  BOOST_TEST(contents(cache, "/A") ==
+             (std::vector<std::string>{"/a/x", "/a/y", "/a/z"}));
+  // The last child fills the hole.
+  cache.remove("/a/X");
+  BOOST_TEST(!cache.find("/a/x"));
+  BOOST_TEST(contents(cache, "/a") ==
+             (std::vector<std::string>{"/a/z", "/a/y"}));
+  cache.update(file("/a/y", 42));
+  BOOST_TEST(cache.find("/a").get().contents.get().at(1).bytes == 42);
+  // Updating a folder without contents preserves them.
+  cache.update(folder("/a"));
+  BOOST_TEST(contents(cache, "/a") ==
+             (std::vector<std::string>{"/a/z", "/a/y"}));
+  // A full cache creates missing parents.
+  cache.update(file("/b/c"));
+  BOOST_TEST(cache.find("/b").get().is_dir);
+  BOOST_TEST(contents(cache, "/b") == (std::vector<std::string>{"/b/c"}));
+  MetadataCache partial({}, false);
+  partial.update(file("/b/c"));
+  BOOST_TEST(!partial.find("/b"));
+  BOOST_TEST(partial.size() == 1u);
+}
+
+static
+void
+reload()
+{
+  auto const dir = elle::filesystem::TemporaryDirectory{};
+  {
+    MetadataCache cache(dir.path());
+    cache.load();
+    BOOST_TEST(cache.cursor() == "");
+    cache.apply(page("1", {folder("/a"), file("/a/x", 1)}));
+    cache.apply(page("2", {file("/a/y", 2)}, {"/a/x"}));
+  }
+  MetadataCache cache(dir.path());
+  cache.load();
+  BOOST_TEST(cache.cursor() == "2");
+  BOOST_TEST(cache.size() == 2u);
+  BOOST_TEST(!cache.find("/a/x"));
+  BOOST_TEST(cache.find("/a/y").get().bytes == 2);
+  BOOST_TEST(contents(cache, "/a") == (std::vector<std::string>{"/a/y"}));
+}
+
+static
+void
+torn_record()
+{
+  auto const dir = elle::filesystem::TemporaryDirectory{};
+  auto const journal = dir.path() / "journal.0";
+  {
+    MetadataCache cache(dir.path());
+    cache.load();
+    cache.apply(page("1", {file("/x")}));
+    cache.apply(page("2", {file("/y")}));
+  }
+  auto const size = bfs::file_size(journal);
+  {
+    // A record announcing more bytes than were written.
+    std::ofstream output(journal.string(), std::ios::binary | std::ios::app);
+    auto const announced = uint32_t(64);
+    output.write(reinterpret_cast<char const*>(&announced), sizeof(announced));
+    output.write("torn", 4);
+  }
+  {
+    MetadataCache cache(dir.path());
+    cache.load();
+    BOOST_TEST(cache.cursor() == "2");
+    BOOST_TEST(cache.size() == 2u);
+    BOOST_TEST(bfs::file_size(journal) == size);
+    cache.apply(page("3", {file("/z")}));
+  }
+  MetadataCache cache(dir.path());
+  cache.load();
+  BOOST_TEST(cache.cursor() == "3");
+  BOOST_TEST(cache.size() == 3u);
+}
+
+static
+void
+compaction()
+{
+  auto const dir = elle::filesystem::TemporaryDirectory{};
+  auto const name = std::string(200, 'n');
+  auto const pages = 60;
+  auto const files = 100;
+  {
+    MetadataCache cache(dir.path());
+    cache.load();
+    for (int p = 0; p < pages; ++p)
+    {
+      auto updates = std::vector<Metadata>{};
+      for (int f = 0; f < files; ++f)
+        updates.emplace_back(
+          file(elle::sprintf("/dir/%s-%s-%s", name, p, f), f));
+      cache.apply(page(std::to_string(p), std::move(updates)));
+    }
+  }
+  // The journal outgrew 1 MiB: it was folded into a snapshot and a new
+  // journal holds the pages applied since.
+  BOOST_TEST(bfs::exists(dir.path() / "snapshot"));
+  BOOST_TEST(!bfs::exists(dir.path() / "snapshot.tmp"));
+  BOOST_TEST(!bfs::exists(dir.path() / "journal.0"));
+  BOOST_TEST(bfs::exists(dir.path() / "journal.1"));
+  MetadataCache cache(dir.path());
+  cache.load();
+  BOOST_TEST(cache.cursor() == std::to_string(pages - 1));
+  // The files and their parent.
+  BOOST_TEST(cache.size() == std::size_t(pages * files + 1));
+  BOOST_TEST(cache.find("/dir").get().contents.get().size() ==
+             std::size_t(pages * files));
+  BOOST_TEST(cache.find(elle::sprintf("/dir/%s-0-7", name)).get().bytes == 7);
+  BOOST_TEST(
+    bool(cache.find(elle::sprintf("/DIR/%s-%s-7", name, pages - 1))));
+}
+
+static
+void
+reset_rebuild()
+{
+  auto const dir = elle::filesystem::TemporaryDirectory{};
+  {
+    MetadataCache cache(dir.path());
+    cache.load();
+    root(cache);
+    cache.apply(page("1", {folder("/a"), file("/a/x")}));
+    BOOST_TEST(contents(cache, "/") == (std::vector<std::string>{"/a"}));
+    // The current metadata are served until the rebuild completes.
+    cache.apply(page("2", {file("/b")}, {}, true, true));
+    BOOST_TEST(bool(cache.find("/a/x")));
+    BOOST_TEST(!cache.find("/b"));
+    cache.apply(page("3", {file("/c")}));
+    BOOST_TEST(cache.cursor() == "3");
+    BOOST_TEST(!cache.find("/a"));
+    BOOST_TEST(!cache.find("/a/x"));
+    BOOST_TEST(bool(cache.find("/b")));
+    BOOST_TEST(cache.size() == 3u);
+    BOOST_TEST(contents(cache, "/").size() == 2u);
+  }
+  // The rebuilt metadata were snapshotted.
+  BOOST_TEST(!bfs::exists(dir.path() / "journal.0"));
+  MetadataCache cache(dir.path());
+  cache.load();
+  BOOST_TEST(cache.cursor() == "3");
+  BOOST_TEST(cache.size() == 3u);
+  BOOST_TEST(!cache.find("/a"));
+  BOOST_TEST(contents(cache, "/").size() == 2u);
+}
+
+ELLE_TEST_SUITE()
+{
+  auto& suite = boost::unit_test::framework::master_test_suite();
+  suite.add(BOOST_TEST_CASE(indexing));
+  suite.add(BOOST_TEST_CASE(reload));
+  suite.add(BOOST_TEST_CASE(torn_record));
+  suite.add(BOOST_TEST_CASE(compaction));
+  suite.add(BOOST_TEST_CASE(reset_rebuild));
+}